@@ -150,6 +150,16 @@ std::shared_ptr<Query> Analyze::do_analyze(std::shared_ptr<ast::TreeNode> parse)
   } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(parse)) {
     // 处理表名
     query->tables = {x->tab_name};
+    // INSERT INTO t SELECT ...，单独分析select语句
+    if (x->select != nullptr) {
+      if (std::dynamic_pointer_cast<ast::SelectStmt>(x->select) == nullptr) {
+        throw InternalError("INSERT INTO expects a SELECT statement");
+      }
+      if (!sm_manager_->db_.is_table(x->tab_name)) {
+        throw TableNotFoundError(x->tab_name);
+      }
+      query->select_query = do_analyze(x->select);
+    }
     // 处理insert 的values值
     for (auto &sv_val : x->vals) {
       query->values.push_back(convert_sv_value(sv_val));
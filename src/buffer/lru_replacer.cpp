@@ -19,17 +19,15 @@
 
 namespace easydb {
 
-LRUReplacer::LRUReplacer(size_t num_pages) {}
-
-LRUReplacer::~LRUReplacer() {
-  LinkListNode *p = head_;
-  while (p != nullptr) {
-    LinkListNode *tmp = p;
-    p = p->next_;
-    delete (tmp);
+LRUReplacer::LRUReplacer(size_t num_pages) {
+  nodes_.reserve(num_pages);
+  for (size_t i = 0; i < num_pages; ++i) {
+    nodes_.emplace_back(static_cast<frame_id_t>(i));
   }
 }
 
+LRUReplacer::~LRUReplacer() = default;
+
 void LRUReplacer::DeleteNode(LinkListNode *curr) {
   if (curr == head_ && curr == tail_) {
     head_ = nullptr;
@@ -44,52 +42,52 @@ void LRUReplacer::DeleteNode(LinkListNode *curr) {
     curr->prev_->next_ = curr->next_;
     curr->next_->prev_ = curr->prev_;
   }
-  delete (curr);
+  curr->prev_ = nullptr;
+  curr->next_ = nullptr;
+  curr->linked_ = false;
+  size_--;
 }
 bool LRUReplacer::Victim(frame_id_t *frame_id) {
   data_latch_.lock();
-  if (data_idx_.empty()) {
+  if (head_ == nullptr) {
     data_latch_.unlock();
     return false;
   }
   *frame_id = head_->val_;
-  data_idx_.erase(head_->val_);
-  LinkListNode *tmp = head_;
-  DeleteNode(tmp);
+  DeleteNode(head_);
   data_latch_.unlock();
   return true;
 }
 
 void LRUReplacer::Pin(frame_id_t frame_id) {
   data_latch_.lock();
-  auto it = data_idx_.find(frame_id);
-  if (it != data_idx_.end()) {
-    DeleteNode(data_idx_[frame_id]);
-    data_idx_.erase(it);
+  LinkListNode *node = &nodes_[frame_id];
+  if (node->linked_) {
+    DeleteNode(node);
   }
   data_latch_.unlock();
 }
 
 void LRUReplacer::Unpin(frame_id_t frame_id) {
   data_latch_.lock();
-  auto it = data_idx_.find(frame_id);
-  if (it == data_idx_.end()) {
-    LinkListNode *new_node = new LinkListNode(frame_id);
-    if (data_idx_.empty()) {
+  LinkListNode *new_node = &nodes_[frame_id];
+  if (!new_node->linked_) {
+    if (head_ == nullptr) {
       head_ = tail_ = new_node;
     } else {
       tail_->next_ = new_node;
       new_node->prev_ = tail_;
       tail_ = new_node;
     }
-    data_idx_[frame_id] = tail_;
+    new_node->linked_ = true;
+    size_++;
   }
   data_latch_.unlock();
 }
 
 size_t LRUReplacer::Size() {
   data_latch_.lock();
-  size_t ret = data_idx_.size();
+  size_t ret = size_;
   data_latch_.unlock();
   return ret;
 }
@@ -42,8 +42,10 @@ Schema::Schema(const std::vector<Column> &columns) {
     // add column
     this->columns_.push_back(column);
   }
+  // the null bitmap follows the columns, one bit per column
+  null_bitmap_offset_ = curr_offset;
   // set tuple length
-  length_ = curr_offset;
+  length_ = curr_offset + GetNullBitmapSize();
 
   SetPhysicalSize();
 }
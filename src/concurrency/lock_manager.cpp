@@ -16,6 +16,9 @@
 
 #include "concurrency/lock_manager.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "common/errors.h"
 #include "transaction/txn_defs.h"
 
@@ -29,6 +32,11 @@ namespace easydb {
  * @param {int} tab_fd
  */
 bool LockManager::LockSharedOnRecord(Transaction *txn, const RID &rid, int tab_fd) {
+  // OCC txns read without record locks, the versions they read are validated on commit
+  if (txn->IsOptimistic()) {
+    return true;
+  }
+
   // 1. Check the txn state(SS2PL)
   if (!CheckTxnStateLock(txn)) {
     return false;
@@ -38,6 +46,7 @@ bool LockManager::LockSharedOnRecord(Transaction *txn, const RID &rid, int tab_f
   LockDataId lock_data_id(tab_fd, rid, LockDataType::RECORD);
   // Acquire lock on the global lock table for thread safety
   std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::SHARED)].requests_++;
   // Find or create the LockRequestQueue
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
   for (auto &req : request_queue.request_queue_) {
@@ -74,7 +83,7 @@ bool LockManager::LockSharedOnRecord(Transaction *txn, const RID &rid, int tab_f
     // request_queue.cv_.wait(lock, wake);
     for (auto &req : request_queue.request_queue_) {
       if (req.lock_mode_ == LockMode::EXCLUSIVE) {
-        WaitDie(txn, req, request_queue, lock, wake);
+        WaitDie(txn, LockMode::SHARED, request_queue, lock, wake);
         break;
       }
     }
@@ -87,6 +96,10 @@ bool LockManager::LockSharedOnRecord(Transaction *txn, const RID &rid, int tab_f
   // Update the group lock mode(change from NON_LOCK or S)
   request_queue.group_lock_mode_ = GroupLockMode::S;
   txn->GetLockSet()->emplace(lock_data_id);
+  // A younger reader waiting to upgrade its lock must now die instead of waiting for us, see WaitDie
+  if (request_queue.request_queue_.size() > 1) {
+    request_queue.cv_.notify_all();
+  }
 
   return true;
 }
@@ -103,6 +116,11 @@ bool LockManager::LockSharedOnRecord(Transaction *txn, const RID &rid, int tab_f
  * @return True if the lock is successfully granted, false otherwise.
  */
 bool LockManager::LockGapOnIndex(Transaction *txn, const Iid &iid, int tab_fd) {
+  // OCC txns do not protect ranges with gap locks
+  if (txn->IsOptimistic()) {
+    return true;
+  }
+
   // 1. Check the txn state(SS2PL)
   if (!CheckTxnStateLock(txn)) {
     return false;
@@ -111,6 +129,7 @@ bool LockManager::LockGapOnIndex(Transaction *txn, const Iid &iid, int tab_fd) {
   // 2. Check if the lock is already granted
   LockDataId lock_data_id(tab_fd, iid, LockDataType::GAP);
   std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::GAP)].requests_++;
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
   for (auto &req : request_queue.request_queue_) {
     if (req.txn_id_ == txn->GetTransactionId()) {
@@ -140,6 +159,11 @@ bool LockManager::LockGapOnIndex(Transaction *txn, const Iid &iid, int tab_fd) {
  * @param tab_fd    The file descriptor of the table.
  */
 void LockManager::HandleIndexGapWaitDie(Transaction *txn, const Iid &iid, int tab_fd) {
+  // OCC txns do not respect gap locks, see LockGapOnIndex
+  if (txn->IsOptimistic()) {
+    return;
+  }
+
   LockDataId lock_data_id(tab_fd, iid, LockDataType::GAP);
   std::unique_lock<std::mutex> lock(latch_);
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
@@ -161,7 +185,7 @@ void LockManager::HandleIndexGapWaitDie(Transaction *txn, const Iid &iid, int ta
   for (auto &req : request_queue.request_queue_) {
     if (req.txn_id_ != txn->GetTransactionId()) {
       /* wait-die */
-      WaitDie(txn, req, request_queue, lock, wake);
+      WaitDie(txn, LockMode::EXCLUSIVE, request_queue, lock, wake);
       break;
     }
   }
@@ -184,6 +208,7 @@ bool LockManager::LockExclusiveOnRecord(Transaction *txn, const RID &rid, int ta
   LockDataId lock_data_id(tab_fd, rid, LockDataType::RECORD);
   // Acquire lock on the global lock table for thread safety
   std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::EXCLUSIVE)].requests_++;
   // Find or create the LockRequestQueue
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
   for (auto &req : request_queue.request_queue_) {
@@ -206,7 +231,7 @@ bool LockManager::LockExclusiveOnRecord(Transaction *txn, const RID &rid, int ta
           /* wait-die */
           for (auto &r : request_queue.request_queue_) {
             if (r.txn_id_ != txn->GetTransactionId()) {
-              WaitDie(txn, r, request_queue, lock, upgrade);
+              WaitDie(txn, LockMode::EXCLUSIVE, request_queue, lock, upgrade);
               break;
             }
           }
@@ -233,12 +258,8 @@ bool LockManager::LockExclusiveOnRecord(Transaction *txn, const RID &rid, int ta
       }
       return false;
     };
-    for (auto &req : request_queue.request_queue_) {
-      // // Don't need check actually
-      // if (req.txn_id_ != txn->GetTransactionId()) {
-      // }
-      WaitDie(txn, req, request_queue, lock, wake);
-      break;
+    if (!request_queue.request_queue_.empty()) {
+      WaitDie(txn, LockMode::EXCLUSIVE, request_queue, lock, wake);
     }
   }
 
@@ -253,6 +274,35 @@ bool LockManager::LockExclusiveOnRecord(Transaction *txn, const RID &rid, int ta
   return true;
 }
 
+/**
+ * @description: 尝试申请行级排他锁，只有没有任何事务（包括自己）持有或等待该记录的锁时才加锁，从不等待
+ * @return {bool} 加锁是否成功
+ * @param {Transaction*} txn 要申请锁的事务对象指针
+ * @param {Rid&} rid 加锁的目标记录ID
+ * @param {int} tab_fd 记录所在的表的fd
+ * @note 用于复用已删除记录的slot：删除该记录的事务结束前会一直持有排他锁
+ */
+bool LockManager::TryLockExclusiveOnRecord(Transaction *txn, const RID &rid, int tab_fd) {
+  if (!CheckTxnStateLock(txn)) {
+    return false;
+  }
+
+  LockDataId lock_data_id(tab_fd, rid, LockDataType::RECORD);
+  std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::EXCLUSIVE)].requests_++;
+  LockRequestQueue &request_queue = lock_table_[lock_data_id];
+  if (!request_queue.request_queue_.empty()) {
+    return false;
+  }
+  LockRequest lock_request(txn->GetTransactionId(), LockMode::EXCLUSIVE);
+  lock_request.granted_ = true;
+  request_queue.request_queue_.emplace_back(lock_request);
+  request_queue.group_lock_mode_ = GroupLockMode::X;
+  txn->GetLockSet()->insert(lock_data_id);
+
+  return true;
+}
+
 /**
  * @description: 申请表级读锁
  * @return {bool} 返回加锁是否成功
@@ -260,6 +310,12 @@ bool LockManager::LockExclusiveOnRecord(Transaction *txn, const RID &rid, int ta
  * @param {int} tab_fd 目标表的fd
  */
 bool LockManager::LockSharedOnTable(Transaction *txn, int tab_fd) {
+  // OCC txns read without record locks, the versions they read are validated on commit; an S lock would block the
+  // writers, so they only take IS to keep DDL away from the table they read
+  if (txn->IsOptimistic()) {
+    return LockISOnTable(txn, tab_fd);
+  }
+
   // 1. Check the txn state(SS2PL)
   if (!CheckTxnStateLock(txn)) {
     return false;
@@ -269,6 +325,7 @@ bool LockManager::LockSharedOnTable(Transaction *txn, int tab_fd) {
   LockDataId lock_data_id(tab_fd, LockDataType::TABLE);
   // Acquire lock on the global lock table for thread safety
   std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::SHARED)].requests_++;
   // Find or create the LockRequestQueue
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
   // Condition to wake
@@ -295,7 +352,7 @@ bool LockManager::LockSharedOnTable(Transaction *txn, int tab_fd) {
             if (r.txn_id_ != txn->GetTransactionId() &&
                 (r.lock_mode_ == LockMode::INTENTION_EXCLUSIVE || r.lock_mode_ == LockMode::S_IX ||
                  r.lock_mode_ == LockMode::EXCLUSIVE)) {
-              WaitDie(txn, r, request_queue, lock, wake);
+              WaitDie(txn, LockMode::SHARED, request_queue, lock, wake);
               break;
             }
           }
@@ -318,7 +375,7 @@ bool LockManager::LockSharedOnTable(Transaction *txn, int tab_fd) {
         for (auto &r : request_queue.request_queue_) {
           if (r.lock_mode_ == LockMode::INTENTION_EXCLUSIVE && r.txn_id_ != txn->GetTransactionId()) {
             /* wait-die */
-            WaitDie(txn, r, request_queue, lock, upgrade);
+            WaitDie(txn, LockMode::S_IX, request_queue, lock, upgrade);
             break;
           }
         }
@@ -341,7 +398,7 @@ bool LockManager::LockSharedOnTable(Transaction *txn, int tab_fd) {
     for (auto &req : request_queue.request_queue_) {
       if (req.lock_mode_ == LockMode::INTENTION_EXCLUSIVE || req.lock_mode_ == LockMode::S_IX ||
           req.lock_mode_ == LockMode::EXCLUSIVE) {
-        WaitDie(txn, req, request_queue, lock, wake);
+        WaitDie(txn, LockMode::SHARED, request_queue, lock, wake);
         break;
       }
     }
@@ -374,6 +431,7 @@ bool LockManager::LockExclusiveOnTable(Transaction *txn, int tab_fd) {
   LockDataId lock_data_id(tab_fd, LockDataType::TABLE);
   // Acquire lock on the global lock table for thread safety
   std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::EXCLUSIVE)].requests_++;
   // Find or create the LockRequestQueue
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
 
@@ -396,7 +454,7 @@ bool LockManager::LockExclusiveOnTable(Transaction *txn, int tab_fd) {
           /* wait-die */
           for (auto &r : request_queue.request_queue_) {
             if (r.txn_id_ != txn->GetTransactionId()) {
-              WaitDie(txn, r, request_queue, lock, upgrade2X);
+              WaitDie(txn, LockMode::EXCLUSIVE, request_queue, lock, upgrade2X);
               break;
             }
           }
@@ -422,9 +480,8 @@ bool LockManager::LockExclusiveOnTable(Transaction *txn, int tab_fd) {
       }
       return false;
     };
-    for (auto &req : request_queue.request_queue_) {
-      WaitDie(txn, req, request_queue, lock, wake);
-      break;
+    if (!request_queue.request_queue_.empty()) {
+      WaitDie(txn, LockMode::EXCLUSIVE, request_queue, lock, wake);
     }
   }
 
@@ -446,6 +503,9 @@ bool LockManager::LockExclusiveOnTable(Transaction *txn, int tab_fd) {
  * @param {int} tab_fd 目标表的fd
  */
 bool LockManager::LockISOnTable(Transaction *txn, int tab_fd) {
+  // OCC txns take IS too: it conflicts only with X, so that DROP TABLE cannot free the file handles in their read
+  // set before they validate it on commit
+
   // 1. Check the txn state(SS2PL)
   if (!CheckTxnStateLock(txn)) {
     return false;
@@ -455,6 +515,7 @@ bool LockManager::LockISOnTable(Transaction *txn, int tab_fd) {
   LockDataId lock_data_id(tab_fd, LockDataType::TABLE);
   // Acquire lock on the global lock table for thread safety
   std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::INTENTION_SHARED)].requests_++;
   // Find or create the LockRequestQueue
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
   for (auto &req : request_queue.request_queue_) {
@@ -478,7 +539,7 @@ bool LockManager::LockISOnTable(Transaction *txn, int tab_fd) {
     };
     for (auto &req : request_queue.request_queue_) {
       if (req.lock_mode_ == LockMode::EXCLUSIVE) {
-        WaitDie(txn, req, request_queue, lock, wake);
+        WaitDie(txn, LockMode::INTENTION_SHARED, request_queue, lock, wake);
         break;
       }
     }
@@ -512,6 +573,7 @@ bool LockManager::LockIXOnTable(Transaction *txn, int tab_fd) {
   LockDataId lock_data_id(tab_fd, LockDataType::TABLE);
   // Acquire lock on the global lock table for thread safety
   std::unique_lock<std::mutex> lock(latch_);
+  mode_stats_[static_cast<int>(LockMode::INTENTION_EXCLUSIVE)].requests_++;
   // Find or create the LockRequestQueue
   LockRequestQueue &request_queue = lock_table_[lock_data_id];
   auto wake = [&]() {
@@ -537,7 +599,7 @@ bool LockManager::LockIXOnTable(Transaction *txn, int tab_fd) {
           for (auto &r : request_queue.request_queue_) {
             if (r.txn_id_ != txn->GetTransactionId() && r.lock_mode_ != LockMode::INTENTION_SHARED &&
                 r.lock_mode_ != LockMode::INTENTION_EXCLUSIVE) {
-              WaitDie(txn, r, request_queue, lock, wake);
+              WaitDie(txn, LockMode::INTENTION_EXCLUSIVE, request_queue, lock, wake);
               break;
             }
           }
@@ -561,7 +623,7 @@ bool LockManager::LockIXOnTable(Transaction *txn, int tab_fd) {
         for (auto &r : request_queue.request_queue_) {
           if (r.lock_mode_ == LockMode::SHARED && r.txn_id_ != txn->GetTransactionId()) {
             /* wait-die */
-            WaitDie(txn, r, request_queue, lock, upgrade2SIX);
+            WaitDie(txn, LockMode::S_IX, request_queue, lock, upgrade2SIX);
             break;
           }
         }
@@ -584,7 +646,7 @@ bool LockManager::LockIXOnTable(Transaction *txn, int tab_fd) {
     for (auto &req : request_queue.request_queue_) {
       if (req.lock_mode_ == LockMode::SHARED || req.lock_mode_ == LockMode::S_IX ||
           req.lock_mode_ == LockMode::EXCLUSIVE) {
-        WaitDie(txn, req, request_queue, lock, wake);
+        WaitDie(txn, LockMode::INTENTION_EXCLUSIVE, request_queue, lock, wake);
         break;
       }
     }
@@ -600,6 +662,41 @@ bool LockManager::LockIXOnTable(Transaction *txn, int tab_fd) {
   return true;
 }
 
+/**
+ * @description: 判断记录上是否有其他事务持有的排他锁，用于OCC事务提交时的验证
+ * @return {bool} 其他事务是否持有该记录的排他锁
+ * @param {Transaction*} txn 进行验证的事务对象指针
+ * @param {Rid&} rid 目标记录ID
+ * @param {int} tab_fd 记录所在的表的fd
+ */
+bool LockManager::IsExclusiveLockedByOthers(Transaction *txn, const RID &rid, int tab_fd) {
+  LockDataId lock_data_id(tab_fd, rid, LockDataType::RECORD);
+  std::unique_lock<std::mutex> lock(latch_);
+  auto iter = lock_table_.find(lock_data_id);
+  if (iter == lock_table_.end() || iter->second.group_lock_mode_ != GroupLockMode::X) {
+    return false;
+  }
+  for (auto &req : iter->second.request_queue_) {
+    if (req.lock_mode_ == LockMode::EXCLUSIVE && req.txn_id_ != txn->GetTransactionId()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @description: 判断是否有事务持有或等待某条记录的锁
+ * @return {bool} 是否有事务持有或等待该记录的锁
+ * @param {Rid&} rid 目标记录ID
+ * @param {int} tab_fd 记录所在的表的fd
+ */
+bool LockManager::IsRecordLocked(const RID &rid, int tab_fd) {
+  LockDataId lock_data_id(tab_fd, rid, LockDataType::RECORD);
+  std::unique_lock<std::mutex> lock(latch_);
+  auto iter = lock_table_.find(lock_data_id);
+  return iter != lock_table_.end() && !iter->second.request_queue_.empty();
+}
+
 /**
  * @description: 释放锁
  * @return {bool} 返回解锁是否成功
@@ -676,6 +773,7 @@ bool LockManager::CheckTxnStateLock(Transaction *txn) {
       return true;
     case TransactionState::SHRINKING:
       // Transaction is in shrinking state, throw exception
+      RecordAbort(AbortReason::LOCK_ON_SHIRINKING);
       throw TransactionAbortException(txn->GetTransactionId(), AbortReason::LOCK_ON_SHIRINKING);
     default:
       // Transaction state is invalid, throw exception
@@ -710,28 +808,192 @@ bool LockManager::CheckTxnStateUnlock(Transaction *txn) {
   }
 }
 
+/**
+ * Checks whether a lock held by another transaction is compatible with the requested lock mode.
+ * Note that GAP locks are only compatible with each other, an insertion into the gap waits as EXCLUSIVE.
+ *
+ * @param held The lock mode held by another transaction.
+ * @param requested The lock mode being requested.
+ * @return True if both locks can be granted at the same time.
+ */
+bool LockManager::IsCompatible(LockMode held, LockMode requested) {
+  switch (held) {
+    case LockMode::INTENTION_SHARED:
+      return requested != LockMode::EXCLUSIVE && requested != LockMode::GAP;
+    case LockMode::INTENTION_EXCLUSIVE:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::INTENTION_EXCLUSIVE;
+    case LockMode::SHARED:
+      return requested == LockMode::INTENTION_SHARED || requested == LockMode::SHARED;
+    case LockMode::S_IX:
+      return requested == LockMode::INTENTION_SHARED;
+    case LockMode::GAP:
+      return requested == LockMode::GAP;
+    default:
+      return false;
+  }
+}
+
 /**
  * Waits or aborts the transaction based on the wait-die protocol.
- * If the transaction is older than the requesting transaction, it waits.
- * If the transaction is younger than the requesting transaction, it aborts.
+ * If the transaction is older than every transaction holding a conflicting lock, it waits.
+ * Otherwise it aborts, so that a transaction never waits for an older one and no wait cycle can form.
  *
  * @param txn The transaction that is requesting the lock.
- * @param req_holder The lock request holder containing the requesting transaction's information.
+ * @param mode The lock mode being requested (the target mode for an upgrade).
  * @param queue The lock request queue.
  * @param lock The unique lock on the lock manager's mutex.
  * @param wake The wake condition for waiting on the lock request queue.
- * @throws TransactionAbortException If the transaction is younger than the requesting transaction.
+ * @throws TransactionAbortException If the transaction is younger than a conflicting lock holder.
  */
-inline void LockManager::WaitDie(Transaction *txn, LockRequest &req_holder, LockRequestQueue &queue,
+inline void LockManager::WaitDie(Transaction *txn, LockMode mode, LockRequestQueue &queue,
                                  std::unique_lock<std::mutex> &lock, std::function<bool()> wake) {
   // Note: We use id instead of start_ts because we cannot get the req.start_ts,
   // but the id increments with the start_ts, which means it's ok to use id.
-  if (txn->GetTransactionId() < req_holder.txn_id_) {
+  // All conflicting holders must be checked, not only the first one, otherwise an older holder
+  // behind a younger one in the queue can be waited for and deadlock.
+  // The holders are checked again after every wakeup: while we waited, an older transaction may have been granted
+  // a conflicting lock (it took the lock freed by a holder before we woke up, or it joined the readers of a record
+  // we wait to upgrade), and waiting for it could close a cycle.
+  bool waited = false;
+  auto start = std::chrono::steady_clock::now();
+  while (true) {
+    for (auto &req : queue.request_queue_) {
+      if (req.txn_id_ != txn->GetTransactionId() && !IsCompatible(req.lock_mode_, mode) &&
+          req.txn_id_ < txn->GetTransactionId()) {
+        // Younger transaction, abort
+        mode_stats_[static_cast<int>(mode)].dies_++;
+        queue.die_count_++;
+        RecordAbort(AbortReason::DEADLOCK_PREVENTION);
+        throw TransactionAbortException(txn->GetTransactionId(), AbortReason::DEADLOCK_PREVENTION);
+      }
+    }
+    if (wake()) {
+      break;
+    }
     // Older transaction, wait
-    queue.cv_.wait(lock, wake);
+    waited = true;
+    queue.cv_.wait(lock);
+  }
+  if (!waited) {
+    return;
+  }
+  auto wait_time_us = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+  // Record the wait, latch_ is held again here
+  LockModeStats &stats = mode_stats_[static_cast<int>(mode)];
+  stats.waits_++;
+  stats.wait_time_us_ += wait_time_us;
+  stats.max_wait_time_us_ = std::max(stats.max_wait_time_us_, wait_time_us);
+  int bucket = 0;
+  while (bucket < LOCK_WAIT_HISTOGRAM_BUCKETS - 1 && (wait_time_us >> bucket) > 0) {
+    bucket++;
+  }
+  stats.wait_histogram_[bucket]++;
+  queue.wait_count_++;
+  queue.wait_time_us_ += wait_time_us;
+}
+
+/**
+ * @description: 记录一次事务回滚的原因，用于SHOW LOCK_STATS
+ * @param {AbortReason} reason 回滚原因
+ */
+void LockManager::RecordAbort(AbortReason reason) { abort_stats_[static_cast<int>(reason)]++; }
+
+/**
+ * @description: 获取锁表中所有已授予的锁，用于SHOW LOCKS
+ * @return {vector<LockInfo>} 每个数据项上每个事务持有的锁
+ */
+std::vector<LockManager::LockInfo> LockManager::GetLocks() {
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<LockInfo> locks;
+  for (auto &[lock_data_id, request_queue] : lock_table_) {
+    for (auto &req : request_queue.request_queue_) {
+      locks.push_back({lock_data_id, req.txn_id_, LockModeToString(req.lock_mode_)});
+    }
+  }
+  return locks;
+}
+
+/**
+ * @description: 获取每种加锁类型的统计信息
+ * @return {vector<pair<string, LockModeStats>>} 加锁类型名称及其统计信息
+ */
+std::vector<std::pair<std::string, LockManager::LockModeStats>> LockManager::GetModeStats() {
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<std::pair<std::string, LockModeStats>> mode_stats;
+  for (int i = 0; i < LOCK_MODE_NUM; ++i) {
+    mode_stats.emplace_back(LockModeToString(static_cast<LockMode>(i)), mode_stats_[i]);
+  }
+  return mode_stats;
+}
+
+/**
+ * @description: 获取每种原因导致的事务回滚次数
+ * @return {vector<pair<string, uint64_t>>} 回滚原因及其次数
+ */
+std::vector<std::pair<std::string, uint64_t>> LockManager::GetAbortStats() {
+  static const std::string abort_reason_str[ABORT_REASON_NUM] = {"LOCK_ON_SHRINKING", "UPGRADE_CONFLICT",
+                                                                 "DEADLOCK_PREVENTION", "VALIDATION_FAILED"};
+  std::vector<std::pair<std::string, uint64_t>> abort_stats;
+  for (int i = 0; i < ABORT_REASON_NUM; ++i) {
+    abort_stats.emplace_back(abort_reason_str[i], abort_stats_[i].load());
+  }
+  return abort_stats;
+}
+
+/**
+ * @description: 获取等待时间最长的n个数据项
+ * @return {vector<HotLockInfo>} 按总等待时间（相同时按等待次数）降序排列的热点数据项
+ * @param {size_t} n 返回的数据项个数
+ */
+std::vector<LockManager::HotLockInfo> LockManager::GetHotLocks(size_t n) {
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<HotLockInfo> hot_locks;
+  for (auto &[lock_data_id, request_queue] : lock_table_) {
+    if (request_queue.wait_count_ > 0 || request_queue.die_count_ > 0) {
+      hot_locks.push_back(
+          {lock_data_id, request_queue.wait_count_, request_queue.die_count_, request_queue.wait_time_us_});
+    }
+  }
+  lock.unlock();
+
+  auto hotter = [](const HotLockInfo &a, const HotLockInfo &b) {
+    if (a.wait_time_us_ != b.wait_time_us_) {
+      return a.wait_time_us_ > b.wait_time_us_;
+    }
+    return a.waits_ + a.dies_ > b.waits_ + b.dies_;
+  };
+  if (hot_locks.size() > n) {
+    std::partial_sort(hot_locks.begin(), hot_locks.begin() + n, hot_locks.end(), hotter);
+    hot_locks.erase(hot_locks.begin() + n, hot_locks.end());
   } else {
-    // Younger transaction, abort
-    throw TransactionAbortException(txn->GetTransactionId(), AbortReason::DEADLOCK_PREVENTION);
+    std::sort(hot_locks.begin(), hot_locks.end(), hotter);
+  }
+  return hot_locks;
+}
+
+/**
+ * @description: 加锁类型的名称
+ * @return {string} 加锁类型的名称
+ * @param {LockMode} mode 加锁类型
+ */
+std::string LockManager::LockModeToString(LockMode mode) {
+  switch (mode) {
+    case LockMode::SHARED:
+      return "S";
+    case LockMode::EXCLUSIVE:
+      return "X";
+    case LockMode::INTENTION_SHARED:
+      return "IS";
+    case LockMode::INTENTION_EXCLUSIVE:
+      return "IX";
+    case LockMode::S_IX:
+      return "SIX";
+    case LockMode::GAP:
+      return "GAP";
+    default:
+      return "UNKNOWN";
   }
 }
 
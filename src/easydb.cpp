@@ -211,7 +211,26 @@ void *client_handler(void *sock_fd) {
     if (context->txn_->GetTxnMode() == false) {
       // 如果已经 abort，则无需提交事务
       if (context->txn_->GetState() != TransactionState::ABORTED) {
-        txn_manager->Commit(context->txn_, context->log_mgr_);
+        try {
+          txn_manager->Commit(context->txn_, context->log_mgr_);
+        } catch (TransactionAbortException &e) {
+          // OCC事务提交时验证失败，回滚事务并把abort信息返回给客户端
+          std::string str = "abort\n";
+          memcpy(data_send, str.c_str(), str.length());
+          data_send[str.length()] = '\0';
+          offset = str.length();
+          context->SetJsonMsg("abort");
+
+          txn_manager->Abort(context->txn_, log_manager.get());
+          std::cout << e.GetInfo() << std::endl;
+
+          if (sm_manager->IsEnableOutput()) {
+            std::fstream outfile;
+            outfile.open("output.txt", std::ios::out | std::ios::app);
+            outfile << str;
+            outfile.close();
+          }
+        }
       }
     }
 
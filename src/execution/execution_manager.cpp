@@ -35,6 +35,7 @@ const char *help_info =
     "  DELETE FROM table_name [WHERE where_clause]\n"
     "  UPDATE table_name SET column_name = value [, column_name = value ...] [WHERE where_clause]\n"
     "  SELECT selector FROM table_name [WHERE where_clause]\n"
+    "  VACUUM [table_name]\n"
     "type:\n"
     "  {INT | FLOAT | CHAR(n)}\n"
     "where_clause:\n"
@@ -53,7 +54,7 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context) {
   if (auto x = std::dynamic_pointer_cast<DDLPlan>(plan)) {
     switch (x->tag) {
       case T_CreateTable: {
-        sm_manager_->CreateTable(x->tab_name_, x->cols_, context);
+        sm_manager_->CreateTable(x->tab_name_, x->cols_, context, x->format_);
         break;
       }
       case T_DropTable: {
@@ -61,7 +62,7 @@ void QlManager::run_mutli_query(std::shared_ptr<Plan> plan, Context *context) {
         break;
       }
       case T_CreateIndex: {
-        sm_manager_->CreateIndex(x->tab_name_, x->tab_col_names_, context);
+        sm_manager_->CreateIndex(x->tab_name_, x->tab_col_names_, context, x->include_col_names_, x->is_hash_);
         break;
       }
       case T_DropIndex: {
@@ -92,6 +93,18 @@ void QlManager::run_cmd_utility(std::shared_ptr<Plan> plan, txn_id_t *txn_id, Co
         sm_manager_->ShowIndex(x->tab_name_, context);
         break;
       }
+      case T_ShowLocks: {
+        sm_manager_->ShowLocks(context);
+        break;
+      }
+      case T_ShowLockStats: {
+        sm_manager_->ShowLockStats(context);
+        break;
+      }
+      case T_Vacuum: {
+        sm_manager_->Vacuum(x->tab_name_, context);
+        break;
+      }
       case T_DescTable: {
         sm_manager_->DescTable(x->tab_name_, context);
         break;
@@ -142,6 +155,17 @@ void QlManager::run_cmd_utility(std::shared_ptr<Plan> plan, txn_id_t *txn_id, Co
       }
       case ast::SetKnobType::EnableOptimizer: {
         planner_->SetEnableOptimizer(x->bool_value_);
+        break;
+      }
+      case ast::SetKnobType::EnableOcc: {
+        // Takes effect from the next transaction, running ones keep their own mode
+        txn_mgr_->SetConcurrencyMode(x->bool_value_ ? ConcurrencyMode::OPTIMISTIC
+                                                    : ConcurrencyMode::TWO_PHASE_LOCKING);
+        break;
+      }
+      case ast::SetKnobType::EnableAutoVacuum: {
+        txn_mgr_->SetEnableAutoVacuum(x->bool_value_);
+        break;
       }
       case ast::SetKnobType::EnableOutput: {
         sm_manager_->SetEnableOutput(x->bool_value_);
@@ -256,6 +280,11 @@ std::vector<Value> subquery_select_from(std::shared_ptr<AbstractExecutor> execut
 
     // auto col = executorTreeRoot->cols()[0];
     auto col = executorTreeRoot->schema().GetColumn(0);
+    // a null value is only marked in the null bitmap, its bytes in the record are zeroes
+    if (Tuple->IsNull(&executorTreeRoot->schema(), 0)) {
+      outputs.push_back(Value(col.GetType()));
+      continue;
+    }
     std::string col_str;
     // char *rec_buf = Tuple->data + col.GetOffset();
     char *tp = new char[Tuple->GetLength()];
@@ -280,6 +309,30 @@ std::vector<Value> subquery_select_from(std::shared_ptr<AbstractExecutor> execut
   return outputs;
 }
 
+void subquery_fill_cond(Condition *cond) {
+  if (!cond->is_rhs_stmt || cond->is_rhs_exe_processed) {
+    return;
+  }
+  std::shared_ptr<AbstractExecutor> rhs_stmt_executor_tree_root =
+      std::static_pointer_cast<AbstractExecutor>(cond->rhs_stmt_exe);
+  std::vector<Value> results = subquery_select_from(rhs_stmt_executor_tree_root, cond->rhs_col);
+  // 进行回填
+  // comparison stmt, sub query should return only one value
+  // Also legal if subquery doesn't use aggregation function, but return only a value.
+  if (cond->op != OP_IN) {
+    if (results.size() > 1) {
+      throw SubqueryIllegalError("Result of subquery contains multiple tuples\n");
+    } else if (results.size() == 1) {
+      cond->rhs_val = results[0];
+    } else {
+      throw SubqueryIllegalError("Result of subquery is empty\n");
+    }
+  } else {
+    cond->rhs_in_col = results;
+  }
+  cond->is_rhs_exe_processed = true;
+}
+
 // 执行DML语句
 void QlManager::run_dml(std::unique_ptr<AbstractExecutor> exec) { exec->Next(); }
 
@@ -113,7 +113,12 @@ Value AggregationExecutor::aggregation_to_value(Column target_colu) {
         return Value(target_colu.GetType(), sm_manager_->GetTableAttrSum(tab_name_, col_name));
       }
     case AggregationType::COUNT_AGG:
-      return Value(TypeId::TYPE_INT, sm_manager_->GetTableCount(tab_name_));
+      // COUNT(*) counts every row, COUNT(col) only the rows where col is not NULL
+      if (col_name == "*") {
+        return Value(TypeId::TYPE_INT, sm_manager_->GetTableCount(tab_name_));
+      }
+      return Value(TypeId::TYPE_INT,
+                   sm_manager_->GetTableCount(tab_name_) - sm_manager_->GetTableAttrNullCount(tab_name_, col_name));
     case AggregationType::MAX_AGG:
       if(target_colu.GetType() == TypeId::TYPE_INT){
         return Value(target_colu.GetType(), int(sm_manager_->GetTableAttrMax(tab_name_, col_name)));
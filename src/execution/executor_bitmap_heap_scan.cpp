@@ -0,0 +1,165 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * executor_bitmap_heap_scan.cpp
+ *
+ * Identification: src/execution/executor_bitmap_heap_scan.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "execution/executor_bitmap_heap_scan.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <map>
+
+#include "execution/executor_index_scan.h"
+
+namespace easydb {
+
+BitmapHeapScanExecutor::BitmapHeapScanExecutor(SmManager *sm_manager, std::string tab_name,
+                                               std::vector<Condition> conds,
+                                               const std::vector<std::vector<std::string>> &index_col_names,
+                                               Context *context) {
+  sm_manager_ = sm_manager;
+  context_ = context;
+  tab_name_ = std::move(tab_name);
+  tab_ = sm_manager_->db_.get_table(tab_name_);
+  conds_ = std::move(conds);
+  fh_ = sm_manager_->fhs_.at(tab_name_).get();
+  schema_ = tab_.schema;
+  len_ = schema_.GetInlinedStorageSize();
+
+  std::map<CompOp, CompOp> swap_op = {
+      {OP_EQ, OP_EQ}, {OP_NE, OP_NE}, {OP_LT, OP_GT}, {OP_GT, OP_LT}, {OP_LE, OP_GE}, {OP_GE, OP_LE},
+  };
+  for (auto &cond : conds_) {
+    if (cond.lhs_col.tab_name != tab_name_) {
+      // lhs is on other table, now rhs must be on this table
+      assert(!cond.is_rhs_val && cond.rhs_col.tab_name == tab_name_);
+      std::swap(cond.lhs_col, cond.rhs_col);
+      cond.op = swap_op.at(cond.op);
+    }
+  }
+
+  for (auto &col_names : index_col_names) {
+    auto &index_meta = *tab_.get_index_meta(col_names);
+    std::vector<Condition> index_conds;
+    for (auto &cond : conds_) {
+      bool on_index = std::any_of(index_meta.cols.begin(), index_meta.cols.end(),
+                                  [&](const ColMeta &col) { return col.name == cond.lhs_col.col_name; });
+      // the value of a subquery is known only when the scan begins
+      if (on_index && cond.is_rhs_val && !cond.is_rhs_stmt && cond.op != OP_NE) {
+        index_conds.push_back(cond);
+      }
+    }
+    index_metas_.push_back(index_meta);
+    index_conds_.push_back(std::move(index_conds));
+  }
+
+  // lock table
+  if (context_ != nullptr) {
+    context_->lock_mgr_->LockISOnTable(context_->txn_, fh_->GetFd());
+  }
+}
+
+void BitmapHeapScanExecutor::beginTuple() {
+  for (auto &cond : conds_) {
+    subquery_fill_cond(&cond);
+  }
+  // 1. 收集每个索引范围内的rid，按页面排序后求交集
+  rids_ = CollectRids(0);
+  for (size_t i = 1; i < index_metas_.size() && !rids_.empty(); ++i) {
+    auto rids = CollectRids(i);
+    std::vector<RID> both;
+    std::set_intersection(rids_.begin(), rids_.end(), rids.begin(), rids.end(), std::back_inserter(both));
+    rids_ = std::move(both);
+  }
+
+  // 2. 按页面顺序回表，找到第一个满足条件的记录
+  next_page_begin_ = 0;
+  FetchNextPage();
+  SeekMatch();
+}
+
+void BitmapHeapScanExecutor::nextTuple() {
+  tuple_idx_++;
+  SeekMatch();
+}
+
+std::vector<RID> BitmapHeapScanExecutor::CollectRids(size_t index_idx) {
+  auto &index_meta = index_metas_[index_idx];
+  std::vector<std::string> col_names;
+  for (auto &col : index_meta.cols) {
+    col_names.push_back(col.name);
+  }
+  auto ih = sm_manager_->ihs_.at(sm_manager_->GetIxManager()->GetIndexName(tab_name_, col_names)).get();
+  Iid lower;
+  Iid upper;
+  IndexScanExecutor::GetScanRange(ih, index_meta, index_conds_[index_idx], &lower, &upper);
+
+  std::vector<RID> rids;
+  IxScan scan(ih, lower, upper, sm_manager_->GetBpm());
+  for (; !scan.IsEnd(); scan.Next()) {
+    rids.push_back(scan.GetRid());
+    // Lock the gaps of the range as IndexScanExecutor does, the rids are rechecked after they are read
+    if (context_ != nullptr) {
+      context_->lock_mgr_->LockGapOnIndex(context_->txn_, scan.GetIid(), fh_->GetFd());
+    }
+  }
+  // lock the gap of next key
+  if (context_ != nullptr) {
+    context_->lock_mgr_->LockGapOnIndex(context_->txn_, scan.GetIid(), fh_->GetFd());
+  }
+  std::sort(rids.begin(), rids.end());
+  return rids;
+}
+
+void BitmapHeapScanExecutor::FetchNextPage() {
+  tuples_.clear();
+  tuple_idx_ = 0;
+  page_begin_ = next_page_begin_;
+  if (page_begin_ == rids_.size()) {
+    return;
+  }
+  page_id_t page_no = rids_[page_begin_].GetPageId();
+  next_page_begin_ = page_begin_;
+  while (next_page_begin_ < rids_.size() && rids_[next_page_begin_].GetPageId() == page_no) {
+    next_page_begin_++;
+  }
+  fh_->GetTuplesOnPage(rids_.data() + page_begin_, next_page_begin_ - page_begin_, context_, &tuples_);
+}
+
+void BitmapHeapScanExecutor::SeekMatch() {
+  while (true) {
+    if (tuple_idx_ == tuples_.size()) {
+      FetchNextPage();
+      if (tuples_.empty()) {
+        return;
+      }
+    }
+    if (predicate(tuples_[tuple_idx_])) {
+      rid_ = rids_[page_begin_ + tuple_idx_];
+      return;
+    }
+    tuple_idx_++;
+  }
+}
+
+// return true only all the conditions were true
+bool BitmapHeapScanExecutor::predicate(const Tuple &tuple) {
+  for (auto &cond : conds_) {
+    Value lhs_v = tuple.GetValue(&schema_, cond.lhs_col.col_name);
+    // an IN list is compared with rhs_in_col
+    Value rhs_v = cond.is_rhs_val || cond.op == OP_IN ? cond.rhs_val : tuple.GetValue(&schema_, cond.rhs_col.col_name);
+    if (!cond.satisfy(lhs_v, rhs_v)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace easydb
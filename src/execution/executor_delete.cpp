@@ -37,12 +37,16 @@ std::unique_ptr<Tuple> DeleteExecutor::Next() {
   for (int i = 0; i < rid_size; i++) {
     RID rid = rids_[i];
 
+    // Lock the record before reading its before-image, see UpdateExecutor::Next
+    if (context_ != nullptr) {
+      context_->lock_mgr_->LockExclusiveOnRecord(context_->txn_, rid, fh_->GetFd());
+    }
+
     // get records
     auto rec = fh_->GetTupleValue(rid, context_);
 
     // delete corresponding index
     for (auto index : tab_.indexes) {
-      auto ih = sm_manager_->ihs_.at(sm_manager_->GetIxManager()->GetIndexName(tab_name_, index.cols)).get();
       auto key_schema = Schema::CopySchema(&tab_.schema, index.col_ids);
       auto key_tuple = fh_->GetKeyTuple(tab_.schema, key_schema, index.col_ids, rid, context_);
       std::vector<char> key(index.col_tot_len);
@@ -54,10 +58,10 @@ std::unique_ptr<Tuple> DeleteExecutor::Next() {
       }
       // Wait for GAP lock first
       if (context_ != nullptr) {
-        Iid lower = ih->LowerBound(key.data());
+        Iid lower = sm_manager_->GetIndexGap(tab_name_, index, key.data());
         context_->lock_mgr_->HandleIndexGapWaitDie(context_->txn_, lower, fh_->GetFd());
       }
-      ih->DeleteEntry(key.data(), context_->txn_);
+      sm_manager_->DeleteIndexEntry(tab_name_, index, key.data(), context_->txn_);
     }
 
     // delete records
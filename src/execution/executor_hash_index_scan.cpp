@@ -0,0 +1,105 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * executor_hash_index_scan.cpp
+ *
+ * Identification: src/execution/executor_hash_index_scan.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "execution/executor_hash_index_scan.h"
+
+#include <cassert>
+#include <map>
+
+namespace easydb {
+
+HashIndexScanExecutor::HashIndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
+                                             std::vector<std::string> index_col_names, Context *context) {
+  sm_manager_ = sm_manager;
+  context_ = context;
+  tab_name_ = std::move(tab_name);
+  tab_ = sm_manager_->db_.get_table(tab_name_);
+  conds_ = std::move(conds);
+  index_col_names_ = std::move(index_col_names);
+  index_meta_ = *tab_.get_index_meta(index_col_names_);
+  fh_ = sm_manager_->fhs_.at(tab_name_).get();
+  schema_ = tab_.schema;
+  len_ = schema_.GetInlinedStorageSize();
+
+  std::map<CompOp, CompOp> swap_op = {
+      {OP_EQ, OP_EQ}, {OP_NE, OP_NE}, {OP_LT, OP_GT}, {OP_GT, OP_LT}, {OP_LE, OP_GE}, {OP_GE, OP_LE},
+  };
+  for (auto &cond : conds_) {
+    if (cond.lhs_col.tab_name != tab_name_) {
+      // lhs is on other table, now rhs must be on this table
+      assert(!cond.is_rhs_val && cond.rhs_col.tab_name == tab_name_);
+      std::swap(cond.lhs_col, cond.rhs_col);
+      cond.op = swap_op.at(cond.op);
+    }
+  }
+
+  // lock table
+  if (context_ != nullptr) {
+    context_->lock_mgr_->LockISOnTable(context_->txn_, fh_->GetFd());
+  }
+}
+
+void HashIndexScanExecutor::beginTuple() {
+  for (auto &cond : conds_) {
+    subquery_fill_cond(&cond);
+  }
+  // 1. 由索引列上的等值条件构造key
+  std::string key(index_meta_.col_tot_len, '\0');
+  int offset = 0;
+  for (auto &col : index_meta_.cols) {
+    auto cond = std::find_if(conds_.begin(), conds_.end(), [&](const Condition &cond) {
+      return cond.is_rhs_val && cond.op == OP_EQ && cond.lhs_col.col_name == col.name;
+    });
+    assert(cond != conds_.end());
+    ix_memcpy(key.data() + offset, cond->rhs_val, col.len);
+    offset += col.len;
+  }
+
+  // 2. 锁住key本身，防止其他事务插入或删除该key（幻读），再查找
+  auto ih = sm_manager_->hash_ihs_.at(sm_manager_->GetIxManager()->GetIndexName(tab_name_, index_col_names_)).get();
+  if (context_ != nullptr) {
+    context_->lock_mgr_->LockGapOnIndex(context_->txn_, ih->GetKeyLock(key.data()), fh_->GetFd());
+  }
+  rids_.clear();
+  ih->GetValue(key.data(), &rids_);
+  rid_idx_ = 0;
+  SeekMatch();
+}
+
+void HashIndexScanExecutor::nextTuple() {
+  rid_idx_++;
+  SeekMatch();
+}
+
+void HashIndexScanExecutor::SeekMatch() {
+  for (; rid_idx_ < rids_.size(); ++rid_idx_) {
+    rid_ = rids_[rid_idx_];
+    tuple_ = fh_->GetTupleValue(rid_, context_);
+    if (predicate(*tuple_)) {
+      return;
+    }
+  }
+}
+
+// return true only all the conditions were true
+bool HashIndexScanExecutor::predicate(const Tuple &tuple) {
+  for (auto &cond : conds_) {
+    Value lhs_v = tuple.GetValue(&schema_, cond.lhs_col.col_name);
+    // an IN list is compared with rhs_in_col
+    Value rhs_v = cond.is_rhs_val || cond.op == OP_IN ? cond.rhs_val : tuple.GetValue(&schema_, cond.rhs_col.col_name);
+    if (!cond.satisfy(lhs_v, rhs_v)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace easydb
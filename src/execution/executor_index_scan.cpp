@@ -10,8 +10,10 @@
  */
 
 #include "execution/executor_index_scan.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <string>
 #include <vector>
 #include "type/type.h"
 #include "type/type_id.h"
@@ -19,7 +21,7 @@
 namespace easydb {
 
 IndexScanExecutor::IndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
-                                     std::vector<std::string> index_col_names, Context *context) {
+                                     std::vector<std::string> index_col_names, Context *context, bool index_only) {
   sm_manager_ = sm_manager;
   context_ = context;
   tab_name_ = std::move(tab_name);
@@ -29,6 +31,9 @@ IndexScanExecutor::IndexScanExecutor(SmManager *sm_manager, std::string tab_name
   index_col_names_ = index_col_names;
   index_meta_ = *(tab_.get_index_meta(index_col_names_));
   fh_ = sm_manager_->fhs_.at(tab_name_).get();
+  // 乐观事务在读集中记录记录的版本，版本只在堆表中，仍然回表
+  index_only_ = index_only && (context_ == nullptr || context_->txn_ == nullptr || !context_->txn_->IsOptimistic());
+  entry_buf_.resize(index_meta_.col_tot_len + index_meta_.GetIncludeLen());
 
   // cols_ = tab_.cols;
   schema_ = tab_.schema;
@@ -38,8 +43,6 @@ IndexScanExecutor::IndexScanExecutor(SmManager *sm_manager, std::string tab_name
       {OP_EQ, OP_EQ}, {OP_NE, OP_NE}, {OP_LT, OP_GT}, {OP_GT, OP_LT}, {OP_LE, OP_GE}, {OP_GE, OP_LE},
   };
 
-  std::vector<std::string> cond_cols;
-  std::unordered_set<std::string> cond_cols_set;
   for (auto &cond : conds_) {
     if (cond.lhs_col.tab_name != tab_name_) {
       // lhs is on other table, now rhs must be on this table
@@ -48,15 +51,6 @@ IndexScanExecutor::IndexScanExecutor(SmManager *sm_manager, std::string tab_name
       std::swap(cond.lhs_col, cond.rhs_col);
       cond.op = swap_op.at(cond.op);
     }
-    cond_cols.emplace_back(cond.lhs_col.col_name);
-    cond_cols_set.emplace(cond.lhs_col.col_name);
-  }
-  // Now we just check columns of conditions must be the same as the index.
-  // Actually, parts of columns can use the index.
-  // TODO: support more complex conditions
-  std::vector<std::string> cond_cols_vec(cond_cols_set.begin(), cond_cols_set.end());
-  if (tab_.is_index(cond_cols_vec)) {
-    fed_conds_ = conds_;
   }
 
   // lock table
@@ -68,148 +62,230 @@ IndexScanExecutor::IndexScanExecutor(SmManager *sm_manager, std::string tab_name
 }
 
 void IndexScanExecutor::beginTuple() {
-  // 找到索引的lower bound和upper bound (遍历cond)
-  // 初始化scan_ 并扫描
-  // 找到第一个满足条件的记录
-  // std::cout << "IndexScanExecutor beginTuple" << std::endl;
-  // 1. Determine the lower and upper bounds for the index scan based on the conditions
-  auto index_name = sm_manager_->GetIxManager()->GetIndexName(tab_name_, index_col_names_);
-  auto ih = sm_manager_->ihs_.at(index_name).get();
-  Iid lower = ih->LeafBegin();
-  Iid upper = ih->LeafEnd();
-  // Initialize key buffer
-  char *key_lower = new char[index_meta_.col_tot_len];
-  char *key_upper = new char[index_meta_.col_tot_len];
-  memset(key_lower, 0, index_meta_.col_tot_len);
-  memset(key_upper, 0xFF, index_meta_.col_tot_len);
-  // char *key = new char[index_meta_.col_tot_len];
-  // memset(key, 0, index_meta_.col_tot_len);
-  // Precompute offsets and lengths for each column in the index
-  std::unordered_map<std::string, std::pair<int, int>> col_off_lens;
-  int offset = 0;
-  for (const auto &col : index_meta_.cols) {
-    col_off_lens[col.name] = {offset, col.len};
-    offset += col.len;
-  }
-  // Determine the bounds based on conditions
-  for (const auto &cond : fed_conds_) {
-    auto [offset, len] = col_off_lens[cond.lhs_col.col_name];
-    // auto index_col = *tab_.get_col(cond.lhs_col.col_name);
-    // memcpy(key + offset, cond.rhs_val.raw->data, len);
-    switch (cond.op) {
-      case OP_EQ:
-        // lower = ih->lower_bound(key);
-        // upper = ih->upper_bound(key);
-        if (cond.rhs_val.GetTypeId() == TYPE_CHAR || cond.rhs_val.GetTypeId() == TYPE_VARCHAR) {
-          memcpy(key_lower + offset, cond.rhs_val.GetData(), len);
-          memcpy(key_upper + offset, cond.rhs_val.GetData(), len);
-        } else {
-          assert(uint32_t(len) == Type(cond.rhs_val.GetTypeId()).GetTypeSize(cond.rhs_val.GetTypeId()));
-          cond.rhs_val.SerializeTo(key_lower + offset);
-          cond.rhs_val.SerializeTo(key_upper + offset);
-        }
-        lower = ih->LowerBound(key_lower);
-        upper = ih->UpperBound(key_upper);
-        break;
-      case OP_GE:
-        // lower = ih->lower_bound(key);
-        if (cond.rhs_val.GetTypeId() == TYPE_CHAR || cond.rhs_val.GetTypeId() == TYPE_VARCHAR) {
-          memcpy(key_lower + offset, cond.rhs_val.GetData(), len);
-        } else {
-          assert(uint32_t(len) == Type(cond.rhs_val.GetTypeId()).GetTypeSize(cond.rhs_val.GetTypeId()));
-          cond.rhs_val.SerializeTo(key_lower + offset);
-        }
-        lower = ih->LowerBound(key_lower);
-        break;
-      case OP_GT:
-        // lower = ih->upper_bound(key);
-        if (cond.rhs_val.GetTypeId() == TYPE_CHAR || cond.rhs_val.GetTypeId() == TYPE_VARCHAR) {
-          memcpy(key_lower + offset, cond.rhs_val.GetData(), len);
-        } else {
-          assert(uint32_t(len) == Type(cond.rhs_val.GetTypeId()).GetTypeSize(cond.rhs_val.GetTypeId()));
-          cond.rhs_val.SerializeTo(key_lower + offset);
-        }
-        lower = ih->UpperBound(key_lower);
-        break;
-      case OP_LE:
-        // upper = ih->upper_bound(key);
-        if (cond.rhs_val.GetTypeId() == TYPE_CHAR || cond.rhs_val.GetTypeId() == TYPE_VARCHAR) {
-          memcpy(key_upper + offset, cond.rhs_val.GetData(), len);
-        } else {
-          assert(uint32_t(len) == Type(cond.rhs_val.GetTypeId()).GetTypeSize(cond.rhs_val.GetTypeId()));
-          cond.rhs_val.SerializeTo(key_upper + offset);
-        }
-        upper = ih->UpperBound(key_upper);
-        break;
-      case OP_LT:
-        // upper = ih->lower_bound(key);
-        if (cond.rhs_val.GetTypeId() == TYPE_CHAR || cond.rhs_val.GetTypeId() == TYPE_VARCHAR) {
-          memcpy(key_upper + offset, cond.rhs_val.GetData(), len);
-        } else {
-          assert(uint32_t(len) == Type(cond.rhs_val.GetTypeId()).GetTypeSize(cond.rhs_val.GetTypeId()));
-          cond.rhs_val.SerializeTo(key_upper + offset);
-        }
-        upper = ih->LowerBound(key_upper);
-        break;
-      default:
-        break;
+  // 1. Determine the key ranges of the index scan based on the conditions on the index columns,
+  // an IN list gives one range per value, e.g. WHERE id IN (...)
+  fed_conds_.clear();
+  for (auto &cond : conds_) {
+    subquery_fill_cond(&cond);
+    bool on_index = std::any_of(index_meta_.cols.begin(), index_meta_.cols.end(),
+                                [&](const ColMeta &col) { return col.name == cond.lhs_col.col_name; });
+    if (on_index && ((cond.is_rhs_val && cond.op != OP_NE) || cond.op == OP_IN)) {
+      fed_conds_.push_back(cond);
     }
   }
+  auto index_name = sm_manager_->GetIxManager()->GetIndexName(tab_name_, index_col_names_);
+  ih_ = sm_manager_->ihs_.at(index_name).get();
+  auto key_ranges = GetKeyRanges(index_meta_, fed_conds_);
 
-  // 2. Initialize the index scan
-  scan_ = std::make_unique<IxScan>(ih, lower, upper, sm_manager_->GetBpm());
-
-  // 3. Find the first tuple that satisfies the conditions
-  while (!IsEnd()) {
-    rid_ = scan_->GetRid();
-    // Note: There maybe some not satisfied records in the index scan,
-    // because the lower and upper bounds may not correct in some cases,
-    // eg. when using a multiple-column index.
-    if (predicate()) {
-      break;
-    }
-    scan_->Next();
+  // 2. Locate the ranges in key order, a range on the leaf where the previous one ends is found without descending
+  ranges_.clear();
+  for (auto &key_range : key_ranges) {
+    Iid lower;
+    Iid upper;
+    SeekKeyRange(ih_, key_range, ranges_.empty() ? nullptr : &ranges_.back().second, &lower, &upper);
+    ranges_.emplace_back(lower, upper);
   }
 
-  // Lock the gap between lower and upper bounds
+  // 3. Lock the gaps of every range, including the gap of the key after the range
   if (context_ != nullptr) {
-    // The reason do before check IsEnd() is that we need to lock the gap of next key
-    // when the current key is the last one in the index or the lower=upper.
-    auto iid = scan_->GetIid();
-    auto lower_iid = iid;
-    context_->lock_mgr_->LockGapOnIndex(context_->txn_, iid, fh_->GetFd());
-    // lock the gap of next key
-    while (!IsEnd()) {
-      scan_->Next();
-      iid = scan_->GetIid();
-      context_->lock_mgr_->LockGapOnIndex(context_->txn_, iid, fh_->GetFd());
+    for (auto &[lower, upper] : ranges_) {
+      IxScan scan(ih_, lower, upper, sm_manager_->GetBpm());
+      context_->lock_mgr_->LockGapOnIndex(context_->txn_, scan.GetIid(), fh_->GetFd());
+      while (!scan.IsEnd()) {
+        scan.Next();
+        context_->lock_mgr_->LockGapOnIndex(context_->txn_, scan.GetIid(), fh_->GetFd());
+      }
     }
-    // reset the lower bound to the first record
-    scan_->set_lower(lower_iid);
   }
 
-  delete[] key_lower;
-  delete[] key_upper;
+  // 4. Find the first tuple that satisfies the conditions
+  range_idx_ = 0;
+  if (!ranges_.empty()) {
+    scan_ = std::make_unique<IxScan>(ih_, ranges_[0].first, ranges_[0].second, sm_manager_->GetBpm());
+  }
+  SeekMatch();
 }
 
 void IndexScanExecutor::nextTuple() {
-  // TODO:
-  // 使用scan_ 找到下一个满足条件的记录
-  // std::cout << "IndexScanExecutor nextTuple" << std::endl;
   scan_->Next();
-  // Note that scan_->next() may out of range
-  while (!IsEnd()) {
+  SeekMatch();
+}
+
+void IndexScanExecutor::SeekMatch() {
+  while (range_idx_ < ranges_.size()) {
+    if (scan_->IsEnd()) {
+      if (++range_idx_ < ranges_.size()) {
+        auto &[lower, upper] = ranges_[range_idx_];
+        scan_ = std::make_unique<IxScan>(ih_, lower, upper, sm_manager_->GetBpm());
+      }
+      continue;
+    }
     rid_ = scan_->GetRid();
     // Note: There maybe some not satisfied records in the index scan,
     // because the lower and upper bounds may not correct in some cases,
     // eg. when using a multiple-column index.
     if (predicate()) {
-      break;
+      return;
     }
     scan_->Next();
   }
 }
 
+void IndexScanExecutor::GetScanRange(IxIndexHandle *ih, const IndexMeta &index_meta,
+                                     const std::vector<Condition> &conds, Iid *lower, Iid *upper) {
+  auto key_ranges = GetKeyRanges(index_meta, conds);
+  if (key_ranges.empty()) {
+    // the conditions contradict each other
+    *lower = ih->LeafEnd();
+    *upper = *lower;
+    return;
+  }
+  SeekKeyRange(ih, key_ranges.front(), nullptr, lower, upper);
+}
+
+std::vector<IxKeyRange> IndexScanExecutor::GetKeyRanges(const IndexMeta &index_meta,
+                                                        const std::vector<Condition> &conds) {
+  // Precompute offsets and lengths for each column in the index
+  std::unordered_map<std::string, std::pair<int, int>> col_off_lens;
+  int offset = 0;
+  for (const auto &col : index_meta.cols) {
+    col_off_lens[col.name] = {offset, col.len};
+    offset += col.len;
+  }
+  auto on_index = [&](const Condition &cond) { return col_off_lens.count(cond.lhs_col.col_name) > 0; };
+
+  // Every combination of the values of the IN lists is a range
+  std::vector<const Condition *> in_conds;
+  size_t num_ranges = 1;
+  for (const auto &cond : conds) {
+    if (cond.op == OP_IN && on_index(cond)) {
+      in_conds.push_back(&cond);
+      num_ranges = std::min(num_ranges * cond.rhs_in_col.size(), MAX_KEY_RANGES + 1);
+    }
+  }
+  bool use_in = num_ranges <= MAX_KEY_RANGES;
+  if (!use_in) {
+    num_ranges = 1;
+  }
+
+  std::vector<IxKeyRange> ranges;
+  std::vector<size_t> value_idx(in_conds.size(), 0);  // the value of each IN list in the current combination
+  for (size_t n = 0; n < num_ranges; ++n) {
+    IxKeyRange range;
+    range.lower.assign(index_meta.col_tot_len, '\0');
+    range.upper.assign(index_meta.col_tot_len, '\xFF');
+    // Determine the bounds based on conditions, the last condition on a bound decides whether it is open
+    size_t in_idx = 0;
+    for (const auto &cond : conds) {
+      if (!on_index(cond) || (!cond.is_rhs_val && cond.op != OP_IN)) {
+        continue;
+      }
+      auto [offset, len] = col_off_lens.at(cond.lhs_col.col_name);
+      CompOp op = cond.op;
+      const Value *val = &cond.rhs_val;
+      if (op == OP_IN) {
+        if (!use_in) {
+          continue;
+        }
+        op = OP_EQ;
+        val = &in_conds[in_idx]->rhs_in_col[value_idx[in_idx]];
+        in_idx++;
+      }
+      if (op == OP_EQ || op == OP_GE || op == OP_GT) {
+        ix_memcpy(range.lower.data() + offset, *val, len);
+        range.has_lower = true;
+        range.lower_open = op == OP_GT;
+      }
+      if (op == OP_EQ || op == OP_LE || op == OP_LT) {
+        ix_memcpy(range.upper.data() + offset, *val, len);
+        range.has_upper = true;
+        range.upper_open = op == OP_LT;
+      }
+    }
+    // next combination
+    for (size_t i = 0; i < value_idx.size(); ++i) {
+      if (++value_idx[i] < in_conds[i]->rhs_in_col.size()) {
+        break;
+      }
+      value_idx[i] = 0;
+    }
+    if (range.has_lower && range.has_upper) {
+      int cmp = memcmp(range.lower.data(), range.upper.data(), index_meta.col_tot_len);
+      if (cmp > 0 || (cmp == 0 && (range.lower_open || range.upper_open))) {
+        continue;
+      }
+    }
+    ranges.push_back(std::move(range));
+  }
+
+  // Sort the ranges by their lower bounds and merge the overlapping ones, e.g. the same value twice in an IN list
+  std::sort(ranges.begin(), ranges.end(), [](const IxKeyRange &a, const IxKeyRange &b) {
+    int cmp = a.lower.compare(b.lower);
+    return cmp != 0 ? cmp < 0 : (!a.lower_open && b.lower_open);
+  });
+  std::vector<IxKeyRange> merged;
+  for (auto &range : ranges) {
+    if (!merged.empty()) {
+      auto &last = merged.back();
+      int cmp = range.lower.compare(last.upper);
+      if (!last.has_upper || !range.has_lower || cmp < 0 || (cmp == 0 && !range.lower_open && !last.upper_open)) {
+        if (!range.has_upper) {
+          last.has_upper = false;
+        } else if (last.has_upper) {
+          cmp = range.upper.compare(last.upper);
+          if (cmp > 0 || (cmp == 0 && !range.upper_open)) {
+            last.upper = std::move(range.upper);
+            last.upper_open = range.upper_open;
+          }
+        }
+        continue;
+      }
+    }
+    merged.push_back(std::move(range));
+  }
+  return merged;
+}
+
+void IndexScanExecutor::SeekKeyRange(IxIndexHandle *ih, const IxKeyRange &range, const Iid *from, Iid *lower,
+                                     Iid *upper) {
+  if (!range.has_lower) {
+    *lower = ih->LeafBegin();
+  } else if (from == nullptr || !ih->BoundInLeaf(*from, range.lower.data(), range.lower_open, lower)) {
+    *lower = range.lower_open ? ih->UpperBound(range.lower.data()) : ih->LowerBound(range.lower.data());
+  }
+  if (!range.has_upper) {
+    *upper = ih->LeafEnd();
+  } else if (!ih->BoundInLeaf(*lower, range.upper.data(), !range.upper_open, upper)) {
+    *upper = range.upper_open ? ih->LowerBound(range.upper.data()) : ih->UpperBound(range.upper.data());
+  }
+}
+
+std::unique_ptr<Tuple> IndexScanExecutor::NextFromIndex() {
+  // 与回表相同，读记录前加记录上的S锁
+  if (context_ != nullptr) {
+    context_->lock_mgr_->LockSharedOnRecord(context_->txn_, rid_, fh_->GetFd());
+  }
+  scan_->GetEntry(entry_buf_.data());
+  std::vector<Value> values;
+  values.reserve(schema_.GetColumnCount());
+  for (uint32_t i = 0; i < schema_.GetColumnCount(); ++i) {
+    values.emplace_back(schema_.GetColumn(i).GetType());
+  }
+  int offset = 0;
+  for (int i = 0; i < index_meta_.col_num; ++i) {
+    auto &col = index_meta_.cols[i];
+    values[index_meta_.col_ids[i]] = ix_value(entry_buf_.data() + offset, col.type, col.len);
+    offset += col.len;
+  }
+  for (size_t i = 0; i < index_meta_.include_cols.size(); ++i) {
+    auto &col = index_meta_.include_cols[i];
+    int len = ix_include_col_len(col.type, col.len);
+    values[index_meta_.include_ids[i]] = ix_include_value(entry_buf_.data() + offset, col.type, len);
+    offset += 1 + len;
+  }
+  return std::make_unique<Tuple>(std::move(values), &schema_);
+}
+
 // return true only all the conditions were true
 bool IndexScanExecutor::predicate() {
   // std::cout << "IndexScanExecutor predicate" << std::endl;
@@ -223,7 +299,7 @@ bool IndexScanExecutor::predicate() {
     // lhs_v.DeserializeFrom(tuple.GetData(), &schema_, cond.lhs_col.col_name);
     if (cond.is_rhs_val) {
       rhs_v = cond.rhs_val;
-    } else {
+    } else if (cond.op != OP_IN) {
       rhs_v = tuple.GetValue(&schema_, cond.rhs_col.col_name);
       // rhs_v.DeserializeFrom(tuple.GetData(), &schema_, cond.rhs_col.col_name);
     }
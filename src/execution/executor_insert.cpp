@@ -12,6 +12,7 @@
 #include "execution/executor_insert.h"
 #include <sys/stat.h>
 #include <vector>
+#include "record/rm_bulk_appender.h"
 
 namespace easydb {
 
@@ -33,7 +34,27 @@ InsertExecutor::InsertExecutor(SmManager *sm_manager, const std::string &tab_nam
   }
 };
 
+InsertExecutor::InsertExecutor(SmManager *sm_manager, const std::string &tab_name,
+                               std::vector<std::vector<Value>> rows, Context *context) {
+  sm_manager_ = sm_manager;
+  tab_ = sm_manager_->db_.get_table(tab_name);
+  rows_ = std::move(rows);
+  is_bulk_ = true;
+  tab_name_ = tab_name;
+  fh_ = sm_manager_->fhs_.at(tab_name).get();
+  context_ = context;
+
+  // The new pages are filled without record locks, nobody else may read or write the table meanwhile
+  if (context_ != nullptr) {
+    context_->lock_mgr_->LockExclusiveOnTable(context_->txn_, fh_->GetFd());
+  }
+}
+
 std::unique_ptr<Tuple> InsertExecutor::Next() {
+  if (is_bulk_) {
+    InsertRows();
+    return nullptr;
+  }
   // Construct the tuple
   Tuple tuple{values_, &tab_.schema};
   // Keep the key to avoid copy again when insert into index
@@ -41,27 +62,17 @@ std::unique_ptr<Tuple> InsertExecutor::Next() {
   // Wait for GAP lock first
   if (context_ != nullptr) {
     for (auto index : tab_.indexes) {
-      auto ih = sm_manager_->ihs_.at(sm_manager_->GetIxManager()->GetIndexName(tab_name_, index.cols)).get();
-      auto key_schema = Schema::CopySchema(&tab_.schema, index.col_ids);
-      auto key_tuple = tuple.KeyFromTuple(tab_.schema, key_schema, index.col_ids);
-      std::vector<char> key(index.col_tot_len);
-      int offset = 0;
-      for (int i = 0; i < index.col_num; ++i) {
-        auto val = key_tuple.GetValue(&key_schema, i);
-        // memcpy(key + offset, rec.data + index.cols[i].offset, index.cols[i].len);
-        ix_memcpy(key.data() + offset, val, index.cols[i].len);
-        offset += index.cols[i].len;
-      }
+      auto key = MakeKey(tuple, index);
       keys.emplace_back(key);
       // wait
-      Iid lower = ih->LowerBound(key.data());
+      Iid lower = sm_manager_->GetIndexGap(tab_name_, index, key.data());
       context_->lock_mgr_->HandleIndexGapWaitDie(context_->txn_, lower, fh_->GetFd());
     }
   }
   // Now we can insert the record into the file and index safely
 
   // Insert into record file
-  auto rid = fh_->InsertTuple(TupleMeta{0, false}, tuple, context_);
+  auto rid = fh_->InsertTuple(TupleMeta{context_->txn_->GetWriteVersion(), false}, tuple, context_);
   // auto page_id = rid->GetPageId();
   // auto slot_num = rid->GetSlotNum();
   rid_ = RID{rid->GetPageId(), rid->GetSlotNum()};
@@ -71,12 +82,9 @@ std::unique_ptr<Tuple> InsertExecutor::Next() {
   int index_len = tab_.indexes.size();
   for (auto i = 0; i < index_len; ++i) {
     auto index = tab_.indexes[i];
-    auto ih = sm_manager_->ihs_.at(sm_manager_->GetIxManager()->GetIndexName(tab_name_, index.cols)).get();
     auto key = keys[i];
 
-    auto is_insert = ih->InsertEntry(key.data(), rid_, context_->txn_);
-
-    if (is_insert == -1) {
+    if (!sm_manager_->InsertIndexEntry(tab_name_, index, key.data(), rid_, context_->txn_)) {
       fh_->DeleteTuple(rid_, context_);
       std::vector<std::string> col_names;
       for (auto col : index.cols) {
@@ -95,4 +103,68 @@ std::unique_ptr<Tuple> InsertExecutor::Next() {
   return nullptr;
 }
 
+void InsertExecutor::InsertRows() {
+  auto is_numeric = [](ColType type) {
+    return type == TYPE_INT || type == TYPE_LONG || type == TYPE_FLOAT || type == TYPE_DOUBLE;
+  };
+  // Called once a page is installed: index its tuples, and on a duplicate key delete the tuples not indexed yet, the
+  // tuples before them have their write records and are removed by the rollback
+  auto on_install = [&](page_id_t page_no, const std::vector<Tuple> &tuples) {
+    for (size_t slot_no = 0; slot_no < tuples.size(); ++slot_no) {
+      RID rid{page_no, static_cast<slot_id_t>(slot_no)};
+      for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+        auto &index = tab_.indexes[i];
+        if (sm_manager_->InsertIndexEntry(tab_name_, index, MakeKey(tuples[slot_no], index).data(), rid,
+                                          context_->txn_)) {
+          continue;
+        }
+        for (size_t j = 0; j < i; ++j) {
+          auto &done = tab_.indexes[j];
+          sm_manager_->DeleteIndexEntry(tab_name_, done, MakeKey(tuples[slot_no], done).data(), context_->txn_);
+        }
+        for (size_t rest = slot_no; rest < tuples.size(); ++rest) {
+          fh_->DeleteTuple(RID{page_no, static_cast<slot_id_t>(rest)}, context_);
+        }
+        sm_manager_->UpdateTableCount(tab_name_, static_cast<int>(slot_no));
+        std::vector<std::string> col_names;
+        for (auto col : index.cols) {
+          col_names.emplace_back(col.name);
+        }
+        throw IndexExistsError(tab_name_, col_names);
+      }
+      context_->txn_->AppendWriteRecord(new WriteRecord(WType::INSERT_TUPLE, tab_name_, rid));
+    }
+    sm_manager_->UpdateTableCount(tab_name_, static_cast<int>(tuples.size()));
+  };
+
+  RmBulkAppender appender(fh_, on_install);
+  for (auto &values : rows_) {
+    if (values.size() != tab_.cols.size()) {
+      throw InvalidValueCountError();
+    }
+    // Numbers are converted to the type of the column, like the comparisons do
+    for (size_t i = 0; i < values.size(); ++i) {
+      auto col_type = tab_.cols[i].type;
+      if (values[i].IsNull()) {
+        values[i] = Value(col_type);
+      } else if (values[i].GetTypeId() != col_type) {
+        if (is_numeric(values[i].GetTypeId()) != is_numeric(col_type)) {
+          throw IncompatibleTypeError(coltype2str(col_type), coltype2str(values[i].GetTypeId()));
+        }
+        if (is_numeric(col_type)) {
+          values[i] = values[i].CastAs(col_type);
+        }
+      }
+    }
+    appender.Append(TupleMeta{context_->txn_->GetWriteVersion(), false}, Tuple{values, &tab_.schema});
+  }
+  appender.Finish();
+}
+
+auto InsertExecutor::MakeKey(const Tuple &tuple, const IndexMeta &index) const -> std::vector<char> {
+  // the key is followed by the INCLUDE columns of the index
+  auto entry = index.MakeEntry([&](uint32_t col_id) { return tuple.GetValue(&tab_.schema, col_id); });
+  return std::vector<char>(entry.begin(), entry.end());
+}
+
 }  // namespace easydb
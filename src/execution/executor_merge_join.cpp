@@ -49,8 +49,8 @@ MergeJoinExecutor::MergeJoinExecutor(std::unique_ptr<AbstractExecutor> left, std
   if (!use_index_) {
     left_size_ = left_->schema().GetPhysicalSize();
     right_size_ = right_->schema().GetPhysicalSize();
-    leftSorter_ = std::make_unique<MergeSorter>(left_sel_colu_, left_->schema().GetColumns(), left_size_, false);
-    rightSorter_ = std::make_unique<MergeSorter>(right_sel_colu_, right_->schema().GetColumns(), right_size_, false);
+    leftSorter_ = std::make_unique<MergeSorter>(left_sel_colu_, left_->schema(), left_size_, false);
+    rightSorter_ = std::make_unique<MergeSorter>(right_sel_colu_, right_->schema(), right_size_, false);
   }
 
   current_left_data_ = new char[left_size_];
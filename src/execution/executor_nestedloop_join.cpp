@@ -52,7 +52,7 @@ NestedLoopJoinExecutor::NestedLoopJoinExecutor(std::unique_ptr<AbstractExecutor>
       }
     }
 
-    leftSorter_ = std::make_unique<MergeSorter>(left_sel_colu_, left_->schema().GetColumns(), left_len_, false);
+    leftSorter_ = std::make_unique<MergeSorter>(left_sel_colu_, left_->schema(), left_len_, false);
   }
 }
 
@@ -10,10 +10,12 @@
 
 #include "execution/executor_seq_scan.h"
 
+#include <algorithm>
+
 namespace easydb {
 
 SeqScanExecutor::SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
-                                 Context *context) {
+                                 Context *context, const std::vector<std::string> &proj_cols) {
   sm_manager_ = sm_manager;
   tab_name_ = std::move(tab_name);
   conds_ = std::move(conds);
@@ -28,6 +30,32 @@ SeqScanExecutor::SeqScanExecutor(SmManager *sm_manager, std::string tab_name, st
 
   fed_conds_ = conds_;
 
+  if (!proj_cols.empty()) {
+    auto add_col = [&](const std::string &col_name) {
+      auto col_id = schema_.TryGetColIdx(col_name);
+      if (col_id.has_value() && std::find(col_ids_.begin(), col_ids_.end(), *col_id) == col_ids_.end()) {
+        col_ids_.push_back(*col_id);
+      }
+    };
+    for (auto &col_name : proj_cols) {
+      add_col(col_name);
+    }
+    for (auto &cond : conds_) {
+      add_col(cond.lhs_col.col_name);
+      if (!cond.is_rhs_val && cond.op != OP_IN) {
+        add_col(cond.rhs_col.col_name);
+      }
+    }
+  }
+
+  // Comparisons with constants let the scan skip pages by their zone maps
+  for (auto &cond : conds_) {
+    auto col_id = schema_.TryGetColIdx(cond.lhs_col.col_name);
+    if (cond.is_rhs_val && !cond.is_rhs_stmt && cond.op != OP_IN && col_id.has_value()) {
+      zone_preds_.push_back({*col_id, cond.op, cond.rhs_val});
+    }
+  }
+
   // lock table
   if (context_ != nullptr) {
     context_->lock_mgr_->LockSharedOnTable(context_->txn_, fh_->GetFd());
@@ -35,7 +63,8 @@ SeqScanExecutor::SeqScanExecutor(SmManager *sm_manager, std::string tab_name, st
 }
 
 void SeqScanExecutor::beginTuple() {
-  scan_ = std::make_unique<RmScan>(fh_);
+  // the table S lock taken in the constructor protects the tuples, the scan does not lock every record
+  scan_ = std::make_unique<RmScan>(fh_, context_, col_ids_, zone_preds_);
   rid_ = scan_->GetRid();
   while (!IsEnd() && !predicate()) {
     scan_->Next();
@@ -50,45 +79,32 @@ void SeqScanExecutor::nextTuple() {
   } while (!IsEnd() && !predicate());
 }
 
-std::unique_ptr<Tuple> SeqScanExecutor::Next() { return fh_->GetTupleValue(rid_, context_); }
+// Only the tuples returned are copied out of the page, predicates are evaluated on the view
+std::unique_ptr<Tuple> SeqScanExecutor::Next() { return std::make_unique<Tuple>(scan_->GetTupleView().ToTuple()); }
 
 bool SeqScanExecutor::predicate() {
-  auto tuple = *this->Next();
+  auto tuple = scan_->GetTupleView();
   bool satisfy = true;
   // return true only all the conditions were true
   // i.e. all conditions are connected with 'and' operator
   for (auto &cond : conds_) {
     // check subquery
-    if (cond.is_rhs_stmt && !cond.is_rhs_exe_processed) {
-      std::shared_ptr<AbstractExecutor> rhs_stmt_executor_tree_root =
-          std::static_pointer_cast<AbstractExecutor>(cond.rhs_stmt_exe);
-      std::vector<Value> results = subquery_select_from(rhs_stmt_executor_tree_root, cond.rhs_col);
-      // 进行回填
-      // comparison stmt, sub query should return only one value
-      // Also legal if subquery doesn't use aggregation function, but return only a value.
-      // Check is delayed until plan_query.
-      // Remember to fill in cond.rhs_val real value after carrying executor.
-      if (cond.op != OP_IN) {
-        if (results.size() > 1) {
-          throw SubqueryIllegalError("Result of subquery contains multiple tuples\n");
-        } else if (results.size() == 1) {
-          cond.rhs_val = results[0];
-        } else {
-          throw SubqueryIllegalError("Result of subquery is empty\n");
-        }
-      } else {
-        cond.rhs_in_col = results;
-      }
-      cond.is_rhs_exe_processed = true;
+    subquery_fill_cond(&cond);
+    // A comparison with a null is never true, which the null bitmap tells without reading the value
+    uint32_t lhs_idx = schema_.GetColIdx(cond.lhs_col.col_name);
+    bool has_rhs_col = !cond.is_rhs_val && cond.op != OP_IN;
+    uint32_t rhs_idx = has_rhs_col ? schema_.GetColIdx(cond.rhs_col.col_name) : 0;
+    if (tuple.IsNull(&schema_, lhs_idx) || (has_rhs_col && tuple.IsNull(&schema_, rhs_idx))) {
+      satisfy = false;
+      break;
     }
     Value lhs_v, rhs_v;
-    lhs_v = tuple.GetValue(&schema_, cond.lhs_col.col_name);
+    lhs_v = tuple.GetValue(&schema_, lhs_idx);
 
     if (cond.is_rhs_val) {
       rhs_v = cond.rhs_val;
-    } else if (cond.op != OP_IN) {
-      rhs_v = tuple.GetValue(&schema_, cond.rhs_col.col_name);
-
+    } else if (has_rhs_col) {
+      rhs_v = tuple.GetValue(&schema_, rhs_idx);
     }
     if (!cond.satisfy(lhs_v, rhs_v)) {
       satisfy = false;
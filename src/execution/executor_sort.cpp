@@ -20,7 +20,7 @@ SortExecutor::SortExecutor(std::unique_ptr<AbstractExecutor> prev, TabCol sel_co
   len_ = prev_->tupleLen();
   max_physical_len_ = schema_.GetPhysicalSize();
   current_data_ = new char[max_physical_len_];
-  sorter = std::make_unique<MergeSorter>(colus_, prev_->schema().GetColumns(), max_physical_len_, is_desc_);
+  sorter = std::make_unique<MergeSorter>(colus_, prev_->schema(), max_physical_len_, is_desc_);
 }
 
 SortExecutor::~SortExecutor() { delete[] current_data_; }
@@ -35,6 +35,11 @@ std::unique_ptr<Tuple> UpdateExecutor::Next() {
   int rid_size = rids_.size();
   for (int i = 0; i < rid_size; i++) {
     RID rid = rids_[i];
+    // Lock the record before reading it, the tuple read here is the before-image used for rollback
+    // (OCC txns read the record without locks while scanning, it may have been changed since then)
+    if (context_ != nullptr) {
+      context_->lock_mgr_->LockExclusiveOnRecord(context_->txn_, rid, fh_->GetFd());
+    }
     // get records and construct updated value buf
     auto tuple = fh_->GetTupleValue(rid, context_);
     auto old_values = tuple->GetValueVec(&tab_.schema);
@@ -59,38 +64,34 @@ std::unique_ptr<Tuple> UpdateExecutor::Next() {
     Tuple new_tuple{new_values, &tab_.schema};
 
     // update corresponding index
-    // 1. construct key_d and key_i
+    // 1. construct entry_d and entry_i (the key followed by the INCLUDE columns)
     // 2. delete old index entry and insert new index entry
+    std::vector<std::vector<char>> new_keys;
     for (auto index : tab_.indexes) {
-      auto ih = sm_manager_->ihs_.at(sm_manager_->GetIxManager()->GetIndexName(tab_name_, index.cols)).get();
-      auto ids = index.col_ids;
-      char *key_d = new char[index.col_tot_len];
-      char *key_i = new char[index.col_tot_len];
-      int offset = 0;
-      for (int i = 0; i < index.col_num; ++i) {
-        // memcpy(key_d + offset, rec->data + index.cols[i].offset, index.cols[i].len);
-        // memcpy(key_i + offset, buf.data + index.cols[i].offset, index.cols[i].len);
-        auto id = ids[i];
-        auto val_d = old_values[id];
-        auto val_i = new_values[id];
-        ix_memcpy(key_d + offset, val_d, index.cols[i].len);
-        ix_memcpy(key_i + offset, val_i, index.cols[i].len);
-        offset += index.cols[i].len;
+      auto entry_d = index.MakeEntry([&](uint32_t col_id) { return old_values[col_id]; });
+      auto entry_i = index.MakeEntry([&](uint32_t col_id) { return new_values[col_id]; });
+      const char *key_d = entry_d.data();
+      const char *key_i = entry_i.data();
+      new_keys.emplace_back(entry_i.begin(), entry_i.end());
+      // check if the entry is the same as before
+      if (entry_d == entry_i) {
+        continue;
       }
-      // check if the key is the same as before
+      // the key is the same, only the INCLUDE columns change: replace the entry in place of the old one
       if (memcmp(key_d, key_i, index.col_tot_len) == 0) {
+        sm_manager_->DeleteIndexEntry(tab_name_, index, key_d, context_->txn_);
+        sm_manager_->InsertIndexEntry(tab_name_, index, key_i, rid, context_->txn_);
         continue;
       }
 
       // Wait for GAP lock before insert
       if (context_ != nullptr) {
-        Iid lower = ih->LowerBound(key_i);
+        Iid lower = sm_manager_->GetIndexGap(tab_name_, index, key_i);
         context_->lock_mgr_->HandleIndexGapWaitDie(context_->txn_, lower, fh_->GetFd());
       }
 
       // check if the new key duplicated
-      auto is_insert = ih->InsertEntry(key_i, rid, context_->txn_);
-      if (is_insert == -1) {
+      if (!sm_manager_->InsertIndexEntry(tab_name_, index, key_i, rid, context_->txn_)) {
         std::vector<std::string> col_names;
         for (auto col : index.cols) {
           col_names.emplace_back(col.name);
@@ -100,13 +101,11 @@ std::unique_ptr<Tuple> UpdateExecutor::Next() {
 
       // Wait for GAP lock before delete
       if (context_ != nullptr) {
-        Iid lower = ih->LowerBound(key_d);
+        Iid lower = sm_manager_->GetIndexGap(tab_name_, index, key_d);
         context_->lock_mgr_->HandleIndexGapWaitDie(context_->txn_, lower, fh_->GetFd());
       }
 
-      ih->DeleteEntry(key_d, context_->txn_);
-      delete[] key_d;
-      delete[] key_i;
+      sm_manager_->DeleteIndexEntry(tab_name_, index, key_d, context_->txn_);
     }
 
     // // Log the update operation(before update old value: *rec)
@@ -114,7 +113,11 @@ std::unique_ptr<Tuple> UpdateExecutor::Next() {
 
     // update records
     // fh_->UpdateTupleInPlace(TupleMeta{0, false}, new_tuple, context_);
-    fh_->UpdateTupleInPlace(TupleMeta{0, false}, new_tuple, rid, context_);
+    if (!fh_->UpdateTupleInPlace(TupleMeta{context_->txn_->GetWriteVersion(), false}, new_tuple, rid, context_)) {
+      // The new values do not fit into the sealed (compressed) page of the tuple, move it to another page
+      MoveTuple(rid, *tuple, new_tuple, new_keys);
+      continue;
+    }
 
     // Update context_ for rollback
     WriteRecord *write_record = new WriteRecord(WType::UPDATE_TUPLE, tab_name_, rid, *tuple);
@@ -124,4 +127,27 @@ std::unique_ptr<Tuple> UpdateExecutor::Next() {
   return nullptr;
 }
 
+/**
+ * @description: 更新后的记录放不进原来的页面时，删除原记录并插入新记录，所有索引项指向新记录
+ * @param {RID&} rid 原记录的位置，索引已经按新记录更新，都指向rid
+ * @param {Tuple&} old_tuple 原记录，回滚删除时写回
+ * @param {Tuple&} new_tuple 更新后的记录
+ * @param new_keys 每个索引中新记录的键
+ * @note 回滚时先撤销插入（删除新记录及其索引项），再撤销删除（恢复原记录及其索引项）
+ */
+void UpdateExecutor::MoveTuple(const RID &rid, const Tuple &old_tuple, const Tuple &new_tuple,
+                               const std::vector<std::vector<char>> &new_keys) {
+  fh_->DeleteTuple(rid, context_);
+  context_->txn_->AppendWriteRecord(new WriteRecord(WType::DELETE_TUPLE, tab_name_, rid, old_tuple));
+
+  auto new_rid = *fh_->InsertTuple(TupleMeta{context_->txn_->GetWriteVersion(), false}, new_tuple, context_);
+  context_->txn_->AppendWriteRecord(new WriteRecord(WType::INSERT_TUPLE, tab_name_, new_rid));
+
+  for (size_t i = 0; i < tab_.indexes.size(); ++i) {
+    auto &index = tab_.indexes[i];
+    sm_manager_->DeleteIndexEntry(tab_name_, index, new_keys[i].data(), context_->txn_);
+    sm_manager_->InsertIndexEntry(tab_name_, index, new_keys[i].data(), new_rid, context_->txn_);
+  }
+}
+
 }  // namespace easydb
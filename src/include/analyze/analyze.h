@@ -49,6 +49,9 @@ class Query {
   // 在逻辑优化后确定的表连接顺序（连接重排后使用）
   std::vector<std::string> optimized_table_order;
 
+  // INSERT INTO t SELECT ... 中select语句的查询
+  std::shared_ptr<Query> select_query;
+
   Query() {}
   Query(std::shared_ptr<void> &ptr) {
     auto queryPtr = std::static_pointer_cast<Query>(ptr);
@@ -63,6 +66,7 @@ class Query {
       this->having_conds = queryPtr->having_conds;
       this->is_unique = queryPtr->is_unique;
       this->optimized_table_order = queryPtr->optimized_table_order;
+      this->select_query = queryPtr->select_query;
     }
   }
 };
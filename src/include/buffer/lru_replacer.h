@@ -20,7 +20,6 @@
 #include <list>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -36,6 +35,7 @@ class LinkListNode {
   frame_id_t val_{0};
   LinkListNode *prev_{nullptr};
   LinkListNode *next_{nullptr};
+  bool linked_{false};  // whether the frame is in the list, i.e. evictable
   explicit LinkListNode(frame_id_t Val) : val_(Val) {}
 };
 class LRUReplacer : public Replacer {
@@ -62,8 +62,9 @@ class LRUReplacer : public Replacer {
   void DeleteNode(LinkListNode *curr);
 
  private:
-  // TODO(student): implement me!
-  std::unordered_map<frame_id_t, LinkListNode *> data_idx_;
+  // one list node per frame, allocated up front, so that Pin/Unpin only relink nodes and never allocate
+  std::vector<LinkListNode> nodes_;
+  size_t size_{0};
   LinkListNode *head_{nullptr};
   LinkListNode *tail_{nullptr};
   std::mutex data_latch_;
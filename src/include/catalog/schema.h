@@ -103,6 +103,12 @@ class Schema {
   /** @return the number of bytes used by one tuple */
   inline auto GetInlinedStorageSize() const -> uint32_t { return length_; }
 
+  /** @return the offset of the null bitmap in the tuple, it follows the fixed-size part of the columns */
+  inline auto GetNullBitmapOffset() const -> uint32_t { return null_bitmap_offset_; }
+
+  /** @return the number of bytes of the null bitmap, one bit per column */
+  inline auto GetNullBitmapSize() const -> uint32_t { return (GetColumnCount() + 7) / 8; }
+
   /** @return true if all columns are inlined, false otherwise */
   inline auto IsInlined() const -> bool { return tuple_is_inlined_; }
 
@@ -116,9 +122,12 @@ class Schema {
   void SetPhysicalSize() ;
 
  private:
-  /** Fixed-length column size, i.e. the number of bytes used by one tuple. */
+  /** Fixed-length column size, i.e. the number of bytes used by one tuple, including the null bitmap. */
   uint32_t length_;
 
+  /** Offset of the null bitmap in the tuple. */
+  uint32_t null_bitmap_offset_{0};
+
   uint32_t physical_size_{0};
 
   /** All the columns in the schema, inlined and uninlined. */
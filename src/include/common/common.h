@@ -71,21 +71,31 @@ struct SetClause {
 //   ColMeta col_;
 // };
 
+// the order of sorting: NULL goes before every value, where the NULL sentinels of the fixed-size types used to sort.
+// The comparisons of Value are false whenever one side is NULL, so they are no strict weak ordering by themselves.
+inline bool SortLessThan(const Value &left, const Value &right) {
+  if (left.IsNull() || right.IsNull()) {
+    return left.IsNull() && !right.IsNull();
+  }
+  return left < right;
+}
+
 struct cmpTuple {
-  cmpTuple(bool asce, Column col) : asce_(asce), col_(col) {}
+  cmpTuple(bool asce, const Schema *schema, uint32_t col_idx) : asce_(asce), schema_(schema), col_idx_(col_idx) {}
 
   bool operator()(const Tuple &pl, const Tuple &pr) const {
     Value leftVal, rightVal;
-    leftVal = pl.GetValue(col_);
-    rightVal = pr.GetValue(col_);
+    leftVal = pl.GetValue(schema_, col_idx_);
+    rightVal = pr.GetValue(schema_, col_idx_);
     // leftVal.get_value_from_record(pl, col_);
     // rightVal.get_value_from_record(pr, col_);
-    return !asce_ ? leftVal < rightVal : leftVal > rightVal;
+    return !asce_ ? SortLessThan(leftVal, rightVal) : SortLessThan(rightVal, leftVal);
   }
 
  private:
   bool asce_;
-  Column col_;
+  const Schema *schema_;  // the schema of the tuples, GetValue reads the null bitmap through it
+  uint32_t col_idx_;
 };
 
 }  // namespace easydb
\ No newline at end of file
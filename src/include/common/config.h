@@ -41,6 +41,12 @@ static constexpr int BUFFER_POOL_SIZE = 1024;                                 //
 static constexpr int DEFAULT_DB_IO_SIZE = 16;                                 // starting size of file on disk
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 64;                                        // size of extendible hash bucket
+static constexpr int TXN_MAP_SHARD_NUM = 64;                                  // number of shards of the txn map
+static constexpr int LOCK_WAIT_HISTOGRAM_BUCKETS = 16;                        // buckets of lock wait time histogram
+static constexpr int LOCK_STATS_TOP_N = 10;                                   // hot locks shown in SHOW LOCK_STATS
+static constexpr double AUTO_VACUUM_THRESHOLD = 0.2;                          // dead slot ratio to auto-vacuum a page
+static constexpr int LOAD_MIN_CHUNK_SIZE = 1 << 20;                           // min bytes of csv parsed by a loader
+static constexpr int BITMAP_SCAN_MIN_ROWS = 128;                              // est. rows to sort the rids of a range
 // static constexpr int LRUK_REPLACER_K = 10;                                    // backward k-distance for lru-k
 
 using frame_id_t = int32_t;    // frame id type
@@ -108,6 +108,17 @@ class TableExistsError : public EASYDBError {
   TableExistsError(const std::string &tab_name) : EASYDBError("Table already exists: " + tab_name) {}
 };
 
+class InvalidTableOptionError : public EASYDBError {
+ public:
+  InvalidTableOptionError(const std::string &option_name, const std::string &option_value)
+      : EASYDBError("Invalid table option: " + option_name + " = " + option_value) {}
+};
+
+class InvalidIndexMethodError : public EASYDBError {
+ public:
+  InvalidIndexMethodError(const std::string &method) : EASYDBError("Invalid index method: " + method) {}
+};
+
 class ColumnNotFoundError : public EASYDBError {
  public:
   ColumnNotFoundError(const std::string &col_name) : EASYDBError("Column not found: " + col_name) {}
@@ -26,7 +26,8 @@ class MergeSorter {
   // ColMeta col_;  // the colMeta of the sort key col
   // std::vector<ColMeta> all_cols;
   Column colu_;  // the colMeta of the sort key col
-  std::vector<Column> all_colus_;
+  Schema schema_;     // the schema of the sorted tuples
+  uint32_t col_idx_;  // the position of the sort key col in schema_
 
   bool is_desc_;
   size_t tuple_len_;
@@ -48,9 +49,11 @@ class MergeSorter {
   std::vector<std::string> file_paths;
 
  public:
-  MergeSorter(Column colu, std::vector<Column> colus, size_t tuple_len, bool is_desc) {
+  MergeSorter(Column colu, const Schema &schema, size_t tuple_len, bool is_desc) {
     colu_ = colu;
-    all_colus_ = colus;
+    schema_ = schema;
+    // the sorter of a nested loop join without an equi-join condition is never used, its key col is not in the schema
+    col_idx_ = schema_.TryGetColIdx(colu_.GetName()).value_or(0);
     tuple_len_ = tuple_len;
     is_desc_ = is_desc;
     total_records_count = 0;
@@ -84,7 +87,7 @@ class MergeSorter {
     if (record_tmp_buffer.size() >= BUFFER_MAX_RECORD_COUNT) {
       // buffer is full, sort and write buffer into disk. wait for multi-way merge sorting.
       k++;
-      sort(record_tmp_buffer.begin(), record_tmp_buffer.end(), cmpTuple(is_desc_, colu_));
+      sort(record_tmp_buffer.begin(), record_tmp_buffer.end(), cmpTuple(is_desc_, &schema_, col_idx_));
       std::string fileName = colu_.GetTabName() + "_" + colu_.GetName() + "_" + std::to_string(file_paths.size());
       std::ofstream fd;
       fd.open(fileName, std::ios::out);
@@ -107,7 +110,7 @@ class MergeSorter {
   void clearBuffer() {
     if (!record_tmp_buffer.empty()) {
       k++;
-      sort(record_tmp_buffer.begin(), record_tmp_buffer.end(), cmpTuple(is_desc_, colu_));
+      sort(record_tmp_buffer.begin(), record_tmp_buffer.end(), cmpTuple(is_desc_, &schema_, col_idx_));
       std::string fileName = colu_.GetTabName() + "_" + colu_.GetName() + "_" + std::to_string(file_paths.size());
       std::ofstream fd;
       fd.open(fileName, std::ios::out);
@@ -137,7 +140,7 @@ class MergeSorter {
       uint32_t size = *reinterpret_cast<const uint32_t *>(record);
       fd.read(record + sizeof(int32_t), size);
       tuple_tp.DeserializeFrom(record);
-      tp = tuple_tp.GetValue(colu_);
+      tp = tuple_tp.GetValue(&schema_, col_idx_);
       // tp.get_value_from_record(record, col_);
       merge_record_list.push_back(record);
       merge_value_list.push_back(tp);
@@ -169,7 +172,7 @@ class MergeSorter {
       } else {
         Tuple tuple_tp;
         tuple_tp.DeserializeFrom(record);
-        tp = tuple_tp.GetValue(colu_);
+        tp = tuple_tp.GetValue(&schema_, col_idx_);
         memcpy(merge_record_list[ls[0]], record, tuple_len_ + sizeof(int32_t));
       }
       free(record);
@@ -230,7 +233,9 @@ class MergeSorter {
     ls[0] = s;
   }
 
-  bool cmp(const Value &leftVal, const Value &rightVal) { return !is_desc_ ? leftVal < rightVal : leftVal > rightVal; }
+  bool cmp(const Value &leftVal, const Value &rightVal) {
+    return !is_desc_ ? SortLessThan(leftVal, rightVal) : SortLessThan(rightVal, leftVal);
+  }
 };
 
 }  // namespace easydb
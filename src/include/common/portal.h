@@ -20,7 +20,9 @@ See the Mulan PSL v2 for more details. */
 
 #include <chrono>
 #include "execution/executor_aggregation.h"
+#include "execution/executor_bitmap_heap_scan.h"
 #include "execution/executor_delete.h"
+#include "execution/executor_hash_index_scan.h"
 #include "execution/executor_hash_join.h"
 #include "execution/executor_index_scan.h"
 #include "execution/executor_insert.h"
@@ -108,8 +110,29 @@ class Portal {
           return std::make_shared<PortalStmt>(PORTAL_DML_WITHOUT_SELECT, std::vector<TabCol>(), std::move(root), plan);
         }
         case T_Insert: {
-          std::unique_ptr<AbstractExecutor> root =
-              std::make_unique<InsertExecutor>(sm_manager_, x->tab_name_, x->values_, context);
+          std::unique_ptr<AbstractExecutor> root;
+          if (x->subplan_ != nullptr && x->subplan_->tag == T_Empty) {
+            // the conditions of the select can never hold, e.g. a=1 AND a=2: there is nothing to insert
+            root = std::make_unique<InsertExecutor>(sm_manager_, x->tab_name_, std::vector<std::vector<Value>>(),
+                                                    context);
+          } else if (x->subplan_ != nullptr) {
+            // INSERT INTO t SELECT ...: collect the rows first, like UPDATE and DELETE collect their rids, so that the
+            // select never reads the rows being inserted
+            auto p = std::dynamic_pointer_cast<ProjectionPlan>(x->subplan_);
+            if (p == nullptr) {
+              throw InternalError("INSERT ... SELECT expects a projection plan");
+            }
+            p->SetUnique(x->unique_);
+            std::unique_ptr<AbstractExecutor> select = convert_plan_executor(p, context);
+            const Schema &schema = select->schema();
+            std::vector<std::vector<Value>> rows;
+            for (select->beginTuple(); !select->IsEnd(); select->nextTuple()) {
+              rows.push_back(select->Next()->GetValueVec(&schema));
+            }
+            root = std::make_unique<InsertExecutor>(sm_manager_, x->tab_name_, std::move(rows), context);
+          } else {
+            root = std::make_unique<InsertExecutor>(sm_manager_, x->tab_name_, x->values_, context);
+          }
 
           return std::make_shared<PortalStmt>(PORTAL_DML_WITHOUT_SELECT, std::vector<TabCol>(), std::move(root), plan);
         }
@@ -173,10 +196,17 @@ class Portal {
         }
       }
       if (x->tag == T_SeqScan) {
-        return std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_, context);
+        return std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_, context, x->proj_cols_);
         // return std::make_unique<SeqScanExecutor>(sm_manager_, x->tab_name_, x->conds_);
+      } else if (x->tag == T_BitmapHeapScan) {
+        return std::make_unique<BitmapHeapScanExecutor>(sm_manager_, x->tab_name_, x->conds_,
+                                                        x->bitmap_index_col_names_, context);
+      } else if (x->tag == T_HashIndexScan) {
+        return std::make_unique<HashIndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_,
+                                                       context);
       } else {
-        return std::make_unique<IndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_, context);
+        return std::make_unique<IndexScanExecutor>(sm_manager_, x->tab_name_, x->conds_, x->index_col_names_, context,
+                                                   x->index_only_);
       }
     } else if (auto x = std::dynamic_pointer_cast<JoinPlan>(plan)) {
       std::unique_ptr<AbstractExecutor> left = convert_plan_executor(x->left_, context);
@@ -16,10 +16,14 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <list>
 #include <mutex>
+#include <string>
+#include <vector>
 #include "transaction/transaction.h"
 
 namespace easydb {
@@ -29,6 +33,7 @@ namespace easydb {
 class LockManager {
   /* 加锁类型，包括共享锁、排他锁、意向共享锁、意向排他锁、SIX（意向排他锁+共享锁）、GAP（间隙锁） */
   enum class LockMode { SHARED, EXCLUSIVE, INTENTION_SHARED, INTENTION_EXCLUSIVE, S_IX, GAP };
+  static constexpr int LOCK_MODE_NUM = 6;
 
   /* 用于标识加锁队列中排他性最强的锁类型，例如加锁队列中有SHARED和EXLUSIVE两个加锁操作，则该队列的锁模式为X */
   enum class GroupLockMode { NON_LOCK, IS, IX, S, X, SIX, GAP };
@@ -49,10 +54,39 @@ class LockManager {
     std::list<LockRequest> request_queue_;  // 加锁队列
     std::condition_variable cv_;  // 条件变量，用于唤醒正在等待加锁的申请，在no-wait策略下无需使用
     GroupLockMode group_lock_mode_ = GroupLockMode::NON_LOCK;  // 加锁队列的锁模式
+    uint64_t wait_count_ = 0;    // 该数据项上发生等待的次数，用于找出热点数据项
+    uint64_t die_count_ = 0;     // 该数据项上因wait-die回滚的次数
+    uint64_t wait_time_us_ = 0;  // 该数据项上的总等待时间(微秒)
     // TODO - OPT: 记录first_lock_pos(group_lock_mode_)，优化 wait-die 中的判断
   };
 
  public:
+  /* 锁表中一个已授予的锁，用于SHOW LOCKS */
+  struct LockInfo {
+    LockDataId lock_data_id_;
+    txn_id_t txn_id_;
+    std::string lock_mode_;
+  };
+
+  /* 一种加锁类型的统计信息，用于SHOW LOCK_STATS */
+  struct LockModeStats {
+    uint64_t requests_ = 0;          // 加锁申请次数
+    uint64_t waits_ = 0;             // 因冲突而等待的次数
+    uint64_t dies_ = 0;              // 因wait-die而回滚的次数
+    uint64_t wait_time_us_ = 0;      // 总等待时间(微秒)
+    uint64_t max_wait_time_us_ = 0;  // 最长等待时间(微秒)
+    // 等待时间直方图，第0个桶统计不足1微秒的等待，第i个桶统计[2^(i-1), 2^i)微秒的等待，最后一个桶包含所有更长的等待
+    std::array<uint64_t, LOCK_WAIT_HISTOGRAM_BUCKETS> wait_histogram_{};
+  };
+
+  /* 一个数据项上的冲突统计，用于SHOW LOCK_STATS中的热点数据项 */
+  struct HotLockInfo {
+    LockDataId lock_data_id_;
+    uint64_t waits_;
+    uint64_t dies_;
+    uint64_t wait_time_us_;
+  };
+
   // LockManager() {}
 
   ~LockManager() { lock_table_.clear(); }
@@ -65,6 +99,8 @@ class LockManager {
 
   bool LockExclusiveOnRecord(Transaction *txn, const RID &rid, int tab_fd);
 
+  bool TryLockExclusiveOnRecord(Transaction *txn, const RID &rid, int tab_fd);
+
   bool LockSharedOnTable(Transaction *txn, int tab_fd);
 
   bool LockExclusiveOnTable(Transaction *txn, int tab_fd);
@@ -75,16 +111,37 @@ class LockManager {
 
   bool Unlock(Transaction *txn, LockDataId lock_data_id);
 
+  bool IsExclusiveLockedByOthers(Transaction *txn, const RID &rid, int tab_fd);
+
+  bool IsRecordLocked(const RID &rid, int tab_fd);
+
   bool CheckTxnStateLock(Transaction *txn);
 
   bool CheckTxnStateUnlock(Transaction *txn);
 
-  inline void WaitDie(Transaction *txn, LockRequest &req_holder, LockRequestQueue &queue,
-                      std::unique_lock<std::mutex> &lock, std::function<bool()> wake);
+  void RecordAbort(AbortReason reason);
+
+  std::vector<LockInfo> GetLocks();
+
+  std::vector<std::pair<std::string, LockModeStats>> GetModeStats();
+
+  std::vector<std::pair<std::string, uint64_t>> GetAbortStats();
+
+  std::vector<HotLockInfo> GetHotLocks(size_t n);
+
+  static bool IsCompatible(LockMode held, LockMode requested);
+
+  static std::string LockModeToString(LockMode mode);
+
+  inline void WaitDie(Transaction *txn, LockMode mode, LockRequestQueue &queue, std::unique_lock<std::mutex> &lock,
+                      std::function<bool()> wake);
 
  private:
   std::mutex latch_;                                             // 用于锁表的并发
   std::unordered_map<LockDataId, LockRequestQueue> lock_table_;  // 全局锁表
+  std::array<LockModeStats, LOCK_MODE_NUM> mode_stats_;          // 每种加锁类型的统计信息，持有latch_时更新
+  // 每种原因导致的事务回滚次数，OCC的验证失败不经过锁表，因此使用原子变量
+  std::array<std::atomic<uint64_t>, ABORT_REASON_NUM> abort_stats_{};
 };
 
 }  // namespace easydb
@@ -51,4 +51,7 @@ class QlManager {
 
 std::vector<Value> subquery_select_from(std::shared_ptr<AbstractExecutor> executorTreeRoot, TabCol sel_col);
 
+// 执行条件右边尚未执行的子查询，结果回填到rhs_val(比较)或rhs_in_col(IN)，每个条件只执行一次
+void subquery_fill_cond(Condition *cond);
+
 }  // namespace easydb
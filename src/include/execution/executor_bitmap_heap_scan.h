@@ -0,0 +1,95 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * executor_bitmap_heap_scan.h
+ *
+ * Identification: src/include/execution/executor_bitmap_heap_scan.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/condition.h"
+#include "common/errors.h"
+#include "defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "storage/index/ix_manager.h"
+#include "storage/index/ix_scan.h"
+#include "system/sm_defs.h"
+#include "system/sm_meta.h"
+namespace easydb {
+
+/**
+ * Bitmap heap scan: the rids in the ranges of one or more indexes are collected first, sorted by page and
+ * intersected (the conditions are connected with AND), then each heap page is read once for all its tuples.
+ * Unlike IndexScanExecutor, a range over a non-clustered index does not read the same page again and again, and
+ * the tuples come out in the order of the heap instead of the key.
+ */
+class BitmapHeapScanExecutor : public AbstractExecutor {
+ private:
+  std::string tab_name_;                             // 表名称
+  TabMeta tab_;                                      // 表的元数据
+  std::vector<Condition> conds_;                     // 扫描条件，所有条件在回表后都会再判断
+  RmFileHandle *fh_;                                 // 表的数据文件句柄
+  Schema schema_;                                    // scan后生成的记录的字段
+  size_t len_;                                       // 选取出来的一条记录的长度
+  std::vector<IndexMeta> index_metas_;               // 用于收集rid的索引
+  std::vector<std::vector<Condition>> index_conds_;  // 每个索引的列上与常量比较的条件
+
+  std::vector<RID> rids_;      // 所有索引范围内rid的交集，按页面排序
+  size_t page_begin_{0};       // 当前页面的第一个rid在rids_中的位置
+  size_t next_page_begin_{0};  // 下一个页面的第一个rid在rids_中的位置
+  std::vector<Tuple> tuples_;  // 当前页面上rids_[page_begin_, next_page_begin_)对应的记录
+  size_t tuple_idx_{0};        // 当前记录在tuples_中的位置
+  RID rid_;
+
+  SmManager *sm_manager_;
+
+ public:
+  /**
+   * @param index_col_names the columns of each index to collect the rids from, every column of an index has a
+   *                        condition in conds
+   */
+  BitmapHeapScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
+                         const std::vector<std::vector<std::string>> &index_col_names, Context *context);
+
+  std::string getTabName() const override { return tab_name_; }
+
+  size_t tupleLen() const override { return len_; }
+
+  const Schema &schema() const override { return schema_; }
+
+  std::string getType() override { return "BitmapHeapScanExecutor"; };
+
+  void beginTuple() override;
+
+  void nextTuple() override;
+
+  bool IsEnd() const override { return tuple_idx_ >= tuples_.size(); }
+
+  RID &rid() override { return rid_; }
+
+  std::unique_ptr<Tuple> Next() override { return std::make_unique<Tuple>(tuples_[tuple_idx_]); }
+
+ private:
+  /* 收集一个索引的扫描范围内的rid，并按页面排序 */
+  std::vector<RID> CollectRids(size_t index_idx);
+
+  /* 读取下一个页面上的记录到tuples_，没有下一个页面时tuples_为空 */
+  void FetchNextPage();
+
+  /* 从tuple_idx_开始找到第一个满足条件的记录 */
+  void SeekMatch();
+
+  // return true only all the conditions were true
+  bool predicate(const Tuple &tuple);
+};
+
+}  // namespace easydb
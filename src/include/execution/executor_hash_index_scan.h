@@ -0,0 +1,81 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * executor_hash_index_scan.h
+ *
+ * Identification: src/include/execution/executor_hash_index_scan.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/condition.h"
+#include "common/errors.h"
+#include "defs.h"
+#include "execution_manager.h"
+#include "executor_abstract.h"
+#include "storage/index/ix_manager.h"
+#include "system/sm_defs.h"
+#include "system/sm_meta.h"
+namespace easydb {
+
+/**
+ * Hash index scan: every column of a hash index has an equality condition with a constant, the key is looked up in
+ * the extendible hash index (one bucket page) and the record it points to is read and checked against all the
+ * conditions. The key itself is locked, so that no other transaction inserts or deletes it meanwhile.
+ */
+class HashIndexScanExecutor : public AbstractExecutor {
+ private:
+  std::string tab_name_;                      // 表名称
+  TabMeta tab_;                               // 表的元数据
+  std::vector<Condition> conds_;              // 扫描条件，所有条件在回表后都会再判断
+  RmFileHandle *fh_;                          // 表的数据文件句柄
+  Schema schema_;                             // scan后生成的记录的字段
+  size_t len_;                                // 选取出来的一条记录的长度
+  std::vector<std::string> index_col_names_;  // hash索引包含的字段
+  IndexMeta index_meta_;                      // hash索引的元数据
+
+  std::vector<RID> rids_;  // 查找到的记录，hash索引的key唯一，最多一个
+  size_t rid_idx_{0};      // 当前记录在rids_中的位置
+  std::unique_ptr<Tuple> tuple_;
+  RID rid_;
+
+  SmManager *sm_manager_;
+
+ public:
+  HashIndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
+                        std::vector<std::string> index_col_names, Context *context);
+
+  std::string getTabName() const override { return tab_name_; }
+
+  size_t tupleLen() const override { return len_; }
+
+  const Schema &schema() const override { return schema_; }
+
+  std::string getType() override { return "HashIndexScanExecutor"; };
+
+  void beginTuple() override;
+
+  void nextTuple() override;
+
+  bool IsEnd() const override { return rid_idx_ >= rids_.size(); }
+
+  RID &rid() override { return rid_; }
+
+  std::unique_ptr<Tuple> Next() override { return std::make_unique<Tuple>(*tuple_); }
+
+ private:
+  /* 从rid_idx_开始找到第一个满足条件的记录 */
+  void SeekMatch();
+
+  // return true only all the conditions were true
+  bool predicate(const Tuple &tuple);
+};
+
+}  // namespace easydb
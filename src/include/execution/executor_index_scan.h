@@ -15,6 +15,9 @@
 #include <unordered_map>
 
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 #include "common/errors.h"
 #include "defs.h"
 #include "execution_manager.h"
@@ -25,6 +28,16 @@
 #include "system/sm_meta.h"
 namespace easydb {
 
+/* 索引上的一个扫描范围，key由ix_memcpy编码，可以直接用memcmp比较 */
+struct IxKeyRange {
+  std::string lower;        // 下界，没有条件的列为全0
+  std::string upper;        // 上界，没有条件的列为全0xFF
+  bool has_lower{false};    // 没有下界时从第一个叶结点开始
+  bool has_upper{false};    // 没有上界时扫描到最后一个叶结点
+  bool lower_open{false};   // 不包含等于下界的key(UpperBound)，否则包含(LowerBound)
+  bool upper_open{false};   // 不包含等于上界的key(LowerBound)，否则包含(UpperBound)
+};
+
 class IndexScanExecutor : public AbstractExecutor {
  private:
   std::string tab_name_;          // 表名称
@@ -34,19 +47,25 @@ class IndexScanExecutor : public AbstractExecutor {
   // std::vector<ColMeta> cols_;         // 需要读取的字段
   Schema schema_;                     // scan后生成的记录的字段
   size_t len_;                        // 选取出来的一条记录的长度
-  std::vector<Condition> fed_conds_;  // 扫描条件，不一定和conds_字段相同(取决于索引的选择)
+  std::vector<Condition> fed_conds_;  // 确定扫描范围的条件：conds_中索引列与常量或IN列表的比较
 
   std::vector<std::string> index_col_names_;  // index scan涉及到的索引包含的字段
   IndexMeta index_meta_;                      // index scan涉及到的索引元数据
 
   RID rid_;
-  std::unique_ptr<IxScan> scan_;
+  IxIndexHandle *ih_;
+  std::unique_ptr<IxScan> scan_;             // 当前范围上的扫描
+  std::vector<std::pair<Iid, Iid>> ranges_;  // 按key递增、互不重叠的扫描范围[lower, upper)
+  size_t range_idx_{0};                      // 当前范围在ranges_中的位置
+
+  bool index_only_;        // 只读索引，由索引项的key和INCLUDE列构造记录，不回表
+  std::string entry_buf_;  // index only scan读出的索引项
 
   SmManager *sm_manager_;
 
  public:
   IndexScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds,
-                    std::vector<std::string> index_col_names, Context *context);
+                    std::vector<std::string> index_col_names, Context *context, bool index_only = false);
 
   std::string getTabName() const override { return tab_name_; }
 
@@ -61,16 +80,49 @@ class IndexScanExecutor : public AbstractExecutor {
   void beginTuple() override;
   void nextTuple() override;
 
-  bool IsEnd() const override { return scan_->IsEnd(); }
+  bool IsEnd() const override { return range_idx_ >= ranges_.size(); }
 
   RID &rid() override { return rid_; }
 
+  /**
+   * 由扫描条件确定索引上的扫描范围[lower, upper)，范围内仍可能有不满足条件的项（如多列索引），需要再判断
+   * @param conds 索引列上与常量比较的条件
+   */
+  static void GetScanRange(IxIndexHandle *ih, const IndexMeta &index_meta, const std::vector<Condition> &conds,
+                           Iid *lower, Iid *upper);
+
+  /**
+   * 由扫描条件确定索引上的key范围：IN列表的每个值(多个IN时为各列值的组合)对应一个范围，
+   * 返回的范围按下界排序，空的范围已去掉，重叠的范围已合并，因此每一项只会被扫描一次
+   * @param conds 索引列上与常量或IN列表比较的条件
+   */
+  static std::vector<IxKeyRange> GetKeyRanges(const IndexMeta &index_meta, const std::vector<Condition> &conds);
+
+  /**
+   * 定位key范围在索引上的[lower, upper)
+   * @param from 不为空时先在from所在的叶结点中查找下界，不在该叶结点上时才从根结点重新下降；上界同样先在下界所在的
+   * 叶结点中查找
+   */
+  static void SeekKeyRange(IxIndexHandle *ih, const IxKeyRange &range, const Iid *from, Iid *lower, Iid *upper);
+
+  // 一组IN列表展开后的范围数超过该值时，IN条件不用于确定范围，只在回表后判断
+  static constexpr size_t MAX_KEY_RANGES = 1 << 16;
+
   std::unique_ptr<Tuple> Next() override {
     // assert(!IsEnd());
+    if (index_only_) {
+      return NextFromIndex();
+    }
     return fh_->GetTupleValue(rid_, context_);
   }
 
  private:
+  // index only scan: 由当前索引项构造记录，索引不包含的列为NULL
+  std::unique_ptr<Tuple> NextFromIndex();
+
+  // 从当前位置开始找到第一个满足条件的记录，当前范围扫描完后移到下一个范围
+  void SeekMatch();
+
   // return true only all the conditions were true
   bool predicate();
 };
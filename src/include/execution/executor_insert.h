@@ -25,14 +25,29 @@ class InsertExecutor : public AbstractExecutor {
  private:
   TabMeta tab_;                // 表的元数据
   std::vector<Value> values_;  // 需要插入的数据
+  std::vector<std::vector<Value>> rows_;  // INSERT ... SELECT需要插入的各行数据
+  bool is_bulk_ = false;                  // 是否为INSERT ... SELECT，按页面批量插入rows_
   RmFileHandle *fh_;           // 表的数据文件句柄
   std::string tab_name_;       // 表名称
   RID rid_;  // 插入的位置，由于系统默认插入时不指定位置，因此当前rid_在插入后才赋值
   SmManager *sm_manager_;
 
+  /* 按页面批量插入rows_，页面安装后再插入索引 */
+  void InsertRows();
+
+  /* 计算记录在某个索引上的key */
+  auto MakeKey(const Tuple &tuple, const IndexMeta &index) const -> std::vector<char>;
+
  public:
   InsertExecutor(SmManager *sm_manager, const std::string &tab_name, std::vector<Value> values, Context *context);
 
+  /**
+   * INSERT INTO t SELECT ...: insert the rows produced by the select, which the caller has collected before.
+   * The rows are packed into new pages by RmBulkAppender, so the table is locked in exclusive mode.
+   */
+  InsertExecutor(SmManager *sm_manager, const std::string &tab_name, std::vector<std::vector<Value>> rows,
+                 Context *context);
+
   std::unique_ptr<Tuple> Next() override;
 
   RID &rid() override { return rid_; }
@@ -31,14 +31,21 @@ class SeqScanExecutor : public AbstractExecutor {
   Schema schema_;                     // scan后生成的记录的字段
   size_t len_;                        // scan后生成的每条记录的长度
   std::vector<Condition> fed_conds_;  // 同conds_，两个字段相同
+  std::vector<uint32_t> col_ids_;     // 需要读取的列，为空时读取所有列
+  std::vector<RmZonePredicate> zone_preds_;  // 列与常量比较的条件，用于根据zone map跳过页面
 
   RID rid_;
-  std::unique_ptr<RecScan> scan_;  // table_iterator
+  std::unique_ptr<RmScan> scan_;  // table_iterator
 
   SmManager *sm_manager_;
 
  public:
-  SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, Context *context);
+  /**
+   * @param proj_cols the columns read by the operators above, empty for all columns. Columnar tables only read
+   *                  these columns and the columns of the conditions, the other columns of the tuples are zero.
+   */
+  SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds, Context *context,
+                  const std::vector<std::string> &proj_cols = {});
   // SeqScanExecutor(SmManager *sm_manager, std::string tab_name, std::vector<Condition> conds);
 
   void beginTuple() override;
@@ -39,5 +39,9 @@ class UpdateExecutor : public AbstractExecutor {
   std::unique_ptr<Tuple> Next() override;
 
   RID &rid() override { return _abstract_rid; }
+
+ private:
+  void MoveTuple(const RID &rid, const Tuple &old_tuple, const Tuple &new_tuple,
+                 const std::vector<std::vector<char>> &new_keys);
 };
 }  // namespace easydb
@@ -42,6 +42,15 @@ class Optimizer {
     } else if (auto x = std::dynamic_pointer_cast<ast::ShowIndex>(query->parse)) {
       // show index;
       return std::make_shared<OtherPlan>(T_ShowIndex, x->tab_name);
+    } else if (auto x = std::dynamic_pointer_cast<ast::ShowLocks>(query->parse)) {
+      // show locks;
+      return std::make_shared<OtherPlan>(T_ShowLocks, std::string());
+    } else if (auto x = std::dynamic_pointer_cast<ast::ShowLockStats>(query->parse)) {
+      // show lock_stats;
+      return std::make_shared<OtherPlan>(T_ShowLockStats, std::string());
+    } else if (auto x = std::dynamic_pointer_cast<ast::Vacuum>(query->parse)) {
+      // vacuum [table];
+      return std::make_shared<OtherPlan>(T_Vacuum, x->tab_name);
     } else if (auto x = std::dynamic_pointer_cast<ast::DescTable>(query->parse)) {
       // desc table;
       return std::make_shared<OtherPlan>(T_DescTable, x->tab_name);
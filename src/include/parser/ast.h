@@ -26,7 +26,15 @@ enum SvArithOp { SV_OP_PLUS, SV_OP_MINUS, SV_OP_MUL, SV_OP_DIV };
 
 enum OrderByDir { OrderBy_DEFAULT, OrderBy_ASC, OrderBy_DESC };
 
-enum SetKnobType { EnableNestLoop, EnableSortMerge, EnableHashJoin, EnableOutput, EnableOptimizer };
+enum SetKnobType {
+  EnableNestLoop,
+  EnableSortMerge,
+  EnableHashJoin,
+  EnableOutput,
+  EnableOptimizer,
+  EnableOcc,
+  EnableAutoVacuum
+};
 
 // Base class for tree nodes
 struct TreeNode {
@@ -43,6 +51,17 @@ struct ShowIndex : public TreeNode {
   ShowIndex(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
 };
 
+struct ShowLocks : public TreeNode {};
+
+struct ShowLockStats : public TreeNode {};
+
+// tab_name为空表示整理所有表
+struct Vacuum : public TreeNode {
+  std::string tab_name;
+
+  Vacuum(std::string tab_name_) : tab_name(std::move(tab_name_)) {}
+};
+
 struct TxnBegin : public TreeNode {};
 
 struct TxnCommit : public TreeNode {};
@@ -74,9 +93,19 @@ struct ColDef : public Field {
 struct CreateTable : public TreeNode {
   std::string tab_name;
   std::vector<std::shared_ptr<Field>> fields;
+  // WITH (option_name = option_value), e.g. WITH (format = columnar)
+  std::string option_name;
+  std::string option_value;
 
   CreateTable(std::string tab_name_, std::vector<std::shared_ptr<Field>> fields_)
       : tab_name(std::move(tab_name_)), fields(std::move(fields_)) {}
+
+  CreateTable(std::string tab_name_, std::vector<std::shared_ptr<Field>> fields_, std::string option_name_,
+              std::string option_value_)
+      : tab_name(std::move(tab_name_)),
+        fields(std::move(fields_)),
+        option_name(std::move(option_name_)),
+        option_value(std::move(option_value_)) {}
 };
 
 struct DropTable : public TreeNode {
@@ -94,9 +123,15 @@ struct DescTable : public TreeNode {
 struct CreateIndex : public TreeNode {
   std::string tab_name;
   std::vector<std::string> col_names;
+  std::vector<std::string> include_names;  // INCLUDE (...): non-key columns stored in the leaves
+  std::string method;                      // USING method: btree (default) or hash
 
-  CreateIndex(std::string tab_name_, std::vector<std::string> col_names_)
-      : tab_name(std::move(tab_name_)), col_names(std::move(col_names_)) {}
+  CreateIndex(std::string tab_name_, std::vector<std::string> col_names_, std::vector<std::string> include_names_ = {},
+              std::string method_ = "")
+      : tab_name(std::move(tab_name_)),
+        col_names(std::move(col_names_)),
+        include_names(std::move(include_names_)),
+        method(std::move(method_)) {}
 };
 
 struct DropIndex : public TreeNode {
@@ -204,9 +239,13 @@ struct OrderBy : public TreeNode {
 struct InsertStmt : public TreeNode {
   std::string tab_name;
   std::vector<std::shared_ptr<Value>> vals;
+  std::shared_ptr<TreeNode> select;  // INSERT INTO t SELECT ...，此时vals为空
 
   InsertStmt(std::string tab_name_, std::vector<std::shared_ptr<Value>> vals_)
       : tab_name(std::move(tab_name_)), vals(std::move(vals_)) {}
+
+  InsertStmt(std::string tab_name_, std::shared_ptr<TreeNode> select_)
+      : tab_name(std::move(tab_name_)), select(std::move(select_)) {}
 };
 
 struct DeleteStmt : public TreeNode {
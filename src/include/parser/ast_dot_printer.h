@@ -163,6 +163,8 @@ class TreeDotPrinter {
       print_edge(_node_id, parent);
       print_val(x->tab_name, _node_id);
       for (auto col_name : x->col_names) print_val(col_name, _node_id);
+      for (auto col_name : x->include_names) print_val(col_name, _node_id);
+      if (!x->method.empty()) print_val(x->method, _node_id);
     } else if (auto x = std::dynamic_pointer_cast<DropIndex>(node)) {
       // std::cout << "DROP_INDEX" << std::endl;
       int _node_id = alloc_node("DROP_INDEX");
@@ -246,6 +248,9 @@ class TreeDotPrinter {
       print_edge(_node_id, parent);
       print_val(x->tab_name, _node_id);
       print_node_list(x->vals, _node_id);
+      if (x->select) {
+        print_node(x->select, _node_id);
+      }
     } else if (auto x = std::dynamic_pointer_cast<DeleteStmt>(node)) {
       // std::cout << "DELETE" << std::endl;
       int _node_id = alloc_node("DELETE");
@@ -95,6 +95,8 @@ class TreePrinter {
       print_val(x->tab_name, offset);
       // print_val(x->col_name, offset);
       for (auto col_name : x->col_names) print_val(col_name, offset);
+      for (auto col_name : x->include_names) print_val(col_name, offset);
+      if (!x->method.empty()) print_val(x->method, offset);
     } else if (auto x = std::dynamic_pointer_cast<DropIndex>(node)) {
       std::cout << "DROP_INDEX" << std::endl;
       print_val(x->tab_name, offset);
@@ -153,6 +155,9 @@ class TreePrinter {
       std::cout << "INSERT" << std::endl;
       print_val(x->tab_name, offset);
       print_node_list(x->vals, offset);
+      if (x->select) {
+        print_node(x->select, offset);
+      }
     } else if (auto x = std::dynamic_pointer_cast<DeleteStmt>(node)) {
       std::cout << "DELETE" << std::endl;
       print_val(x->tab_name, offset);
@@ -29,6 +29,9 @@ typedef enum PlanTag {
   T_Help,
   T_ShowTable,
   T_ShowIndex,
+  T_ShowLocks,
+  T_ShowLockStats,
+  T_Vacuum,
   T_DescTable,
   T_CreateTable,
   T_DropTable,
@@ -47,6 +50,8 @@ typedef enum PlanTag {
   T_Transaction_rollback,
   T_SeqScan,
   T_IndexScan,
+  T_BitmapHeapScan,  // 先收集并排序索引范围内的rid，再按页面回表
+  T_HashIndexScan,   // 由hash索引等值查找记录
   T_NestLoop,
   T_SortMerge,   // sort merge join
   T_IndexMerge,  // merge join using index
@@ -100,6 +105,9 @@ class ScanPlan : public Plan {
   size_t len_;
   std::vector<Condition> fed_conds_;
   std::vector<std::string> index_col_names_;
+  std::vector<std::string> proj_cols_;  // 上层算子用到的列，为空时读取所有列；只对select的seq scan和index only scan设置
+  bool index_only_{false};              // index scan只读索引：索引的key和INCLUDE列覆盖了proj_cols_
+  std::vector<std::vector<std::string>> bitmap_index_col_names_;  // bitmap heap scan用到的各个索引的列
 };
 
 class JoinPlan : public Plan {
@@ -218,6 +226,9 @@ class DDLPlan : public Plan {
   std::string tab_name_;
   std::vector<std::string> tab_col_names_;
   std::vector<ColDef> cols_;
+  RmFileFormat format_{RmFileFormat::ROW};  // create table的存储格式
+  std::vector<std::string> include_col_names_;  // create index的INCLUDE列
+  bool is_hash_{false};                         // create index ... USING HASH
 };
 
 // load data语句对应的plan
@@ -84,6 +84,9 @@ class Planner {
 
   std::shared_ptr<Plan> make_one_rel(std::shared_ptr<Query> query, Context *context);
 
+  // select语句中表tab_name被用到的列，包括投影列、where条件、group by、having和order by中的列
+  std::vector<std::string> get_scan_cols(std::shared_ptr<Query> query, const std::string &tab_name);
+
   std::shared_ptr<Plan> generate_sort_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan);
   std::shared_ptr<Plan> generate_aggregation_plan(std::shared_ptr<Query> query, std::shared_ptr<Plan> plan);
 
@@ -95,6 +98,17 @@ class Planner {
   bool get_index_cols_swap(std::string tab_name, std::vector<Condition> curr_conds,
                            std::vector<std::string> &index_col_names);
 
+  // 每一列上都有与常量的等值条件的hash索引，index_col_names按索引中列的顺序
+  bool get_hash_index_cols(const std::string &tab_name, const std::vector<Condition> &conds,
+                           std::vector<std::string> &index_col_names);
+
+  // 第一列上有与常量比较的条件、可以用于bitmap heap scan的索引
+  std::vector<std::vector<std::string>> get_bitmap_index_cols(const std::string &tab_name,
+                                                              const std::vector<Condition> &conds);
+  // 由直方图估计列col_name上与常量比较的条件选出的行的比例，没有统计信息时返回-1
+  double estimate_selectivity(const std::string &tab_name, const std::string &col_name,
+                              const std::vector<Condition> &conds);
+
   ColType interp_sv_type(ast::SvType sv_type) {
     std::map<ast::SvType, ColType> m = {
         {ast::SV_TYPE_INT, TYPE_INT}, {ast::SV_TYPE_FLOAT, TYPE_FLOAT}, {ast::SV_TYPE_STRING, TYPE_VARCHAR}};
@@ -0,0 +1,81 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_bulk_appender.h
+ *
+ * Identification: src/include/record/rm_bulk_appender.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "record/rm_file_handle.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+
+namespace easydb {
+
+/**
+ * Bulk insert path of a table, used by LOAD DATA and INSERT ... SELECT.
+ *
+ * Tuples are not inserted one by one through RmFileHandle::InsertTuple, which searches the FSM, fetches, latches
+ * and unpins a page for every tuple. The appender instead fills a page image in private memory, in the format of the
+ * table (see RmPageHandle), and installs it as a new page of the file once it is full: one NewPage, one FSM update
+ * and one zone per page. Free space in the existing pages is left to the regular inserts.
+ *
+ * The tuples of a page only get their RIDs when the page is installed, they are then handed to the install callback,
+ * e.g. to insert the index entries; the callback gets the whole page, so that it can undo the tuples it has not
+ * processed if it fails. Nobody else reads a page before it is installed, so the tuples are not locked
+ * one by one: a caller with a transaction holds the table lock in exclusive mode.
+ *
+ * Finish() installs the last page, which is not full. Tuples appended after the last Finish() are lost if the
+ * appender is destroyed, the destructor does not install them since it cannot report the errors.
+ */
+class RmBulkAppender {
+ public:
+  /* 页面安装后调用，tuples[i]为页面中第i个slot的记录（不含TOAST指针） */
+  using InstallCallback = std::function<void(page_id_t page_no, const std::vector<Tuple> &tuples)>;
+
+  /**
+   * @param file_handle the table to append to
+   * @param on_install called with the tuples of each page once the page is installed, can be nullptr
+   */
+  explicit RmBulkAppender(RmFileHandle *file_handle, InstallCallback on_install = nullptr);
+
+  /**
+   * Append a tuple to the current page, and install the page first if the tuple does not fit into it.
+   * @param meta tuple meta
+   * @param tuple tuple to append
+   */
+  void Append(const TupleMeta &meta, const Tuple &tuple);
+
+  /** Install the current page if it holds any tuple. */
+  void Finish();
+
+  /** @return the number of pages installed so far */
+  auto GetNumPages() const -> int { return num_pages_; }
+
+ private:
+  /* 将页面镜像安装为文件的一个新页面，再对其中的记录调用安装回调 */
+  void InstallPage();
+
+  /* 清空页面镜像，初始化为文件格式的空页面 */
+  void ResetPage();
+
+  RmFileHandle *file_handle_;
+  InstallCallback on_install_;
+  Page image_;                 // 私有的页面镜像，安装前其他线程不可见
+  RmPageHandle page_handle_;   // 页面镜像的句柄，按表的格式写入记录
+  std::vector<Tuple> tuples_;  // 页面镜像中的记录，用于建立zone和安装回调
+  std::shared_lock<std::shared_mutex> gc_lock_;  // 页面镜像中有记录指向TOAST值时持有，见RmToastStore::GetGcLatch
+  int num_pages_{0};           // 已安装的页面个数
+};
+
+}  // namespace easydb
@@ -10,6 +10,7 @@
  */
 
 #pragma once
+#include <cstdint>
 #include <cstring>
 // #include "common/config.h"
 // #include "storage/page/page.h"
@@ -21,26 +22,66 @@ constexpr int RM_NO_PAGE = -1;
 constexpr int RM_FILE_HDR_PAGE = 0;
 constexpr int RM_FIRST_RECORD_PAGE = 1;
 constexpr int RM_MAX_RECORD_SIZE = 512;
+constexpr int RM_MAX_COLUMNS = 64;
+// 行存格式：记录超过该长度时，将最长的变长列的值移到TOAST页面中，直到不超过该长度，见RmToastStore
+constexpr uint32_t RM_TOAST_TUPLE_THRESHOLD = 1024;
+// 记录中变长列的长度的最高位，表示该值存放在TOAST页面中
+constexpr uint32_t RM_TOAST_FLAG = 0x80000000;
+
+/* 表数据文件的存储格式 */
+enum class RmFileFormat : int {
+  ROW = 0,       // 行存：slotted page，每个页面中存放完整的记录
+  COLUMNAR = 1,  // 列存（PAX）：每个页面中每一列的值连续存放在该列的minipage中
+};
+
+/* 表中一列的布局 */
+struct RmColumnHdr {
+  int offset;           // 该列在行格式记录定长部分中的偏移量
+  int width;            // 列存格式：该列在minipage中每个值占用的空间，变长列为长度(4) + 最大长度 + 结尾的'\0'
+  int minipage_offset;  // 列存格式：该列的minipage在页面中的偏移量
+  bool is_inlined;      // 是否为定长列，变长列在记录定长部分中存放的是数据的偏移量
+  int type;             // 该列的类型（TypeId），用于选择封存页面时的压缩编码
+};
+
+/* 封存的列存页面中一列的编码方式 */
+enum class RmColumnEncoding : uint8_t {
+  PLAIN = 0,  // 不压缩，每个值占用RmColumnHdr::width，与未封存的页面相同
+  FOR = 1,    // frame of reference：INT列的值减去页面中的最小值后按固定位数存放
+  DICT = 2,   // 字典编码：变长列的不同值存放在页面的字典中，每条记录按固定位数存放其在字典中的编号
+};
 
 /* 文件头，记录表数据文件的元信息，写入磁盘中文件的第0号页面 */
 struct RmFileHdr {
   int num_pages;           // 文件中分配的页面个数（初始化为1）
-  int first_free_page_no;  // 文件中当前第一个包含空闲空间的页面号（初始化为-1）
+  int first_free_page_no;  // 已弃用，空闲空间由RmFreeSpaceMap维护，保留以兼容已有的数据文件（初始化为-1）
   // int record_size;  // 表中每条记录的大小，由于不包含变长字段，因此当前字段初始化后保持不变
-  // int num_records_per_page;  // 每个页面最多能存储的元组个数
   // int bitmap_size;           // 每个页面bitmap大小
+  // Note: 以下字段为列存格式新增。空值位图之前写入的数据文件中的记录没有位图，读出的值不正确，需要重新建表导入
+  RmFileFormat format;       // 存储格式（初始化为ROW）
+  int num_records_per_page;  // 列存格式：每个页面最多能存储的记录个数
+  int fixed_size;            // 行格式记录定长部分的大小
+  int max_record_size;       // 列存格式：行格式记录的最大长度
+  int num_cols;              // 列数，包括最后的空值位图（见RmManager::InitColumns），不带schema创建的文件中为0
+  RmColumnHdr cols[RM_MAX_COLUMNS];  // 每一列的布局，minipage相关的字段只用于列存格式
 
   void Init() {
     num_pages = 1;
     first_free_page_no = RM_NO_PAGE;
+    format = RmFileFormat::ROW;
+    num_records_per_page = 0;
+    fixed_size = 0;
+    max_record_size = 0;
+    num_cols = 0;
   }
 };
 
 /**
  * Tuple format:
- * ---------------------------------------------------------------------
- * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
- * ---------------------------------------------------------------------
+ * -----------------------------------------------------------------------------------
+ * | FIXED-SIZE or VARIED-SIZED OFFSET | NULL BITMAP | PAYLOAD OF VARIED-SIZED FIELD |
+ * -----------------------------------------------------------------------------------
+ * The null bitmap has one bit per column. Tuples written before it existed have no bitmap, such data files have to be
+ * rebuilt.
  */
 /* 表中的记录 */
 struct RmRecord {
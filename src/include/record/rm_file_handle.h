@@ -13,6 +13,10 @@
 #include <assert.h>
 
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
 
 #include "bitmap.h"
 #include "buffer/buffer_pool_manager.h"
@@ -20,6 +24,9 @@
 #include "common/context.h"
 #include "common/rid.h"
 #include "rm_defs.h"
+#include "rm_free_space_map.h"
+#include "rm_toast_store.h"
+#include "rm_zone_map.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
@@ -47,10 +54,11 @@ namespace easydb {
 
 /* 表数据文件中每个页面的页头，记录每个页面的元信息 */
 struct RmPageHdr {
-  page_id_t next_page_id;  // 当前页面满了之后，下一个包含空闲空间的页面号（初始化为-1）
+  page_id_t next_page_id;  // 已弃用，空闲页面由RmFreeSpaceMap维护（初始化为-1）
   uint16_t num_records;    // 当前页面中当前已经存储的记录个数（初始化为0）
   uint16_t num_deleted_records;  // 当前页面中已经删除的记录个数（初始化为0）
-  // num_records 只增不减，删除记录则增 num_deleted_records，标记相应的slot为已删除
+  // 删除记录则增 num_deleted_records，标记相应的slot为已删除；已删除的slot可以被之后插入的记录复用。
+  // VACUUM回收已删除记录的数据，并截断页面末尾已删除的slot，此时num_records减少
 
   void Init() {
     next_page_id = RM_NO_PAGE;
@@ -61,15 +69,82 @@ struct RmPageHdr {
 
 static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = Page::SIZE_PAGE_HEADER + sizeof(RmPageHdr);
 
-/* 对表数据文件中的页面进行封装 */
+/* 列存格式的页面在RmPageHdr之后的页头 */
+struct RmColumnarPageHdr {
+  int capacity;    // 封存的页面中slot的个数，未封存的页面为RmFileHdr::num_records_per_page（初始化为0）
+  bool is_sealed;  // 页面是否已封存，即各列是否已压缩（初始化为false）
+
+  void Init() {
+    capacity = 0;
+    is_sealed = false;
+  }
+};
+
+static constexpr uint64_t COLUMNAR_PAGE_HEADER_SIZE = TABLE_PAGE_HEADER_SIZE + sizeof(RmColumnarPageHdr);
+
+/* 封存的列存页面中一列的编码信息 */
+struct RmColumnChunk {
+  RmColumnEncoding encoding;  // 编码方式
+  uint8_t bits;               // FOR/DICT：每条记录占用的位数
+  uint16_t dict_size;         // DICT：字典中值的个数
+  uint16_t offset;            // 该列的数据在页面中的偏移量
+  uint16_t size;              // 该列的数据的大小
+  int32_t base;               // FOR：页面中该列的最小值
+};
+
+/* VACUUM的统计信息 */
+struct RmVacuumStats {
+  int num_pages_{0};        // 整理过的页面个数
+  int num_tuples_{0};       // 回收的已删除记录个数
+  int num_bytes_{0};        // 回收的空间大小（记录数据和TupleInfo）
+  int num_empty_pages_{0};  // 整理后不包含任何slot的页面个数
+  int num_sealed_pages_{0};  // 封存（压缩）的列存页面个数
+  int num_toast_pages_{0};   // 回收的TOAST页面个数
+};
+
+/**
+ * 对表数据文件中的页面进行封装
+ *
+ * Slotted page format:
+ *  ------------------------------------------------------------------------------------
+ *  | Page header | RmPageHdr | TupleInfo[0..num_records) | free | ... | tuple 1 | tuple 0 |
+ *  ------------------------------------------------------------------------------------
+ * Tuple data grows backward in slot order, i.e. the data of slot i lies in [offset_i, offset_{i-1}) (the capacity
+ * of the slot, offset_{-1} = PAGE_SIZE), and the last slot has the lowest offset. Slots never move to another
+ * page, so a RID stays valid after compaction and indexes do not need to be updated.
+ *
+ * Columnar (PAX) page format, see RmFileFormat::COLUMNAR:
+ *  ------------------------------------------------------------------------------------------------
+ *  | Page header | RmPageHdr | TupleMeta[0..n) | column 0: value[0..n) | column 1: value[0..n) | ... |
+ *  ------------------------------------------------------------------------------------------------
+ * n is RmFileHdr::num_records_per_page. Every value has a fixed width in the minipage of its column, so a slot
+ * never moves and a scan reading a few columns only touches their minipages. Tuples are still handed in and out
+ * in the row format, split into and assembled from the minipages. RmColumnarPageHdr follows RmPageHdr.
+ *
+ * Sealed columnar page format, see Seal:
+ *  -----------------------------------------------------------------------------------------------------
+ *  | Page header | RmPageHdr | RmColumnarPageHdr | TupleMeta[0..m) | RmColumnChunk[num_cols] | chunks ... |
+ *  -----------------------------------------------------------------------------------------------------
+ * m is RmColumnarPageHdr::capacity. Each column is stored as a chunk of m values in one of the encodings:
+ *  - PLAIN: value[0..m), as in a minipage
+ *  - FOR:   (value - base)[0..m) bit-packed, for INT columns
+ *  - DICT:  code[0..m) bit-packed | uint16 offset of entry[0..dict_size) in the chunk | entries, for strings
+ * The encodings only ever grow: a write that does not fit the current encoding of a column re-encodes the page
+ * with a wider FOR range or more dictionary entries, giving up free slots if needed, so a value that has been on
+ * the page always fits again (e.g. when an update is rolled back). A write fails only if the used slots no longer
+ * fit into the page.
+ */
 class RmPageHandle {
   friend class RmFileHandle;
   friend class RmScan;
+  friend class RmBulkAppender;
 
  public:
   RmPageHandle(const RmFileHdr *fhdr_, Page *page_) : file_hdr(fhdr_), page(page_) {
     page_hdr_ = reinterpret_cast<RmPageHdr *>(page->GetData() + page->OFFSET_PAGE_HDR);
     tuple_info_ = reinterpret_cast<TupleInfo *>(page->GetData() + sizeof(RmPageHdr) + page->OFFSET_PAGE_HDR);
+    columnar_hdr_ = reinterpret_cast<RmColumnarPageHdr *>(page->GetData() + TABLE_PAGE_HEADER_SIZE);
+    metas_ = reinterpret_cast<TupleMeta *>(page->GetData() + COLUMNAR_PAGE_HEADER_SIZE);
     page_start_ = page->GetData();
   }
 
@@ -79,6 +154,15 @@ class RmPageHandle {
   //   每个slot的大小(每个record的大小)
   // }
 
+  /** @return true if the page is in the columnar (PAX) format */
+  auto IsColumnar() const -> bool { return file_hdr->format == RmFileFormat::COLUMNAR; }
+
+  /** @return true if the page is a sealed columnar page, whose columns are compressed */
+  auto IsSealed() const -> bool { return IsColumnar() && columnar_hdr_->is_sealed; }
+
+  /** @return the number of slots of a columnar page */
+  auto GetCapacity() const -> int { return IsSealed() ? columnar_hdr_->capacity : file_hdr->num_records_per_page; }
+
   /** @return number of tuples in this page */
   auto GetNumTuples() const -> uint32_t { return page_hdr_->num_records; }
 
@@ -91,6 +175,59 @@ class RmPageHandle {
   /** Get the next offset to insert, return nullopt if this tuple cannot fit in this page */
   auto GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t>;
 
+  /** @return the space between the TupleInfo array and the tuple data */
+  auto GetUnusedSpace() const -> int;
+
+  /** @return the size of the largest tuple that fits into a new slot of this page */
+  auto GetContiguousFreeSpace() const -> int;
+
+  /** @return the size of the largest tuple that fits into a new slot or a deleted slot of this page */
+  auto GetFreeSpace() const -> int;
+
+  /** @return true if the tuple fits into a new slot of this page */
+  auto CanInsertTuple(const Tuple &tuple) const -> bool;
+
+  /** @return true if the tuple fits into a deleted slot, growing it only if the data of other slots can be moved */
+  auto CanReuseSlot(uint16_t slot_no, const Tuple &tuple) const -> bool;
+
+  /**
+   * Write a tuple into a deleted slot, the caller has checked CanReuseSlot.
+   */
+  void ReuseSlot(uint16_t slot_no, const TupleMeta &meta, const Tuple &tuple);
+
+  /** @return the space of a slot, i.e. the size of the largest tuple it holds without moving other slots */
+  auto GetSlotCapacity(uint16_t slot_no) const -> int;
+
+  /**
+   * The data of the slots can only be moved (by GrowSlot or Compact) if nobody else pins the page, since RmScan
+   * hands out views into the pinned page. The caller holds the write latch, so nobody can start reading the page.
+   * @return true if the caller holds the only pin of the page
+   */
+  auto CanMoveTuples() const -> bool { return page->GetPinCount() == 1; }
+
+  /**
+   * Make room for a tuple of the given size in a slot, moving the data of the following slots if needed.
+   * @return false if the page does not have enough free space
+   */
+  auto GrowSlot(uint16_t slot_no, int size) -> bool;
+
+  /**
+   * Compact the page: drop the data of the reclaimed slots, pack the data of the other slots at the end of the page,
+   * and truncate the reclaimed slots at the end of the slot array.
+   * @param reclaim reclaim[i] is true if slot i is deleted and nobody can access it any more
+   */
+  void Compact(const std::vector<bool> &reclaim);
+
+  /**
+   * Seal a columnar page: compress its columns with dictionary encoding (strings) or frame of reference (INT),
+   * whichever is smaller than the plain values, and grow the page to as many slots as the compressed columns
+   * leave room for. The encodings are chosen from the tuples of the page, so only full pages are worth sealing.
+   * @return the number of bytes saved by the encodings, 0 if the page was not sealed since it would not gain slots
+   * @note the caller holds the write latch and has checked CanMoveTuples. No slot of the page may be locked,
+   *       otherwise a rollback could write back a value that is no longer on the page and may not fit.
+   */
+  auto Seal() -> int;
+
   /**
    * Insert a tuple into the table.
    * @param tuple tuple to insert
@@ -115,8 +252,9 @@ class RmPageHandle {
 
   /**
    * Update a tuple in place.
+   * @return false if the tuple does not fit into the encodings of a sealed page, the page is left unchanged
    */
-  void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
+  auto UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) -> bool;
 
   /**
    * Check if a tuple is deleted.
@@ -124,6 +262,90 @@ class RmPageHandle {
   auto IsTupleDeleted(const RID &rid) -> bool;
 
  private:
+  struct ChunkPlan;
+
+  /* slot_no对应的元组元数据，不检查slot_no是否越界 */
+  auto MetaAt(uint16_t slot_no) const -> TupleMeta & {
+    return IsColumnar() ? metas_[slot_no] : std::get<2>(tuple_info_[slot_no]);
+  }
+
+  /* 列存格式：第slot_no条记录第col_idx列的值在页面中的地址，只用于未封存的页面 */
+  auto GetColumnData(uint16_t slot_no, int col_idx) const -> char * {
+    const auto &col = file_hdr->cols[col_idx];
+    return page_start_ + col.minipage_offset + slot_no * col.width;
+  }
+
+  /* 封存的页面：各列的编码信息 */
+  auto GetChunks() const -> RmColumnChunk * {
+    return reinterpret_cast<RmColumnChunk *>(page_start_ + COLUMNAR_PAGE_HEADER_SIZE +
+                                             columnar_hdr_->capacity * TUPLE_META_SIZE);
+  }
+
+  /* 变长列的数据（长度(4) + 字符串）占用的空间 */
+  static auto GetPayloadSize(const char *payload) -> uint32_t {
+    uint32_t len = *reinterpret_cast<const uint32_t *>(payload);
+    return sizeof(uint32_t) + (len == EASYDB_VALUE_NULL ? 0 : len);
+  }
+
+  /**
+   * 列存格式：第slot_no条记录第col_idx列的值，格式与未封存页面的minipage中相同
+   * @param buf FOR编码的值解码到buf中（至少4字节），其他编码返回页面中的地址
+   */
+  auto ReadColumnValue(uint16_t slot_no, int col_idx, char *buf) const -> const char *;
+
+  /* 封存的页面：字典编码的列中第slot_no条记录在字典中的编号 */
+  auto GetDictCode(uint16_t slot_no, int col_idx) const -> uint32_t;
+
+  /* 封存的页面：字典编码的列中第code个值，格式与minipage中相同 */
+  auto GetDictEntry(int col_idx, uint32_t code) const -> const char *;
+
+  /**
+   * 封存的页面：对谓词列的字典中每个值计算一次谓词，扫描据此跳过编号不满足谓词的记录
+   * @param matches matches[code]为字典中第code个值是否满足谓词
+   * @return false if the column is not dictionary encoded or the predicate cannot be evaluated on its values
+   */
+  auto EvalOnDictionary(const RmZonePredicate &pred, std::vector<bool> *matches) const -> bool;
+
+  /* 列存格式：记录能否写入slot_no，封存的页面中写不进当前编码的值需要重新编码页面 */
+  auto CanWriteColumnarTuple(uint16_t slot_no, const Tuple &tuple) const -> bool;
+
+  /* 封存的页面：记录的每个值是否都能按当前的编码写入 */
+  auto CanEncodeInPlace(const Tuple &tuple) const -> bool;
+
+  /**
+   * 列存格式：读出页面中所有记录的值并选择各列的编码，封存的页面只扩展已有的编码
+   * @param tuple 不为nullptr时，第slot_no条记录的值取自tuple（slot_no可以是新插入的slot）
+   */
+  void PlanChunks(uint16_t slot_no, const Tuple *tuple, std::vector<ChunkPlan> *plans) const;
+
+  /* 按plan编码后，capacity个slot的页面中第col_idx列占用的空间 */
+  auto GetChunkSize(const ChunkPlan &plan, int col_idx, int capacity) const -> int;
+
+  /* 按plans编码后，capacity个slot的页面占用的空间 */
+  auto GetSealedPageSize(const std::vector<ChunkPlan> &plans, int capacity) const -> int;
+
+  /* 按plans编码后页面最多能有的slot个数，放不下min_capacity个slot时返回0 */
+  auto GetMaxCapacity(const std::vector<ChunkPlan> &plans, int min_capacity) const -> int;
+
+  /* 按plans重写页面中的各列，页面变为有capacity个slot的封存页面 */
+  void WriteChunks(const std::vector<ChunkPlan> &plans, int capacity);
+
+  /* 封存的页面：按当前的编码写入记录，写不进时重新编码页面，见WriteColumnarTuple */
+  auto WriteSealedTuple(uint16_t slot_no, const Tuple &tuple) -> bool;
+
+  /**
+   * 列存格式：从各列的minipage中拼装出行格式的记录
+   * @param projection projection[i]为true时读取第i列，其余列为0或空串；为空时读取所有列
+   * @param data 拼装出的记录
+   */
+  void ReadColumnarTuple(uint16_t slot_no, const std::vector<bool> &projection, std::vector<char> *data) const;
+
+  /**
+   * 列存格式：将行格式的记录拆分写入各列的minipage，调用者已经用RmFileHandle::CheckColumnarTuple检查过记录
+   * @return false if the tuple does not fit into a sealed page (see CanWriteColumnarTuple), nothing is written
+   */
+  auto WriteColumnarTuple(uint16_t slot_no, const Tuple &tuple) -> bool;
+
   const RmFileHdr *file_hdr;  // 当前页面所在文件的文件头指针
   Page *page;                 // 页面的实际数据，包括页面存储的数据、元信息等
   // 元组信息，包括slot号(offset)、大小(size)、元数据
@@ -132,6 +354,8 @@ class RmPageHandle {
   TupleInfo *tuple_info_;  // page->data的第二部分，存储页面的元组信息，长度为num_records * sizeof(TupleInfo)
   // char *bitmap;  // page->data的第二部分，存储页面的bitmap，指针指向首地址，长度为file_hdr->bitmap_size
   // char *slots;  // page->data的第三部分，存储表的记录，指针指向首地址，每个slot的长度为file_hdr->record_size
+  RmColumnarPageHdr *columnar_hdr_;  // 列存格式：RmPageHdr之后的页头
+  TupleMeta *metas_;  // 列存格式：RmColumnarPageHdr之后，存储每个slot的元数据，长度为GetCapacity()
   char *page_start_;
 
   static constexpr size_t TUPLE_INFO_SIZE = 24;
@@ -142,12 +366,17 @@ class RmPageHandle {
 class RmFileHandle {
   friend class RmScan;
   friend class RmManager;
+  friend class RmBulkAppender;
 
  private:
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
   int fd_;              // 打开文件后产生的文件句柄
   RmFileHdr file_hdr_;  // 文件头，维护当前表文件的元数据
+  std::unique_ptr<RmFreeSpaceMap> fsm_;  // 空闲空间映射，记录每个页面的空闲空间
+  std::mutex extend_latch_;              // 用于分配新页面时的并发
+  std::unique_ptr<RmZoneMap> zone_map_;  // 每个页面各列的min/max，用于扫描时跳过页面，未启用时为nullptr
+  std::unique_ptr<RmToastStore> toast_;  // 行存格式：存放过长的变长列的值，不使用TOAST的表为nullptr
 
  public:
   RmFileHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
@@ -158,14 +387,33 @@ class RmFileHandle {
     disk_manager_->ReadPage(fd, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
     // disk_manager管理的fd对应的文件中，设置从file_hdr_.num_pages开始分配page_no
     disk_manager_->SetFd2Pageno(fd, file_hdr_.num_pages);
+    // open the free space map, rebuild it from the data pages if the table was created without one
+    fsm_ = std::make_unique<RmFreeSpaceMap>(disk_manager_, buffer_pool_manager_, disk_manager_->GetFileName(fd),
+                                            file_hdr_.num_pages);
+    if (fsm_->IsNew()) {
+      RebuildFreeSpaceMap();
+    }
+    if (RmToastStore::IsToastable(file_hdr_)) {
+      toast_ = std::make_unique<RmToastStore>(disk_manager_, buffer_pool_manager_, &file_hdr_,
+                                              disk_manager_->GetFileName(fd));
+    }
   }
 
   // RmFileHdr get_file_hdr() { return file_hdr_; }
   RmFileHdr GetFileHdr() { return file_hdr_; }
   int GetFd() { return fd_; }
+  RmFileFormat GetFormat() const { return file_hdr_.format; }
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt.
+   * Maintain zone maps for the table, so that scans with predicates can skip pages. The record layer does not
+   * know the types of the columns, so the owner of the table metadata enables them after opening the table.
+   * @param schema the schema of the table
+   */
+  void EnableZoneMap(const Schema &schema) { zone_map_ = std::make_unique<RmZoneMap>(schema); }
+
+  /**
+   * Insert a tuple into the table. On a row table with string columns, the largest values of a tuple longer than
+   * RM_TOAST_TUPLE_THRESHOLD are stored out of line, see RmToastStore.
    * @param meta tuple meta
    * @param tuple tuple to insert
    * @param context context of transaction
@@ -191,6 +439,31 @@ class RmFileHandle {
    */
   auto DeleteTuple(RID rid, Context *context) -> bool;
 
+  /**
+   * Recompute the free space of a page and record it in the free space map. Called when the deleted slots of the
+   * page become reusable, i.e. the transaction that deleted them has finished.
+   * @param page_no the page to update
+   */
+  void UpdateFreeSpace(page_id_t page_no);
+
+  /**
+   * Reclaim the space of the deleted tuples of a page that are no longer locked, see RmPageHandle::Compact.
+   * A full columnar page is sealed instead, see RmPageHandle::Seal. The free space map is updated in any case.
+   * @param page_no the page to vacuum
+   * @param lock_mgr lock manager, a deleted tuple is reclaimed only if no txn holds or waits for its lock
+   * @param log_mgr log manager, the log is flushed before the data of deleted tuples is discarded
+   * @param min_dead_ratio only vacuum the page if at least this ratio of its slots are deleted
+   * @param stats statistics to accumulate, can be nullptr
+   */
+  void VacuumPage(page_id_t page_no, LockManager *lock_mgr, LogManager *log_mgr, double min_dead_ratio = 0,
+                  RmVacuumStats *stats = nullptr);
+
+  /**
+   * Vacuum all pages of the table, and reclaim the toast pages that no tuple points to any more.
+   * @return the statistics of the vacuum
+   */
+  auto Vacuum(LockManager *lock_mgr, LogManager *log_mgr) -> RmVacuumStats;
+
   /**
    * Update a tuple in place.
    * @param meta new tuple meta
@@ -198,6 +471,8 @@ class RmFileHandle {
    * @param rid the rid of the tuple to be updated
    * @param context context of transaction
    * @param check the check to run before actually update.
+   * @return false if the check fails, or if the new values do not fit into a sealed columnar page; the caller
+   *         then deletes the tuple and inserts the new one elsewhere
    */
   auto UpdateTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid, Context *context,
                           std::function<bool(const TupleMeta &meta, const Tuple &table, RID rid)> &&check = nullptr)
@@ -212,7 +487,7 @@ class RmFileHandle {
   void UpdateTupleMeta(const TupleMeta &meta, RID rid, Context *context);
 
   /**
-   * Read a tuple from the table.
+   * Read a tuple from the table, with its toasted values read back.
    * @param rid rid of the tuple to read
    * @param context context of transaction
    * @return the meta and tuple
@@ -220,13 +495,22 @@ class RmFileHandle {
   auto GetTuple(RID rid, Context *context) -> std::pair<TupleMeta, Tuple>;
 
   /**
-   * Read a tuple from the table.
+   * Read a tuple from the table, with its toasted values read back.
    * @param rid rid of the tuple to read
    * @param context context of transaction
    * @return the tuple
    */
   auto GetTupleValue(const RID &rid, Context *context) -> std::unique_ptr<Tuple>;
 
+  /**
+   * Read several tuples of one page, with the page fetched and latched once, e.g. by a bitmap heap scan.
+   * @param rids rids of the tuples to read, all on the same page
+   * @param num_rids number of rids
+   * @param context context of transaction
+   * @param[out] tuples the tuples are appended, in the order of rids
+   */
+  void GetTuplesOnPage(const RID *rids, size_t num_rids, Context *context, std::vector<Tuple> *tuples);
+
   /**
    * Read a tuple meta from the table. Note: if you want to get tuple and meta together, use `GetTuple` instead
    * to ensure atomicity.
@@ -246,7 +530,8 @@ class RmFileHandle {
   // auto GetRecord(const RID &rid) -> std::unique_ptr<RmRecord>;
 
   /**
-   * Read a tuple from the table and generates a key tuple given schemas and attributes.
+   * Read a tuple from the table and generates a key tuple given schemas and attributes. Only the toasted values of
+   * the key attributes are read.
    * @param schema the schema of the table
    * @param key_schema the schema of the key
    * @param key_attrs the attributes of the key in the table schema
@@ -278,10 +563,23 @@ class RmFileHandle {
   void SetPageLSN(page_id_t page_id_, lsn_t lsn);
 
  private:
-  // RmPageHandle create_page_handle();
-  RmPageHandle CreatePageHandle();
+  auto ReuseDeletedSlot(RmPageHandle &page_handle, const TupleMeta &meta, const Tuple &tuple, Context *context)
+      -> std::optional<uint16_t>;
+
+  void RebuildFreeSpaceMap();
+
+  void CheckColumnarTuple(const Tuple &tuple) const;
+
+  void BuildZone(RmPageHandle &page_handle);
+
+  auto ToastTuple(const Tuple &tuple, std::shared_lock<std::shared_mutex> *gc_lock) -> std::optional<Tuple>;
+
+  void SweepToast(RmVacuumStats *stats);
+
+  void SealPage(page_id_t page_no, LockManager *lock_mgr, RmVacuumStats *stats);
+
+  void TrackRead(Context *context, const RID &rid, const TupleMeta &meta);
 
-  // void release_page_handle(RmPageHandle &page_handle);
-  void ReleasePageHandle(RmPageHandle &page_handle);
+  void CheckReadBeforeWrite(Context *context, const RID &rid, const TupleMeta &meta);
 };
 }  // namespace easydb
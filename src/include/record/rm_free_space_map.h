@@ -0,0 +1,109 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_free_space_map.h
+ *
+ * Identification: src/include/record/rm_free_space_map.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "record/rm_defs.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace easydb {
+
+/**
+ * Free space map (FSM) of a table data file, stored in its own file "<table>.fsm".
+ *
+ * Every data page has a one-byte category in the FSM, i.e. its free space divided by FSM_UNIT_SIZE and rounded
+ * up, and FindPage(size) returns a page whose category is at least that of size. Rounding up makes a deleted slot
+ * of exactly the size of the tuple findable, even though a page found may turn out to be a few bytes short.
+ *
+ * FSM page format:
+ *  ---------------------------------------------------
+ *  | Page header (8) | max-tree (FSM_NODES_PER_PAGE) |
+ *  ---------------------------------------------------
+ * The max-tree is a complete binary tree stored as an array, node i has children 2i+1 and 2i+2. Its
+ * FSM_LEAVES_PER_PAGE leaves are the categories of consecutive data pages, and every inner node is the max of its
+ * children. The root tells whether any page covered by the FSM page has enough room, and such a page is found or
+ * updated in O(log n) without scanning the data pages.
+ *
+ * The FSM is only a hint: it is not logged, and callers always check the data page itself before using it.
+ */
+class RmFreeSpaceMap {
+ public:
+  static constexpr int FSM_UNIT_SIZE = PAGE_SIZE / 256;
+  static constexpr int FSM_LEAVES_PER_PAGE = 1024;
+  static constexpr int FSM_NODES_PER_PAGE = 2 * FSM_LEAVES_PER_PAGE - 1;
+  static_assert(Page::SIZE_PAGE_HEADER + FSM_NODES_PER_PAGE <= PAGE_SIZE);
+
+  /**
+   * Open the FSM file of a table data file, create it if it does not exist.
+   * @param file_name name of the table data file
+   * @param num_pages number of pages in the table data file
+   */
+  RmFreeSpaceMap(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, const std::string &file_name,
+                 int num_pages);
+
+  /** @return the name of the FSM file of a table data file */
+  static auto GetFileName(const std::string &file_name) -> std::string { return file_name + ".fsm"; }
+
+  /** @return the category of a free space or a tuple size */
+  static auto GetCategory(int size) -> int { return (size + FSM_UNIT_SIZE - 1) / FSM_UNIT_SIZE; }
+
+  /** @return true if the FSM file has just been created, so the FSM must be rebuilt from the data pages */
+  auto IsNew() const -> bool { return is_new_; }
+
+  /**
+   * Find a data page that probably has size bytes of free space, see the category rounding above.
+   * @param size the free space needed
+   * @param hint the page to start from, the search wraps around at the end of the file
+   * @return the page number, or RM_NO_PAGE if no page has enough space
+   * @note if the tuple does not fit after all, the caller records a free space of category lower than
+   *       GetCategory(size) for the page, so the page is not returned again
+   */
+  auto FindPage(int size, page_id_t hint) -> page_id_t;
+
+  /**
+   * Record the free space of a data page.
+   * @param page_no the data page
+   * @param free_space the size of the largest tuple that can be inserted into the page
+   */
+  void Update(page_id_t page_no, int free_space);
+
+  /** Flush all FSM pages and close the FSM file. */
+  void Close();
+
+ private:
+  /* 保证FSM文件中有第fsm_page_no个FSM页面，必要时分配新页面 */
+  void Extend(int fsm_page_no);
+
+  /* 在max-tree中找到第一个不小于from、类别不小于need的叶子，没有则返回-1 */
+  static auto SearchLeaf(const uint8_t *tree, uint8_t need, int from) -> int;
+
+  static auto GetTree(Page *page) -> uint8_t * {
+    return reinterpret_cast<uint8_t *>(page->GetData() + Page::SIZE_PAGE_HEADER);
+  }
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  int fd_;        // FSM文件的文件句柄
+  bool is_new_;   // FSM文件是否是新创建的
+  std::shared_mutex latch_;     // 保护roots_和FSM页面的分配
+  std::vector<uint8_t> roots_;  // 每个FSM页面的根节点，即该页面覆盖的数据页面中最大的类别
+};
+
+}  // namespace easydb
@@ -31,18 +31,31 @@ class RmManager {
   /**
    * @description: 创建表的数据文件并初始化相关信息
    * @param {string&} filename 要创建的文件名称
-   * @param {int} record_size 表中记录的大小
+   * @param {int} record_size 表中记录定长部分的大小，变长列的值过长时存放在TOAST页面中，不计入记录的大小
+   * @param {RmFileFormat} format 存储格式
+   * @param {Schema*} schema 表的schema，据此确定每一列的布局；行存格式可以为nullptr，此时不使用TOAST
    */
-  void CreateFile(const std::string &filename, int record_size) {
+  void CreateFile(const std::string &filename, int record_size, RmFileFormat format = RmFileFormat::ROW,
+                  const Schema *schema = nullptr) {
     if (record_size < 1 || record_size > RM_MAX_RECORD_SIZE) {
       throw InvalidRecordSizeError(record_size);
     }
-    disk_manager_->CreateFile(filename);
-    int fd = disk_manager_->OpenFile(filename);
-
     // 初始化file header
     RmFileHdr file_hdr{};
     file_hdr.Init();
+    if (schema != nullptr) {
+      InitColumns(&file_hdr, schema);
+    }
+    if (format == RmFileFormat::COLUMNAR) {
+      InitColumnarLayout(&file_hdr, schema);
+    }
+
+    disk_manager_->CreateFile(filename);
+    int fd = disk_manager_->OpenFile(filename);
+    // A leftover FSM or toast file would describe the pages of a dropped file, the FSM is rebuilt when the file is
+    // opened
+    DestroyAuxFiles(filename);
+
     // file_hdr.record_size = record_size;
     // file_hdr.num_pages = 1;
     // file_hdr.first_free_page_no = RM_NO_PAGE;
@@ -58,10 +71,13 @@ class RmManager {
   }
 
   /**
-   * @description: 删除表的数据文件
+   * @description: 删除表的数据文件及其空闲空间映射文件、TOAST文件
    * @param {string&} filename 要删除的文件名称
    */
-  void DestoryFile(const std::string &filename) { disk_manager_->DestroyFile(filename); }
+  void DestoryFile(const std::string &filename) {
+    disk_manager_->DestroyFile(filename);
+    DestroyAuxFiles(filename);
+  }
 
   // 注意这里打开文件，创建并返回了record file handle的指针
   /**
@@ -83,6 +99,86 @@ class RmManager {
     // 缓冲区的所有页刷到磁盘，注意这句话必须写在close_file前面
     buffer_pool_manager_->FlushAllPages(file_handle->fd_);
     disk_manager_->CloseFile(file_handle->fd_);
+    file_handle->fsm_->Close();
+    if (file_handle->toast_ != nullptr) {
+      file_handle->toast_->Close();
+    }
+  }
+
+ private:
+  /**
+   * @description: 删除表的数据文件的空闲空间映射文件和TOAST文件（如果存在）
+   * @param {string&} filename 表的数据文件名称
+   */
+  void DestroyAuxFiles(const std::string &filename) {
+    for (const auto &aux_file_name : {RmFreeSpaceMap::GetFileName(filename), RmToastStore::GetFileName(filename)}) {
+      if (disk_manager_->IsFile(aux_file_name)) {
+        disk_manager_->DestroyFile(aux_file_name);
+      }
+    }
+  }
+
+  /**
+   * @description: 记录每一列在行格式记录中的位置和类型，行存格式据此将过长的变长列的值移到TOAST页面中。
+   *               记录的空值位图作为最后一个定长列，列存格式因此像其他列一样将其存放在自己的minipage中
+   * @param {RmFileHdr*} file_hdr 要初始化的文件头
+   * @param {Schema*} schema 表的schema
+   */
+  static void InitColumns(RmFileHdr *file_hdr, const Schema *schema) {
+    if (schema->GetColumnCount() + 1 > RM_MAX_COLUMNS) {
+      throw InternalError("RmManager::CreateFile: too many columns");
+    }
+    file_hdr->num_cols = schema->GetColumnCount() + 1;
+    file_hdr->fixed_size = schema->GetInlinedStorageSize();
+    auto &bitmap_hdr = file_hdr->cols[file_hdr->num_cols - 1];
+    bitmap_hdr.offset = schema->GetNullBitmapOffset();
+    bitmap_hdr.is_inlined = true;
+    bitmap_hdr.type = TYPE_EMPTY;
+    bitmap_hdr.width = schema->GetNullBitmapSize();
+    bitmap_hdr.minipage_offset = 0;
+    for (int i = 0; i < file_hdr->num_cols - 1; ++i) {
+      const auto &col = schema->GetColumn(i);
+      auto &col_hdr = file_hdr->cols[i];
+      col_hdr.offset = col.GetOffset();
+      col_hdr.is_inlined = col.IsInlined();
+      col_hdr.type = col.GetType();
+      // A string payload is its length followed by the string and the terminating '\0'
+      col_hdr.width = col.IsInlined() ? col.GetStorageSize() : sizeof(uint32_t) + col.GetStorageSize() + 1;
+      col_hdr.minipage_offset = 0;
+    }
+  }
+
+  /**
+   * @description: 计算列存格式下每一列的布局：每个值在minipage中占用定长的空间，变长列按最大长度预留，
+   *               因此列存格式不使用TOAST，一个页面至少要能存放一条记录
+   * @param {RmFileHdr*} file_hdr 已由InitColumns初始化的文件头
+   * @param {Schema*} schema 表的schema
+   */
+  static void InitColumnarLayout(RmFileHdr *file_hdr, const Schema *schema) {
+    if (schema == nullptr) {
+      throw InternalError("RmManager::CreateFile: invalid schema for columnar format");
+    }
+    file_hdr->format = RmFileFormat::COLUMNAR;
+    file_hdr->max_record_size = file_hdr->fixed_size;
+    int row_width = 0;
+    for (int i = 0; i < file_hdr->num_cols; ++i) {
+      const auto &col_hdr = file_hdr->cols[i];
+      if (!col_hdr.is_inlined) {
+        file_hdr->max_record_size += col_hdr.width;
+      }
+      row_width += col_hdr.width;
+    }
+    // Page format: | page header | RmPageHdr | RmColumnarPageHdr | TupleMeta[n] | minipage of column 0 (n values) | ...
+    int n = (PAGE_SIZE - COLUMNAR_PAGE_HEADER_SIZE) / (TUPLE_META_SIZE + row_width);
+    if (n < 1) {
+      throw InvalidRecordSizeError(file_hdr->max_record_size);
+    }
+    file_hdr->num_records_per_page = n;
+    int minipage_offset = COLUMNAR_PAGE_HEADER_SIZE + TUPLE_META_SIZE * n;
+    for (int i = 0; i < file_hdr->num_cols; ++i) {
+      file_hdr->cols[i].minipage_offset = minipage_offset;
+      minipage_offset += file_hdr->cols[i].width * n;
+    }
   }
 };
 }  // namespace easydb
@@ -10,8 +10,15 @@
  */
 
 #pragma once
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
 #include "common/rid.h"
 #include "rm_defs.h"
+#include "rm_zone_map.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
 
 namespace easydb {
 class RecScan {
@@ -26,19 +33,90 @@ class RecScan {
 };
 
 class RmFileHandle;
+class RmPageHandle;
+class Context;
 
+/**
+ * Sequential scan of a table data file, one page at a time.
+ *
+ * The scan pins the page it is positioned on until it moves to the next page, and reads the live slots of the page
+ * once under the page latch. The tuples of the page are handed out as TupleViews pointing into the pinned frame,
+ * so scanning a tuple neither fetches the page again nor copies the tuple.
+ *
+ * On a columnar (PAX) table the tuples are assembled from the minipages of the page. A projection restricts the
+ * columns assembled, so a scan reading a few columns of a wide table only touches their minipages. On a row table,
+ * a tuple with toasted values (see RmToastStore) is assembled as well, reading only the toast pages of the
+ * projected columns, so a scan that does not read a large column never touches its toast pages.
+ *
+ * A scan given predicates skips the pages whose zone maps (see RmZoneMap) rule them out without fetching them, and
+ * builds the zone maps of the pages it reads, so the next scans of the table can skip them. On sealed columnar
+ * pages, a predicate on a dictionary encoded column is evaluated once per dictionary entry, and the tuples whose
+ * codes do not match are skipped without being assembled.
+ *
+ * Note: the views are read without the page latch. This is safe because the data of a slot is only moved by
+ * VACUUM or by an insert growing a slot, and both require that nobody else pins the page (see
+ * RmPageHandle::CanMoveTuples); the tuples themselves are protected by the table lock of the caller. An OCC txn
+ * takes no table lock, so its scan copies each tuple under the page latch and hands out views of the copy.
+ */
 class RmScan : public RecScan {
-  const RmFileHandle *file_handle_;
+  RmFileHandle *file_handle_;
+  Context *context_;
   RID rid_;
+  Page *page_{nullptr};  // 当前所在的页面，扫描停留在该页面上时保持pin，扫描结束时为nullptr
+  // 当前页面中未删除的记录：slot号、记录在页面中的偏移量和大小
+  std::vector<std::tuple<uint16_t, uint16_t, uint16_t>> live_slots_;
+  size_t pos_{0};  // 当前记录在live_slots_中的下标
+  std::vector<bool> projection_;  // 需要读取的列（列存格式的minipage和行存格式的TOAST值），为空时读取所有列
+  std::vector<char> row_buf_;     // 当前记录拼装成行格式后的数据，用于列存格式和包含TOAST值的记录
+  bool in_row_buf_{false};        // 当前记录是否在row_buf_中，否则指向页面中的数据
+  std::vector<RmZonePredicate> preds_;  // 用于跳过页面和记录的谓词
+  int num_skipped_pages_{0};            // 根据zone map跳过的页面数
 
  public:
-  RmScan(const RmFileHandle *file_handle);
+  /**
+   * @param file_handle the table to scan
+   * @param context context of transaction, the reads of OCC txns are tracked for validation. Except for OCC txns,
+   *                the caller must hold a table lock that keeps other txns from writing to the table.
+   * @param col_ids the columns the caller reads, empty for all columns. The other columns of the tuples handed out
+   *                are zero or empty on columnar tables, and complete on row tables except for toasted values,
+   *                which are empty.
+   * @param preds predicates that every tuple the caller wants satisfies, used to skip pages by their zone maps and
+   *              tuples by their dictionary codes. The other tuples of the pages read are handed out, the caller
+   *              still evaluates its predicates.
+   */
+  RmScan(RmFileHandle *file_handle, Context *context = nullptr, const std::vector<uint32_t> &col_ids = {},
+         std::vector<RmZonePredicate> preds = {});
+
+  RmScan(const RmScan &) = delete;
+
+  auto operator=(const RmScan &) -> RmScan & = delete;
+
+  ~RmScan() override;
 
   void Next() override;
 
   bool IsEnd() const override;
 
   RID GetRid() const override;
+
+  /** @return a view of the current tuple, valid until the scan moves to the next tuple */
+  auto GetTupleView() const -> TupleView;
+
+  /** @return the number of pages skipped so far by their zone maps */
+  auto GetNumSkippedPages() const -> int { return num_skipped_pages_; }
+
+ private:
+  /* 从page_no开始找到第一个包含未删除记录的页面，pin住该页面并读取其中的记录 */
+  void LoadPage(page_id_t page_no);
+
+  /* 去掉当前页面中字典编码的列不满足谓词的记录 */
+  void FilterByDictionary(const RmPageHandle &page_handle);
+
+  /* 定位到当前页面中的第pos条记录 */
+  void SetPosition(size_t pos);
+
+  /* unpin当前页面 */
+  void ReleasePage();
 };
 
 }  // namespace easydb
@@ -0,0 +1,170 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_toast_store.h
+ *
+ * Identification: src/include/record/rm_toast_store.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "record/rm_defs.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+#include "type/limits.h"
+
+namespace easydb {
+
+/**
+ * Out-of-line (TOAST) storage of the large variable-length values of a row table, in its own file "<table>.toast".
+ *
+ * When a tuple is longer than RM_TOAST_TUPLE_THRESHOLD, its largest string values are moved out of the tuple, one
+ * at a time, until it is short enough. Each value moved is stored in a chain of toast pages, and its payload in the
+ * tuple is replaced by a pointer:
+ *  ------------------------------------------------------
+ *  | length | RM_TOAST_FLAG (4) | first toast page (4) |
+ *  ------------------------------------------------------
+ * i.e. the length word of the payload has RM_TOAST_FLAG set and is followed by the chain, not by the value. A wide
+ * row thus takes a few bytes of the data page per toasted column, and many more rows fit into a page.
+ *
+ * Toast page format:
+ *  ---------------------------------------------------------
+ *  | Page header (8) | RmToastPageHdr | value data ...      |
+ *  ---------------------------------------------------------
+ *
+ * Values are detoasted lazily: RmFileHandle hands out complete tuples, but RmScan only reads the toast pages of
+ * the projected columns, so a scan that does not read a large column never touches its toast pages.
+ *
+ * A chain is written once and never changed. An update or a delete leaves the old chain in place, since a rollback
+ * or a concurrent reader may still need it; the chains no tuple of the table points to any more are reclaimed by
+ * VACUUM (see RmFileHandle::Vacuum), which marks the chains of all slots and frees the others. The free pages are
+ * kept in memory, so after a restart they are found again by the next VACUUM.
+ *
+ * Toast pages are written through to disk when a chain is stored, so a data page on disk never points to a chain
+ * that is not on disk as well.
+ */
+class RmToastStore {
+ public:
+  /* 每个TOAST页面的页头 */
+  struct RmToastPageHdr {
+    page_id_t next_page_no;  // 链中下一个页面，最后一个页面为RM_NO_PAGE
+    uint32_t size;           // 页面中存放的数据的大小
+  };
+
+  static constexpr int TOAST_PAGE_HEADER_SIZE = Page::SIZE_PAGE_HEADER + sizeof(RmToastPageHdr);
+  static constexpr int TOAST_DATA_SIZE = PAGE_SIZE - TOAST_PAGE_HEADER_SIZE;
+  // Size of a toasted payload in the tuple: the flagged length and the first page of the chain
+  static constexpr uint32_t TOAST_POINTER_SIZE = sizeof(uint32_t) + sizeof(page_id_t);
+
+  /**
+   * Open the toast file of a table data file, create it if it does not exist.
+   * @param file_hdr the file header of the table data file, which tells the layout of the tuples
+   * @param file_name name of the table data file
+   */
+  RmToastStore(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, const RmFileHdr *file_hdr,
+               const std::string &file_name);
+
+  /** @return the name of the toast file of a table data file */
+  static auto GetFileName(const std::string &file_name) -> std::string { return file_name + ".toast"; }
+
+  /** @return true if the tables of the file header may have toasted values, i.e. row tables with string columns */
+  static auto IsToastable(const RmFileHdr &file_hdr) -> bool;
+
+  /** @return true if a payload in a tuple is a pointer to a toasted value */
+  static auto IsToasted(const char *payload) -> bool {
+    uint32_t len = *reinterpret_cast<const uint32_t *>(payload);
+    return len != EASYDB_VALUE_NULL && (len & RM_TOAST_FLAG) != 0;
+  }
+
+  /**
+   * Move the largest values of a tuple to toast pages until the tuple is no longer than RM_TOAST_TUPLE_THRESHOLD.
+   * @return the tuple with pointers to the values moved, or std::nullopt if no value was moved
+   * @note the caller holds the GC latch in shared mode until the tuple is written, see GetGcLatch
+   */
+  auto Toast(const Tuple &tuple) -> std::optional<Tuple>;
+
+  /** @return true if some value of a tuple is toasted */
+  auto HasToastedValues(const char *data) const -> bool;
+
+  /**
+   * Read the toasted values of a tuple back into it.
+   * @param data the tuple as stored in the data page
+   * @param projection projection[i] is true if column i is read, the other toasted values are left empty; read
+   *                   all the columns if empty
+   * @param out the tuple with the values read
+   * @note the caller either holds the latch of the data page or keeps the tuple from being written by a table lock,
+   *       so the chains the tuple points to cannot be reclaimed
+   */
+  void Detoast(const char *data, const std::vector<bool> &projection, std::vector<char> *out) const;
+
+  /**
+   * Read the toasted values of a tuple back into it, see Detoast. Nothing is done if no value is toasted.
+   */
+  void Detoast(Tuple *tuple, const std::vector<bool> &projection = {}) const;
+
+  /**
+   * Collect the first pages of the chains a tuple points to, used by VACUUM to mark the live chains.
+   * @param data the tuple as stored in the data page
+   */
+  void CollectChains(const char *data, std::vector<page_id_t> *chains) const;
+
+  /**
+   * Free every toast page that is not in one of the chains given.
+   * @param chains the first pages of the live chains
+   * @return the number of pages freed by this call
+   * @note the caller holds the GC latch in exclusive mode
+   */
+  auto Sweep(const std::vector<page_id_t> &chains) -> int;
+
+  /**
+   * The GC latch keeps VACUUM from reclaiming a chain between the time it is stored and the time the tuple pointing
+   * to it is written: writers hold it in shared mode, VACUUM in exclusive mode.
+   */
+  auto GetGcLatch() -> std::shared_mutex & { return gc_latch_; }
+
+  /** Flush all toast pages and close the toast file. */
+  void Close();
+
+ private:
+  /* 将一个值存放到一串TOAST页面中，返回第一个页面 */
+  auto StoreValue(const char *data, uint32_t size) -> page_id_t;
+
+  /* 从以first_page_no开头的一串TOAST页面中读出size字节的值 */
+  void LoadValue(page_id_t first_page_no, uint32_t size, char *data) const;
+
+  /* 分配一个TOAST页面，优先复用空闲的页面，返回的页面被pin住 */
+  auto AllocatePage() -> Page *;
+
+  /* 变长列的数据在记录中占用的空间，TOAST指针为TOAST_POINTER_SIZE */
+  static auto GetPayloadSize(const char *payload) -> uint32_t;
+
+  static auto GetHdr(Page *page) -> RmToastPageHdr * {
+    return reinterpret_cast<RmToastPageHdr *>(page->GetData() + Page::SIZE_PAGE_HEADER);
+  }
+
+  static auto GetData(Page *page) -> char * { return page->GetData() + TOAST_PAGE_HEADER_SIZE; }
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  const RmFileHdr *file_hdr_;  // 表数据文件的文件头，用于确定记录中各列的位置
+  int fd_;                     // TOAST文件的文件句柄
+  std::shared_mutex gc_latch_;       // 见GetGcLatch
+  std::mutex latch_;                 // 保护free_pages_和num_pages_
+  std::vector<page_id_t> free_pages_;  // 空闲的TOAST页面
+  int num_pages_;                      // TOAST文件中的页面个数
+};
+
+}  // namespace easydb
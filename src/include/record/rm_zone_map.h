@@ -0,0 +1,90 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_zone_map.h
+ *
+ * Identification: src/include/record/rm_zone_map.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/condition.h"
+#include "common/config.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace easydb {
+
+/** A comparison of a column with a constant, i.e. `col op val`, that a scan can check against the zone maps. */
+struct RmZonePredicate {
+  uint32_t col_id_;
+  CompOp op_;
+  Value val_;
+};
+
+/**
+ * Zone maps of a table data file: the min/max and the number of nulls of every column on every data page.
+ *
+ * A scan skips a page whose zone map shows that no tuple of the page can satisfy its predicates, without fetching
+ * the page. The zone of a page is built from the page the first time a scan reads it, and is widened by every
+ * tuple written to the page afterwards. Deletes never narrow it, and deleted tuples count as well, since their
+ * data comes back if the delete is rolled back; a zone is therefore a superset of the values on the page.
+ *
+ * The zone maps are kept in memory only, so they never go stale across restarts: after a restart every page is
+ * unknown again and is read, until a scan rebuilds its zone.
+ *
+ * Concurrency: Update is called by writers under the page write latch and Build under the page read latch, so a
+ * tuple written to a page is either in the data Build reads or is added by Update after Build.
+ */
+class RmZoneMap {
+ public:
+  struct ColumnZone {
+    std::optional<Value> min_;  // 最小值，页面中没有非空值时为空
+    std::optional<Value> max_;  // 最大值
+    uint32_t num_nulls_{0};     // 空值的个数
+  };
+
+  explicit RmZoneMap(const Schema &schema) : schema_(schema) {}
+
+  /** @return true if the zone of the page has been built */
+  auto IsBuilt(page_id_t page_no) const -> bool;
+
+  /**
+   * Build the zone of a page from all its tuples, including the deleted ones.
+   * @note the caller holds the page latch
+   */
+  void Build(page_id_t page_no, const std::vector<Tuple> &tuples);
+
+  /**
+   * Widen the zone of a page with a tuple written to it, nothing is done if the zone has not been built.
+   * @note the caller holds the page write latch
+   */
+  void Update(page_id_t page_no, const Tuple &tuple);
+
+  /**
+   * @return false if no tuple of the page can satisfy all the predicates, true if some may or if the zone of the
+   *         page has not been built
+   */
+  auto MayMatch(page_id_t page_no, const std::vector<RmZonePredicate> &preds) const -> bool;
+
+ private:
+  /* 用一条记录扩展页面的zone */
+  void Widen(std::vector<ColumnZone> *zone, const Tuple &tuple) const;
+
+  /* 判断一列的zone中是否可能存在满足谓词的值 */
+  static auto MayMatch(const ColumnZone &zone, const RmZonePredicate &pred) -> bool;
+
+  Schema schema_;                                          // 表的schema，用于从记录中读取各列的值
+  mutable std::shared_mutex latch_;                        // 保护zones_
+  std::vector<std::optional<std::vector<ColumnZone>>> zones_;  // 每个页面各列的zone，未建立时为空
+};
+
+}  // namespace easydb
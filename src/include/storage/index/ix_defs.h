@@ -11,12 +11,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
+#include <string>
 #include <vector>
 
 #include "common/config.h"
 #include "common/errors.h"
+#include "common/rid.h"
 #include "type/type_id.h"
 #include "type/value.h"
 
@@ -28,52 +32,192 @@ constexpr int IX_LEAF_HEADER_PAGE = 1;
 constexpr int IX_INIT_ROOT_PAGE = 2;
 constexpr int IX_INIT_NUM_PAGES = 3;
 constexpr int IX_MAX_COL_LEN = 512;
+constexpr double IX_BULK_FILL_FACTOR = 0.9;  // 自底向上批量构建时每个结点的填充率，留出空位给之后的插入
 
 constexpr int IX_INIT_DIRECTORY_PAGE = 1;
 constexpr int IX_INIT_BUCKET_0_PAGE = 2;
 constexpr int IX_INIT_BUCKET_1_PAGE = 3;
 constexpr int IX_INIT_HASH_NUM_PAGES = 4;
 constexpr int IX_INIT_HASH_FIRST_FREE_PAGES = 4;
+constexpr int IX_HASH_MAX_GLOBAL_DEPTH = 20;  // 目录最多2^20项
+constexpr int IX_HASH_KEY_LOCK_PAGE = -2;     // hash索引的key锁的page_id_，见IxExtendibleHashIndexHandle::GetKeyLock
 
-inline int ix_compare(const char *a, const char *b, ColType type, int col_len) {
+/* 主机字节序与大端之间的转换，编码后的key按大端存放，memcmp从高位字节开始比较 */
+template <typename T>
+inline T ix_big_endian(T v) {
+  if constexpr (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) {
+    return v;
+  } else if constexpr (sizeof(T) == sizeof(uint32_t)) {
+    return __builtin_bswap32(v);
+  } else {
+    return __builtin_bswap64(v);
+  }
+}
+
+template <typename T>
+inline T ix_load_big_endian(const char *src) {
+  T v;
+  memcpy(&v, src, sizeof(T));
+  return ix_big_endian(v);
+}
+
+/**
+ * @brief 把data中一列的值就地编码为保序的字节串，编码后的key按memcmp比较即为按值比较
+ * 整数翻转符号位；浮点数为正时翻转符号位，为负时所有位取反（-0.0先变为0.0）；都按大端存放。字符串不变
+ */
+inline void ix_encode(char *data, ColType type, int len) {
   switch (type) {
-    case TYPE_INT: {
-      int ia = *(int *)a;
-      int ib = *(int *)b;
-      return (ia < ib) ? -1 : ((ia > ib) ? 1 : 0);
-    }
-    case TYPE_FLOAT: {
-      float fa = *(float *)a;
-      float fb = *(float *)b;
-      return (fa < fb) ? -1 : ((fa > fb) ? 1 : 0);
+    case TYPE_INT:
+    case TYPE_LONG:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+      break;
+    default:
+      return;
+  }
+  auto encode = [&](auto bits) {
+    using T = decltype(bits);
+    memcpy(&bits, data, sizeof(T));
+    constexpr T sign = T{1} << (sizeof(T) * 8 - 1);
+    if (type == TYPE_FLOAT || type == TYPE_DOUBLE) {
+      bits = (bits & sign) != 0 ? (bits == sign ? sign : ~bits) : bits ^ sign;
+    } else {
+      bits ^= sign;
     }
-    case TYPE_CHAR:
-    case TYPE_VARCHAR:
-      return memcmp(a, b, col_len);
+    bits = ix_big_endian(bits);
+    memcpy(data, &bits, sizeof(T));
+  };
+  if (len == sizeof(uint32_t)) {
+    encode(uint32_t{});
+  } else {
+    assert(len == sizeof(uint64_t));
+    encode(uint64_t{});
+  }
+}
+
+/**
+ * @brief ix_encode的逆变换，把编码后的一列就地还原为原来的值
+ */
+inline void ix_decode(char *data, ColType type, int len) {
+  switch (type) {
+    case TYPE_INT:
+    case TYPE_LONG:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+      break;
     default:
-      throw InternalError("Unexpected data type");
+      return;
+  }
+  auto decode = [&](auto bits) {
+    using T = decltype(bits);
+    bits = ix_load_big_endian<T>(data);
+    constexpr T sign = T{1} << (sizeof(T) * 8 - 1);
+    if (type == TYPE_FLOAT || type == TYPE_DOUBLE) {
+      bits = (bits & sign) != 0 ? bits ^ sign : ~bits;
+    } else {
+      bits ^= sign;
+    }
+    memcpy(data, &bits, sizeof(T));
+  };
+  if (len == sizeof(uint32_t)) {
+    decode(uint32_t{});
+  } else {
+    assert(len == sizeof(uint64_t));
+    decode(uint64_t{});
   }
 }
 
-inline int ix_compare(const char *a, const char *b, const std::vector<ColType> &col_types,
-                      const std::vector<int> &col_lens) {
-  int offset = 0;
-  for (size_t i = 0; i < col_types.size(); ++i) {
-    int res = ix_compare(a + offset, b + offset, col_types[i], col_lens[i]);
-    if (res != 0) return res;
-    offset += col_lens[i];
+/* key去掉末尾的0x00之后的长度：定长的key末尾补0，截断后补回0即为原来的key */
+inline int ix_trimmed_len(const char *key, int len) {
+  while (len > 0 && key[len - 1] == 0) {
+    len--;
   }
-  return 0;
+  return len;
 }
 
-// wrapper function for memcpy to handle different data types
-inline void ix_memcpy(char *dest, Value &value, int len) {
-  if (value.GetTypeId() == TYPE_CHAR || value.GetTypeId() == TYPE_VARCHAR) {
-    memcpy(dest, value.GetData(), len);
+/* 两个key的公共前缀的长度 */
+inline int ix_common_prefix(const char *a, const char *b, int len) {
+  int i = 0;
+  while (i < len && a[i] == b[i]) {
+    i++;
+  }
+  return i;
+}
+
+/**
+ * @brief 后缀截断：求left < sep <= right的最短的分隔key，即right在与left第一个不同的字节之后补0
+ * 分隔key只用于内部结点和high key，截断后的key更短，前缀压缩后占用的空间更少
+ */
+inline void ix_separator(const char *left, const char *right, int len, char *sep) {
+  int prefix = ix_common_prefix(left, right, len);
+  assert(prefix < len && static_cast<unsigned char>(left[prefix]) < static_cast<unsigned char>(right[prefix]));
+  memcpy(sep, right, prefix + 1);
+  memset(sep + prefix + 1, 0, len - prefix - 1);
+}
+
+/**
+ * @brief 比较两个key：索引中的key都由ix_memcpy编码，按字节比较即为按值比较，不再按列的类型分别比较
+ */
+inline int ix_compare(const char *a, const char *b, int col_len) { return memcmp(a, b, col_len); }
+
+inline int ix_compare(const char *a, const char *b, const std::vector<int> &col_lens) {
+  int len = 0;
+  for (int col_len : col_lens) {
+    len += col_len;
+  }
+  return memcmp(a, b, len);
+}
+
+// wrapper function for memcpy to handle different data types, the key is encoded by ix_encode
+// a string shorter than the column is padded with 0, a NULL value is stored as 0
+inline void ix_memcpy(char *dest, const Value &value, int len) {
+  if (value.IsNull()) {
+    memset(dest, 0, len);
+  } else if (value.GetTypeId() == TYPE_CHAR || value.GetTypeId() == TYPE_VARCHAR) {
+    int n = std::min(static_cast<int>(value.GetStorageSize()), len);
+    memcpy(dest, value.GetData(), n);
+    memset(dest + n, 0, len - n);
   } else {
     assert(uint32_t(len) == Type(value.GetTypeId()).GetTypeSize(value.GetTypeId()));
     value.SerializeTo(dest);
+    ix_encode(dest, value.GetTypeId(), len);
+  }
+}
+
+/**
+ * @brief ix_memcpy的逆变换：把索引中编码后的一列还原为Value，字符串去掉末尾补的0
+ */
+inline Value ix_value(const char *src, ColType type, int len) {
+  if (type == TYPE_CHAR || type == TYPE_VARCHAR) {
+    return Value(type, std::string(src, strnlen(src, len)));
   }
+  char buf[sizeof(double)];
+  memcpy(buf, src, len);
+  ix_decode(buf, type, len);
+  return Value::DeserializeFrom(buf, type);
+}
+
+/**
+ * @brief INCLUDE列在payload中的长度（不含NULL标记）：字符串为列的长度，其余类型为Value序列化后的长度，
+ * FLOAT列在记录中的长度是sizeof(float)，值却按double序列化
+ */
+inline int ix_include_col_len(ColType type, int len) {
+  return type == TYPE_CHAR || type == TYPE_VARCHAR ? len : static_cast<int>(Type::GetTypeSize(type));
+}
+
+/**
+ * @brief 把INCLUDE列的值写入叶结点的payload：一个NULL标记字节，之后同ix_memcpy；payload不参与比较
+ */
+inline void ix_include_memcpy(char *dest, const Value &value, int len) {
+  dest[0] = static_cast<char>(value.IsNull());
+  ix_memcpy(dest + 1, value, len);
+}
+
+/**
+ * @brief ix_include_memcpy的逆变换
+ */
+inline Value ix_include_value(const char *src, ColType type, int len) {
+  return src[0] != 0 ? Value(type) : ix_value(src + 1, type, len);
 }
 
 class IxFileHdr {
@@ -91,6 +235,9 @@ class IxFileHdr {
   page_id_t first_leaf_;  // 首叶节点对应的页号，在上层IxManager的open函数进行初始化，初始化为root page_no
   page_id_t last_leaf_;  // 尾叶节点对应的页号
   int tot_len_;          // 记录结构体的整体长度(IxFileHdr的size)
+  int include_len_{0};   // 叶结点中每个key之后存放的INCLUDE列（payload）的长度，只用于slotted格式
+  int int_key_len_{0};   // 只有一个整数列时为其长度(4/8)，结点中按整数查找，否则为0；不写入磁盘
+  bool slotted_{false};  // 其他的索引为true，结点按slotted格式存放压缩后的变长key；不写入磁盘
 
   IxFileHdr() { tot_len_ = col_num_ = 0; }
 
@@ -110,7 +257,7 @@ class IxFileHdr {
 
   void UpdateTotLen() {
     tot_len_ = 0;
-    tot_len_ += sizeof(page_id_t) * 4 + sizeof(int) * 6;
+    tot_len_ += sizeof(page_id_t) * 4 + sizeof(int) * 7;
     tot_len_ += sizeof(ColType) * col_num_ + sizeof(int) * col_num_;
   }
 
@@ -144,6 +291,8 @@ class IxFileHdr {
     offset += sizeof(page_id_t);
     memcpy(dest + offset, &last_leaf_, sizeof(page_id_t));
     offset += sizeof(page_id_t);
+    memcpy(dest + offset, &include_len_, sizeof(int));
+    offset += sizeof(int);
     assert(offset == tot_len_);
   }
 
@@ -182,7 +331,16 @@ class IxFileHdr {
     offset += sizeof(page_id_t);
     last_leaf_ = *reinterpret_cast<const page_id_t *>(src + offset);
     offset += sizeof(page_id_t);
+    // the files written before the INCLUDE columns end here
+    if (offset < tot_len_) {
+      include_len_ = *reinterpret_cast<const int *>(src + offset);
+      offset += sizeof(int);
+    }
     assert(offset == tot_len_);
+    bool is_int = col_num_ == 1 && (col_types_[0] == TYPE_INT || col_types_[0] == TYPE_LONG);
+    // the payload is stored after the key in the slotted format
+    int_key_len_ = is_int && include_len_ == 0 ? col_lens_[0] : 0;
+    slotted_ = int_key_len_ == 0;
   }
 };
 
@@ -195,7 +353,7 @@ class ExtendibleHashIxFileHdr {
   std::vector<ColType> col_types_;  // 字段的类型
   std::vector<int> col_lens_;       // 字段的长度
   int col_tot_len_;                 // 索引包含的字段的总长度
-  int keys_size_;                   // keys_size = (BUCKET_SIZE + 1) * col_tot_len
+  int keys_size_;                   // keys_size = bucket_size * col_tot_len，见ix_hash_bucket_size
   int tot_len_;                     // 记录结构体的整体长度(IxFileHdr的size)
 
   ExtendibleHashIxFileHdr() { tot_len_ = col_num_ = 0; }
@@ -256,7 +414,6 @@ class ExtendibleHashIxFileHdr {
     offset += sizeof(page_id_t);
     col_num_ = *reinterpret_cast<const int *>(src + offset);
     offset += sizeof(int);
-    std::cout << col_num_ << "\n";
     for (int i = 0; i < col_num_; ++i) {
       // col_types_[i] = *reinterpret_cast<const ColType*>(src + offset);
       ColType type = *reinterpret_cast<const ColType *>(src + offset);
@@ -285,20 +442,42 @@ class IxPageHdr {
   bool is_leaf;         // 是否为叶节点
   page_id_t prev_leaf;  // previous leaf node's page_no, effective only when is_leaf is true
   page_id_t next_leaf;  // next leaf node's page_no, effective only when is_leaf is true
+  page_id_t right_link;  // B-link树中同一层右兄弟结点的page_no，最右结点为IX_NO_PAGE
+  bool has_high_key;     // 是否有high key（结点中key的上界，不含），最右结点没有；high key存放在页面的最后
+  // 以下只用于slotted格式
+  int prefix_len;  // 结点中所有key的公共前缀的长度，前缀存放在high key之前，key只存放前缀之后的部分
+  int heap_size;   // 存放key的区域的大小（含删除后留下的空隙），从前缀往前增长
+  int key_bytes;   // 结点中的key占用的字节数
 };
 
+/* slotted格式的槽，紧跟在IxPageHdr之后，按key的顺序排列 */
+struct IxSlot {
+  RID rid;          // 叶结点为记录的rid，内部结点为孩子结点的page_no
+  uint16_t offset;  // key在页面中的位置
+  uint16_t len;     // key去掉结点前缀和末尾的0之后的长度
+};
+
+/* 可扩展hash的桶和目录页面的页头，目录页面的页头之后为page_id_t数组 */
 class IxExtendibleHashPageHdr {
  public:
-  page_id_t next_free_page_no;  // unused
+  page_id_t next_free_page_no;  // 目录页面中为下一个目录页面的页面号，最后一个为IX_NO_PAGE；桶中未使用
   // page_id_t prev_bucket;        // Page number of the previous bucket, default is -1.
   // page_id_t next_bucket;        // Page number of the next bucket, default is -1.
   bool is_valid;  // Indicates if the current bucket is valid. Some invalid buckets may be preallocated during a split;
                   // invalid buckets do not need to be flushed to disk.
-  int local_depth;  // Depth of the current bucket
-  int key_nums;     // Number of keys in the current bucket
+  int local_depth;  // Depth of the current bucket, -1 for the directory pages
+  int key_nums;     // Number of keys in the current bucket, or number of directory entries in the directory page
   int size;         // Size of the bucket
 };
 
+constexpr int IX_HASH_DIR_ENTRIES_PER_PAGE =
+    static_cast<int>((PAGE_SIZE - sizeof(IxExtendibleHashPageHdr)) / sizeof(page_id_t));
+
+/* 一个桶页面最多存放的键值对数量 */
+inline int ix_hash_bucket_size(int col_tot_len) {
+  return static_cast<int>((PAGE_SIZE - sizeof(IxExtendibleHashPageHdr)) / (col_tot_len + sizeof(RID)));
+}
+
 class Iid {
  public:
   page_id_t page_id_;
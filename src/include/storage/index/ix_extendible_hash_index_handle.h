@@ -2,15 +2,20 @@
  *
  * EasyDB
  *
- * ix_defs.h
+ * ix_extendible_hash_index_handle.h
  *
- * Identification: src/include/storage/index/ix_defs.h
+ * Identification: src/include/storage/index/ix_extendible_hash_index_handle.h
  *
  *-------------------------------------------------------------------------
  */
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "common/rid.h"
 #include "storage/disk/disk_manager.h"
@@ -19,16 +24,15 @@
 
 namespace easydb {
 
-/* 管理中的每个节点 */
+/* 可扩展hash中的一个桶，桶内的键值对无序存放 */
 class IxBucketHandle {
   friend class IxExtendibleHashIndexHandle;
-  friend class IxScan;
 
  private:
-  const ExtendibleHashIxFileHdr *file_hdr;  // 节点所在文件的头部信息
+  const ExtendibleHashIxFileHdr *file_hdr;  // 桶所在文件的头部信息
   Page *page;                               // 存储桶的页面
   IxExtendibleHashPageHdr *page_hdr;  // page->data的第一部分，指针指向首地址，长度为sizeof(IxExtendibleHashPageHdr)
-  char *keys;  // page->data的第二部分，指针指向首地址，长度为file_hdr->keys_size，每个key的长度为file_hdr->col_len
+  char *keys;  // page->data的第二部分，指针指向首地址，长度为file_hdr->keys_size_，每个key长file_hdr->col_tot_len_
   RID *rids;   // page->data的第三部分，指针指向首地址
 
  public:
@@ -40,89 +44,60 @@ class IxBucketHandle {
     rids = reinterpret_cast<RID *>(keys + file_hdr->keys_size_);
   }
 
-  IxBucketHandle(const ExtendibleHashIxFileHdr *file_hdr_, Page *page_, int local_depth, int size, bool is_valid)
-      : file_hdr(file_hdr_), page(page_) {
-    page_hdr = reinterpret_cast<IxExtendibleHashPageHdr *>(page->GetData());
-    page_hdr->local_depth = local_depth;
-    page_hdr->size = size;
-    page_hdr->is_valid = is_valid;
-    keys = page->GetData() + sizeof(IxExtendibleHashPageHdr);
-    rids = reinterpret_cast<RID *>(keys + file_hdr->keys_size_);
-  }
-
-  int get_size() { return page_hdr->size; }
-
-  void set_size(int size) { page_hdr->size = size; }
-
-  int key_at(int i) { return *(int *)get_key(i); }
+  page_id_t get_page_no() const { return page->GetPageId().page_no; }
 
-  page_id_t value_at(int i) { return get_rid(i)->GetPageId(); }
-
-  page_id_t get_page_no() { return page->GetPageId().page_no; }
-
-  PageId get_page_id() { return page->GetPageId(); }
+  PageId get_page_id() const { return page->GetPageId(); }
 
   char *get_key(int key_idx) const { return keys + key_idx * file_hdr->col_tot_len_; }
 
   RID *get_rid(int rid_idx) const { return &rids[rid_idx]; }
 
-  void set_key(int key_idx, const char *key) {
-    memcpy(keys + key_idx * file_hdr->col_tot_len_, key, file_hdr->col_tot_len_);
-  }
-
-  void set_rid(int rid_idx, const RID &rid) { rids[rid_idx] = rid; }
+  bool IsFull() const { return page_hdr->key_nums == page_hdr->size; }
 
-  // bucket操作
-  bool IsFull() { return page_hdr->size == page_hdr->key_nums; }
+  int GetLocalDepth() const { return page_hdr->local_depth; }
 
-  int GetLocalDepth() { return page_hdr->local_depth; }
+  void SetLocalDepth(int local_depth) { page_hdr->local_depth = local_depth; }
 
-  void IncrementLocalDepth() { page_hdr->local_depth++; }
-
-  // int operator[](int index);
-
-  int GetNumOfKeys() { return page_hdr->key_nums; }
-
-  void Clear() { page_hdr->key_nums = 0; }
+  int GetNumOfKeys() const { return page_hdr->key_nums; }
 
+  /* 在桶的末尾插入键值对，返回插入后的键值对数量 */
   int Insert(const char *key, const RID &value);
 
-  int Insert(int pos, const char *key, const RID &value);
-
-  int Remove(const char *key);
+  /* 删除第pos个键值对，用最后一个键值对填补其位置 */
+  void RemoveAt(int pos);
 
-  bool Find(const char *key);
-
-  int Find(const char *key, std::vector<RID> *result);
-
-  // bool TestRuntimeError(const char *key);  // 没懂干啥的。
-
-  void Reorganize(int pos);
-
-  void DoubleDirectory(int new_size);
-
-  void Update(int old_idx, int new_idx);
+  /* 返回key在桶中的位置，不存在时返回-1 */
+  int Find(const char *key) const;
 };
 
-/* extendible hash  */
+/**
+ * Extendible hash index: the directory maps the low global_depth bits of the hash of a key to the bucket holding
+ * the key, so a point lookup reads exactly one bucket page. A full bucket is split in two by one more bit of the
+ * hash, the directory is doubled when the bucket already uses all the bits of the directory. The keys are unique
+ * like the B+ tree indexes: inserting a key that exists fails.
+ *
+ * The directory is kept in memory and written to the directory pages when the index is closed, like the root of the
+ * B+ tree is kept in the file header; after a crash the indexes are rebuilt from the tables.
+ *
+ * Concurrency: the directory is read under the shared dir_latch_ only long enough to find the bucket and latch its
+ * page, so lookups, inserts and deletes in different buckets run in parallel. A full bucket is split, and the
+ * directory doubled, under the exclusive dir_latch_; the latches are always taken directory first, then bucket.
+ */
 class IxExtendibleHashIndexHandle {
-  friend class IxScan;
   friend class IxManager;
 
  private:
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
-  int fd_;                             // 存储可扩展hash的文件
-  ExtendibleHashIxFileHdr *file_hdr_;  // 存了root_page，但其初始化为2（第0页存FILE_HDR_PAGE，第1页存LEAF_HEADER_PAGE）
-  std::mutex root_latch_;
-  int global_depth;     // Record the global depth of the hash table
-  int size_per_bucket;  // Size of each bucket
+  int fd_;                                             // 存储可扩展hash的文件
+  std::unique_ptr<ExtendibleHashIxFileHdr> file_hdr_;  // 文件头，目录的第一个页面为file_hdr_->directory_page_
+  mutable std::shared_mutex dir_latch_;                // 保护目录，找桶时加读锁，分裂桶时加写锁
+  int global_depth_;                                   // 目录使用hash值的低global_depth_位
+  std::vector<page_id_t> directory_;                   // 大小为2^global_depth_，每一项为桶的页面号
 
  public:
   IxExtendibleHashIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
 
-  ~IxExtendibleHashIndexHandle();
-
   // for search
   bool GetValue(const char *key, std::vector<RID> *result);
 
@@ -132,36 +107,46 @@ class IxExtendibleHashIndexHandle {
   // for delete
   bool DeleteEntry(const char *key);
 
-  bool Erase();
+  int GetGlobalDepth() const {
+    std::shared_lock lock{dir_latch_};
+    return global_depth_;
+  }
 
-  int getGlobalDepth() { return global_depth; }
+  int GetFd() const { return fd_; }
 
-  // hash function
-  int HashFunction(const char *key, int n);
+  int GetBucketSize() const { return file_hdr_->keys_size_ / file_hdr_->col_tot_len_; }
 
- private:
-  void ReleaseBucketHandle(IxBucketHandle &bucket);
+  /**
+   * hash索引上没有key的间隙，事务对key本身加GAP锁：等值查找锁住key，插入和删除key前等待该锁，以防止幻读
+   * @return 代表key的锁对象，page_id_为IX_HASH_KEY_LOCK_PAGE，不会与B+树的iid相同
+   */
+  Iid GetKeyLock(const char *key) const;
 
-  // for index test
-  RID GetRid(const Iid &iid) const;
+  /* 把目录写回目录页面，目录页面不够时在文件末尾分配 */
+  void FlushDirectory();
 
-  // split the bucket
-  void SplitBucket(int originalBucket);
+ private:
+  uint64_t Hash(const char *key) const;
 
-  // double the num of buckets
-  void DoubleDirectory();
+  /* 读取目录页面中的目录 */
+  void LoadDirectory();
+
+  /* 注意：返回的桶已pin，使用后需要unpin */
+  IxBucketHandle FetchBucket(page_id_t page_no) const;
 
-  // update pointers in the bucket
-  void UpdatePointers(int index, int new_local_depth);
+  /* 在目录的读锁下找到hash所在的桶并锁住桶(exclusive时为写锁)，返回前释放目录的读锁；用ReleaseBucket释放 */
+  IxBucketHandle LatchBucket(uint64_t hash, bool exclusive) const;
 
-  // create a new bucket
-  IxBucketHandle *CreateBucket(int index, const char *key, int new_local_depth);
+  /* 释放桶上的锁并unpin */
+  void ReleaseBucket(const IxBucketHandle &bucket, bool exclusive, bool is_dirty) const;
 
-  IxBucketHandle *FetchBucket(int page_no) const;
+  IxBucketHandle CreateBucket(int local_depth);
 
-  IxBucketHandle *FindBucketPage(const char *key);
+  /* 按hash值的第local_depth位把已满的桶分裂为两个，hash为桶中任意一个key的hash值；调用者持有目录的写锁 */
+  void SplitBucket(IxBucketHandle *bucket, uint64_t hash);
 
-  IxBucketHandle *FindBucketPage(int index);
+  /* 目录大小翻倍，新的一半指向与原来一半相同的桶 */
+  void DoubleDirectory();
 };
 
 }  // namespace easydb
@@ -11,7 +11,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <shared_mutex>
 #include <string>
+#include <utility>
+#include <vector>
 #include "storage/disk/disk_manager.h"
 #include "storage/index/ix_defs.h"
 #include "storage/page/page.h"
@@ -25,38 +30,10 @@ namespace easydb {
 
 enum class Operation { FIND = 0, INSERT, DELETE };  // 三种操作：查找、插入、删除
 
-static const bool binary_search = false;
+// 批量构建索引时的一个键值对，key长度为col_tot_len，有INCLUDE列时其后紧跟include_len字节的payload
+using IxEntry = std::pair<std::string, RID>;
 
-inline int IxCompare(const char *a, const char *b, ColType type, int col_len) {
-  switch (type) {
-    case TYPE_INT: {
-      int ia = *(int *)a;
-      int ib = *(int *)b;
-      return (ia < ib) ? -1 : ((ia > ib) ? 1 : 0);
-    }
-    case TYPE_FLOAT: {
-      float fa = *(float *)a;
-      float fb = *(float *)b;
-      return (fa < fb) ? -1 : ((fa > fb) ? 1 : 0);
-    }
-    case TYPE_CHAR:
-    case TYPE_VARCHAR:
-      return memcmp(a, b, col_len);
-    default:
-      throw InternalError("Unexpected data type");
-  }
-}
-
-inline int IxCompare(const char *a, const char *b, const std::vector<ColType> &col_types,
-                     const std::vector<int> &col_lens) {
-  int offset = 0;
-  for (size_t i = 0; i < col_types.size(); ++i) {
-    int res = IxCompare(a + offset, b + offset, col_types[i], col_lens[i]);
-    if (res != 0) return res;
-    offset += col_lens[i];
-  }
-  return 0;
-}
+static const bool binary_search = false;
 
 /* 管理B+树中的每个节点 */
 class IxNodeHandle {
@@ -67,8 +44,12 @@ class IxNodeHandle {
   const IxFileHdr *file_hdr;  // 节点所在文件的头部信息
   Page *page;                 // 存储节点的页面
   IxPageHdr *page_hdr;        // page->data的第一部分，指针指向首地址，长度为sizeof(IxPageHdr)
+  // 定长格式（只有一个整数列的索引）：
   char *keys;  // page->data的第二部分，指针指向首地址，长度为file_hdr->keys_size，每个key的长度为file_hdr->col_len
   RID *rids;   // page->data的第三部分，指针指向首地址
+  // slotted格式（其他的索引）：槽数组紧跟page_hdr向后增长；key去掉结点的公共前缀和末尾的0后存放在页面后部，
+  // 从前缀往前增长；页面最后依次为前缀和high key。叶结点中每个key之后紧跟INCLUDE列的payload
+  IxSlot *slots;
 
  public:
   IxNodeHandle() = default;
@@ -77,6 +58,7 @@ class IxNodeHandle {
     page_hdr = reinterpret_cast<IxPageHdr *>(page->GetData());
     keys = page->GetData() + sizeof(IxPageHdr);
     rids = reinterpret_cast<RID *>(keys + file_hdr->keys_size_);
+    slots = reinterpret_cast<IxSlot *>(page->GetData() + sizeof(IxPageHdr));
   }
 
   const IxPageHdr *GetPageHdr() { return page_hdr; }
@@ -84,7 +66,15 @@ class IxNodeHandle {
 
   int GetSize() { return page_hdr->num_key; }
 
-  void SetSize(int size) { page_hdr->num_key = size; }
+  /* 只保留前size个键值对 */
+  void SetSize(int size) {
+    if (file_hdr->slotted_) {
+      for (int i = size; i < page_hdr->num_key; ++i) {
+        page_hdr->key_bytes -= slots[i].len + GetPayloadLen();
+      }
+    }
+    page_hdr->num_key = size;
+  }
 
   int GetMaxSize() { return file_hdr->btree_order_ + 1; }
 
@@ -92,7 +82,50 @@ class IxNodeHandle {
 
   int GetColNum() { return file_hdr->col_num_; }
 
-  int KeyAt(int i) { return *(int *)GetKey(i); }
+  int KeyAt(int i) {
+    std::string key(file_hdr->col_tot_len_, '\0');
+    CopyKey(i, key.data());
+    ix_decode(key.data(), TYPE_INT, sizeof(int));
+    return *reinterpret_cast<const int *>(key.data());
+  }
+
+  /* slotted格式中结点可用的空间：页面除去page_hdr和high key */
+  int GetUsableSize() const { return PAGE_SIZE - static_cast<int>(sizeof(IxPageHdr)) - file_hdr->col_tot_len_; }
+
+  /* slotted格式中前缀、槽和key占用的空间 */
+  int GetUsedSize() const {
+    return page_hdr->prefix_len + page_hdr->num_key * static_cast<int>(sizeof(IxSlot)) + page_hdr->key_bytes;
+  }
+
+  /* slotted格式中一个键值对最多占用的空间 */
+  int GetMaxEntrySize() const {
+    return static_cast<int>(sizeof(IxSlot)) + file_hdr->col_tot_len_ - page_hdr->prefix_len + GetPayloadLen();
+  }
+
+  /* 叶结点中每个key之后的payload的长度，内部结点没有payload */
+  int GetPayloadLen() const { return page_hdr->is_leaf ? file_hdr->include_len_ : 0; }
+
+  /* 第key_idx个key之后的payload */
+  const char *GetPayload(int key_idx) const { return GetSuffix(key_idx) + slots[key_idx].len; }
+
+  /**
+   * @brief 结点是否已满，需要分裂：定长格式达到max size；slotted格式放不下一个最长的键值对
+   * 结点在插入前总是未满的，因此插入一个键值对总能放下
+   */
+  bool IsFull() {
+    if (!file_hdr->slotted_) {
+      return GetSize() >= GetMaxSize();
+    }
+    return GetUsableSize() - GetUsedSize() < GetMaxEntrySize();
+  }
+
+  /* 结点是否过空，需要合并或重分配：定长格式少于min size；slotted格式占用的空间少于可用空间的1/4 */
+  bool IsUnderflow() {
+    if (!file_hdr->slotted_) {
+      return GetSize() < GetMinSize();
+    }
+    return GetUsedSize() < GetUsableSize() / 4;
+  }
 
   /* 得到第i个孩子结点的page_no */
   page_id_t ValueAt(int i) { return GetRid(i)->GetPageId(); }
@@ -111,25 +144,111 @@ class IxNodeHandle {
 
   bool IsRootPage() { return GetParentPageNo() == INVALID_PAGE_ID; }
 
+  /**
+   * @brief 结点在operation之后是否不会分裂或合并，即不会修改父结点
+   * 插入：插入后不会达到max size；删除：删除后不会小于min size（根结点：删除后仍有键值对/多于一个孩子）
+   */
+  bool IsSafe(Operation operation) {
+    if (operation == Operation::INSERT) {
+      if (file_hdr->slotted_) {
+        return GetUsableSize() - GetUsedSize() >= 2 * GetMaxEntrySize();
+      }
+      return GetSize() + 1 < GetMaxSize();
+    }
+    if (operation == Operation::DELETE) {
+      if (IsRootPage()) {
+        return GetSize() > (IsLeafPage() ? 1 : 2);
+      }
+      if (file_hdr->slotted_) {
+        return GetUsedSize() - GetMaxEntrySize() >= GetUsableSize() / 4;
+      }
+      return GetSize() > GetMinSize();
+    }
+    return true;
+  }
+
   void SetNextLeaf(page_id_t page_no) { page_hdr->next_leaf = page_no; }
 
   void SetPrevLeaf(page_id_t page_no) { page_hdr->prev_leaf = page_no; }
 
   void SetParentPageNo(page_id_t parent) { page_hdr->parent = parent; }
 
-  char *GetKey(int key_idx) const { return keys + key_idx * file_hdr->col_tot_len_; }
+  page_id_t GetRightLink() { return page_hdr->right_link; }
+
+  void SetRightLink(page_id_t page_no) { page_hdr->right_link = page_no; }
+
+  bool HasHighKey() { return page_hdr->has_high_key; }
+
+  /* high key存放在页面的最后，IxManager计算btree_order时已为其留出空间 */
+  char *GetHighKey() const { return page->GetData() + PAGE_SIZE - file_hdr->col_tot_len_; }
+
+  void SetHighKey(const char *key) {
+    memcpy(GetHighKey(), key, file_hdr->col_tot_len_);
+    page_hdr->has_high_key = true;
+  }
+
+  void ClearHighKey() { page_hdr->has_high_key = false; }
+
+  /* 把high key和right link设为与other相同，用于分裂出的右结点接替原结点、合并后的左结点接替右结点 */
+  void CopyRightBound(IxNodeHandle *other) {
+    SetRightLink(other->GetRightLink());
+    if (other->HasHighKey()) {
+      SetHighKey(other->GetHighKey());
+    } else {
+      ClearHighKey();
+    }
+  }
 
-  RID *GetRid(int rid_idx) const { return &rids[rid_idx]; }
+  /* key不小于high key，说明结点被并发地分裂过，key在右兄弟结点（或更右边）中 */
+  bool NeedMoveRight(const char *key) {
+    return HasHighKey() && memcmp(key, GetHighKey(), file_hdr->col_tot_len_) >= 0;
+  }
 
-  void SetKey(int key_idx, const char *key) {
-    memcpy(keys + key_idx * file_hdr->col_tot_len_, key, file_hdr->col_tot_len_);
+  /* 定长格式中第key_idx个key的地址；slotted格式用CopyKey取出完整的key */
+  char *GetKey(int key_idx) const {
+    assert(!file_hdr->slotted_);
+    return keys + key_idx * file_hdr->col_tot_len_;
   }
 
-  void SetRid(int rid_idx, const RID &Rid) { rids[rid_idx] = Rid; }
+  RID *GetRid(int rid_idx) const { return file_hdr->slotted_ ? &slots[rid_idx].rid : &rids[rid_idx]; }
+
+  void SetKey(int key_idx, const char *key);
+
+  void SetRid(int rid_idx, const RID &Rid) { *GetRid(rid_idx) = Rid; }
+
+  void CopyKey(int key_idx, char *dest) const;
+
+  void CopyEntry(int key_idx, char *dest) const;
+
+  int CompareKey(int key_idx, const char *target) const;
+
+  int GetPrefixLen() const { return file_hdr->slotted_ ? page_hdr->prefix_len : 0; }
+
+  /* 公共前缀存放在high key之前 */
+  const char *GetPrefix() const { return GetHighKey() - page_hdr->prefix_len; }
+
+  void SetPrefix(const char *key, int prefix_len);
+
+  void ShrinkPrefix(int prefix_len);
+
+  int GetSplitPoint() const;
+
+  bool CanMerge(IxNodeHandle *other);
+
+  bool CanTake(const char *key, int prefix_len);
+
+  bool CanReplaceKey(int key_idx, const char *key);
+
+  void AppendPairs(const IxNodeHandle *src, int begin, int end);
 
   int LowerBound(const char *target) const;
 
-  int UpperBound(const char *target) const;
+  int UpperBound(const char *target, int begin = 0) const;
+
+  template <typename T>
+  int IntBound(const char *target, bool upper, int begin) const;
+
+  int SlottedBound(const char *target, bool upper, int begin) const;
 
   void InsertPairs(int pos, const char *key, const RID *rid, int n);
 
@@ -178,34 +297,61 @@ class IxNodeHandle {
   std::vector<std::vector<std::string>> GetDeserializeKeys() {
     if (file_hdr == nullptr || page_hdr == nullptr) return std::vector<std::vector<std::string>>();
     std::vector<std::vector<std::string>> result;
-    int offset = 0;
+    int col_offset = 0;
     int col_types_size = file_hdr->col_types_.size();
+    std::string key(file_hdr->col_tot_len_, '\0');
     for (int i = 0; i < col_types_size; i++) {
       std::vector<std::string> tmp_res;
       for (int j = 0; j < page_hdr->num_key; j++) {
         auto cur_type = file_hdr->col_types_[i];
         auto cur_lens = file_hdr->col_lens_[i];
         std::string tmp_str;
+        // 压缩后的key先还原为完整的key
+        CopyKey(j, key.data());
+        const char *col = key.data() + col_offset;
+        // 数值在索引中是编码后的，先还原
+        char value[sizeof(double)] = {};
+        if (cur_type != TYPE_CHAR && cur_type != TYPE_VARCHAR) {
+          memcpy(value, col, cur_lens);
+          ix_decode(value, cur_type, cur_lens);
+        }
         if (cur_type == TYPE_INT) {
-          tmp_str = std::to_string(*(int *)(keys + offset));
+          tmp_str = std::to_string(*(int *)value);
         } else if (cur_type == TYPE_LONG) {
-          tmp_str = std::to_string(*(long long *)(keys + offset));
+          tmp_str = std::to_string(*(long long *)value);
         } else if (cur_type == TYPE_FLOAT) {
-          tmp_str = std::to_string(*(float *)(keys + offset));
+          tmp_str = std::to_string(cur_lens == sizeof(float) ? *(float *)value : *(double *)value);
         } else if (cur_type == TYPE_DOUBLE) {
-          tmp_str = std::to_string(*(double *)(keys + offset));
+          tmp_str = std::to_string(*(double *)value);
         } else if (cur_type == TYPE_CHAR) {
-          tmp_str = std::string(keys + offset);
+          tmp_str = std::string(col, strnlen(col, cur_lens));
         } else if (cur_type == TYPE_VARCHAR) {
-          tmp_str = std::string(keys + offset);
+          tmp_str = std::string(col, strnlen(col, cur_lens));
         }
         tmp_res.push_back(tmp_str);
-        offset += cur_lens;
       }
+      col_offset += file_hdr->col_lens_[i];
       result.push_back(tmp_res);
     }
     return result;
   }
+
+ private:
+  // for slotted format
+  const char *GetSuffix(int key_idx) const { return page->GetData() + slots[key_idx].offset; }
+
+  // key的存放区域为[GetHeapBegin(), GetHeapEnd())，从公共前缀之前向前增长
+  int GetHeapEnd() const { return PAGE_SIZE - file_hdr->col_tot_len_ - page_hdr->prefix_len; }
+
+  int GetHeapBegin() const { return GetHeapEnd() - page_hdr->heap_size; }
+
+  int CompareSuffix(int key_idx, const char *suffix, int len) const;
+
+  int GetStoredLen(const char *key, int prefix_len) const;
+
+  int GetKeyBytes(int prefix_len) const;
+
+  void Compact();
 };
 
 /* B+树 */
@@ -219,18 +365,30 @@ class IxIndexHandle {
   int fd_;  // 存储B+树的文件
   // IxFileHdr *file_hdr_;  // 存了root_page，但其初始化为2（第0页存FILE_HDR_PAGE，第1页存LEAF_HEADER_PAGE）
   std::unique_ptr<IxFileHdr> file_hdr_;
-  std::mutex root_latch_;
+  std::shared_mutex root_latch_;  // 保护file_hdr_->root_page_，查找时加读锁，可能修改根结点时加写锁
+  std::mutex file_hdr_latch_;     // 保护file_hdr_->num_pages_，不同子树的分裂/合并可以同时进行
+  bool blink_{true};              // 查找是否按B-link树的方式下降，同一时刻只持有一个读锁
+  // 键值对左移到左兄弟结点或结点被删除的次数，B-link查找据此判断是否需要重新查找
+  std::atomic<uint64_t> smo_epoch_{0};
 
  public:
   IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd);
 
   int GetFd() const { return fd_; }
 
+  // 叶结点中每个key之后存放的INCLUDE列的长度
+  int GetIncludeLen() const { return file_hdr_->include_len_; }
+
+  // 关闭后查找按latch crabbing下降；写操作总是维护high key和right link，可以随时切换
+  void SetBLink(bool blink) { blink_ = blink; }
+
   // for search
   bool GetValue(const char *key, std::vector<RID> *result, Transaction *transaction);
 
-  std::pair<IxNodeHandle *, bool> FindLeafPage(const char *key, Operation operation, Transaction *transaction,
-                                               bool find_first = false);
+  bool GetValue(const char *key, RID *rid, Transaction *transaction);
+
+  std::pair<IxNodeHandle, bool> FindLeafPage(const char *key, Operation operation,
+                                             std::deque<Page *> *latched_pages = nullptr);
 
   // for insert
   page_id_t InsertEntry(const char *key, const RID &value, Transaction *transaction);
@@ -239,6 +397,9 @@ class IxIndexHandle {
 
   void InsertIntoParent(IxNodeHandle *old_node, const char *key, IxNodeHandle *new_node, Transaction *transaction);
 
+  // for bulk load
+  bool BulkLoad(std::vector<IxEntry> *entries, Transaction *transaction, double fill_factor = IX_BULK_FILL_FACTOR);
+
   // for delete
   bool DeleteEntry(const char *key, Transaction *transaction);
 
@@ -246,7 +407,7 @@ class IxIndexHandle {
 
   bool AdjustRoot(IxNodeHandle *old_root_node);
 
-  void Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index);
+  bool Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index);
 
   bool Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node, IxNodeHandle **parent, int index,
                 Transaction *transaction, bool *root_is_latched);
@@ -257,15 +418,26 @@ class IxIndexHandle {
 
   Iid UpperBound(const char *key);
 
+  /**
+   * 在iid所在的叶结点中从iid开始查找key的LowerBound(upper为false)或UpperBound(upper为true)，不从根结点下降
+   * 用于按key递增的多个范围的扫描：下一个范围的边界常常就在当前叶结点上
+   * @return key不在该叶结点的范围内(不小于high key)时返回false，需要用LowerBound/UpperBound重新查找
+   */
+  bool BoundInLeaf(const Iid &iid, const char *key, bool upper, Iid *result) const;
+
   Iid LeafEnd() const;
 
   Iid LeafBegin() const;
 
+  RID GetEntry(const Iid &iid, char *entry) const;
+
   IxNodeHandle *GetRoot() const;
 
   // for get/create node
   IxNodeHandle *FetchNode(int page_no) const;
 
+  IxNodeHandle PinNode(int page_no) const;
+
  private:
   // 辅助函数
   void UpdateRootPageNo(page_id_t root) { file_hdr_->root_page_ = root; }
@@ -274,9 +446,24 @@ class IxIndexHandle {
 
   IxNodeHandle *CreateNode();
 
-  // for maintain data structure
-  void MaintainParent(IxNodeHandle *node);
+  void BuildBottomUp(const std::vector<IxEntry> &entries, double fill_factor);
+
+  std::vector<int> SplitLevel(const std::vector<const char *> &keys, const std::vector<std::string> &lows,
+                              double fill_factor, int payload_len) const;
+
+  int NodePrefixLen(const std::vector<std::string> &lows, int begin, int end) const;
 
+  void MakeSeparator(bool is_leaf, const char *left_key, const char *right_key, char *sep) const;
+
+  // for B-link search
+  IxNodeHandle FindLeafPageBLink(const char *key);
+
+  // for latch crabbing
+  std::deque<Page *> *GetLatchedPages(Transaction *transaction, std::deque<Page *> *local_pages);
+
+  void ReleaseLatchedPages(std::deque<Page *> *latched_pages, bool is_dirty);
+
+  // for maintain data structure
   void EraseLeaf(IxNodeHandle *leaf);
 
   void ReleaseNodeHandle(IxNodeHandle &node);
@@ -53,7 +53,11 @@ class IxManager {
     return disk_manager_->IsFile(ix_name);
   }
 
-  void CreateIndex(const std::string &filename, const std::vector<ColMeta> &index_cols) {
+  /**
+   * @brief 创建B+树索引文件
+   * @param include_len 叶结点中每个key之后存放的INCLUDE列的长度，非0时总是用slotted格式
+   */
+  void CreateIndex(const std::string &filename, const std::vector<ColMeta> &index_cols, int include_len = 0) {
     std::string ix_name = GetIndexName(filename, index_cols);
     // Create index file
     disk_manager_->CreateFile(ix_name);
@@ -69,12 +73,14 @@ class IxManager {
     for (auto &col : index_cols) {
       col_tot_len += col.len;
     }
-    if (col_tot_len > IX_MAX_COL_LEN) {
-      throw InvalidColLengthError(col_tot_len);
+    if (col_tot_len + include_len > IX_MAX_COL_LEN) {
+      throw InvalidColLengthError(col_tot_len + include_len);
     }
-    // 根据 |page_hdr| + (|attr| + |Rid|) * (n + 1) <= PAGE_SIZE 求得n的最大值btree_order
+    // 根据 |page_hdr| + (|attr| + |Rid|) * (n + 1) + |high key| <= PAGE_SIZE 求得n的最大值btree_order
     // 即 n <= btree_order，那么btree_order就是每个结点最多可插入的键值对数量（实际还多留了一个空位，但其不可插入）
-    int btree_order = static_cast<int>((PAGE_SIZE - sizeof(IxPageHdr)) / (col_tot_len + sizeof(RID)) - 1);
+    // 只用于定长格式（单个整数列）；其他索引用slotted格式，按占用的字节数判断结点是否已满
+    int btree_order =
+        static_cast<int>((PAGE_SIZE - sizeof(IxPageHdr) - col_tot_len) / (col_tot_len + sizeof(RID)) - 1);
     assert(btree_order > 2);
 
     // Create file header and write to file
@@ -84,6 +90,7 @@ class IxManager {
       fhdr->col_types_.push_back(index_cols[i].type);
       fhdr->col_lens_.push_back(index_cols[i].len);
     }
+    fhdr->include_len_ = include_len;
     fhdr->UpdateTotLen();
 
     char *data = new char[fhdr->tot_len_];
@@ -105,6 +112,11 @@ class IxManager {
           .is_leaf = true,
           .prev_leaf = IX_INIT_ROOT_PAGE,
           .next_leaf = IX_INIT_ROOT_PAGE,
+          .right_link = IX_NO_PAGE,
+          .has_high_key = false,
+          .prefix_len = 0,
+          .heap_size = 0,
+          .key_bytes = 0,
       };
       disk_manager_->WritePage(fd, IX_LEAF_HEADER_PAGE, page_buf, PAGE_SIZE);
     }
@@ -120,6 +132,11 @@ class IxManager {
           .is_leaf = true,
           .prev_leaf = IX_LEAF_HEADER_PAGE,
           .next_leaf = IX_LEAF_HEADER_PAGE,
+          .right_link = IX_NO_PAGE,
+          .has_high_key = false,
+          .prefix_len = 0,
+          .heap_size = 0,
+          .key_bytes = 0,
       };
       // Must write PAGE_SIZE here in case of future FetchNode()
       disk_manager_->WritePage(fd, IX_INIT_ROOT_PAGE, page_buf, PAGE_SIZE);
@@ -134,17 +151,16 @@ class IxManager {
     delete[] data;
   }
 
-  void CreateExtendibleHashIndex(const std::string &filename, const std::vector<ColMeta> &index_cols){
+  /**
+   * 创建可扩展hash索引文件：文件头、一个目录页面和两个桶，初始的global depth为1
+   */
+  void CreateExtendibleHashIndex(const std::string &filename, const std::vector<ColMeta> &index_cols) {
     std::string ix_name = GetIndexName(filename, index_cols);
     // Create index file
     disk_manager_->CreateFile(ix_name);
     // Open index file
     int fd = disk_manager_->OpenFile(ix_name);
 
-    // Create file header and write to file
-    // Theoretically we have: |page_hdr| + (|attr| + |rid|) * n <= PAGE_SIZE
-    // but we reserve one slot for convenient inserting and deleting, i.e.
-    // |page_hdr| + (|attr| + |rid|) * (n + 1) <= PAGE_SIZE
     int col_tot_len = 0;
     int col_num = index_cols.size();
     for (auto &col : index_cols) {
@@ -153,61 +169,43 @@ class IxManager {
     if (col_tot_len > IX_MAX_COL_LEN) {
       throw InvalidColLengthError(col_tot_len);
     }
+    // |page_hdr| + (|attr| + |rid|) * bucket_size <= PAGE_SIZE
+    int bucket_size = ix_hash_bucket_size(col_tot_len);
 
     // Create file header and write to file
-    ExtendibleHashIxFileHdr *fhdr =
-        new ExtendibleHashIxFileHdr(IX_INIT_HASH_FIRST_FREE_PAGES, IX_INIT_HASH_NUM_PAGES, IX_INIT_DIRECTORY_PAGE,
-                                    col_num, col_tot_len, (BUCKET_SIZE + 1) * col_tot_len);
+    auto fhdr = std::make_unique<ExtendibleHashIxFileHdr>(IX_INIT_HASH_FIRST_FREE_PAGES, IX_INIT_HASH_NUM_PAGES,
+                                                          IX_INIT_DIRECTORY_PAGE, col_num, col_tot_len,
+                                                          bucket_size * col_tot_len);
     for (int i = 0; i < col_num; ++i) {
       fhdr->col_types_.push_back(index_cols[i].type);
       fhdr->col_lens_.push_back(index_cols[i].len);
     }
     fhdr->update_tot_len();
 
-    char *data = new char[fhdr->tot_len_];
-    fhdr->serialize(data);
-
-    disk_manager_->WritePage(fd, IX_FILE_HDR_PAGE, data, fhdr->tot_len_);
-    delete[] data;
+    std::vector<char> data(fhdr->tot_len_);
+    fhdr->serialize(data.data());
+    disk_manager_->WritePage(fd, IX_FILE_HDR_PAGE, data.data(), fhdr->tot_len_);
 
     char page_buf[PAGE_SIZE];  // 在内存中初始化page_buf中的内容，然后将其写入磁盘
-    memset(page_buf, 0, PAGE_SIZE);
+    auto phdr = reinterpret_cast<IxExtendibleHashPageHdr *>(page_buf);
 
-    // Create initial bucket page 0 and write to file
-    {
+    // Create initial buckets 0 and 1, the keys are distributed by the lowest bit of the hash
+    for (page_id_t page_no : {IX_INIT_BUCKET_0_PAGE, IX_INIT_BUCKET_1_PAGE}) {
       memset(page_buf, 0, PAGE_SIZE);
-      auto phdr = reinterpret_cast<IxExtendibleHashPageHdr *>(page_buf);
-      *phdr = {.next_free_page_no = IX_NO_PAGE, .is_valid = true, .local_depth = 1, .key_nums = 0, .size = BUCKET_SIZE};
+      *phdr = {.next_free_page_no = IX_NO_PAGE, .is_valid = true, .local_depth = 1, .key_nums = 0, .size = bucket_size};
       // Must write PAGE_SIZE here in case of future fetch_node()
-      disk_manager_->WritePage(fd, IX_INIT_BUCKET_0_PAGE, page_buf, PAGE_SIZE);
+      disk_manager_->WritePage(fd, page_no, page_buf, PAGE_SIZE);
     }
 
-    // Create initial bucket page 1 and write to file
+    // Create directory page and write to file
     {
       memset(page_buf, 0, PAGE_SIZE);
-      auto phdr = reinterpret_cast<IxExtendibleHashPageHdr *>(page_buf);
-      *phdr = {.next_free_page_no = IX_NO_PAGE, .is_valid = true, .local_depth = 1, .key_nums = 0, .size = BUCKET_SIZE};
-      // Must write PAGE_SIZE here in case of future fetch_node()
-      disk_manager_->WritePage(fd, IX_INIT_BUCKET_1_PAGE, page_buf, PAGE_SIZE);
-    }
-
-    // Create directory bucket page and write to file
-    {
-      memset(page_buf, 0, PAGE_SIZE);
-      auto phdr = reinterpret_cast<IxExtendibleHashPageHdr *>(page_buf);
-      *phdr = {
-          .next_free_page_no = IX_NO_PAGE, .is_valid = true, .local_depth = -1, .key_nums = 2, .size = BUCKET_SIZE};
-      char *tp_keys = page_buf + sizeof(IxExtendibleHashPageHdr);
-      RID *tp_rids = reinterpret_cast<RID *>(tp_keys + fhdr->keys_size_);
-      // tp_rids[0] = {.page_id_ = IX_INIT_BUCKET_0_PAGE, .slot_num_ = IX_NO_PAGE};  // only page_no is valid
-      // tp_rids[1] = {.page_id_ = IX_INIT_BUCKET_1_PAGE, .slot_num_ = IX_NO_PAGE};  // only page_no is valid
-      tp_rids[0].Set(IX_INIT_BUCKET_0_PAGE, IX_NO_PAGE);
-      tp_rids[1].Set(IX_INIT_BUCKET_1_PAGE, IX_NO_PAGE);
-      // Must write PAGE_SIZE here in case of future fetch_node()
+      *phdr = {.next_free_page_no = IX_NO_PAGE, .is_valid = true, .local_depth = -1, .key_nums = 2, .size = 0};
+      auto entries = reinterpret_cast<page_id_t *>(page_buf + sizeof(IxExtendibleHashPageHdr));
+      entries[0] = IX_INIT_BUCKET_0_PAGE;
+      entries[1] = IX_INIT_BUCKET_1_PAGE;
       disk_manager_->WritePage(fd, IX_INIT_DIRECTORY_PAGE, page_buf, PAGE_SIZE);
     }
-    disk_manager_->SetFd2Pageno(fd, IX_INIT_HASH_NUM_PAGES - 1);  // DEBUG
-    delete fhdr;
     // Close index file
     disk_manager_->CloseFile(fd);
   }
@@ -235,11 +233,11 @@ class IxManager {
     return std::make_unique<IxIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
   }
 
-  IxExtendibleHashIndexHandle* OpenExtendibleHashIndex(const std::string &filename, const std::vector<ColMeta> &index_cols){
+  std::unique_ptr<IxExtendibleHashIndexHandle> OpenExtendibleHashIndex(const std::string &filename,
+                                                                       const std::vector<ColMeta> &index_cols) {
     std::string ix_name = GetIndexName(filename, index_cols);
     int fd = disk_manager_->OpenFile(ix_name);
-    IxExtendibleHashIndexHandle *tp = new IxExtendibleHashIndexHandle(disk_manager_, buffer_pool_manager_, fd);
-    return tp;
+    return std::make_unique<IxExtendibleHashIndexHandle>(disk_manager_, buffer_pool_manager_, fd);
   }
 
   void CloseIndex(const IxIndexHandle *ih) {
@@ -251,16 +249,16 @@ class IxManager {
     disk_manager_->CloseFile(ih->fd_);
   }
 
-  void CloseExtendibleHashIndex(const IxExtendibleHashIndexHandle* ih){
-    char *data = new char[ih->file_hdr_->tot_len_];
-    ih->file_hdr_->serialize(data);
-    disk_manager_->WritePage(ih->fd_, IX_FILE_HDR_PAGE, data, ih->file_hdr_->tot_len_);
+  void CloseExtendibleHashIndex(IxExtendibleHashIndexHandle *ih) {
+    // 目录只在内存中修改，关闭前写回目录页面
+    ih->FlushDirectory();
+    std::vector<char> data(ih->file_hdr_->tot_len_);
+    ih->file_hdr_->serialize(data.data());
+    disk_manager_->WritePage(ih->fd_, IX_FILE_HDR_PAGE, data.data(), ih->file_hdr_->tot_len_);
     // 缓冲区的所有页刷到磁盘，注意这句话必须写在close_file前面
     buffer_pool_manager_->FlushAllPages(ih->fd_);
     disk_manager_->CloseFile(ih->fd_);
-    delete[] data;
   }
-  
 };
 
 }  // namespace easydb
@@ -37,6 +37,9 @@ class IxScan : public RecScan {
 
   RID GetRid() const override;
 
+  // 当前键值对的key和INCLUDE列，见IxIndexHandle::GetEntry
+  RID GetEntry(char *entry) const { return ih_->GetEntry(iid_, entry); }
+
   const Iid &GetIid() const { return iid_; }
 
   void set_lower(const Iid &lower) { iid_ = lower; }
@@ -48,13 +48,16 @@ static_assert(sizeof(TupleMeta) == TUPLE_META_SIZE);
 
 /**
  * Tuple format:
- * ---------------------------------------------------------------------
- * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
- * ---------------------------------------------------------------------
+ * -----------------------------------------------------------------------------------
+ * | FIXED-SIZE or VARIED-SIZED OFFSET | NULL BITMAP | PAYLOAD OF VARIED-SIZED FIELD |
+ * -----------------------------------------------------------------------------------
+ * Bit i of the null bitmap is set if column i is null. A null fixed-size value is left zeroed, a null string still
+ * has its payload, which is only the length EASYDB_VALUE_NULL.
  */
 class Tuple {
   friend class RmPageHandle;
   friend class RmFileHandle;
+  friend class RmToastStore;
   friend class TablePage;
   friend class TableHeap;
   friend class TableIterator;
@@ -114,19 +117,14 @@ class Tuple {
 
   auto GetValue(const Schema *schema, std::string column_name) const -> Value;
 
-  auto GetValue(const Column col) const -> Value;
-
   auto GetValueVec(const Schema *schema) const -> std::vector<Value>;
 
   // Generates a key tuple given schemas and attributes
   auto KeyFromTuple(const Schema &schema, const Schema &key_schema,
                     const std::vector<uint32_t> &key_attrs) const -> Tuple;
 
-  // Is the column value null ?
-  inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
-    Value value = GetValue(schema, column_idx);
-    return value.IsNull();
-  }
+  // Is the column value null ? Only tests its bit in the null bitmap
+  auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool;
 
   auto ToString(const Schema *schema) const -> std::string;
 
@@ -144,4 +142,49 @@ class Tuple {
   std::vector<char> data_;
 };
 
+/**
+ * A read-only view of a tuple stored elsewhere, e.g. in a page pinned by RmScan. It does not own the data, so it
+ * is only valid as long as the storage it points into, and must be copied with ToTuple() to outlive it.
+ */
+class TupleView {
+ public:
+  TupleView() = default;
+
+  TupleView(const char *data, uint32_t size, RID rid) : data_(data), size_(size), rid_(rid) {}
+
+  // return RID of current tuple
+  inline auto GetRid() const -> RID { return rid_; }
+
+  // Get the address of this tuple in the backing store
+  inline auto GetData() const -> const char * { return data_; }
+
+  // Get length of the tuple, including varchar length
+  inline auto GetLength() const -> uint32_t { return size_; }
+
+  // Get the value of a specified column
+  auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
+
+  auto GetValue(const Schema *schema, const std::string &column_name) const -> Value;
+
+  // Is the column value null ? Only tests its bit in the null bitmap
+  auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool { return IsNull(data_, schema, column_idx); }
+
+  // Copy the tuple out of the backing store
+  auto ToTuple() const -> Tuple;
+
+  // Get the starting storage address of a column in the tuple data
+  static auto GetDataPtr(const char *data, const Column &col) -> const char *;
+
+  // Test the bit of a column in the null bitmap of the tuple data
+  static auto IsNull(const char *data, const Schema *schema, uint32_t column_idx) -> bool {
+    uint8_t bits = static_cast<uint8_t>(data[schema->GetNullBitmapOffset() + column_idx / 8]);
+    return (bits & (1U << (column_idx % 8))) != 0;
+  }
+
+ private:
+  const char *data_{nullptr};
+  uint32_t size_{0};
+  RID rid_{};
+};
+
 }  // namespace easydb
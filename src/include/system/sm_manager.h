@@ -15,6 +15,7 @@ See the Mulan PSL v2 for more details. */
 #include "record/rm_manager.h"
 #include "sm_defs.h"
 #include "sm_meta.h"
+#include "sm_stats.h"
 #include "storage/index/ix_defs.h"
 #include "storage/index/ix_manager.h"
 #include "storage/table/tuple.h"
@@ -38,6 +39,8 @@ class SmManager {
       fhs_;  // file name -> record file handle, 当前数据库中每张表的数据文件
   std::unordered_map<std::string, std::unique_ptr<IxIndexHandle>>
       ihs_;  // file name -> index file handle, 当前数据库中每个索引的文件
+  std::unordered_map<std::string, std::unique_ptr<IxExtendibleHashIndexHandle>>
+      hash_ihs_;  // file name -> hash index file handle, 当前数据库中每个hash索引的文件，B+树索引在ihs_中
  private:
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
@@ -50,6 +53,8 @@ class SmManager {
   std::unordered_map<std::string, std::unordered_map<std::string, float>> table_attr_min_;
   std::unordered_map<std::string, std::unordered_map<std::string, float>> table_attr_sum_;
   std::unordered_map<std::string, std::unordered_map<std::string, int>> table_attr_distinct_;
+  std::unordered_map<std::string, std::unordered_map<std::string, int>> table_attr_null_count_;
+  std::unordered_map<std::string, std::unordered_map<std::string, EquiDepthHistogram>> table_attr_histogram_;
   // -1 for not load, 0 for loading, 1 for loaded
   int load_ = -1;
   std::vector<std::future<void>> futures_;
@@ -89,13 +94,21 @@ class SmManager {
 
   void DescTable(const std::string &tab_name, Context *context);
 
-  void CreateTable(const std::string &tab_name, const std::vector<ColDef> &col_defs, Context *context);
+  void CreateTable(const std::string &tab_name, const std::vector<ColDef> &col_defs, Context *context,
+                   RmFileFormat format = RmFileFormat::ROW);
 
   void DropTable(const std::string &tab_name, Context *context);
 
   void ShowIndex(const std::string &tab_name, Context *context);
 
-  void CreateIndex(const std::string &tab_name, const std::vector<std::string> &col_names, Context *context);
+  void ShowLocks(Context *context);
+
+  void ShowLockStats(Context *context);
+
+  void Vacuum(const std::string &tab_name, Context *context);
+
+  void CreateIndex(const std::string &tab_name, const std::vector<std::string> &col_names, Context *context,
+                   const std::vector<std::string> &include_names = {}, bool is_hash = false);
 
   void DropIndex(const std::string &tab_name, const std::vector<std::string> &col_names, Context *context);
 
@@ -110,6 +123,17 @@ class SmManager {
 
   void RollbackUpdate(const std::string &table_name, RID &rid, Tuple &record, Context *context);
 
+  // index entries of both the B+ tree and the hash indexes
+  // return false if the key exists
+  bool InsertIndexEntry(const std::string &tab_name, const IndexMeta &index, const char *entry, const RID &rid,
+                        Transaction *txn);
+
+  bool DeleteIndexEntry(const std::string &tab_name, const IndexMeta &index, const char *key, Transaction *txn);
+
+  // the GAP lock to wait for before the key is inserted or deleted:
+  // the gap of the key in a B+ tree index, the key itself in a hash index
+  Iid GetIndexGap(const std::string &tab_name, const IndexMeta &index, const char *key);
+
   // split string by delimiter
   void Split(const std::string &s, char delimiter, std::vector<std::string> &tokens);
 
@@ -237,6 +261,37 @@ class SmManager {
     return table_attr_sum_[table_name][attr_name];
   }
 
+  // table statistics, the NULLs are counted over all the loads like the rows of the table
+  void SetTableAttrNullCount(const std::string &table_name, const std::string &attr_name, int count) {
+    table_attr_null_count_[table_name][attr_name] += count;
+  }
+
+  // 0 if table or attr not found
+  int GetTableAttrNullCount(const std::string &table_name, const std::string &attr_name) {
+    auto tab_it = table_attr_null_count_.find(table_name);
+    if (tab_it == table_attr_null_count_.end()) return 0;
+    auto attr_it = tab_it->second.find(attr_name);
+    if (attr_it == tab_it->second.end()) return 0;
+    return attr_it->second;
+  }
+
+  // table statistics
+  void SetTableAttrHistogram(const std::string &table_name, const std::string &attr_name,
+                             EquiDepthHistogram histogram) {
+    table_attr_histogram_[table_name][attr_name] = std::move(histogram);
+  }
+
+  // nullptr if table or attr not found
+  const EquiDepthHistogram *GetTableAttrHistogram(const std::string &table_name, const std::string &attr_name) {
+    auto tab_it = table_attr_histogram_.find(table_name);
+    if (tab_it == table_attr_histogram_.end()) return nullptr;
+    auto attr_it = tab_it->second.find(attr_name);
+    if (attr_it == tab_it->second.end()) return nullptr;
+    return &attr_it->second;
+  }
+
+ private:
+  std::string GetLockObjectName(const LockDataId &lock_data_id);
 };
 
 }  // namespace easydb
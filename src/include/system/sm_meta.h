@@ -20,6 +20,7 @@
 #include "common/errors.h"
 #include "common/exception.h"
 #include "sm_defs.h"
+#include "storage/index/ix_defs.h"
 #include "type/type_id.h"
 
 namespace easydb {
@@ -62,15 +63,57 @@ struct ColMeta {
 
 /* 索引元数据 */
 struct IndexMeta {
-  std::string tab_name;           // 索引所属表名称
-  int col_tot_len;                // 索引字段长度总和
-  int col_num;                    // 索引字段数量
-  std::vector<ColMeta> cols;      // 索引包含的字段
-  std::vector<uint32_t> col_ids;  // 索引字段在表schema中的位置
+  std::string tab_name;               // 索引所属表名称
+  int col_tot_len;                    // 索引字段长度总和
+  int col_num;                        // 索引字段数量
+  std::vector<ColMeta> cols;          // 索引包含的字段
+  std::vector<uint32_t> col_ids;      // 索引字段在表schema中的位置
+  std::vector<ColMeta> include_cols;  // INCLUDE的字段，只存放在叶结点中，不参与比较
+  std::vector<uint32_t> include_ids;  // INCLUDE字段在表schema中的位置
+  bool is_hash = false;               // USING HASH：可扩展hash索引，只支持等值查找，否则为B+树索引
   // Schema schema;
 
   // IndexMeta() {}
 
+  /* 叶结点中key之后存放的INCLUDE字段的长度：每个字段为一个NULL标记字节加上ix_include_col_len */
+  int GetIncludeLen() const {
+    int len = 0;
+    for (auto &col : include_cols) {
+      len += 1 + ix_include_col_len(col.type, col.len);
+    }
+    return len;
+  }
+
+  /* 判断索引的字段和INCLUDE字段是否包含了col_names中的所有字段，即只读索引就能得到这些字段 */
+  bool is_covering(const std::vector<std::string> &col_names) const {
+    auto has_col = [](const std::vector<ColMeta> &cols, const std::string &col_name) {
+      return std::any_of(cols.begin(), cols.end(), [&](const ColMeta &col) { return col.name == col_name; });
+    };
+    return std::all_of(col_names.begin(), col_names.end(), [&](const std::string &col_name) {
+      return has_col(cols, col_name) || has_col(include_cols, col_name);
+    });
+  }
+
+  /**
+   * 由一条记录构造索引项：key之后紧跟INCLUDE字段，没有INCLUDE字段时即为key
+   * @param get_value get_value(col_id)返回记录中第col_id个字段的值
+   */
+  template <typename GetValue>
+  std::string MakeEntry(GetValue &&get_value) const {
+    std::string entry(col_tot_len + GetIncludeLen(), '\0');
+    int offset = 0;
+    for (int i = 0; i < col_num; ++i) {
+      ix_memcpy(entry.data() + offset, get_value(col_ids[i]), cols[i].len);
+      offset += cols[i].len;
+    }
+    for (size_t i = 0; i < include_cols.size(); ++i) {
+      int len = ix_include_col_len(include_cols[i].type, include_cols[i].len);
+      ix_include_memcpy(entry.data() + offset, get_value(include_ids[i]), len);
+      offset += 1 + len;
+    }
+    return entry;
+  }
+
   friend std::ostream &operator<<(std::ostream &os, const IndexMeta &index) {
     os << index.tab_name << " " << index.col_tot_len << " " << index.col_num;
     for (auto &col : index.cols) {
@@ -79,6 +122,14 @@ struct IndexMeta {
     for (auto &col_index : index.col_ids) {
       os << "\n" << col_index;
     }
+    os << "\n" << index.include_cols.size();
+    for (auto &col : index.include_cols) {
+      os << "\n" << col;
+    }
+    for (auto &col_index : index.include_ids) {
+      os << "\n" << col_index;
+    }
+    os << "\n" << index.is_hash;
     return os;
   }
 
@@ -94,6 +145,29 @@ struct IndexMeta {
       is >> col_index;
       index.col_ids.push_back(col_index);
     }
+    // a db.meta written before INCLUDE and USING HASH ends the index here: the next token is the table name of the
+    // next index or the schema of the table, never a number, and is left to the caller
+    if (!is) {
+      return is;
+    }
+    auto pos = is.tellg();
+    size_t include_num = 0;
+    if (!(is >> include_num)) {
+      is.clear();
+      is.seekg(pos);
+      return is;
+    }
+    for (size_t i = 0; i < include_num; ++i) {
+      ColMeta col;
+      is >> col;
+      index.include_cols.push_back(col);
+    }
+    for (size_t i = 0; i < include_num; ++i) {
+      uint32_t col_index;
+      is >> col_index;
+      index.include_ids.push_back(col_index);
+    }
+    is >> index.is_hash;
     return is;
   }
 };
@@ -115,6 +189,8 @@ struct TabMeta {
     for (auto col : other.cols) cols.push_back(col);
   }
 
+  TabMeta &operator=(const TabMeta &other) = default;
+
   /* 判断当前表中是否存在名为col_name的字段 */
   bool is_col(const std::string &col_name) const {
     auto pos = std::find_if(cols.begin(), cols.end(), [&](const ColMeta &col) { return col.name == col_name; });
@@ -176,21 +252,27 @@ struct TabMeta {
   }
 
   friend std::istream &operator>>(std::istream &is, TabMeta &tab) {
-    size_t n;
+    size_t n = 0;
     is >> tab.name >> n;
-    for (size_t i = 0; i < n; i++) {
+    for (size_t i = 0; i < n && is; i++) {
       ColMeta col;
-      is >> col;
-      tab.cols.push_back(col);
+      if (is >> col) {
+        tab.cols.push_back(col);
+      }
     }
+    n = 0;
     is >> n;
-    for (size_t i = 0; i < n; ++i) {
+    for (size_t i = 0; i < n && is; ++i) {
       IndexMeta index;
-      is >> index;
-      tab.indexes.push_back(index);
+      if (is >> index) {
+        tab.indexes.push_back(index);
+      }
     }
     // TODO
     // is >> tab.schema;
+    // the schema line written by operator<< is not parsed yet, skip it so that the next table starts on its own line
+    std::string schema_line;
+    std::getline(is >> std::ws, schema_line);
     return is;
   }
 };
@@ -234,11 +316,17 @@ class DbMeta {
   }
 
   friend std::istream &operator>>(std::istream &is, DbMeta &db_meta) {
-    size_t n;
-    is >> db_meta.name_ >> n;
+    // a truncated or malformed catalog is an error, opening the database without some of its tables would lose them
+    size_t n = 0;
+    if (!(is >> db_meta.name_ >> n)) {
+      throw InternalError("DbMeta::operator>> failed to read the database name and table count");
+    }
     for (size_t i = 0; i < n; i++) {
       TabMeta tab;
-      is >> tab;
+      if (!(is >> tab)) {
+        throw InternalError("DbMeta::operator>> failed to read table " + std::to_string(i) + " of " +
+                            std::to_string(n));
+      }
       db_meta.tabs_[tab.name] = tab;
     }
     return is;
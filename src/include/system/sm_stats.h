@@ -0,0 +1,137 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * sm_stats.h
+ *
+ * Identification: src/include/system/sm_stats.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "type/type_id.h"
+#include "type/value.h"
+
+namespace easydb {
+
+/**
+ * HyperLogLog sketch of the number of distinct values of a column.
+ *
+ * Each value is hashed with murmur3, the first PRECISION bits of the hash pick a register, which keeps the longest
+ * run of leading zeros seen in the other bits. The sketch takes NUM_REGISTERS bytes whatever the number of values,
+ * with a standard error of about 1.04 / sqrt(NUM_REGISTERS), i.e. 1.6%. Sketches of disjoint parts of a column are
+ * merged by taking the max of each register.
+ */
+class HyperLogLog {
+ public:
+  static constexpr int PRECISION = 12;
+  static constexpr int NUM_REGISTERS = 1 << PRECISION;
+
+  HyperLogLog() : registers_(NUM_REGISTERS, 0) {}
+
+  /** Add the value stored in data[0, len). */
+  void Add(const void *data, int len);
+
+  /** Add the values added to another sketch. */
+  void Merge(const HyperLogLog &other);
+
+  /** @return the estimated number of distinct values added */
+  auto Estimate() const -> int64_t;
+
+ private:
+  std::vector<uint8_t> registers_;  // 每个寄存器记录的最长前导零个数+1
+};
+
+/**
+ * Equi-depth histogram of a column: each bucket holds about the same number of rows. bounds_[0] is the smallest
+ * value, and bucket i holds the values in (bounds_[i], bounds_[i + 1]].
+ */
+class EquiDepthHistogram {
+ public:
+  EquiDepthHistogram() = default;
+
+  /**
+   * Build the histogram from a sample of the column.
+   * @param sample the sampled values, not NULL
+   * @param num_buckets the number of buckets, fewer if the sample is smaller
+   */
+  EquiDepthHistogram(std::vector<Value> sample, int num_buckets);
+
+  auto IsEmpty() const -> bool { return bounds_.empty(); }
+
+  auto GetNumBuckets() const -> int { return bounds_.empty() ? 0 : static_cast<int>(bounds_.size()) - 1; }
+
+  auto GetBounds() const -> const std::vector<Value> & { return bounds_; }
+
+  /**
+   * @return the estimated fraction of the rows whose value is less than val, interpolated inside the bucket for
+   *         numbers; 0.5 if the histogram is empty
+   */
+  auto EstimateLessThan(const Value &val) const -> double;
+
+ private:
+  std::vector<Value> bounds_;  // 各个桶的边界，共GetNumBuckets()+1个
+};
+
+/**
+ * Statistics of a column collected in a single pass over its values, e.g. by LOAD DATA: the exact min, max and sum
+ * of a numeric column, the number of distinct values by HyperLogLog and a reservoir sample for the histogram, for
+ * numeric and string columns alike. Builders of disjoint parts of a column, e.g. one per loading thread, are merged.
+ */
+class ColumnStatsBuilder {
+ public:
+  static constexpr int SAMPLE_SIZE = 4096;     // 直方图的采样个数
+  static constexpr int HISTOGRAM_BUCKETS = 64;  // 直方图的桶个数
+
+  /**
+   * @param type type of the column
+   * @param seed seed of the sampling, builders that are merged use different seeds
+   */
+  explicit ColumnStatsBuilder(ColType type, uint32_t seed = 0) : type_(type), rng_(seed) {}
+
+  /** Add a value of the column, NULL is left out. */
+  void Add(const Value &val);
+
+  /** Add the values added to another builder of the same column. */
+  void Merge(ColumnStatsBuilder &&other);
+
+  /** @return the number of values added that are not NULL */
+  auto GetCount() const -> int64_t { return count_; }
+
+  auto IsNumeric() const -> bool { return IsNumeric(type_); }
+
+  auto GetMin() const -> double { return min_; }
+
+  auto GetMax() const -> double { return max_; }
+
+  auto GetSum() const -> double { return sum_; }
+
+  auto EstimateDistinct() const -> int64_t { return distinct_.Estimate(); }
+
+  auto BuildHistogram() const -> EquiDepthHistogram { return EquiDepthHistogram(sample_, HISTOGRAM_BUCKETS); }
+
+  static auto IsNumeric(ColType type) -> bool {
+    return type == TYPE_INT || type == TYPE_LONG || type == TYPE_FLOAT || type == TYPE_DOUBLE;
+  }
+
+  /** @return a numeric value as a double */
+  static auto ToDouble(const Value &val) -> double;
+
+ private:
+  ColType type_;
+  int64_t count_{0};
+  double min_{0};
+  double max_{0};
+  double sum_{0};
+  HyperLogLog distinct_;
+  std::vector<Value> sample_;  // 非NULL值的均匀采样（reservoir sampling）
+  std::mt19937_64 rng_;
+};
+
+}  // namespace easydb
@@ -19,6 +19,7 @@
 #include <deque>
 #include <memory>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "common/config.h"
@@ -33,6 +34,7 @@ class Transaction {
       : state_(TransactionState::DEFAULT), isolation_level_(isolation_level), txn_id_(txn_id) {
     write_set_ = std::make_shared<std::deque<WriteRecord *>>();
     lock_set_ = std::make_shared<std::unordered_set<LockDataId>>();
+    read_set_ = std::make_shared<std::unordered_map<LockDataId, ReadRecord>>();
     index_latch_page_set_ = std::make_shared<std::deque<Page *>>();
     index_deleted_page_set_ = std::make_shared<std::deque<Page *>>();
     prev_lsn_ = INVALID_LSN;
@@ -53,6 +55,15 @@ class Transaction {
 
   inline IsolationLevel GetIsolationLevel() { return isolation_level_; }
 
+  // 记录的版本号(TupleMeta.ts_)：本事务写入的记录版本号为txn_id + 1，回滚时置为其相反数，
+  // 保证回滚前后的版本号不同；0表示记录不是由事务写入的（如load data）
+  inline timestamp_t GetWriteVersion() { return static_cast<timestamp_t>(txn_id_) + 1; }
+  inline timestamp_t GetRollbackVersion() { return -GetWriteVersion(); }
+
+  inline ConcurrencyMode GetConcurrencyMode() { return concurrency_mode_; }
+  inline void SetConcurrencyMode(ConcurrencyMode concurrency_mode) { concurrency_mode_ = concurrency_mode; }
+  inline bool IsOptimistic() { return concurrency_mode_ == ConcurrencyMode::OPTIMISTIC; }
+
   inline TransactionState GetState() { return state_; }
   inline void SetState(TransactionState state) { state_ = state; }
 
@@ -70,6 +81,8 @@ class Transaction {
 
   inline std::shared_ptr<std::unordered_set<LockDataId>> GetLockSet() { return lock_set_; }
 
+  inline std::shared_ptr<std::unordered_map<LockDataId, ReadRecord>> GetReadSet() { return read_set_; }
+
  private:
   bool txn_mode_;                   // 用于标识当前事务为显式事务还是单条SQL语句的隐式事务
   TransactionState state_;          // 事务状态
@@ -78,9 +91,11 @@ class Transaction {
   lsn_t prev_lsn_;                  // 当前事务执行的最后一条操作对应的lsn，用于系统故障恢复
   txn_id_t txn_id_;                 // 事务的ID，唯一标识符
   timestamp_t start_ts_;            // 事务的开始时间戳
+  ConcurrencyMode concurrency_mode_{ConcurrencyMode::TWO_PHASE_LOCKING};  // 事务开始时采用的并发控制算法
 
   std::shared_ptr<std::deque<WriteRecord *>> write_set_;        // 事务包含的所有写操作
   std::shared_ptr<std::unordered_set<LockDataId>> lock_set_;    // 事务申请的所有锁
+  std::shared_ptr<std::unordered_map<LockDataId, ReadRecord>> read_set_;  // OCC事务读到的记录及其版本
   std::shared_ptr<std::deque<Page *>> index_latch_page_set_;    // 维护事务执行过程中加锁的索引页面
   std::shared_ptr<std::deque<Page *>> index_deleted_page_set_;  // 维护事务执行过程中删除的索引页面
 };
@@ -16,8 +16,13 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <thread>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "concurrency/lock_manager.h"
 #include "recovery/log_manager.h"
@@ -26,9 +31,6 @@
 
 namespace easydb {
 
-/* 系统采用的并发控制算法，当前题目中要求两阶段封锁并发控制算法 */
-enum class ConcurrencyMode { TWO_PHASE_LOCKING = 0, BASIC_TO };
-
 class TransactionManager {
   friend class RecoveryManager;
 
@@ -40,19 +42,26 @@ class TransactionManager {
     concurrency_mode_ = concurrency_mode;
   }
 
-  ~TransactionManager() = default;
+  ~TransactionManager();
 
   Transaction *Begin(Transaction *txn, LogManager *log_manager);
 
   void Commit(Transaction *txn, LogManager *log_manager);
 
+  bool ValidateReadSet(Transaction *txn);
+
   void Abort(Transaction *txn, LogManager *log_manager);
 
   void CreateStaticCheckpoint(Transaction *txn, LogManager *log_manager);
 
-  ConcurrencyMode GetConcurrencyMode() { return concurrency_mode_; }
+  ConcurrencyMode GetConcurrencyMode() { return concurrency_mode_.load(); }
+
+  // 只影响之后开始的事务，已开始的事务沿用开始时的并发控制算法
+  void SetConcurrencyMode(ConcurrencyMode concurrency_mode) { concurrency_mode_.store(concurrency_mode); }
+
+  bool IsEnableAutoVacuum() { return enable_auto_vacuum_.load(); }
 
-  void SetConcurrencyMode(ConcurrencyMode concurrency_mode) { concurrency_mode_ = concurrency_mode; }
+  void SetEnableAutoVacuum(bool enable_auto_vacuum) { enable_auto_vacuum_.store(enable_auto_vacuum); }
 
   LockManager *GetLockManager() { return lock_manager_; }
 
@@ -61,40 +70,44 @@ class TransactionManager {
    * @return {Transaction*} 事务对象的指针
    * @param {txn_id_t} txn_id 事务ID
    */
-  Transaction *GetTransaction(txn_id_t txn_id) {
-    if (txn_id == INVALID_TXN_ID) return nullptr;
+  Transaction *GetTransaction(txn_id_t txn_id);
 
-    std::unique_lock<std::mutex> lock(latch_);
-    assert(TransactionManager::txn_map.find(txn_id) != TransactionManager::txn_map.end());
-    auto *res = TransactionManager::txn_map[txn_id];
-    lock.unlock();
-    assert(res != nullptr);
-    assert(res->GetThreadId() == std::this_thread::get_id());
+  // release txn of the thread in the map
+  void ReleaseTxnOfThread(std::thread::id thread_id);
 
-    return res;
+ private:
+  /* 全局事务表的一个分片，按txn_id散列，各分片之间互不干扰 */
+  struct TxnMapShard {
+    std::mutex latch_;                                     // 用于本分片txn_map_的并发
+    std::unordered_map<txn_id_t, Transaction *> txn_map_;  // 存放事务ID与事务对象的映射关系
+  };
+
+  inline TxnMapShard &GetShard(txn_id_t txn_id) {
+    return txn_shards_[static_cast<size_t>(txn_id) % TXN_MAP_SHARD_NUM];
   }
 
-  // release txn of the thread in the map
-  void ReleaseTxnOfThread(std::thread::id thread_id) {
-    std::unique_lock<std::mutex> lock(latch_);
-    for (auto it = txn_map.begin(); it != txn_map.end();) {
-      if (it->second->GetThreadId() == thread_id) {
-        delete it->second;
-        it = txn_map.erase(it);
-      } else {
-        ++it;
-      }
-    }
-    lock.unlock();
-  }
+  void RegisterTxn(Transaction *txn);
 
-  static std::unordered_map<txn_id_t, Transaction *> txn_map;  // 全局事务表，存放事务ID与事务对象的映射关系
+  void ReclaimTxn(Transaction *txn);
 
- private:
-  ConcurrencyMode concurrency_mode_;            // 事务使用的并发控制算法，目前只需要考虑2PL
-  std::atomic<txn_id_t> next_txn_id_{0};        // 用于分发事务ID
-  std::atomic<timestamp_t> next_timestamp_{0};  // 用于分发事务时间戳
-  std::mutex latch_;                            // 用于txn_map的并发
+  void UpdateFreeSpace(std::vector<std::pair<std::string, page_id_t>> &freed_pages, LogManager *log_manager);
+
+  /* 当前会话在本事务管理器中开启的事务 */
+  std::vector<Transaction *> &SessionTxns() { return session_txns_[manager_id_]; }
+
+  // 每个连接线程（会话）自己开启的事务，按事务管理器分开，只有所属线程会读写，因此无需加锁
+  // 以manager_id_而不是this区分事务管理器：析构后其他线程中残留的项不会被新的事务管理器误用
+  static thread_local std::unordered_map<uint64_t, std::vector<Transaction *>> session_txns_;
+  static std::atomic<uint64_t> next_manager_id_;
+
+  const uint64_t manager_id_{next_manager_id_.fetch_add(1)};  // 本事务管理器的编号，进程内唯一
+
+  std::atomic<ConcurrencyMode> concurrency_mode_;            // 新事务使用的并发控制算法，2PL或OCC
+  std::atomic<bool> enable_auto_vacuum_{true};               // 事务结束时是否自动整理有记录被删除的页面
+  std::atomic<txn_id_t> next_txn_id_{0};                     // 用于分发事务ID
+  std::atomic<timestamp_t> next_timestamp_{0};               // 用于分发事务时间戳
+  std::mutex latch_;                                         // 用于静态检查点
+  std::array<TxnMapShard, TXN_MAP_SHARD_NUM> txn_shards_;  // 分片的全局事务表
   SmManager *sm_manager_;
   LockManager *lock_manager_;
 };
@@ -22,6 +22,14 @@ enum class TransactionState { DEFAULT, GROWING, SHRINKING, COMMITTED, ABORTED };
 /* 系统的隔离级别，当前赛题中为可串行化隔离级别 */
 enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED, SERIALIZABLE };
 
+/**
+ * 系统采用的并发控制算法
+ * TWO_PHASE_LOCKING: 严格两阶段封锁（wait-die）
+ * BASIC_TO: 基本时间戳排序（未实现）
+ * OPTIMISTIC: 乐观并发控制，读不加记录锁（只加表级IS锁），只记录读到的记录版本，提交时验证（Silo风格）
+ */
+enum class ConcurrencyMode { TWO_PHASE_LOCKING = 0, BASIC_TO, OPTIMISTIC };
+
 /* 事务写操作类型，包括插入、删除、更新三种操作 */
 enum class WType { INSERT_TUPLE = 0, DELETE_TUPLE, UPDATE_TUPLE };
 
@@ -65,6 +73,19 @@ class WriteRecord {
   Tuple tuple_;
 };
 
+class RmFileHandle;
+
+/**
+ * @brief OCC事务的读记录，保存读到的记录所在文件、位置以及读到时的版本(TupleMeta)，提交时用于验证
+ * 记录的版本号即TupleMeta.ts_，见Transaction::GetWriteVersion()
+ * @note 事务读表前加表级IS锁并持有到提交，DROP TABLE的X锁与之冲突，所以验证时fh_仍然有效
+ */
+struct ReadRecord {
+  RmFileHandle *fh_;
+  RID rid_;
+  TupleMeta meta_;
+};
+
 /* 多粒度锁，加锁对象的类型，包括记录和表 */
 enum class LockDataType { TABLE = 0, RECORD = 1, GAP = 2 };
 
@@ -124,7 +145,8 @@ class LockDataId {
 };
 
 /* 事务回滚原因 */
-enum class AbortReason { LOCK_ON_SHIRINKING = 0, UPGRADE_CONFLICT, DEADLOCK_PREVENTION };
+enum class AbortReason { LOCK_ON_SHIRINKING = 0, UPGRADE_CONFLICT, DEADLOCK_PREVENTION, VALIDATION_FAILED };
+static constexpr int ABORT_REASON_NUM = 4;
 
 /* 事务回滚异常，在rmdb.cpp中进行处理 */
 class TransactionAbortException : public std::exception {
@@ -153,6 +175,11 @@ class TransactionAbortException : public std::exception {
         return "Transaction " + std::to_string(txn_id_) + " aborted for deadlock prevention\n";
       } break;
 
+      case AbortReason::VALIDATION_FAILED: {
+        return "Transaction " + std::to_string(txn_id_) +
+               " aborted because the records it read were modified by other transactions\n";
+      } break;
+
       default: {
         return "Transaction aborted\n";
       } break;
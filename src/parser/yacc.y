@@ -21,10 +21,10 @@ using namespace ast;
 %define parse.error verbose
 
 // keywords
-%token SHOW TABLES CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM ASC ORDER BY AS COUNT MAX MIN SUM GROUP HAVING IN
+%token SHOW TABLES LOCKS LOCK_STATS VACUUM CREATE TABLE DROP DESC INSERT INTO VALUES DELETE FROM ASC ORDER BY AS COUNT MAX MIN SUM GROUP HAVING IN
 WHERE UPDATE SET SELECT INT CHAR VARCHAR FLOAT DATETIME NOT_NULL INDEX AND JOIN EXIT HELP TXN_BEGIN TXN_COMMIT TXN_ABORT TXN_ROLLBACK ORDER_BY 
-UNIQUE ENABLE_NESTLOOP ENABLE_SORTMERGE ENABLE_HASHJOIN ENABLE_OPTIMIZER
-STATIC_CHECKPOINT LOAD OUTPUT_FILE
+UNIQUE ENABLE_NESTLOOP ENABLE_SORTMERGE ENABLE_HASHJOIN ENABLE_OPTIMIZER ENABLE_OCC ENABLE_AUTO_VACUUM
+STATIC_CHECKPOINT LOAD OUTPUT_FILE WITH INCLUDE USING
 
 // non-keywords
 %token LEQ NEQ GEQ T_EOF
@@ -125,6 +125,22 @@ dbStmt:
     {
         $$ = std::make_shared<ShowIndex>($4);
     }
+    |   SHOW LOCKS
+    {
+        $$ = std::make_shared<ShowLocks>();
+    }
+    |   SHOW LOCK_STATS
+    {
+        $$ = std::make_shared<ShowLockStats>();
+    }
+    |   VACUUM
+    {
+        $$ = std::make_shared<Vacuum>("");
+    }
+    |   VACUUM tbName
+    {
+        $$ = std::make_shared<Vacuum>($2);
+    }
     ;
 
 setStmt:
@@ -146,6 +162,10 @@ ddl:
     {
         $$ = std::make_shared<CreateTable>($3, $5);
     }
+    |   CREATE TABLE tbName '(' fieldList ')' WITH '(' IDENTIFIER '=' IDENTIFIER ')'
+    {
+        $$ = std::make_shared<CreateTable>($3, $5, $9, $11);
+    }
     |   DROP TABLE tbName
     {
         $$ = std::make_shared<DropTable>($3);
@@ -158,6 +178,14 @@ ddl:
     {
         $$ = std::make_shared<CreateIndex>($3, $5);
     }
+    |   CREATE INDEX tbName '(' colNameList ')' INCLUDE '(' colNameList ')'
+    {
+        $$ = std::make_shared<CreateIndex>($3, $5, $9);
+    }
+    |   CREATE INDEX tbName '(' colNameList ')' USING IDENTIFIER
+    {
+        $$ = std::make_shared<CreateIndex>($3, $5, std::vector<std::string>(), $8);
+    }
     |   DROP INDEX tbName '(' colNameList ')'
     {
         $$ = std::make_shared<DropIndex>($3, $5);
@@ -177,6 +205,10 @@ dml:
     {
         $$ = std::make_shared<InsertStmt>($3, $6);
     }
+    |   INSERT INTO tbName dml
+    {
+        $$ = std::make_shared<InsertStmt>($3, $4);
+    }
     |   DELETE FROM tbName optWhereClause
     {
         $$ = std::make_shared<DeleteStmt>($3, $4);
@@ -551,6 +583,8 @@ set_knob_type:
     |   ENABLE_SORTMERGE { $$ = EnableSortMerge; }
     |   ENABLE_HASHJOIN { $$ = EnableHashJoin; }
     |   ENABLE_OPTIMIZER { $$ = EnableOptimizer; }
+    |   ENABLE_OCC { $$ = EnableOcc; }
+    |   ENABLE_AUTO_VACUUM { $$ = EnableAutoVacuum; }
     |   OUTPUT_FILE { $$ = EnableOutput; }
     ;
 
@@ -10,6 +10,7 @@ See the Mulan PSL v2 for more details. */
 
 #include "planner/planner.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "common/common.h"
@@ -423,7 +424,8 @@ bool Planner::get_index_cols(std::string tab_name, std::vector<Condition> curr_c
   // }
   std::unordered_set<std::string> added_cols;
   for (const auto &cond : curr_conds) {
-    if (!cond.is_rhs_stmt && cond.lhs_col.tab_name.compare(tab_name) == 0) {
+    // col IN (...)按列表中的每个值扫描索引上的一个范围
+    if ((!cond.is_rhs_stmt || cond.op == OP_IN) && cond.lhs_col.tab_name.compare(tab_name) == 0) {
       if (added_cols.find(cond.lhs_col.col_name) == added_cols.end() && cond.op != OP_NE) {
         index_col_names.push_back(cond.lhs_col.col_name);
         added_cols.insert(cond.lhs_col.col_name);
@@ -431,7 +433,8 @@ bool Planner::get_index_cols(std::string tab_name, std::vector<Condition> curr_c
     }
   }
   TabMeta &tab = sm_manager_->db_.get_table(tab_name);
-  if (tab.is_index(index_col_names)) return true;
+  // hash索引只支持等值查找，见get_hash_index_cols
+  if (tab.is_index(index_col_names)) return !tab.get_index_meta(index_col_names)->is_hash;
   return false;
 }
 
@@ -453,10 +456,93 @@ bool Planner::get_index_cols_swap(std::string tab_name, std::vector<Condition> c
     }
   }
   TabMeta &tab = sm_manager_->db_.get_table(tab_name);
-  if (tab.is_index(index_col_names)) return true;
+  if (tab.is_index(index_col_names)) return !tab.get_index_meta(index_col_names)->is_hash;
   return false;
 }
 
+bool Planner::get_hash_index_cols(const std::string &tab_name, const std::vector<Condition> &conds,
+                                  std::vector<std::string> &index_col_names) {
+  index_col_names.clear();
+  TabMeta &tab = sm_manager_->db_.get_table(tab_name);
+  for (auto &index : tab.indexes) {
+    if (!index.is_hash) {
+      continue;
+    }
+    bool all_eq = std::all_of(index.cols.begin(), index.cols.end(), [&](const ColMeta &col) {
+      return std::any_of(conds.begin(), conds.end(), [&](const Condition &cond) {
+        return cond.is_rhs_val && !cond.is_rhs_stmt && cond.op == OP_EQ && cond.lhs_col.tab_name == tab_name &&
+               cond.lhs_col.col_name == col.name;
+      });
+    });
+    if (all_eq) {
+      for (auto &col : index.cols) {
+        index_col_names.push_back(col.name);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<std::vector<std::string>> Planner::get_bitmap_index_cols(const std::string &tab_name,
+                                                                     const std::vector<Condition> &conds) {
+  std::vector<std::vector<std::string>> index_cols;
+  TabMeta &tab = sm_manager_->db_.get_table(tab_name);
+  for (auto &index : tab.indexes) {
+    if (index.is_hash) {
+      continue;
+    }
+    const std::string &first_col = index.cols.front().name;
+    bool has_cond = std::any_of(conds.begin(), conds.end(), [&](const Condition &cond) {
+      return cond.is_rhs_val && cond.op != OP_NE && cond.op != OP_IN && cond.lhs_col.tab_name == tab_name &&
+             cond.lhs_col.col_name == first_col;
+    });
+    // 选出超过一半的行时，顺序扫描更快；没有统计信息时无法估计，同样使用顺序扫描
+    double selectivity = estimate_selectivity(tab_name, first_col, conds);
+    if (!has_cond || selectivity < 0 || selectivity > 0.5) {
+      continue;
+    }
+    std::vector<std::string> col_names;
+    for (auto &col : index.cols) {
+      col_names.push_back(col.name);
+    }
+    index_cols.push_back(std::move(col_names));
+  }
+  return index_cols;
+}
+
+double Planner::estimate_selectivity(const std::string &tab_name, const std::string &col_name,
+                                     const std::vector<Condition> &conds) {
+  const auto *histogram = sm_manager_->GetTableAttrHistogram(tab_name, col_name);
+  if (histogram == nullptr || histogram->IsEmpty() || sm_manager_->GetTableCount(tab_name) < 0) {
+    return -1;
+  }
+  double lower = 0;
+  double upper = 1;
+  double equal = -1;
+  for (auto &cond : conds) {
+    if (!cond.is_rhs_val || cond.lhs_col.tab_name != tab_name || cond.lhs_col.col_name != col_name) {
+      continue;
+    }
+    switch (cond.op) {
+      case OP_EQ:
+        equal = 1.0 / std::max(sm_manager_->GetTableAttrDistinct(tab_name, col_name), 1);
+        break;
+      case OP_LT:
+      case OP_LE:
+        upper = std::min(upper, histogram->EstimateLessThan(cond.rhs_val));
+        break;
+      case OP_GT:
+      case OP_GE:
+        lower = std::max(lower, histogram->EstimateLessThan(cond.rhs_val));
+        break;
+      default:
+        break;
+    }
+  }
+  return equal >= 0 ? equal : std::max(upper - lower, 0.0);
+}
+
 /**
  * @brief 表算子条件谓词生成
  *
@@ -664,12 +750,60 @@ std::shared_ptr<Plan> Planner::physical_optimization(std::shared_ptr<Query> quer
   return plan;
 }
 
+std::vector<std::string> Planner::get_scan_cols(std::shared_ptr<Query> query, const std::string &tab_name) {
+  auto x = std::dynamic_pointer_cast<ast::SelectStmt>(query->parse);
+  const TabMeta &tab = sm_manager_->db_.get_table(tab_name);
+  std::vector<std::string> scan_cols;
+  auto add_col = [&](const TabCol &col) {
+    // order by列只有列名，按列名匹配
+    if (col.col_name.empty() || col.col_name == "*" || (!col.tab_name.empty() && col.tab_name != tab_name) ||
+        !tab.is_col(col.col_name)) {
+      return;
+    }
+    if (std::find(scan_cols.begin(), scan_cols.end(), col.col_name) == scan_cols.end()) {
+      scan_cols.push_back(col.col_name);
+    }
+  };
+  auto add_conds = [&](const std::vector<Condition> &conds) {
+    for (auto &cond : conds) {
+      add_col(cond.lhs_col);
+      if (!cond.is_rhs_val && !cond.is_rhs_stmt) {
+        add_col(cond.rhs_col);
+      }
+    }
+  };
+  for (auto &col : query->cols) {
+    add_col(col);
+  }
+  add_conds(query->conds);
+  for (auto &col : query->groupby_cols) {
+    add_col(col);
+  }
+  add_conds(query->having_conds);
+  if (x != nullptr && x->has_sort) {
+    add_col({.tab_name = "", .col_name = x->order->cols->col_name, .aggregation_type = NO_AGG, .new_col_name = ""});
+  }
+  // COUNT(*)只需要知道记录条数，读取第一列即可
+  if (scan_cols.empty()) {
+    scan_cols.push_back(tab.cols.front().name);
+  }
+  return scan_cols;
+}
+
 std::shared_ptr<Plan> Planner::make_one_rel(std::shared_ptr<Query> query, Context *context) {
   auto x = std::dynamic_pointer_cast<ast::SelectStmt>(query->parse);
   std::vector<std::string> tables = query->optimized_table_order.empty() ? query->tables : query->optimized_table_order;
 
   std::vector<std::shared_ptr<Plan>> table_scan_executors(tables.size());
 
+  // 在条件被分配到各个表之前，记录每个表被用到的列，seq scan只读取这些列
+  std::vector<std::vector<std::string>> scan_cols(tables.size());
+  if (x != nullptr) {
+    for (size_t i = 0; i < tables.size(); i++) {
+      scan_cols[i] = get_scan_cols(query, tables[i]);
+    }
+  }
+
   // std::vector<std::string> tables = query->tables;
   // // Scan table , 生成表算子列表tab_nodes
   // std::vector<std::shared_ptr<Plan>> table_scan_executors(tables.size());
@@ -685,14 +819,46 @@ std::shared_ptr<Plan> Planner::make_one_rel(std::shared_ptr<Query> query, Contex
     }
     // int index_no = get_indexNo(tables[i], curr_conds);
     std::vector<std::string> index_col_names;
+    // 索引的每一列上都是等值条件时，hash索引只读一个桶就能找到记录
+    if (get_hash_index_cols(tables[i], curr_conds, index_col_names)) {
+      table_scan_executors[i] =
+          std::make_shared<ScanPlan>(T_HashIndexScan, sm_manager_, tables[i], curr_conds, index_col_names);
+      continue;
+    }
     bool index_exist = get_index_cols(tables[i], curr_conds, index_col_names);
     if (index_exist == false) {  // 该表没有索引
       index_col_names.clear();
-      table_scan_executors[i] =
-          std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, tables[i], curr_conds, index_col_names);
+      // 没有与条件的列相同的索引时，用第一列上有条件的索引收集rid，按页面回表后再判断所有条件
+      auto bitmap_index_cols = get_bitmap_index_cols(tables[i], curr_conds);
+      if (!bitmap_index_cols.empty()) {
+        auto scan_plan =
+            std::make_shared<ScanPlan>(T_BitmapHeapScan, sm_manager_, tables[i], curr_conds, index_col_names);
+        scan_plan->bitmap_index_col_names_ = std::move(bitmap_index_cols);
+        table_scan_executors[i] = scan_plan;
+        continue;
+      }
+      auto scan_plan = std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, tables[i], curr_conds, index_col_names);
+      scan_plan->proj_cols_ = std::move(scan_cols[i]);
+      table_scan_executors[i] = scan_plan;
     } else {  // 存在索引
-      table_scan_executors[i] =
-          std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, tables[i], curr_conds, index_col_names);
+      auto scan_plan = std::make_shared<ScanPlan>(T_IndexScan, sm_manager_, tables[i], curr_conds, index_col_names);
+      // 索引的key和INCLUDE列覆盖了用到的所有列时，只读索引，不回表
+      auto &tab = sm_manager_->db_.get_table(tables[i]);
+      double selectivity = estimate_selectivity(tables[i], index_col_names.front(), curr_conds);
+      // IN列表对应多个范围，只有IndexScan按key的顺序逐个扫描，位图扫描只扫描一个范围
+      bool has_in = std::any_of(curr_conds.begin(), curr_conds.end(), [](const Condition &cond) {
+        return cond.op == OP_IN;
+      });
+      if (x != nullptr && tab.get_index_meta(index_col_names)->is_covering(scan_cols[i])) {
+        scan_plan->index_only_ = true;
+        scan_plan->proj_cols_ = std::move(scan_cols[i]);
+      } else if (!has_in && selectivity >= 0 &&
+                 selectivity * sm_manager_->GetTableCount(tables[i]) >= BITMAP_SCAN_MIN_ROWS) {
+        // 范围内的行较多时，按索引顺序回表会反复读取同一个页面，先排序rid再回表
+        scan_plan->tag = T_BitmapHeapScan;
+        scan_plan->bitmap_index_col_names_.push_back(index_col_names);
+      }
+      table_scan_executors[i] = scan_plan;
     }
   }
   // 只有一个表，不需要join。
@@ -886,21 +1052,51 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
         throw InternalError("Unexpected field type");
       }
     }
-    plannerRoot = std::make_shared<DDLPlan>(T_CreateTable, x->tab_name, std::vector<std::string>(), col_defs);
+    auto ddl_plan = std::make_shared<DDLPlan>(T_CreateTable, x->tab_name, std::vector<std::string>(), col_defs);
+    // WITH (format = row | columnar)
+    if (!x->option_name.empty()) {
+      std::string option_name = x->option_name;
+      std::string option_value = x->option_value;
+      std::transform(option_name.begin(), option_name.end(), option_name.begin(), ::tolower);
+      std::transform(option_value.begin(), option_value.end(), option_value.begin(), ::tolower);
+      if (option_name != "format" || (option_value != "row" && option_value != "columnar")) {
+        throw InvalidTableOptionError(x->option_name, x->option_value);
+      }
+      ddl_plan->format_ = option_value == "columnar" ? RmFileFormat::COLUMNAR : RmFileFormat::ROW;
+    }
+    plannerRoot = ddl_plan;
   } else if (auto x = std::dynamic_pointer_cast<ast::DropTable>(query->parse)) {
     // drop table;
     plannerRoot =
         std::make_shared<DDLPlan>(T_DropTable, x->tab_name, std::vector<std::string>(), std::vector<ColDef>());
   } else if (auto x = std::dynamic_pointer_cast<ast::CreateIndex>(query->parse)) {
     // create index;
-    plannerRoot = std::make_shared<DDLPlan>(T_CreateIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+    auto ddl_plan = std::make_shared<DDLPlan>(T_CreateIndex, x->tab_name, x->col_names, std::vector<ColDef>());
+    ddl_plan->include_col_names_ = x->include_names;
+    // USING btree | hash
+    std::string method = x->method;
+    std::transform(method.begin(), method.end(), method.begin(), ::tolower);
+    if (!method.empty() && method != "btree" && method != "hash") {
+      throw InvalidIndexMethodError(x->method);
+    }
+    ddl_plan->is_hash_ = method == "hash";
+    plannerRoot = ddl_plan;
   } else if (auto x = std::dynamic_pointer_cast<ast::DropIndex>(query->parse)) {
     // drop index
     plannerRoot = std::make_shared<DDLPlan>(T_DropIndex, x->tab_name, x->col_names, std::vector<ColDef>());
   } else if (auto x = std::dynamic_pointer_cast<ast::InsertStmt>(query->parse)) {
-    // insert;
-    plannerRoot = std::make_shared<DMLPlan>(T_Insert, std::shared_ptr<Plan>(), x->tab_name, query->values,
-                                            std::vector<Condition>(), std::vector<SetClause>());
+    // insert; INSERT INTO t SELECT ... 以select语句的投影计划为子计划
+    std::shared_ptr<Plan> select_plan;
+    bool unique = false;
+    if (query->select_query != nullptr) {
+      select_plan = do_planner(query->select_query, context);
+      if (auto dml = std::dynamic_pointer_cast<DMLPlan>(select_plan)) {
+        select_plan = dml->subplan_;
+        unique = dml->unique_;
+      }
+    }
+    plannerRoot = std::make_shared<DMLPlan>(T_Insert, select_plan, x->tab_name, query->values,
+                                            std::vector<Condition>(), std::vector<SetClause>(), unique);
   } else if (auto x = std::dynamic_pointer_cast<ast::DeleteStmt>(query->parse)) {
     // delete;
     // 生成表扫描方式
@@ -908,9 +1104,10 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
     // 只有一张表，不需要进行物理优化了
     // int index_no = get_indexNo(x->tab_name, query->conds);
     std::vector<std::string> index_col_names;
-    bool index_exist = get_index_cols(x->tab_name, query->conds, index_col_names);
-
-    if (index_exist == false) {  // 该表没有索引
+    if (get_hash_index_cols(x->tab_name, query->conds, index_col_names)) {
+      table_scan_executors =
+          std::make_shared<ScanPlan>(T_HashIndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
+    } else if (!get_index_cols(x->tab_name, query->conds, index_col_names)) {  // 该表没有索引
       index_col_names.clear();
       table_scan_executors =
           std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, x->tab_name, query->conds, index_col_names);
@@ -928,9 +1125,10 @@ std::shared_ptr<Plan> Planner::do_planner(std::shared_ptr<Query> query, Context
     // 只有一张表，不需要进行物理优化了
     // int index_no = get_indexNo(x->tab_name, query->conds);
     std::vector<std::string> index_col_names;
-    bool index_exist = get_index_cols(x->tab_name, query->conds, index_col_names);
-
-    if (index_exist == false) {  // 该表没有索引
+    if (get_hash_index_cols(x->tab_name, query->conds, index_col_names)) {
+      table_scan_executors =
+          std::make_shared<ScanPlan>(T_HashIndexScan, sm_manager_, x->tab_name, query->conds, index_col_names);
+    } else if (!get_index_cols(x->tab_name, query->conds, index_col_names)) {  // 该表没有索引
       index_col_names.clear();
       table_scan_executors =
           std::make_shared<ScanPlan>(T_SeqScan, sm_manager_, x->tab_name, query->conds, index_col_names);
@@ -0,0 +1,86 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_bulk_appender.cpp
+ *
+ * Identification: src/record/rm_bulk_appender.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "record/rm_bulk_appender.h"
+
+#include <cstring>
+#include <optional>
+
+#include "common/macros.h"
+
+namespace easydb {
+
+RmBulkAppender::RmBulkAppender(RmFileHandle *file_handle, InstallCallback on_install)
+    : file_handle_(file_handle),
+      on_install_(std::move(on_install)),
+      page_handle_(&file_handle->file_hdr_, &image_) {
+  ResetPage();
+}
+
+void RmBulkAppender::Append(const TupleMeta &meta, const Tuple &tuple) {
+  file_handle_->CheckColumnarTuple(tuple);
+  // The GC latch is kept until the page is installed, so that VACUUM does not reclaim the values the page points to
+  std::optional<Tuple> toasted = file_handle_->ToastTuple(tuple, &gc_lock_);
+  const Tuple &stored = toasted.has_value() ? *toasted : tuple;
+  EASYDB_ENSURE(TABLE_PAGE_HEADER_SIZE + RmPageHandle::TUPLE_INFO_SIZE + stored.GetLength() <= PAGE_SIZE,
+                "tuple is too large, cannot insert");
+
+  if (!page_handle_.CanInsertTuple(stored)) {
+    InstallPage();
+  }
+  page_handle_.InsertTuple(meta, stored);
+  tuples_.push_back(tuple);
+}
+
+void RmBulkAppender::Finish() {
+  if (!tuples_.empty()) {
+    InstallPage();
+  }
+}
+
+void RmBulkAppender::InstallPage() {
+  // 1. Copy the image into a new page, the common page header (page id and LSN) is the one of the new page
+  RmPageHandle page_handle = file_handle_->CreateNewPageHandle();
+  page_id_t page_no = page_handle.page->GetPageId().page_no;
+  page_handle.page->WLatch();
+  memcpy(page_handle.page->GetData() + Page::OFFSET_PAGE_HDR, image_.GetData() + Page::OFFSET_PAGE_HDR,
+         PAGE_SIZE - Page::OFFSET_PAGE_HDR);
+  int free_space = page_handle.GetFreeSpace();
+  page_handle.page->WUnlatch();
+  file_handle_->buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), true);
+  if (gc_lock_.owns_lock()) {
+    gc_lock_.unlock();
+  }
+
+  // 2. Publish the page: one zone and one FSM update for all its tuples
+  if (file_handle_->zone_map_ != nullptr) {
+    file_handle_->zone_map_->Build(page_no, tuples_);
+  }
+  file_handle_->fsm_->Update(page_no, free_space);
+  num_pages_++;
+
+  std::vector<Tuple> tuples = std::move(tuples_);
+  ResetPage();
+  if (on_install_ != nullptr) {
+    on_install_(page_no, tuples);
+  }
+}
+
+void RmBulkAppender::ResetPage() {
+  memset(image_.GetData(), 0, PAGE_SIZE);
+  page_handle_.page_hdr_->Init();
+  if (page_handle_.IsColumnar()) {
+    page_handle_.columnar_hdr_->Init();
+  }
+  tuples_.clear();
+}
+
+}  // namespace easydb
@@ -0,0 +1,407 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_column_compression.cpp
+ *
+ * Identification: src/record/rm_column_compression.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+// Compression of sealed columnar pages, see the page format in rm_file_handle.h
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/condition.h"
+#include "record/rm_file_handle.h"
+
+namespace easydb {
+
+/* 一列的编码方案及页面中该列的所有值 */
+struct RmPageHandle::ChunkPlan {
+  RmColumnEncoding encoding{RmColumnEncoding::PLAIN};
+  int bits{0};                                       // FOR/DICT：每条记录占用的位数
+  int32_t base{0};                                   // FOR：最小值
+  std::vector<std::string> dict;                     // DICT：字典中的值
+  std::unordered_map<std::string, uint32_t> codes;  // DICT：值在字典中的编号
+  std::vector<std::string> values;                   // 页面中每条记录的值，格式与minipage中相同
+};
+
+namespace {
+
+/* 表示[0, max_delta]中的值需要的位数 */
+auto GetBitWidth(uint64_t max_delta) -> int {
+  int bits = 0;
+  while (bits < 64 && (max_delta >> bits) != 0) {
+    bits++;
+  }
+  return bits;
+}
+
+/* n个bits位的值占用的字节数 */
+auto GetPackedSize(int bits, int n) -> int { return (bits * n + 7) / 8; }
+
+auto UnpackBits(const char *data, int idx, int bits) -> uint32_t {
+  if (bits == 0) {
+    return 0;
+  }
+  uint64_t bit = static_cast<uint64_t>(idx) * bits;
+  const auto *bytes = reinterpret_cast<const uint8_t *>(data) + bit / 8;
+  int shift = bit % 8;
+  uint64_t word = 0;
+  for (int i = 0; i < (shift + bits + 7) / 8; ++i) {
+    word |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  return static_cast<uint32_t>((word >> shift) & ((uint64_t{1} << bits) - 1));
+}
+
+void PackBits(char *data, int idx, int bits, uint32_t value) {
+  if (bits == 0) {
+    return;
+  }
+  uint64_t bit = static_cast<uint64_t>(idx) * bits;
+  auto *bytes = reinterpret_cast<uint8_t *>(data) + bit / 8;
+  int shift = bit % 8;
+  int num_bytes = (shift + bits + 7) / 8;
+  uint64_t word = 0;
+  for (int i = 0; i < num_bytes; ++i) {
+    word |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  uint64_t mask = ((uint64_t{1} << bits) - 1) << shift;
+  word = (word & ~mask) | ((static_cast<uint64_t>(value) << shift) & mask);
+  for (int i = 0; i < num_bytes; ++i) {
+    bytes[i] = static_cast<uint8_t>(word >> (8 * i));
+  }
+}
+
+auto ReadInt(const char *value) -> int32_t {
+  int32_t v;
+  memcpy(&v, value, sizeof(v));
+  return v;
+}
+
+auto IsString(TypeId type) -> bool { return type == TYPE_CHAR || type == TYPE_VARCHAR; }
+
+}  // namespace
+
+auto RmPageHandle::ReadColumnValue(uint16_t slot_no, int col_idx, char *buf) const -> const char * {
+  if (!IsSealed()) {
+    return GetColumnData(slot_no, col_idx);
+  }
+  const auto &chunk = GetChunks()[col_idx];
+  const char *data = page_start_ + chunk.offset;
+  switch (chunk.encoding) {
+    case RmColumnEncoding::FOR: {
+      uint32_t value = static_cast<uint32_t>(chunk.base) + UnpackBits(data, slot_no, chunk.bits);
+      memcpy(buf, &value, sizeof(value));
+      return buf;
+    }
+    case RmColumnEncoding::DICT:
+      return GetDictEntry(col_idx, UnpackBits(data, slot_no, chunk.bits));
+    default:
+      return data + slot_no * file_hdr->cols[col_idx].width;
+  }
+}
+
+auto RmPageHandle::GetDictCode(uint16_t slot_no, int col_idx) const -> uint32_t {
+  const auto &chunk = GetChunks()[col_idx];
+  return UnpackBits(page_start_ + chunk.offset, slot_no, chunk.bits);
+}
+
+auto RmPageHandle::GetDictEntry(int col_idx, uint32_t code) const -> const char * {
+  const auto &chunk = GetChunks()[col_idx];
+  const char *data = page_start_ + chunk.offset;
+  uint16_t entry_offset;
+  memcpy(&entry_offset, data + GetPackedSize(chunk.bits, columnar_hdr_->capacity) + code * sizeof(uint16_t),
+         sizeof(entry_offset));
+  return data + entry_offset;
+}
+
+auto RmPageHandle::EvalOnDictionary(const RmZonePredicate &pred, std::vector<bool> *matches) const -> bool {
+  if (!IsSealed() || pred.col_id_ >= static_cast<uint32_t>(file_hdr->num_cols)) {
+    return false;
+  }
+  const auto &chunk = GetChunks()[pred.col_id_];
+  auto type = static_cast<TypeId>(file_hdr->cols[pred.col_id_].type);
+  // Only compare strings with strings, like the zone maps do, other comparisons are left to the caller
+  if (chunk.encoding != RmColumnEncoding::DICT || pred.val_.IsNull() || !IsString(type) ||
+      !IsString(pred.val_.GetTypeId())) {
+    return false;
+  }
+  Condition cond;
+  cond.op = pred.op_;
+  matches->resize(chunk.dict_size);
+  for (uint32_t code = 0; code < chunk.dict_size; ++code) {
+    // A null string is an entry of the dictionary as well, and never satisfies a comparison
+    Value entry = Value::DeserializeFrom(GetDictEntry(pred.col_id_, code), type);
+    (*matches)[code] = !entry.IsNull() && cond.satisfy(entry, pred.val_);
+  }
+  return true;
+}
+
+auto RmPageHandle::CanWriteColumnarTuple(uint16_t slot_no, const Tuple &tuple) const -> bool {
+  if (!IsSealed() || CanEncodeInPlace(tuple)) {
+    return true;
+  }
+  // Re-encoding rewrites the chunks, which is not allowed while a scan pins the page
+  if (!CanMoveTuples()) {
+    return false;
+  }
+  std::vector<ChunkPlan> plans;
+  PlanChunks(slot_no, &tuple, &plans);
+  return GetMaxCapacity(plans, std::max<int>(page_hdr_->num_records, slot_no + 1)) > 0;
+}
+
+auto RmPageHandle::CanEncodeInPlace(const Tuple &tuple) const -> bool {
+  const char *row = tuple.GetData();
+  for (int i = 0; i < file_hdr->num_cols; ++i) {
+    const auto &col = file_hdr->cols[i];
+    const auto &chunk = GetChunks()[i];
+    if (chunk.encoding == RmColumnEncoding::FOR) {
+      uint64_t delta = static_cast<uint32_t>(ReadInt(row + col.offset)) - static_cast<uint32_t>(chunk.base);
+      if (delta >> chunk.bits != 0) {
+        return false;
+      }
+    } else if (chunk.encoding == RmColumnEncoding::DICT) {
+      const char *payload = row + *reinterpret_cast<const uint32_t *>(row + col.offset);
+      uint32_t size = GetPayloadSize(payload);
+      bool found = false;
+      for (uint32_t code = 0; code < chunk.dict_size && !found; ++code) {
+        const char *entry = GetDictEntry(i, code);
+        found = GetPayloadSize(entry) == size && memcmp(entry, payload, size) == 0;
+      }
+      if (!found) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+auto RmPageHandle::WriteSealedTuple(uint16_t slot_no, const Tuple &tuple) -> bool {
+  if (!CanEncodeInPlace(tuple)) {
+    // Widen the encodings so that the new values fit, giving up the free slots the wider encodings take
+    if (!CanMoveTuples()) {
+      return false;
+    }
+    std::vector<ChunkPlan> plans;
+    PlanChunks(slot_no, &tuple, &plans);
+    int capacity = GetMaxCapacity(plans, std::max<int>(page_hdr_->num_records, slot_no + 1));
+    if (capacity == 0) {
+      return false;
+    }
+    WriteChunks(plans, capacity);
+    return true;
+  }
+  const char *row = tuple.GetData();
+  for (int i = 0; i < file_hdr->num_cols; ++i) {
+    const auto &col = file_hdr->cols[i];
+    const auto &chunk = GetChunks()[i];
+    char *data = page_start_ + chunk.offset;
+    const char *value = col.is_inlined ? row + col.offset : row + *reinterpret_cast<const uint32_t *>(row + col.offset);
+    if (chunk.encoding == RmColumnEncoding::FOR) {
+      PackBits(data, slot_no, chunk.bits, static_cast<uint32_t>(ReadInt(value)) - static_cast<uint32_t>(chunk.base));
+    } else if (chunk.encoding == RmColumnEncoding::DICT) {
+      uint32_t size = GetPayloadSize(value);
+      for (uint32_t code = 0; code < chunk.dict_size; ++code) {
+        const char *entry = GetDictEntry(i, code);
+        if (GetPayloadSize(entry) == size && memcmp(entry, value, size) == 0) {
+          PackBits(data, slot_no, chunk.bits, code);
+          break;
+        }
+      }
+    } else {
+      memcpy(data + slot_no * col.width, value, col.is_inlined ? col.width : GetPayloadSize(value));
+    }
+  }
+  return true;
+}
+
+void RmPageHandle::PlanChunks(uint16_t slot_no, const Tuple *tuple, std::vector<ChunkPlan> *plans) const {
+  int num_rows = page_hdr_->num_records;
+  if (tuple != nullptr) {
+    num_rows = std::max(num_rows, slot_no + 1);
+  }
+  char buf[sizeof(int32_t)];
+  plans->assign(file_hdr->num_cols, ChunkPlan{});
+  for (int i = 0; i < file_hdr->num_cols; ++i) {
+    const auto &col = file_hdr->cols[i];
+    auto &plan = (*plans)[i];
+    const RmColumnChunk *prev = IsSealed() ? &GetChunks()[i] : nullptr;
+
+    // 1. Collect the values of the column
+    plan.values.reserve(num_rows);
+    for (int row = 0; row < num_rows; ++row) {
+      const char *value;
+      if (tuple != nullptr && row == slot_no) {
+        const char *data = tuple->GetData();
+        value = col.is_inlined ? data + col.offset : data + *reinterpret_cast<const uint32_t *>(data + col.offset);
+      } else {
+        value = ReadColumnValue(row, i, buf);
+      }
+      plan.values.emplace_back(value, col.is_inlined ? col.width : GetPayloadSize(value));
+    }
+
+    // 2. Choose the encoding, a sealed page keeps the encoding of every column and only widens it
+    if (col.is_inlined && col.type == TYPE_INT && (prev == nullptr || prev->encoding == RmColumnEncoding::FOR)) {
+      int64_t min = prev != nullptr ? prev->base : INT32_MAX;
+      int64_t max = prev != nullptr ? prev->base + ((int64_t{1} << prev->bits) - 1) : INT32_MIN;
+      for (auto &value : plan.values) {
+        min = std::min<int64_t>(min, ReadInt(value.data()));
+        max = std::max<int64_t>(max, ReadInt(value.data()));
+      }
+      int bits = min <= max ? GetBitWidth(max - min) : 0;
+      if (prev != nullptr || bits < static_cast<int>(sizeof(int32_t) * 8)) {
+        plan.encoding = RmColumnEncoding::FOR;
+        plan.bits = bits;
+        plan.base = min <= max ? static_cast<int32_t>(min) : 0;
+      }
+    } else if (!col.is_inlined && (prev == nullptr || prev->encoding == RmColumnEncoding::DICT)) {
+      std::vector<std::string> dict;
+      std::unordered_map<std::string, uint32_t> codes;
+      auto add_entry = [&](std::string entry) {
+        if (codes.emplace(entry, dict.size()).second) {
+          dict.push_back(std::move(entry));
+        }
+      };
+      for (uint32_t code = 0; prev != nullptr && code < prev->dict_size; ++code) {
+        const char *entry = GetDictEntry(i, code);
+        add_entry(std::string(entry, GetPayloadSize(entry)));
+      }
+      for (auto &value : plan.values) {
+        add_entry(value);
+      }
+      int bits = dict.empty() ? 0 : GetBitWidth(dict.size() - 1);
+      int dict_bytes = 0;
+      for (auto &entry : dict) {
+        dict_bytes += sizeof(uint16_t) + entry.size();
+      }
+      // A new dictionary only pays off for a column with few distinct values
+      if (prev != nullptr || GetPackedSize(bits, num_rows) + dict_bytes < num_rows * col.width) {
+        plan.encoding = RmColumnEncoding::DICT;
+        plan.bits = bits;
+        plan.dict = std::move(dict);
+        plan.codes = std::move(codes);
+      }
+    }
+  }
+}
+
+auto RmPageHandle::GetChunkSize(const ChunkPlan &plan, int col_idx, int capacity) const -> int {
+  switch (plan.encoding) {
+    case RmColumnEncoding::FOR:
+      return GetPackedSize(plan.bits, capacity);
+    case RmColumnEncoding::DICT: {
+      int size = GetPackedSize(plan.bits, capacity);
+      for (auto &entry : plan.dict) {
+        size += sizeof(uint16_t) + entry.size();
+      }
+      return size;
+    }
+    default:
+      return capacity * file_hdr->cols[col_idx].width;
+  }
+}
+
+auto RmPageHandle::GetSealedPageSize(const std::vector<ChunkPlan> &plans, int capacity) const -> int {
+  int size = COLUMNAR_PAGE_HEADER_SIZE + capacity * TUPLE_META_SIZE + plans.size() * sizeof(RmColumnChunk);
+  for (size_t i = 0; i < plans.size(); ++i) {
+    size += GetChunkSize(plans[i], i, capacity);
+  }
+  return size;
+}
+
+auto RmPageHandle::GetMaxCapacity(const std::vector<ChunkPlan> &plans, int min_capacity) const -> int {
+  if (GetSealedPageSize(plans, min_capacity) > static_cast<int>(PAGE_SIZE)) {
+    return 0;
+  }
+  int capacity = min_capacity;
+  while (GetSealedPageSize(plans, capacity + 1) <= static_cast<int>(PAGE_SIZE)) {
+    capacity++;
+  }
+  return capacity;
+}
+
+void RmPageHandle::WriteChunks(const std::vector<ChunkPlan> &plans, int capacity) {
+  // The chunks may overlap the old ones, so they are built aside first. The values are copies in the plans
+  int chunks_offset = COLUMNAR_PAGE_HEADER_SIZE + capacity * TUPLE_META_SIZE;
+  int data_offset = chunks_offset + plans.size() * sizeof(RmColumnChunk);
+  std::vector<RmColumnChunk> chunks(plans.size());
+  std::vector<char> data(PAGE_SIZE - data_offset, 0);
+  int offset = data_offset;
+  for (size_t i = 0; i < plans.size(); ++i) {
+    const auto &plan = plans[i];
+    const auto &col = file_hdr->cols[i];
+    char *dst = data.data() + (offset - data_offset);
+    switch (plan.encoding) {
+      case RmColumnEncoding::FOR:
+        for (size_t row = 0; row < plan.values.size(); ++row) {
+          uint32_t delta = static_cast<uint32_t>(ReadInt(plan.values[row].data())) - static_cast<uint32_t>(plan.base);
+          PackBits(dst, row, plan.bits, delta);
+        }
+        break;
+      case RmColumnEncoding::DICT: {
+        for (size_t row = 0; row < plan.values.size(); ++row) {
+          PackBits(dst, row, plan.bits, plan.codes.at(plan.values[row]));
+        }
+        int codes_size = GetPackedSize(plan.bits, capacity);
+        auto entry_offset = static_cast<uint16_t>(codes_size + plan.dict.size() * sizeof(uint16_t));
+        for (size_t code = 0; code < plan.dict.size(); ++code) {
+          memcpy(dst + codes_size + code * sizeof(uint16_t), &entry_offset, sizeof(entry_offset));
+          memcpy(dst + entry_offset, plan.dict[code].data(), plan.dict[code].size());
+          entry_offset += plan.dict[code].size();
+        }
+        break;
+      }
+      default:
+        for (size_t row = 0; row < plan.values.size(); ++row) {
+          memcpy(dst + row * col.width, plan.values[row].data(), plan.values[row].size());
+        }
+    }
+    int size = GetChunkSize(plan, i, capacity);
+    chunks[i] = RmColumnChunk{plan.encoding,
+                              static_cast<uint8_t>(plan.bits),
+                              static_cast<uint16_t>(plan.dict.size()),
+                              static_cast<uint16_t>(offset),
+                              static_cast<uint16_t>(size),
+                              plan.base};
+    offset += size;
+  }
+  assert(offset <= static_cast<int>(PAGE_SIZE));
+
+  // The metas of the new slots are never read before the slots are used, clear them anyway
+  int old_capacity = GetCapacity();
+  if (capacity > old_capacity) {
+    memset(reinterpret_cast<char *>(metas_ + old_capacity), 0, (capacity - old_capacity) * TUPLE_META_SIZE);
+  }
+  columnar_hdr_->capacity = capacity;
+  columnar_hdr_->is_sealed = true;
+  memcpy(page_start_ + chunks_offset, chunks.data(), chunks.size() * sizeof(RmColumnChunk));
+  memcpy(page_start_ + data_offset, data.data(), data.size());
+}
+
+auto RmPageHandle::Seal() -> int {
+  if (IsSealed()) {
+    return 0;
+  }
+  std::vector<ChunkPlan> plans;
+  PlanChunks(0, nullptr, &plans);
+  int num_rows = page_hdr_->num_records;
+  int capacity = GetMaxCapacity(plans, num_rows);
+  if (capacity <= file_hdr->num_records_per_page) {
+    return 0;
+  }
+  int num_saved_bytes = 0;
+  for (size_t i = 0; i < plans.size(); ++i) {
+    num_saved_bytes += num_rows * file_hdr->cols[i].width - GetChunkSize(plans[i], i, num_rows);
+  }
+  WriteChunks(plans, capacity);
+  return num_saved_bytes;
+}
+
+}  // namespace easydb
@@ -10,9 +10,13 @@
  */
 
 #include "record/rm_file_handle.h"
+
+#include <thread>
+
 #include "common/exception.h"
 #include "common/macros.h"
 #include "common/rid.h"
+#include "type/limits.h"
 
 namespace easydb {
 
@@ -33,7 +37,126 @@ auto RmPageHandle::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple)
   return tuple_offset;
 }
 
+auto RmPageHandle::GetUnusedSpace() const -> int {
+  int slot_end_offset = PAGE_SIZE;
+  if (page_hdr_->num_records > 0) {
+    slot_end_offset = std::get<0>(tuple_info_[page_hdr_->num_records - 1]);
+  }
+  int offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * page_hdr_->num_records;
+  return slot_end_offset - offset_size;
+}
+
+auto RmPageHandle::GetContiguousFreeSpace() const -> int {
+  if (IsColumnar()) {
+    // Every tuple fits into a free slot, unless the values do not fit the encodings of a sealed page
+    return page_hdr_->num_records < GetCapacity() ? file_hdr->max_record_size : 0;
+  }
+  return std::max(GetUnusedSpace() - static_cast<int>(TUPLE_INFO_SIZE), 0);
+}
+
+auto RmPageHandle::GetFreeSpace() const -> int {
+  if (IsColumnar()) {
+    return page_hdr_->num_deleted_records > 0 ? file_hdr->max_record_size : GetContiguousFreeSpace();
+  }
+  int free_space = GetContiguousFreeSpace();
+  if (page_hdr_->num_deleted_records > 0) {
+    // A deleted slot can be grown into the contiguous free space without a new TupleInfo
+    int gap = GetUnusedSpace();
+    for (uint16_t slot_no = 0; slot_no < page_hdr_->num_records; ++slot_no) {
+      auto &[offset, size, meta] = tuple_info_[slot_no];
+      if (meta.is_deleted_) {
+        free_space = std::max(free_space, GetSlotCapacity(slot_no) + gap);
+      }
+    }
+  }
+  return free_space;
+}
+
+auto RmPageHandle::CanInsertTuple(const Tuple &tuple) const -> bool {
+  if (IsColumnar()) {
+    return page_hdr_->num_records < GetCapacity() && CanWriteColumnarTuple(page_hdr_->num_records, tuple);
+  }
+  return GetNextTupleOffset(TupleMeta{}, tuple) != std::nullopt;
+}
+
+auto RmPageHandle::CanReuseSlot(uint16_t slot_no, const Tuple &tuple) const -> bool {
+  if (IsColumnar()) {
+    return CanWriteColumnarTuple(slot_no, tuple);
+  }
+  // Growing a slot moves the data of the following slots, which is not allowed while a scan pins the page
+  int gap = CanMoveTuples() ? GetUnusedSpace() : 0;
+  return GetSlotCapacity(slot_no) + gap >= static_cast<int>(tuple.GetLength());
+}
+
+void RmPageHandle::ReuseSlot(uint16_t slot_no, const TupleMeta &meta, const Tuple &tuple) {
+  if (IsColumnar()) {
+    WriteColumnarTuple(slot_no, tuple);
+    metas_[slot_no] = meta;
+  } else {
+    // A vacuumed slot has no space left, take it from the contiguous free space
+    GrowSlot(slot_no, tuple.GetLength());
+    auto offset = std::get<0>(tuple_info_[slot_no]);
+    tuple_info_[slot_no] = std::make_tuple(offset, tuple.GetLength(), meta);
+    memcpy(page_start_ + offset, tuple.data_.data(), tuple.GetLength());
+  }
+  page_hdr_->num_deleted_records--;
+}
+
+auto RmPageHandle::GetSlotCapacity(uint16_t slot_no) const -> int {
+  int slot_end_offset = slot_no == 0 ? PAGE_SIZE : std::get<0>(tuple_info_[slot_no - 1]);
+  return slot_end_offset - std::get<0>(tuple_info_[slot_no]);
+}
+
+auto RmPageHandle::GrowSlot(uint16_t slot_no, int size) -> bool {
+  int delta = size - GetSlotCapacity(slot_no);
+  if (delta <= 0) {
+    return true;
+  }
+  if (GetUnusedSpace() < delta) {
+    return false;
+  }
+  // Move the data of this slot and all following slots down by delta
+  int data_start = std::get<0>(tuple_info_[page_hdr_->num_records - 1]);
+  int slot_offset = std::get<0>(tuple_info_[slot_no]);
+  memmove(page_start_ + data_start - delta, page_start_ + data_start, slot_offset - data_start);
+  for (uint16_t i = slot_no; i < page_hdr_->num_records; ++i) {
+    std::get<0>(tuple_info_[i]) -= delta;
+  }
+  return true;
+}
+
+void RmPageHandle::Compact(const std::vector<bool> &reclaim) {
+  // Pack the data in slot order, moving it toward the end of the page. The data of a slot only moves up, and
+  // never beyond its old end, so it never overwrites the data of a slot that has not been moved yet
+  int slot_end_offset = PAGE_SIZE;
+  for (uint16_t slot_no = 0; slot_no < page_hdr_->num_records; ++slot_no) {
+    auto &[offset, size, meta] = tuple_info_[slot_no];
+    if (reclaim[slot_no]) {
+      size = 0;
+    } else {
+      memmove(page_start_ + slot_end_offset - size, page_start_ + offset, size);
+    }
+    offset = slot_end_offset - size;
+    slot_end_offset = offset;
+  }
+  // Truncate the reclaimed slots at the end, their RIDs will be handed out again by new inserts
+  while (page_hdr_->num_records > 0 && reclaim[page_hdr_->num_records - 1]) {
+    page_hdr_->num_records--;
+    page_hdr_->num_deleted_records--;
+  }
+}
+
 auto RmPageHandle::InsertTuple(const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t> {
+  if (IsColumnar()) {
+    if (!CanInsertTuple(tuple)) {
+      return std::nullopt;
+    }
+    auto tuple_id = page_hdr_->num_records;
+    WriteColumnarTuple(tuple_id, tuple);
+    metas_[tuple_id] = meta;
+    page_hdr_->num_records++;
+    return tuple_id;
+  }
   auto tuple_offset = GetNextTupleOffset(meta, tuple);
   if (tuple_offset == std::nullopt) {
     return std::nullopt;
@@ -50,11 +173,13 @@ void RmPageHandle::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
   if (tuple_id >= page_hdr_->num_records) {
     throw easydb::Exception("Tuple ID out of range");
   }
-  auto &[offset, size, old_meta] = tuple_info_[tuple_id];
+  auto &old_meta = MetaAt(tuple_id);
   if (!old_meta.is_deleted_ && meta.is_deleted_) {
     page_hdr_->num_deleted_records++;
+  } else if (old_meta.is_deleted_ && !meta.is_deleted_) {
+    page_hdr_->num_deleted_records--;
   }
-  tuple_info_[tuple_id] = std::make_tuple(offset, size, meta);
+  old_meta = meta;
 }
 
 auto RmPageHandle::GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple> {
@@ -62,12 +187,16 @@ auto RmPageHandle::GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple>
   if (tuple_id >= page_hdr_->num_records) {
     throw easydb::Exception("Tuple ID out of range");
   }
-  auto &[offset, size, meta] = tuple_info_[tuple_id];
   Tuple tuple;
-  tuple.data_.resize(size);
-  memmove(tuple.data_.data(), page_start_ + offset, size);
+  if (IsColumnar()) {
+    ReadColumnarTuple(tuple_id, {}, &tuple.data_);
+  } else {
+    auto &[offset, size, meta] = tuple_info_[tuple_id];
+    tuple.data_.resize(size);
+    memmove(tuple.data_.data(), page_start_ + offset, size);
+  }
   tuple.rid_ = rid;
-  return std::make_pair(meta, std::move(tuple));
+  return std::make_pair(MetaAt(tuple_id), std::move(tuple));
 }
 
 auto RmPageHandle::GetTupleMeta(const RID &rid) const -> TupleMeta {
@@ -75,15 +204,27 @@ auto RmPageHandle::GetTupleMeta(const RID &rid) const -> TupleMeta {
   if (tuple_id >= page_hdr_->num_records) {
     throw easydb::Exception("Tuple ID out of range");
   }
-  auto &[_1, _2, meta] = tuple_info_[tuple_id];
-  return meta;
+  return MetaAt(tuple_id);
 }
 
-void RmPageHandle::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
+auto RmPageHandle::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) -> bool {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= page_hdr_->num_records) {
     throw easydb::Exception("Tuple ID out of range");
   }
+  if (IsColumnar()) {
+    if (!WriteColumnarTuple(tuple_id, tuple)) {
+      return false;
+    }
+    auto &old_meta = MetaAt(tuple_id);
+    if (!old_meta.is_deleted_ && meta.is_deleted_) {
+      page_hdr_->num_deleted_records++;
+    } else if (old_meta.is_deleted_ && !meta.is_deleted_) {
+      page_hdr_->num_deleted_records--;
+    }
+    old_meta = meta;
+    return true;
+  }
   auto &[offset, size, old_meta] = tuple_info_[tuple_id];
   // if (size != tuple.GetLength()) {
   //   throw easydb::Exception("Tuple size mismatch");
@@ -94,9 +235,12 @@ void RmPageHandle::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &
   }
   if (!old_meta.is_deleted_ && meta.is_deleted_) {
     page_hdr_->num_deleted_records++;
+  } else if (old_meta.is_deleted_ && !meta.is_deleted_) {
+    page_hdr_->num_deleted_records--;
   }
   tuple_info_[tuple_id] = std::make_tuple(offset, size, meta);
   memcpy(page_start_ + offset, tuple.data_.data(), tuple.GetLength());
+  return true;
 }
 
 auto RmPageHandle::IsTupleDeleted(const RID &rid) -> bool {
@@ -104,47 +248,120 @@ auto RmPageHandle::IsTupleDeleted(const RID &rid) -> bool {
   return meta.is_deleted_;
 }
 
-auto RmFileHandle::InsertTuple(const TupleMeta &meta, const Tuple &tuple, Context *context) -> std::optional<RID> {
-  // 1. Fetch the current first free page handle
-  RmPageHandle page_handle = CreatePageHandle();
-  int page_no = page_handle.page->GetPageId().page_no;
-  std::optional<uint16_t> tuple_offset;
+void RmPageHandle::ReadColumnarTuple(uint16_t slot_no, const std::vector<bool> &projection,
+                                     std::vector<char> *data) const {
+  // 1. Calculate the size of the tuple: the fixed-size part followed by the payload of the uninlined columns
+  char buf[sizeof(int32_t)];
+  uint32_t size = file_hdr->fixed_size;
+  for (int i = 0; i < file_hdr->num_cols; ++i) {
+    if (!file_hdr->cols[i].is_inlined) {
+      bool wanted = projection.empty() || projection[i];
+      size += wanted ? GetPayloadSize(ReadColumnValue(slot_no, i, buf)) : sizeof(uint32_t);
+    }
+  }
+  data->resize(size);
+  char *row = data->data();
+  if (!projection.empty()) {
+    memset(row, 0, file_hdr->fixed_size);
+  }
 
-  // 2. Find a free slot in the page handle
-  while (true) {
-    tuple_offset = page_handle.GetNextTupleOffset(meta, tuple);
-    if (tuple_offset != std::nullopt) {
-      break;
+  // 2. Copy the values out of the minipages, the payloads are appended in column order like Tuple does
+  uint32_t offset = file_hdr->fixed_size;
+  for (int i = 0; i < file_hdr->num_cols; ++i) {
+    const auto &col = file_hdr->cols[i];
+    bool wanted = projection.empty() || projection[i];
+    if (col.is_inlined) {
+      if (wanted) {
+        memcpy(row + col.offset, ReadColumnValue(slot_no, i, buf), col.width);
+      }
+      continue;
     }
+    *reinterpret_cast<uint32_t *>(row + col.offset) = offset;
+    if (wanted) {
+      const char *value = ReadColumnValue(slot_no, i, buf);
+      uint32_t payload_size = GetPayloadSize(value);
+      memcpy(row + offset, value, payload_size);
+      offset += payload_size;
+    } else {
+      *reinterpret_cast<uint32_t *>(row + offset) = 0;
+      offset += sizeof(uint32_t);
+    }
+  }
+}
 
-    // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
-    EASYDB_ENSURE(page_handle.GetNumTuples() != 0, "tuple is too large, cannot insert");
+auto RmPageHandle::WriteColumnarTuple(uint16_t slot_no, const Tuple &tuple) -> bool {
+  if (IsSealed()) {
+    return WriteSealedTuple(slot_no, tuple);
+  }
+  const char *row = tuple.GetData();
+  for (int i = 0; i < file_hdr->num_cols; ++i) {
+    const auto &col = file_hdr->cols[i];
+    char *value = GetColumnData(slot_no, i);
+    if (col.is_inlined) {
+      memcpy(value, row + col.offset, col.width);
+    } else {
+      const char *payload = row + *reinterpret_cast<const uint32_t *>(row + col.offset);
+      memcpy(value, payload, GetPayloadSize(payload));
+    }
+  }
+  return true;
+}
 
-    auto new_page_handle = CreateNewPageHandle();
-    page_handle.SetNextPageId(new_page_handle.page->GetPageId().page_no);
-    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+auto RmFileHandle::InsertTuple(const TupleMeta &meta, const Tuple &tuple, Context *context) -> std::optional<RID> {
+  CheckColumnarTuple(tuple);
+  std::shared_lock<std::shared_mutex> gc_lock;
+  std::optional<Tuple> toasted = ToastTuple(tuple, &gc_lock);
+  // The tuple written to the page, the zone map is widened with the original values
+  const Tuple &stored = toasted.has_value() ? *toasted : tuple;
+  EASYDB_ENSURE(TABLE_PAGE_HEADER_SIZE + RmPageHandle::TUPLE_INFO_SIZE + stored.GetLength() <= PAGE_SIZE,
+                "tuple is too large, cannot insert");
+  // Each thread starts searching the FSM from its own page, so that concurrent inserters are spread over the pages
+  // with free space instead of all contending on the same one
+  auto hint = static_cast<page_id_t>(std::hash<std::thread::id>()(std::this_thread::get_id()) % file_hdr_.num_pages);
 
-    page_handle = std::move(new_page_handle);
+  while (true) {
+    // 1. Find a page with enough free space in the FSM, or extend the file
+    page_id_t page_no = fsm_->FindPage(stored.GetLength(), hint);
+    RmPageHandle page_handle = page_no == RM_NO_PAGE ? CreateNewPageHandle() : FetchPageHandle(page_no);
     page_no = page_handle.page->GetPageId().page_no;
-  }
 
-  // 3. Insert the tuple to the free slot
-  // auto slot_no = *page_handle.InsertTuple(meta, tuple);
-  auto slot_no = page_handle.page_hdr_->num_records;
-  auto rid = RID(page_no, slot_no);
-  // lock manager
-  if (context != nullptr) {
-    context->lock_mgr_->LockExclusiveOnRecord(context->txn_, rid, fd_);
-  }
-
-  page_handle.tuple_info_[slot_no] = std::make_tuple(*tuple_offset, tuple.GetLength(), meta);
-  page_handle.page_hdr_->num_records++;
-  memcpy(page_handle.page_start_ + *tuple_offset, tuple.data_.data(), tuple.GetLength());
+    // 2. Insert into a reusable deleted slot or a new slot
+    // Hold the page latch until the tuple is written, so that concurrent inserters get different slots
+    page_handle.page->WLatch();
+    if (zone_map_ != nullptr && page_handle.page_hdr_->num_records == 0) {
+      // A new or fully vacuumed page holds no data, its zone is exactly the tuples inserted from now on
+      zone_map_->Build(page_no, {});
+    }
+    std::optional<uint16_t> slot_no = ReuseDeletedSlot(page_handle, meta, stored, context);
+    if (slot_no == std::nullopt && page_handle.CanInsertTuple(stored)) {
+      // lock manager
+      // Note: VACUUM truncates the trailing deleted slots, so the rid of a new slot may still be locked by another
+      // transaction. Never wait for a record lock while holding the page latch, try another page instead
+      if (context == nullptr ||
+          context->lock_mgr_->TryLockExclusiveOnRecord(context->txn_, RID(page_no, page_handle.GetNumTuples()), fd_)) {
+        slot_no = page_handle.InsertTuple(meta, stored);
+      }
+    }
+    if (slot_no != std::nullopt && zone_map_ != nullptr) {
+      zone_map_->Update(page_no, tuple);
+    }
 
-  // Unpin the page that was pinned in create_page_handle
-  buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), true);
+    // 3. Update the FSM. If the tuple did not fit, the FSM entry was stale, the page was a few bytes short or the
+    // deleted slots and the new slot are still locked, lower the entry below the category of the tuple so that
+    // we never retry this page
+    int free_space = page_handle.GetFreeSpace();
+    if (slot_no == std::nullopt) {
+      int category = RmFreeSpaceMap::GetCategory(stored.GetLength());
+      free_space = std::min(free_space, (category - 1) * RmFreeSpaceMap::FSM_UNIT_SIZE);
+    }
+    page_handle.page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), slot_no != std::nullopt);
+    fsm_->Update(page_no, free_space);
 
-  return rid;
+    if (slot_no != std::nullopt) {
+      return RID(page_no, *slot_no);
+    }
+  }
 }
 
 auto RmFileHandle::InsertTuple(RID rid, const TupleMeta &meta, const Tuple &tuple, Context *context) -> bool {
@@ -153,13 +370,17 @@ auto RmFileHandle::InsertTuple(RID rid, const TupleMeta &meta, const Tuple &tupl
     context->lock_mgr_->LockExclusiveOnRecord(context->txn_, rid, fd_);
   }
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
-  auto [old_meta, old_tup] = page_handle.GetTuple(rid);
-  if (old_meta.is_deleted_) {
-    old_meta.is_deleted_ = false;
-    page_handle.UpdateTupleMeta(old_meta, rid);
-  } else {
+  page_handle.page->WLatch();
+  auto old_meta = page_handle.GetTupleMeta(rid);
+  if (!old_meta.is_deleted_) {
+    page_handle.page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
     throw Exception("RmFileHandle::InsertTuple(Rollback) Error: Tuple already exists");
   }
+  old_meta.ts_ = meta.ts_;
+  old_meta.is_deleted_ = false;
+  page_handle.UpdateTupleMeta(old_meta, rid);
+  page_handle.page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), true);
   return true;
 }
@@ -171,30 +392,136 @@ auto RmFileHandle::DeleteTuple(RID rid, Context *context) -> bool {
   }
 
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
-  auto [meta, tuple] = page_handle.GetTuple(rid);
+  page_handle.page->WLatch();
+  auto meta = page_handle.GetTupleMeta(rid);
   if (meta.is_deleted_) {
+    page_handle.page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
     throw InternalError("RmFileHandle::DeleteTuple Error: Tuple already deleted");
   }
+  CheckReadBeforeWrite(context, rid, meta);
+  if (context != nullptr) {
+    meta.ts_ = context->txn_->GetWriteVersion();
+  }
   meta.is_deleted_ = true;
   page_handle.UpdateTupleMeta(meta, rid);
+  page_handle.page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), true);
+  // Without a txn the slot is reusable right away, otherwise it is advertised when the txn finishes
+  if (context == nullptr) {
+    UpdateFreeSpace(rid.GetPageId());
+  }
   return true;
 }
 
+void RmFileHandle::UpdateFreeSpace(page_id_t page_no) {
+  RmPageHandle page_handle = FetchPageHandle(page_no);
+  page_handle.page->RLatch();
+  int free_space = page_handle.GetFreeSpace();
+  page_handle.page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+  fsm_->Update(page_no, free_space);
+}
+
+void RmFileHandle::VacuumPage(page_id_t page_no, LockManager *lock_mgr, LogManager *log_mgr, double min_dead_ratio,
+                              RmVacuumStats *stats) {
+  if (file_hdr_.format == RmFileFormat::COLUMNAR) {
+    // Columnar slots have a fixed size and are reused in place, there is nothing to compact. A full page is sealed
+    SealPage(page_no, lock_mgr, stats);
+    UpdateFreeSpace(page_no);
+    return;
+  }
+  RmPageHandle page_handle = FetchPageHandle(page_no);
+  page_handle.page->RLatch();
+  int num_records = page_handle.page_hdr_->num_records;
+  int num_deleted_records = page_handle.page_hdr_->num_deleted_records;
+  page_handle.page->RUnlatch();
+  if (num_deleted_records == 0 || num_deleted_records < min_dead_ratio * num_records) {
+    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+    UpdateFreeSpace(page_no);
+    return;
+  }
+
+  // WAL: the deletes must be durable before the deleted data is discarded. The deleters of the reclaimed tuples
+  // have released their locks, so their commit records are already in the log buffer
+  log_mgr->flush_log_to_disk();
+
+  page_handle.page->WLatch();
+  if (!page_handle.CanMoveTuples()) {
+    // A scan is positioned on the page, leave it to the next vacuum
+    page_handle.page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+    UpdateFreeSpace(page_no);
+    return;
+  }
+  int old_unused_space = page_handle.GetUnusedSpace();
+  num_records = page_handle.page_hdr_->num_records;
+  std::vector<bool> reclaim(num_records, false);
+  int num_reclaimed = 0;
+  for (uint16_t slot_no = 0; slot_no < num_records; ++slot_no) {
+    auto &[offset, size, meta] = page_handle.tuple_info_[slot_no];
+    // Note: inserters reuse deleted slots under the page latch too, so a slot we find unlocked stays unlocked
+    if (meta.is_deleted_ && !lock_mgr->IsRecordLocked(RID(page_no, slot_no), fd_)) {
+      reclaim[slot_no] = true;
+      num_reclaimed += size > 0 ? 1 : 0;
+    }
+  }
+  page_handle.Compact(reclaim);
+  int free_space = page_handle.GetFreeSpace();
+  if (stats != nullptr) {
+    stats->num_pages_++;
+    stats->num_tuples_ += num_reclaimed;
+    stats->num_bytes_ += page_handle.GetUnusedSpace() - old_unused_space;
+    stats->num_empty_pages_ += page_handle.page_hdr_->num_records == 0 ? 1 : 0;
+  }
+  page_handle.page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), true);
+  fsm_->Update(page_no, free_space);
+}
+
+auto RmFileHandle::Vacuum(LockManager *lock_mgr, LogManager *log_mgr) -> RmVacuumStats {
+  RmVacuumStats stats;
+  for (page_id_t page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr_.num_pages; ++page_no) {
+    VacuumPage(page_no, lock_mgr, log_mgr, 0, &stats);
+  }
+  if (toast_ != nullptr) {
+    SweepToast(&stats);
+  }
+  return stats;
+}
+
 auto RmFileHandle::UpdateTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid, Context *context,
                                       std::function<bool(const TupleMeta &meta, const Tuple &table, RID rid)> &&check)
     -> bool {
+  CheckColumnarTuple(tuple);
   // lock manager
   if (context != nullptr) {
     context->lock_mgr_->LockExclusiveOnRecord(context->txn_, rid, fd_);
   }
+  std::shared_lock<std::shared_mutex> gc_lock;
+  std::optional<Tuple> toasted = ToastTuple(tuple, &gc_lock);
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
+  page_handle.page->WLatch();
   auto [old_meta, old_tup] = page_handle.GetTuple(rid);
+  if (check != nullptr && toast_ != nullptr) {
+    toast_->Detoast(&old_tup);
+  }
   if (check == nullptr || check(old_meta, old_tup, rid)) {
-    page_handle.UpdateTupleInPlaceUnsafe(meta, tuple, rid);
+    CheckReadBeforeWrite(context, rid, old_meta);
+    if (!page_handle.UpdateTupleInPlaceUnsafe(meta, toasted.has_value() ? *toasted : tuple, rid)) {
+      // The new values do not fit into the encodings of a sealed page, the caller moves the tuple
+      page_handle.page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+      return false;
+    }
+    if (zone_map_ != nullptr) {
+      zone_map_->Update(rid.GetPageId(), tuple);
+    }
+    page_handle.page->WUnlatch();
     buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), true);
     return true;
   }
+  page_handle.page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
   return false;
 }
@@ -205,7 +532,10 @@ void RmFileHandle::UpdateTupleMeta(const TupleMeta &meta, RID rid, Context *cont
     context->lock_mgr_->LockExclusiveOnRecord(context->txn_, rid, fd_);
   }
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
+  page_handle.page->WLatch();
+  CheckReadBeforeWrite(context, rid, page_handle.GetTupleMeta(rid));
   page_handle.UpdateTupleMeta(meta, rid);
+  page_handle.page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), true);
 }
 
@@ -215,8 +545,15 @@ auto RmFileHandle::GetTuple(RID rid, Context *context) -> std::pair<TupleMeta, T
     context->lock_mgr_->LockSharedOnRecord(context->txn_, rid, fd_);
   }
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
+  page_handle.page->RLatch();
   auto [meta, tuple] = page_handle.GetTuple(rid);
+  // Note: the toasted values are read under the page latch, so VACUUM cannot reclaim them in between
+  if (toast_ != nullptr) {
+    toast_->Detoast(&tuple);
+  }
+  page_handle.page->RUnlatch();
   buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+  TrackRead(context, rid, meta);
   tuple.rid_ = rid;
   return std::make_pair(meta, std::move(tuple));
 }
@@ -227,8 +564,17 @@ auto RmFileHandle::GetTupleMeta(RID rid, Context *context) -> TupleMeta {
     context->lock_mgr_->LockSharedOnRecord(context->txn_, rid, fd_);
   }
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
+  page_handle.page->RLatch();
+  if (rid.GetSlotNum() >= page_handle.GetNumTuples()) {
+    // the slot has been truncated by VACUUM
+    page_handle.page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+    throw Exception("Tuple ID out of range");
+  }
   TupleMeta meat = page_handle.GetTupleMeta(rid);
+  page_handle.page->RUnlatch();
   buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+  TrackRead(context, rid, meat);
   return meat;
 }
 
@@ -276,14 +622,49 @@ auto RmFileHandle::GetTupleValue(const RID &rid, Context *context) -> std::uniqu
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
 
   // 2. Initialize a unique pointer to Tuple
+  page_handle.page->RLatch();
   auto [meta, tuple] = page_handle.GetTuple(rid);
+  if (toast_ != nullptr) {
+    toast_->Detoast(&tuple);
+  }
+  page_handle.page->RUnlatch();
 
   // Unpin the page
   buffer_pool_manager_->UnpinPage({fd_, rid.GetPageId()}, false);
+  TrackRead(context, rid, meta);
 
   return std::make_unique<Tuple>(tuple);
 }
 
+void RmFileHandle::GetTuplesOnPage(const RID *rids, size_t num_rids, Context *context, std::vector<Tuple> *tuples) {
+  // lock manager: the record locks are taken before the page latch, a lock may wait
+  if (context != nullptr) {
+    for (size_t i = 0; i < num_rids; ++i) {
+      context->lock_mgr_->LockSharedOnRecord(context->txn_, rids[i], fd_);
+    }
+  }
+
+  RmPageHandle page_handle = FetchPageHandle(rids[0].GetPageId());
+  std::vector<TupleMeta> metas;
+  metas.reserve(num_rids);
+  page_handle.page->RLatch();
+  for (size_t i = 0; i < num_rids; ++i) {
+    EASYDB_ASSERT(rids[i].GetPageId() == rids[0].GetPageId(), "the rids are not on the same page");
+    auto [meta, tuple] = page_handle.GetTuple(rids[i]);
+    if (toast_ != nullptr) {
+      toast_->Detoast(&tuple);
+    }
+    tuple.rid_ = rids[i];
+    metas.push_back(meta);
+    tuples->push_back(std::move(tuple));
+  }
+  page_handle.page->RUnlatch();
+  buffer_pool_manager_->UnpinPage({fd_, rids[0].GetPageId()}, false);
+  for (size_t i = 0; i < num_rids; ++i) {
+    TrackRead(context, rids[i], metas[i]);
+  }
+}
+
 auto RmFileHandle::GetKeyTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
                                const RID &rid, Context *context) -> Tuple {
   // lock manager
@@ -295,11 +676,21 @@ auto RmFileHandle::GetKeyTuple(const Schema &schema, const Schema &key_schema, c
   RmPageHandle page_handle = FetchPageHandle(rid.GetPageId());
 
   // 2. Initialize a unique pointer to RmRecord
+  page_handle.page->RLatch();
   auto [meta, tuple] = page_handle.GetTuple(rid);
+  if (toast_ != nullptr) {
+    std::vector<bool> projection(file_hdr_.num_cols, false);
+    for (auto attr : key_attrs) {
+      projection[attr] = true;
+    }
+    toast_->Detoast(&tuple, projection);
+  }
+  page_handle.page->RUnlatch();
   auto key_tuple = tuple.KeyFromTuple(schema, key_schema, key_attrs);
 
   // Unpin the page
   buffer_pool_manager_->UnpinPage({fd_, rid.GetPageId()}, false);
+  TrackRead(context, rid, meta);
   return key_tuple;
 }
 
@@ -360,6 +751,199 @@ auto RmFileHandle::GetKeyTuple(const Schema &schema, const Schema &key_schema, c
 //   throw InternalError("RmFileHandle::update_record removed, use UpdateTupleInPlace instead.");
 // }
 
+/**
+ * @description: OCC事务记录读到的记录版本，提交时验证
+ * @param {Context*} context
+ * @param {RID&} rid 读到的记录号
+ * @param {TupleMeta&} meta 读到的记录版本
+ * @note 已被本事务写锁定的记录不会再被其他事务修改，无需记录
+ */
+void RmFileHandle::TrackRead(Context *context, const RID &rid, const TupleMeta &meta) {
+  if (context == nullptr || !context->txn_->IsOptimistic()) {
+    return;
+  }
+  LockDataId lock_data_id(fd_, rid, LockDataType::RECORD);
+  if (context->txn_->GetLockSet()->count(lock_data_id) > 0) {
+    return;
+  }
+  // Keep the first version we read, later reads of a different version must fail validation anyway
+  context->txn_->GetReadSet()->emplace(lock_data_id, ReadRecord{this, rid, meta});
+}
+
+/**
+ * @description: OCC事务写锁定一条读过的记录时，检查记录在读之后是否被修改
+ * @param {Context*} context
+ * @param {RID&} rid 要写的记录号，调用时已持有排他锁
+ * @param {TupleMeta&} meta 加锁后记录的当前版本
+ * @note 未被修改则从读集合中移除（排他锁会一直保护它到提交）；被修改则保留，
+ *       写入后记录的版本变为本事务的版本，提交验证必然失败。这里不直接抛出异常，
+ *       避免在执行器修改索引的中途回滚
+ */
+void RmFileHandle::CheckReadBeforeWrite(Context *context, const RID &rid, const TupleMeta &meta) {
+  if (context == nullptr || !context->txn_->IsOptimistic()) {
+    return;
+  }
+  auto read_set = context->txn_->GetReadSet();
+  auto iter = read_set->find(LockDataId(fd_, rid, LockDataType::RECORD));
+  if (iter != read_set->end() && iter->second.meta_ == meta) {
+    read_set->erase(iter);
+  }
+}
+
+/**
+ * @description: 在页面中找到一个放得下tuple的已删除slot并复用，调用者需持有页面的写锁
+ * @return {optional<uint16_t>} 复用的slot号，没有可复用的slot时返回nullopt
+ * @param {RmPageHandle&} page_handle 要插入的页面
+ * @param {TupleMeta&} meta 新记录的元数据
+ * @param {Tuple&} tuple 新记录
+ * @param {Context*} context
+ * @note 只有删除该记录的事务已经结束（记录上没有任何锁）时slot才可以复用，因此这里只尝试加锁，不会等待；
+ *       没有事务上下文时（如load data）无法判断删除是否已经提交，不复用；
+ *       slot的空间不够时（如已被VACUUM回收）从页面的连续空闲空间中扩展，但页面被扫描pin住时不能移动其他记录
+ */
+auto RmFileHandle::ReuseDeletedSlot(RmPageHandle &page_handle, const TupleMeta &meta, const Tuple &tuple,
+                                    Context *context) -> std::optional<uint16_t> {
+  if (context == nullptr || page_handle.page_hdr_->num_deleted_records == 0) {
+    return std::nullopt;
+  }
+  page_id_t page_no = page_handle.page->GetPageId().page_no;
+  for (uint16_t slot_no = 0; slot_no < page_handle.page_hdr_->num_records; ++slot_no) {
+    TupleMeta old_meta = page_handle.MetaAt(slot_no);
+    if (!old_meta.is_deleted_ || !page_handle.CanReuseSlot(slot_no, tuple)) {
+      continue;
+    }
+    RID rid(page_no, slot_no);
+    if (!context->lock_mgr_->TryLockExclusiveOnRecord(context->txn_, rid, fd_)) {
+      continue;
+    }
+    CheckReadBeforeWrite(context, rid, old_meta);
+    page_handle.ReuseSlot(slot_no, meta, tuple);
+    return slot_no;
+  }
+  return std::nullopt;
+}
+
+/**
+ * @description: 检查列存格式的表能否存放一条记录，变长列的值不能超过该列在minipage中预留的空间
+ * @param {Tuple&} tuple 要写入的记录
+ */
+void RmFileHandle::CheckColumnarTuple(const Tuple &tuple) const {
+  if (file_hdr_.format != RmFileFormat::COLUMNAR) {
+    return;
+  }
+  if (tuple.GetLength() < static_cast<uint32_t>(file_hdr_.fixed_size)) {
+    throw InternalError("RmFileHandle: tuple does not match the columnar layout");
+  }
+  const char *row = tuple.GetData();
+  for (int i = 0; i < file_hdr_.num_cols; ++i) {
+    const auto &col = file_hdr_.cols[i];
+    if (col.is_inlined) {
+      continue;
+    }
+    const char *payload = row + *reinterpret_cast<const uint32_t *>(row + col.offset);
+    if (RmPageHandle::GetPayloadSize(payload) > static_cast<uint32_t>(col.width)) {
+      throw StringOverflowError();
+    }
+  }
+}
+
+/**
+ * @description: 封存（压缩）一个已满的列存页面，见RmPageHandle::Seal
+ * @param {page_id_t} page_no 要封存的页面
+ * @param {LockManager*} lock_mgr 页面中有记录被加锁时不封存，回滚时可能写回页面中已经没有的值
+ * @param {RmVacuumStats*} stats 可以为nullptr
+ * @note 与VACUUM整理页面一样，页面被扫描pin住时不封存，留给下一次VACUUM
+ */
+void RmFileHandle::SealPage(page_id_t page_no, LockManager *lock_mgr, RmVacuumStats *stats) {
+  RmPageHandle page_handle = FetchPageHandle(page_no);
+  page_handle.page->WLatch();
+  int num_records = page_handle.page_hdr_->num_records;
+  bool can_seal = !page_handle.IsSealed() && num_records == file_hdr_.num_records_per_page &&
+                  page_handle.CanMoveTuples();
+  for (uint16_t slot_no = 0; can_seal && slot_no < num_records; ++slot_no) {
+    can_seal = !lock_mgr->IsRecordLocked(RID(page_no, slot_no), fd_);
+  }
+  int num_saved_bytes = can_seal ? page_handle.Seal() : 0;
+  if (num_saved_bytes > 0 && stats != nullptr) {
+    stats->num_pages_++;
+    stats->num_bytes_ += num_saved_bytes;
+    stats->num_sealed_pages_++;
+  }
+  page_handle.page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), num_saved_bytes > 0);
+}
+
+/**
+ * @description: 根据页面中的所有记录（包括已删除的记录）建立页面的zone，调用者需持有页面的读锁
+ * @param {RmPageHandle&} page_handle 要建立zone的页面
+ */
+void RmFileHandle::BuildZone(RmPageHandle &page_handle) {
+  page_id_t page_no = page_handle.page->GetPageId().page_no;
+  std::vector<Tuple> tuples;
+  for (uint16_t slot_no = 0; slot_no < page_handle.page_hdr_->num_records; ++slot_no) {
+    // Note: the data of a slot reclaimed by VACUUM is gone
+    if (!page_handle.IsColumnar() && std::get<1>(page_handle.tuple_info_[slot_no]) == 0) {
+      continue;
+    }
+    tuples.push_back(page_handle.GetTuple(RID(page_no, slot_no)).second);
+    if (toast_ != nullptr) {
+      toast_->Detoast(&tuples.back());
+    }
+  }
+  zone_map_->Build(page_no, tuples);
+}
+
+/**
+ * @description: 行存格式：记录过长时将其中最长的值移到TOAST页面中，见RmToastStore::Toast
+ * @param {Tuple&} tuple 要写入的记录
+ * @param {shared_lock*} gc_lock 移动了值时对TOAST的GC latch加共享锁（已经持有时不再加锁），调用者在记录写入
+ *                              页面之后才释放，使VACUUM不会回收还没有记录指向的值
+ * @return {optional<Tuple>} 指向TOAST页面的记录，没有移动任何值时为nullopt
+ */
+auto RmFileHandle::ToastTuple(const Tuple &tuple, std::shared_lock<std::shared_mutex> *gc_lock)
+    -> std::optional<Tuple> {
+  if (toast_ == nullptr || tuple.GetLength() <= RM_TOAST_TUPLE_THRESHOLD) {
+    return std::nullopt;
+  }
+  if (!gc_lock->owns_lock()) {
+    *gc_lock = std::shared_lock(toast_->GetGcLatch());
+  }
+  return toast_->Toast(tuple);
+}
+
+/**
+ * @description: 回收TOAST页面：标记所有slot（包括还没有被VACUUM回收的已删除记录）指向的值，其余的页面都是空闲的
+ * @param {RmVacuumStats*} stats 统计信息
+ * @note 持有GC latch的排他锁，此时没有写入者在移动值。读取者在页面latch下读取值（包括OCC事务的RmScan，见
+ *       RmScan::SetPosition），或持有表锁使其他事务不能让正在读取的值失去引用，因此正在读取的值都被标记
+ */
+void RmFileHandle::SweepToast(RmVacuumStats *stats) {
+  std::unique_lock gc_lock(toast_->GetGcLatch());
+  std::vector<page_id_t> chains;
+  for (page_id_t page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr_.num_pages; ++page_no) {
+    RmPageHandle page_handle = FetchPageHandle(page_no);
+    page_handle.page->RLatch();
+    for (uint16_t slot_no = 0; slot_no < page_handle.page_hdr_->num_records; ++slot_no) {
+      auto &[offset, size, meta] = page_handle.tuple_info_[slot_no];
+      if (size > 0) {
+        toast_->CollectChains(page_handle.page_start_ + offset, &chains);
+      }
+    }
+    page_handle.page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+  }
+  stats->num_toast_pages_ += toast_->Sweep(chains);
+}
+
+/**
+ * @description: 根据每个数据页面的实际空闲空间重建空闲空间映射，用于打开没有FSM文件的旧表
+ */
+void RmFileHandle::RebuildFreeSpaceMap() {
+  for (page_id_t page_no = RM_FIRST_RECORD_PAGE; page_no < file_hdr_.num_pages; ++page_no) {
+    UpdateFreeSpace(page_no);
+  }
+}
+
 /**
  * 以下函数为辅助函数，仅提供参考，可以选择完成如下函数，也可以删除如下函数，在单元测试中不涉及如下函数接口的直接调用
  */
@@ -401,7 +985,7 @@ RmPageHandle RmFileHandle::FetchPageHandle(page_id_t page_no) const {
  * @return {RmPageHandle} 新的PageHandle
  * @note 该函数调用new_page进行pin操作，调用者需要调用UnpinPage进行unpin操作；
  *       初始化page_hdr中的next_free_page_no(-1)和num_records(0);
- *       更新file_hdr_中的num_pages和first_free_page_no;
+ *       更新file_hdr_中的num_pages，新页面的空闲空间由调用者写入FSM;
  *       写回文件头到磁盘
  */
 RmPageHandle RmFileHandle::CreateNewPageHandle() {
@@ -411,6 +995,9 @@ RmPageHandle RmFileHandle::CreateNewPageHandle() {
   // 3.更新file_hdr_
   // return RmPageHandle(&file_hdr_, nullptr);
 
+  // Concurrent inserters may extend the file at the same time
+  std::scoped_lock lock(extend_latch_);
+
   // 1. Use the buffer pool to create a new page
   PageId new_page_id;
   new_page_id.fd = fd_;
@@ -424,10 +1011,12 @@ RmPageHandle RmFileHandle::CreateNewPageHandle() {
   RmPageHandle new_page_handle(&file_hdr_, new_page);
   // Initialize the new page header
   new_page_handle.page_hdr_->Init();
+  if (new_page_handle.IsColumnar()) {
+    new_page_handle.columnar_hdr_->Init();
+  }
 
   // 3. Update the file header
   file_hdr_.num_pages++;
-  file_hdr_.first_free_page_no = new_page_id.page_no;
 
   // Write the updated file header back to the disk
   disk_manager_->WritePage(fd_, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
@@ -457,53 +1046,4 @@ void RmFileHandle::SetPageLSN(page_id_t page_id_, lsn_t lsn) {
   buffer_pool_manager_->UnpinPage(page_id, true);
 }
 
-/**
- * @brief 创建或获取一个空闲的page handle
- *
- * @return RmPageHandle 返回生成的空闲page handle
- * @note pin the page, remember to unpin it outside!
- */
-RmPageHandle RmFileHandle::CreatePageHandle() {
-  // Todo:
-  // 1. 判断file_hdr_中是否还有空闲页
-  //     1.1 没有空闲页：使用缓冲池来创建一个新page；可直接调用create_new_page_handle()
-  //     1.2 有空闲页：直接获取第一个空闲页
-  // 2. 生成page handle并返回给上层
-  // return RmPageHandle(&file_hdr_, nullptr);
-
-  int page_no = file_hdr_.first_free_page_no;
-  // 1. Check if there are free pages in file_hdr_
-  if (page_no == RM_NO_PAGE) {
-    // 1.1 No free pages: create a new page handle using the existing function
-    return CreateNewPageHandle();
-  }
-
-  // 1.2 There are free pages: fetch the first free page
-  RmPageHandle page_handle = FetchPageHandle(page_no);
-
-  // 2. Return the page handle
-  return page_handle;
-}
-
-/**
- * @description: 当一个页面从没有空闲空间的状态变为有空闲空间状态时，更新文件头和页头中空闲页面相关的元数据
- * @note 该函数更新
-         文件头中的first_free_page_no为该空闲页面，
-         页头中的next_free_page_no为原文件头中的first_free_page_no，
-         写回文件头到磁盘
- */
-void RmFileHandle::ReleasePageHandle(RmPageHandle &page_handle) {
-  // Todo:
-  // 当page从已满变成未满，考虑如何更新：
-  // 1. page_handle.page_hdr->next_free_page_no
-  // 2. file_hdr_.first_free_page_no
-
-  // If the page becomes non-full, update the next_free_page_no and first_free_page_no
-  // page_handle.page_hdr->next_free_page_no = file_hdr_.first_free_page_no;
-  file_hdr_.first_free_page_no = page_handle.page->GetPageId().page_no;
-
-  // Write the updated file header back to disk
-  disk_manager_->WritePage(fd_, RM_FILE_HDR_PAGE, (char *)&file_hdr_, sizeof(file_hdr_));
-}
-
 }  // namespace easydb
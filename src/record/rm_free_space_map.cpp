@@ -0,0 +1,168 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_free_space_map.cpp
+ *
+ * Identification: src/record/rm_free_space_map.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "record/rm_free_space_map.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "common/errors.h"
+
+namespace easydb {
+
+RmFreeSpaceMap::RmFreeSpaceMap(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager,
+                               const std::string &file_name, int num_pages)
+    : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager) {
+  std::string fsm_file_name = GetFileName(file_name);
+  is_new_ = !disk_manager_->IsFile(fsm_file_name);
+  if (is_new_) {
+    disk_manager_->CreateFile(fsm_file_name);
+  }
+  fd_ = disk_manager_->OpenFile(fsm_file_name);
+
+  // Every data page of the file is covered, pages that were never flushed read as zeros (no free space)
+  int num_fsm_pages = is_new_ ? 0 : (num_pages + FSM_LEAVES_PER_PAGE - 1) / FSM_LEAVES_PER_PAGE;
+  disk_manager_->SetFd2Pageno(fd_, num_fsm_pages);
+  for (int fsm_page_no = 0; fsm_page_no < num_fsm_pages; ++fsm_page_no) {
+    Page *page = buffer_pool_manager_->FetchPage({fd_, fsm_page_no});
+    if (page == nullptr) {
+      throw InternalError("RmFreeSpaceMap: Failed to fetch fsm page");
+    }
+    roots_.push_back(GetTree(page)[0]);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
+
+auto RmFreeSpaceMap::FindPage(int size, page_id_t hint) -> page_id_t {
+  int need = std::max(1, GetCategory(size));
+  if (need > UINT8_MAX) {
+    return RM_NO_PAGE;
+  }
+
+  std::shared_lock lock(latch_);
+  int num_fsm_pages = roots_.size();
+  lock.unlock();
+  if (num_fsm_pages == 0) {
+    return RM_NO_PAGE;
+  }
+  hint = std::max(hint, 0) % (num_fsm_pages * FSM_LEAVES_PER_PAGE);
+  int start = hint / FSM_LEAVES_PER_PAGE;
+
+  // Visit the FSM page of the hint from the hint, then the others, then the first part of the hint's FSM page
+  for (int i = 0; i <= num_fsm_pages; ++i) {
+    int fsm_page_no = (start + i) % num_fsm_pages;
+    int from = i == 0 ? hint % FSM_LEAVES_PER_PAGE : 0;
+    if (i == num_fsm_pages && hint % FSM_LEAVES_PER_PAGE == 0) {
+      break;
+    }
+    lock.lock();
+    bool has_room = roots_[fsm_page_no] >= need;
+    lock.unlock();
+    if (!has_room) {
+      continue;
+    }
+
+    Page *page = buffer_pool_manager_->FetchPage({fd_, fsm_page_no});
+    if (page == nullptr) {
+      throw InternalError("RmFreeSpaceMap: Failed to fetch fsm page");
+    }
+    page->RLatch();
+    int leaf = SearchLeaf(GetTree(page), need, from);
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (leaf >= 0) {
+      return fsm_page_no * FSM_LEAVES_PER_PAGE + leaf;
+    }
+  }
+  return RM_NO_PAGE;
+}
+
+void RmFreeSpaceMap::Update(page_id_t page_no, int free_space) {
+  auto category = static_cast<uint8_t>(std::clamp(GetCategory(free_space), 0, static_cast<int>(UINT8_MAX)));
+  int fsm_page_no = page_no / FSM_LEAVES_PER_PAGE;
+  Extend(fsm_page_no);
+
+  Page *page = buffer_pool_manager_->FetchPage({fd_, fsm_page_no});
+  if (page == nullptr) {
+    throw InternalError("RmFreeSpaceMap: Failed to fetch fsm page");
+  }
+  page->WLatch();
+  uint8_t *tree = GetTree(page);
+  int node = FSM_LEAVES_PER_PAGE - 1 + page_no % FSM_LEAVES_PER_PAGE;
+  bool changed = tree[node] != category;
+  tree[node] = category;
+  // Propagate to the root until the max stops changing
+  while (node > 0) {
+    int parent = (node - 1) / 2;
+    uint8_t max_child = std::max(tree[2 * parent + 1], tree[2 * parent + 2]);
+    if (tree[parent] == max_child) {
+      break;
+    }
+    tree[parent] = max_child;
+    node = parent;
+  }
+  if (changed) {
+    // Note: always page latch -> latch_, FindPage never holds latch_ while latching a page
+    std::unique_lock lock(latch_);
+    roots_[fsm_page_no] = tree[0];
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), changed);
+}
+
+void RmFreeSpaceMap::Close() {
+  buffer_pool_manager_->FlushAllPages(fd_);
+  buffer_pool_manager_->RemoveAllPages(fd_);
+  disk_manager_->CloseFile(fd_);
+}
+
+void RmFreeSpaceMap::Extend(int fsm_page_no) {
+  {
+    std::shared_lock lock(latch_);
+    if (fsm_page_no < static_cast<int>(roots_.size())) {
+      return;
+    }
+  }
+  std::unique_lock lock(latch_);
+  while (fsm_page_no >= static_cast<int>(roots_.size())) {
+    PageId page_id{fd_, INVALID_PAGE_ID};
+    Page *page = buffer_pool_manager_->NewPage(&page_id);
+    if (page == nullptr) {
+      throw InternalError("RmFreeSpaceMap: Failed to create fsm page");
+    }
+    assert(page_id.page_no == static_cast<int>(roots_.size()));
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    roots_.push_back(0);
+  }
+}
+
+auto RmFreeSpaceMap::SearchLeaf(const uint8_t *tree, uint8_t need, int from) -> int {
+  // Climb from the leaf until a right sibling has room, then descend to its leftmost leaf with room
+  int node = FSM_LEAVES_PER_PAGE - 1 + from;
+  if (tree[node] < need) {
+    while (true) {
+      if (node == 0) {
+        return -1;
+      }
+      if (node % 2 == 1 && tree[node + 1] >= need) {
+        node++;
+        break;
+      }
+      node = (node - 1) / 2;
+    }
+    while (node < FSM_LEAVES_PER_PAGE - 1) {
+      node = tree[2 * node + 1] >= need ? 2 * node + 1 : 2 * node + 2;
+    }
+  }
+  return node - (FSM_LEAVES_PER_PAGE - 1);
+}
+
+}  // namespace easydb
@@ -10,72 +10,176 @@
  */
 
 #include "record/rm_scan.h"
+#include <algorithm>
+#include <cassert>
 #include <cstdint>
 #include "record/rm_file_handle.h"
 
 namespace easydb {
 
 /**
- * @brief 初始化file_handle和rid
+ * @brief 初始化file_handle，并定位到文件中的第一条记录
  * @param file_handle
+ * @param context
  */
-RmScan::RmScan(const RmFileHandle *file_handle) : file_handle_(file_handle) {
-  // Initialize file_handle and set rid_ to the first valid record
+RmScan::RmScan(RmFileHandle *file_handle, Context *context, const std::vector<uint32_t> &col_ids,
+               std::vector<RmZonePredicate> preds)
+    : file_handle_(file_handle), context_(context), preds_(std::move(preds)) {
+  if (!col_ids.empty() && file_handle_->file_hdr_.num_cols > 0) {
+    projection_.assign(file_handle_->file_hdr_.num_cols, false);
+    for (auto col_id : col_ids) {
+      if (col_id < projection_.size()) {
+        projection_[col_id] = true;
+      }
+    }
+    // The null bitmap is the last column, and is always read
+    projection_.back() = true;
+  }
   // Start from the first data page (page 0 is the file header)
-  // Initialize slot_no to 0 to start scanning from the beginning
-  rid_.Set(RM_FIRST_RECORD_PAGE, 0);
+  LoadPage(RM_FIRST_RECORD_PAGE);
 }
 
+RmScan::~RmScan() { ReleasePage(); }
+
 /**
  * @brief 找到文件中下一个存放了记录的位置
  */
 void RmScan::Next() {
-  auto page_no = rid_.GetPageId();
-  auto slot_no = rid_.GetSlotNum() + 1;
+  if (IsEnd()) {
+    return;
+  }
+  // Move to the next live slot of the current page, or to the next page
+  if (pos_ + 1 < live_slots_.size()) {
+    SetPosition(pos_ + 1);
+    return;
+  }
+  LoadPage(rid_.GetPageId() + 1);
+}
 
-  bool found_valid_record = false;
-  // If we have not reached the end of the file
-  while (page_no < file_handle_->file_hdr_.num_pages) {
-    RmPageHandle page_handle = file_handle_->FetchPageHandle(page_no);
-    uint32_t num_records = page_handle.GetNumTuples();
+/**
+ * @brief ​ 判断是否到达文件末尾
+ */
+bool RmScan::IsEnd() const { return page_ == nullptr; }
 
-    while (slot_no < num_records) {
-      // If not deleted, we have found a valid record
-      if (!page_handle.IsTupleDeleted({page_no, slot_no})) {
-        found_valid_record = true;
-        break;
-      }
-      // Move to the next slot
-      slot_no++;
-    };
+/**
+ * @brief RmScan内部存放的rid
+ */
+RID RmScan::GetRid() const { return rid_; }
 
-    // Unpin the page that was pinned in 'fetch_page_handle'
-    file_handle_->buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
+/**
+ * @brief 当前记录的视图，指向pin住的页面中的数据
+ */
+auto RmScan::GetTupleView() const -> TupleView {
+  assert(!IsEnd());
+  if (in_row_buf_) {
+    return TupleView(row_buf_.data(), row_buf_.size(), rid_);
+  }
+  auto [slot_no, offset, size] = live_slots_[pos_];
+  return TupleView(page_->GetData() + offset, size, rid_);
+}
 
-    // If we have reached the end of the page, move to the next page
-    if (slot_no == num_records) {
-      page_no++;
-      slot_no = 0;
+void RmScan::LoadPage(page_id_t page_no) {
+  ReleasePage();
+  RmZoneMap *zone_map = file_handle_->zone_map_.get();
+  for (; page_no < file_handle_->file_hdr_.num_pages; ++page_no) {
+    if (!preds_.empty() && zone_map != nullptr && !zone_map->MayMatch(page_no, preds_)) {
+      num_skipped_pages_++;
+      continue;
+    }
+    RmPageHandle page_handle = file_handle_->FetchPageHandle(page_no);
+    live_slots_.clear();
+    page_handle.page->RLatch();
+    if (!preds_.empty() && zone_map != nullptr && !zone_map->IsBuilt(page_no)) {
+      file_handle_->BuildZone(page_handle);
+    }
+    // Note: VACUUM may have truncated the slot array, num_records is re-read for every page
+    for (uint16_t slot_no = 0; slot_no < page_handle.page_hdr_->num_records; ++slot_no) {
+      const auto &meta = page_handle.MetaAt(slot_no);
+      if (meta.is_deleted_) {
+        continue;
+      }
+      if (page_handle.IsColumnar()) {
+        live_slots_.emplace_back(slot_no, 0, 0);
+      } else {
+        auto &[offset, size, _] = page_handle.tuple_info_[slot_no];
+        live_slots_.emplace_back(slot_no, offset, size);
+      }
+      file_handle_->TrackRead(context_, RID(page_no, slot_no), meta);
+    }
+    if (page_handle.IsSealed() && !preds_.empty()) {
+      FilterByDictionary(page_handle);
     }
+    page_handle.page->RUnlatch();
 
-    // If we have found a valid record, break out of the loop
-    if (found_valid_record) {
-      break;
+    if (!live_slots_.empty()) {
+      // Keep the page pinned while the scan is positioned on it
+      page_ = page_handle.page;
+      rid_.Set(page_no, 0);
+      SetPosition(0);
+      return;
     }
+    file_handle_->buffer_pool_manager_->UnpinPage(page_handle.page->GetPageId(), false);
   }
-  rid_.Set(page_no, slot_no);
+  rid_.Set(page_no, 0);
 }
 
 /**
- * @brief ​ 判断是否到达文件末尾
+ * @brief 在字典编码的列上计算谓词：字典中每个值只比较一次，然后按记录的编号去掉不满足谓词的记录
+ * @param page_handle 当前页面，调用者持有页面的读锁
  */
-bool RmScan::IsEnd() const {
-  // Check if we have reached the end of the file
-  return rid_.GetPageId() >= file_handle_->file_hdr_.num_pages;
+void RmScan::FilterByDictionary(const RmPageHandle &page_handle) {
+  std::vector<bool> matches;
+  for (auto &pred : preds_) {
+    if (!page_handle.EvalOnDictionary(pred, &matches)) {
+      continue;
+    }
+    live_slots_.erase(std::remove_if(live_slots_.begin(), live_slots_.end(),
+                                     [&](const auto &slot) {
+                                       return !matches[page_handle.GetDictCode(std::get<0>(slot), pred.col_id_)];
+                                     }),
+                      live_slots_.end());
+  }
+}
+
+void RmScan::SetPosition(size_t pos) {
+  pos_ = pos;
+  auto [slot_no, offset, size] = live_slots_[pos_];
+  rid_.Set(rid_.GetPageId(), slot_no);
+  // An OCC txn holds no table lock, other txns may update the tuple in place meanwhile, so it is copied out under
+  // the page latch instead of being handed out as a view into the page
+  bool copy = context_ != nullptr && context_->txn_->IsOptimistic();
+  if (copy) {
+    page_->RLatch();
+  }
+  if (file_handle_->file_hdr_.format == RmFileFormat::COLUMNAR) {
+    // Only the projected columns are read from their minipages
+    RmPageHandle page_handle(&file_handle_->file_hdr_, page_);
+    page_handle.ReadColumnarTuple(slot_no, projection_, &row_buf_);
+    in_row_buf_ = true;
+  } else {
+    const char *data = page_->GetData() + offset;
+    if (file_handle_->toast_ != nullptr && file_handle_->toast_->HasToastedValues(data)) {
+      // Only the toasted values of the projected columns are read from their toast pages. Without a table lock they
+      // are read under the page latch, so that VACUUM cannot reclaim them in between (see RmFileHandle::SweepToast)
+      file_handle_->toast_->Detoast(data, projection_, &row_buf_);
+      in_row_buf_ = true;
+    } else if (copy) {
+      row_buf_.assign(data, data + size);
+      in_row_buf_ = true;
+    } else {
+      in_row_buf_ = false;
+    }
+  }
+  if (copy) {
+    page_->RUnlatch();
+  }
+}
+
+void RmScan::ReleasePage() {
+  if (page_ != nullptr) {
+    file_handle_->buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+  }
 }
 
-/**
- * @brief RmScan内部存放的rid
- */
-RID RmScan::GetRid() const { return rid_; }
 }  // namespace easydb
@@ -0,0 +1,303 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_toast_store.cpp
+ *
+ * Identification: src/record/rm_toast_store.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "record/rm_toast_store.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "common/errors.h"
+
+namespace easydb {
+
+RmToastStore::RmToastStore(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager,
+                           const RmFileHdr *file_hdr, const std::string &file_name)
+    : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), file_hdr_(file_hdr) {
+  std::string toast_file_name = GetFileName(file_name);
+  if (!disk_manager_->IsFile(toast_file_name)) {
+    disk_manager_->CreateFile(toast_file_name);
+  }
+  fd_ = disk_manager_->OpenFile(toast_file_name);
+  // Toast pages are written through, so the file holds every page allocated before
+  num_pages_ = disk_manager_->GetFileSize(toast_file_name) / PAGE_SIZE;
+  disk_manager_->SetFd2Pageno(fd_, num_pages_);
+}
+
+auto RmToastStore::IsToastable(const RmFileHdr &file_hdr) -> bool {
+  if (file_hdr.format != RmFileFormat::ROW) {
+    return false;
+  }
+  for (int i = 0; i < file_hdr.num_cols; ++i) {
+    if (!file_hdr.cols[i].is_inlined) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto RmToastStore::Toast(const Tuple &tuple) -> std::optional<Tuple> {
+  if (tuple.GetLength() <= RM_TOAST_TUPLE_THRESHOLD) {
+    return std::nullopt;
+  }
+  const char *row = tuple.GetData();
+  auto payload_of = [&](int col_idx) {
+    return row + *reinterpret_cast<const uint32_t *>(row + file_hdr_->cols[col_idx].offset);
+  };
+
+  // 1. Pick the values to move, the largest first, until the tuple is short enough
+  std::vector<bool> moved(file_hdr_->num_cols, false);
+  uint32_t length = tuple.GetLength();
+  bool any_moved = false;
+  while (length > RM_TOAST_TUPLE_THRESHOLD) {
+    int victim = -1;
+    uint32_t victim_size = TOAST_POINTER_SIZE;
+    for (int i = 0; i < file_hdr_->num_cols; ++i) {
+      if (file_hdr_->cols[i].is_inlined || moved[i] || IsToasted(payload_of(i))) {
+        continue;
+      }
+      uint32_t payload_size = GetPayloadSize(payload_of(i));
+      if (payload_size > victim_size) {
+        victim = i;
+        victim_size = payload_size;
+      }
+    }
+    if (victim < 0) {
+      break;
+    }
+    moved[victim] = true;
+    length -= victim_size - TOAST_POINTER_SIZE;
+    any_moved = true;
+  }
+  if (!any_moved) {
+    return std::nullopt;
+  }
+
+  // 2. Rebuild the tuple with the payloads in column order like Tuple does, the values moved become pointers
+  Tuple toasted;
+  auto &data = toasted.data_;
+  data.assign(row, row + file_hdr_->fixed_size);
+  for (int i = 0; i < file_hdr_->num_cols; ++i) {
+    if (file_hdr_->cols[i].is_inlined) {
+      continue;
+    }
+    const char *payload = payload_of(i);
+    uint32_t offset = data.size();
+    *reinterpret_cast<uint32_t *>(data.data() + file_hdr_->cols[i].offset) = offset;
+    if (!moved[i]) {
+      data.insert(data.end(), payload, payload + GetPayloadSize(payload));
+      continue;
+    }
+    uint32_t len = *reinterpret_cast<const uint32_t *>(payload);
+    page_id_t first_page_no = StoreValue(payload + sizeof(uint32_t), len);
+    data.resize(offset + TOAST_POINTER_SIZE);
+    *reinterpret_cast<uint32_t *>(data.data() + offset) = len | RM_TOAST_FLAG;
+    *reinterpret_cast<page_id_t *>(data.data() + offset + sizeof(uint32_t)) = first_page_no;
+  }
+  toasted.rid_ = tuple.rid_;
+  return toasted;
+}
+
+auto RmToastStore::HasToastedValues(const char *data) const -> bool {
+  for (int i = 0; i < file_hdr_->num_cols; ++i) {
+    const auto &col = file_hdr_->cols[i];
+    if (!col.is_inlined && IsToasted(data + *reinterpret_cast<const uint32_t *>(data + col.offset))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RmToastStore::Detoast(const char *data, const std::vector<bool> &projection, std::vector<char> *out) const {
+  auto payload_of = [&](int col_idx) {
+    return data + *reinterpret_cast<const uint32_t *>(data + file_hdr_->cols[col_idx].offset);
+  };
+  auto is_wanted = [&](int col_idx) { return projection.empty() || projection[col_idx]; };
+
+  // 1. Calculate the size of the tuple, a toasted value that is not read is left as an empty string
+  uint32_t size = file_hdr_->fixed_size;
+  for (int i = 0; i < file_hdr_->num_cols; ++i) {
+    if (file_hdr_->cols[i].is_inlined) {
+      continue;
+    }
+    const char *payload = payload_of(i);
+    if (!IsToasted(payload)) {
+      size += GetPayloadSize(payload);
+    } else {
+      uint32_t len = *reinterpret_cast<const uint32_t *>(payload) & ~RM_TOAST_FLAG;
+      size += sizeof(uint32_t) + (is_wanted(i) ? len : 0);
+    }
+  }
+  out->resize(size);
+  char *row = out->data();
+  memcpy(row, data, file_hdr_->fixed_size);
+
+  // 2. Copy the payloads in column order, reading the toasted values from their chains
+  uint32_t offset = file_hdr_->fixed_size;
+  for (int i = 0; i < file_hdr_->num_cols; ++i) {
+    const auto &col = file_hdr_->cols[i];
+    if (col.is_inlined) {
+      continue;
+    }
+    const char *payload = payload_of(i);
+    *reinterpret_cast<uint32_t *>(row + col.offset) = offset;
+    if (!IsToasted(payload)) {
+      uint32_t payload_size = GetPayloadSize(payload);
+      memcpy(row + offset, payload, payload_size);
+      offset += payload_size;
+      continue;
+    }
+    uint32_t len = is_wanted(i) ? *reinterpret_cast<const uint32_t *>(payload) & ~RM_TOAST_FLAG : 0;
+    *reinterpret_cast<uint32_t *>(row + offset) = len;
+    if (len > 0) {
+      LoadValue(*reinterpret_cast<const page_id_t *>(payload + sizeof(uint32_t)), len, row + offset + sizeof(uint32_t));
+    }
+    offset += sizeof(uint32_t) + len;
+  }
+}
+
+void RmToastStore::Detoast(Tuple *tuple, const std::vector<bool> &projection) const {
+  if (!HasToastedValues(tuple->GetData())) {
+    return;
+  }
+  std::vector<char> data;
+  Detoast(tuple->GetData(), projection, &data);
+  tuple->data_ = std::move(data);
+}
+
+void RmToastStore::CollectChains(const char *data, std::vector<page_id_t> *chains) const {
+  for (int i = 0; i < file_hdr_->num_cols; ++i) {
+    const auto &col = file_hdr_->cols[i];
+    if (col.is_inlined) {
+      continue;
+    }
+    const char *payload = data + *reinterpret_cast<const uint32_t *>(data + col.offset);
+    if (IsToasted(payload)) {
+      chains->push_back(*reinterpret_cast<const page_id_t *>(payload + sizeof(uint32_t)));
+    }
+  }
+}
+
+auto RmToastStore::Sweep(const std::vector<page_id_t> &chains) -> int {
+  std::unique_lock lock(latch_);
+  std::vector<bool> is_live(num_pages_, false);
+  for (page_id_t first_page_no : chains) {
+    for (page_id_t page_no = first_page_no; page_no >= 0 && page_no < num_pages_ && !is_live[page_no];) {
+      is_live[page_no] = true;
+      Page *page = buffer_pool_manager_->FetchPage({fd_, page_no});
+      if (page == nullptr) {
+        throw InternalError("RmToastStore: Failed to fetch toast page");
+      }
+      page->RLatch();
+      page_no = GetHdr(page)->next_page_no;
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+  }
+  int num_free_pages = free_pages_.size();
+  free_pages_.clear();
+  for (page_id_t page_no = 0; page_no < num_pages_; ++page_no) {
+    if (!is_live[page_no]) {
+      free_pages_.push_back(page_no);
+    }
+  }
+  // The pages that were free already are still free, pages allocated since are in a live chain
+  return static_cast<int>(free_pages_.size()) - num_free_pages;
+}
+
+void RmToastStore::Close() {
+  buffer_pool_manager_->FlushAllPages(fd_);
+  buffer_pool_manager_->RemoveAllPages(fd_);
+  disk_manager_->CloseFile(fd_);
+}
+
+auto RmToastStore::StoreValue(const char *data, uint32_t size) -> page_id_t {
+  // The chain is private to the writer until the tuple pointing to it is written, so the pages are written in order
+  // and each page is linked to its successor once that one is allocated
+  page_id_t first_page_no = RM_NO_PAGE;
+  Page *prev = nullptr;
+  uint32_t num_stored = 0;
+  while (num_stored < size) {
+    Page *page = AllocatePage();
+    uint32_t chunk_size = std::min(size - num_stored, static_cast<uint32_t>(TOAST_DATA_SIZE));
+    page->WLatch();
+    GetHdr(page)->next_page_no = RM_NO_PAGE;
+    GetHdr(page)->size = chunk_size;
+    memcpy(GetData(page), data + num_stored, chunk_size);
+    page->WUnlatch();
+    num_stored += chunk_size;
+    if (prev == nullptr) {
+      first_page_no = page->GetPageId().page_no;
+    } else {
+      prev->WLatch();
+      GetHdr(prev)->next_page_no = page->GetPageId().page_no;
+      prev->WUnlatch();
+      buffer_pool_manager_->FlushPage(prev->GetPageId());
+      buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+    }
+    prev = page;
+  }
+  assert(prev != nullptr);
+  buffer_pool_manager_->FlushPage(prev->GetPageId());
+  buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+  return first_page_no;
+}
+
+void RmToastStore::LoadValue(page_id_t first_page_no, uint32_t size, char *data) const {
+  uint32_t num_loaded = 0;
+  for (page_id_t page_no = first_page_no; num_loaded < size;) {
+    if (page_no == RM_NO_PAGE) {
+      throw InternalError("RmToastStore: toast chain is shorter than the value");
+    }
+    Page *page = buffer_pool_manager_->FetchPage({fd_, page_no});
+    if (page == nullptr) {
+      throw InternalError("RmToastStore: Failed to fetch toast page");
+    }
+    page->RLatch();
+    uint32_t chunk_size = std::min(size - num_loaded, GetHdr(page)->size);
+    memcpy(data + num_loaded, GetData(page), chunk_size);
+    page_no = GetHdr(page)->next_page_no;
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    num_loaded += chunk_size;
+  }
+}
+
+auto RmToastStore::AllocatePage() -> Page * {
+  std::unique_lock lock(latch_);
+  if (!free_pages_.empty()) {
+    page_id_t page_no = free_pages_.back();
+    free_pages_.pop_back();
+    lock.unlock();
+    Page *page = buffer_pool_manager_->FetchPage({fd_, page_no});
+    if (page == nullptr) {
+      throw InternalError("RmToastStore: Failed to fetch toast page");
+    }
+    return page;
+  }
+  PageId page_id{fd_, INVALID_PAGE_ID};
+  Page *page = buffer_pool_manager_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw InternalError("RmToastStore: Failed to create toast page");
+  }
+  num_pages_ = std::max(num_pages_, page_id.page_no + 1);
+  return page;
+}
+
+auto RmToastStore::GetPayloadSize(const char *payload) -> uint32_t {
+  if (IsToasted(payload)) {
+    return TOAST_POINTER_SIZE;
+  }
+  uint32_t len = *reinterpret_cast<const uint32_t *>(payload);
+  return sizeof(uint32_t) + (len == EASYDB_VALUE_NULL ? 0 : len);
+}
+
+}  // namespace easydb
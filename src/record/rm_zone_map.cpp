@@ -0,0 +1,113 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_zone_map.cpp
+ *
+ * Identification: src/record/rm_zone_map.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "record/rm_zone_map.h"
+
+#include <mutex>
+
+namespace easydb {
+
+namespace {
+
+auto IsString(TypeId type) -> bool { return type == TYPE_CHAR || type == TYPE_VARCHAR; }
+
+/* 只有同为数值或同为字符串的值之间的比较与zone的min/max保序，其他比较不剪枝 */
+auto IsPrunable(const Value &col_val, const Value &val) -> bool {
+  return !val.IsNull() && IsString(col_val.GetTypeId()) == IsString(val.GetTypeId());
+}
+
+}  // namespace
+
+auto RmZoneMap::IsBuilt(page_id_t page_no) const -> bool {
+  std::shared_lock lock(latch_);
+  return page_no < static_cast<page_id_t>(zones_.size()) && zones_[page_no].has_value();
+}
+
+void RmZoneMap::Build(page_id_t page_no, const std::vector<Tuple> &tuples) {
+  std::vector<ColumnZone> zone(schema_.GetColumnCount());
+  for (auto &tuple : tuples) {
+    Widen(&zone, tuple);
+  }
+  std::unique_lock lock(latch_);
+  if (page_no >= static_cast<page_id_t>(zones_.size())) {
+    zones_.resize(page_no + 1);
+  }
+  zones_[page_no] = std::move(zone);
+}
+
+void RmZoneMap::Update(page_id_t page_no, const Tuple &tuple) {
+  std::unique_lock lock(latch_);
+  if (page_no < static_cast<page_id_t>(zones_.size()) && zones_[page_no].has_value()) {
+    Widen(&*zones_[page_no], tuple);
+  }
+}
+
+auto RmZoneMap::MayMatch(page_id_t page_no, const std::vector<RmZonePredicate> &preds) const -> bool {
+  std::shared_lock lock(latch_);
+  if (page_no >= static_cast<page_id_t>(zones_.size()) || !zones_[page_no].has_value()) {
+    return true;
+  }
+  const auto &zone = *zones_[page_no];
+  for (auto &pred : preds) {
+    if (!MayMatch(zone[pred.col_id_], pred)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RmZoneMap::Widen(std::vector<ColumnZone> *zone, const Tuple &tuple) const {
+  for (uint32_t i = 0; i < zone->size(); ++i) {
+    auto &col_zone = (*zone)[i];
+    if (tuple.IsNull(&schema_, i)) {
+      col_zone.num_nulls_++;
+      continue;
+    }
+    Value value = tuple.GetValue(&schema_, i);
+    if (!col_zone.min_.has_value() || value < *col_zone.min_) {
+      col_zone.min_ = value;
+    }
+    if (!col_zone.max_.has_value() || value > *col_zone.max_) {
+      col_zone.max_ = value;
+    }
+  }
+}
+
+auto RmZoneMap::MayMatch(const ColumnZone &zone, const RmZonePredicate &pred) -> bool {
+  // A null never satisfies a comparison, so a page with only nulls in the column never matches
+  if (!zone.min_.has_value()) {
+    return false;
+  }
+  const Value &min = *zone.min_;
+  const Value &max = *zone.max_;
+  const Value &val = pred.val_;
+  if (!IsPrunable(min, val)) {
+    return true;
+  }
+  switch (pred.op_) {
+    case OP_EQ:
+      return min <= val && val <= max;
+    case OP_NE:
+      return !(min == val && max == val);
+    case OP_LT:
+      return min < val;
+    case OP_GT:
+      return max > val;
+    case OP_LE:
+      return min <= val;
+    case OP_GE:
+      return max >= val;
+    default:
+      return true;
+  }
+}
+
+}  // namespace easydb
@@ -576,14 +576,19 @@ void RecoveryManager::redo_update(UpdateLogRecord *update_log) {
 
 void RecoveryManager::redo_index() {
   for (auto &tab_name : tab_name_with_index_) {
-    auto &tab = sm_manager_->db_.get_table(tab_name);
-    for (auto &index : tab.indexes) {
+    // DropIndex and CreateIndex modify the indexes of the table, iterate over a copy
+    auto indexes = sm_manager_->db_.get_table(tab_name).indexes;
+    for (auto &index : indexes) {
       std::vector<std::string> col_names;
       for (auto col : index.cols) {
         col_names.emplace_back(col.name);
       }
+      std::vector<std::string> include_names;
+      for (auto &col : index.include_cols) {
+        include_names.emplace_back(col.name);
+      }
       sm_manager_->DropIndex(tab_name, col_names, nullptr);
-      sm_manager_->CreateIndex(tab_name, col_names, nullptr);
+      sm_manager_->CreateIndex(tab_name, col_names, nullptr, include_names, index.is_hash);
     }
   }
 }
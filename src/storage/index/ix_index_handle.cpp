@@ -10,12 +10,20 @@
  */
 
 #include "storage/index/ix_index_handle.h"
+#include <algorithm>
 #include <memory>
 #include "common/config.h"
 #include "storage/index/ix_defs.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace easydb {
 
+// 整数key的二分查找缩小到这么多个key以内后，改为顺序比较（SSE2一次比较4个）
+constexpr int IX_INT_SCAN_WINDOW = 32;
+
 /**
  * @brief 在当前node中查找第一个>=target的key_idx
  *
@@ -29,20 +37,13 @@ int IxNodeHandle::LowerBound(const char *target) const {
   // return -1;
   // return -1;
 
-  // Binary search
-  int left = 0;
-  int right = page_hdr->num_key;
-  while (left < right) {
-    int mid = left + (right - left) / 2;
-    int cmp = IxCompare(GetKey(mid), target, file_hdr->col_types_, file_hdr->col_lens_);
-    if (cmp < 0) {
-      left = mid + 1;
-    } else {
-      right = mid;
-    }
+  if (file_hdr->slotted_) {
+    return SlottedBound(target, false, 0);
   }
-
-  return left;
+  if (file_hdr->int_key_len_ == sizeof(uint32_t)) {
+    return IntBound<uint32_t>(target, false, 0);
+  }
+  return IntBound<uint64_t>(target, false, 0);
 }
 
 /**
@@ -51,26 +52,67 @@ int IxNodeHandle::LowerBound(const char *target) const {
  * @return key_idx，范围为[1,num_key)，如果返回的key_idx=num_key，则表示target大于等于最后一个key
  * @note 注意此处的范围从1开始
  * @note 修改原有note，从0开始，因为可能第一个key > target
+ * @param begin 从这个位置开始查找，内部结点查找孩子时从1开始
  */
-int IxNodeHandle::UpperBound(const char *target) const {
+int IxNodeHandle::UpperBound(const char *target, int begin) const {
   // Todo:
   // 查找当前节点中第一个大于target的key，并返回key的位置给上层
   // 提示: 可以采用多种查找方式：顺序遍历、二分查找等；使用ix_compare()函数进行比较
   // return -1;
 
-  // Binary search
-  int left = 0;
+  if (file_hdr->slotted_) {
+    return SlottedBound(target, true, begin);
+  }
+  if (file_hdr->int_key_len_ == sizeof(uint32_t)) {
+    return IntBound<uint32_t>(target, true, begin);
+  }
+  return IntBound<uint64_t>(target, true, begin);
+}
+
+/**
+ * @brief 只有一个整数列时的LowerBound/UpperBound：编码后的key按大端读出即为按值有序的无符号整数，
+ * 二分查找时比较整数而不是逐字节比较；缩小到IX_INT_SCAN_WINDOW个key以内后顺序数出比target小的key，
+ * 4字节的key用SSE2一次比较4个
+ * @param upper false: 第一个>=target的位置；true: 第一个>target的位置
+ * @param begin 从这个位置开始查找
+ */
+template <typename T>
+int IxNodeHandle::IntBound(const char *target, bool upper, int begin) const {
+  const T value = ix_load_big_endian<T>(target);
+  auto before = [value, upper](T key) { return upper ? key <= value : key < value; };
+  int left = begin;
   int right = page_hdr->num_key;
-  while (left < right) {
+  while (right - left > IX_INT_SCAN_WINDOW) {
     int mid = left + (right - left) / 2;
-    int cmp = IxCompare(GetKey(mid), target, file_hdr->col_types_, file_hdr->col_lens_);
-    if (cmp <= 0) {
+    if (before(ix_load_big_endian<T>(GetKey(mid)))) {
       left = mid + 1;
     } else {
       right = mid;
     }
   }
-
+#if defined(__SSE2__)
+  if constexpr (sizeof(T) == sizeof(uint32_t)) {
+    // SSE2 only compares signed 32-bit integers: flip the sign bit of both sides
+    const __m128i sign = _mm_set1_epi32(INT32_MIN);
+    const __m128i target_vec = _mm_set1_epi32(static_cast<int32_t>(value ^ 0x80000000u));
+    for (; left + 4 <= right; left += 4) {
+      __m128i vec = _mm_loadu_si128(reinterpret_cast<const __m128i *>(GetKey(left)));
+      // byte swap every 32-bit lane: swap the bytes of the 16-bit words, then the words
+      vec = _mm_or_si128(_mm_slli_epi16(vec, 8), _mm_srli_epi16(vec, 8));
+      vec = _mm_shufflelo_epi16(vec, _MM_SHUFFLE(2, 3, 0, 1));
+      vec = _mm_shufflehi_epi16(vec, _MM_SHUFFLE(2, 3, 0, 1));
+      vec = _mm_xor_si128(vec, sign);
+      int mask = upper ? 0xF & ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(vec, target_vec)))
+                       : _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(vec, target_vec)));
+      if (mask != 0xF) {
+        return left + __builtin_popcount(mask);
+      }
+    }
+  }
+#endif
+  while (left < right && before(ix_load_big_endian<T>(GetKey(left)))) {
+    left++;
+  }
   return left;
 }
 
@@ -94,7 +136,7 @@ bool IxNodeHandle::LeafLookup(const char *key, RID **value) {
   int pos = LowerBound(key);
 
   // 2. Check if the target key Exists
-  if (pos < page_hdr->num_key && IxCompare(GetKey(pos), key, file_hdr->col_types_, file_hdr->col_lens_) == 0) {
+  if (pos < page_hdr->num_key && CompareKey(pos, key) == 0) {
     // 3. If it Exists, assign Rid to value
     *value = GetRid(pos);
     return true;
@@ -116,9 +158,10 @@ page_id_t IxNodeHandle::InternalLookup(const char *key) {
   // return -1;
 
   // 1. Find the position of the target key
-  int pos = UpperBound(key);
+  // key[0] is not kept up to date when smaller keys go into the first child, and it is never needed: start from 1
+  int pos = UpperBound(key, 1);
   // Decrement position to get the correct child node
-  pos = (pos > 0) ? pos - 1 : pos;
+  pos = pos - 1;
 
   // 2. Get the child node's page ID
   page_id_t child_page_id = ValueAt(pos);
@@ -132,6 +175,7 @@ page_id_t IxNodeHandle::InternalLookup(const char *key) {
  *
  * @param pos 要插入键值对的位置
  * @param (key, rid) 连续键值对的起始地址，也就是第一个键值对，可以通过(key, rid)来获取n个键值对
+ *                   slotted格式的叶结点中每个key之后紧跟payload
  * @param n 键值对数量
  * @note 会更新当前节点的键数量(+=n)
  * @note [0,pos)           [pos,num_key)
@@ -153,8 +197,34 @@ void IxNodeHandle::InsertPairs(int pos, const char *key, const RID *rid, int n)
     throw InternalError("IxNodeHandle::InsertPairs Error: Invalid position");
   }
 
-  // 2. Shift existing keys and RIDs to make space for new pairs
   int key_size = file_hdr->col_tot_len_;
+  if (file_hdr->slotted_) {
+    // slotted: the suffix of the key and the payload go into the heap, the slots after pos shift right
+    int prefix_len = page_hdr->prefix_len;
+    int payload_len = GetPayloadLen();
+    for (int i = 0; i < n; ++i) {
+      const char *cur = key + i * (key_size + payload_len);
+      assert(memcmp(cur, GetPrefix(), prefix_len) == 0);
+      int len = GetStoredLen(cur, prefix_len);
+      int bytes = len + payload_len;
+      int slots_end = sizeof(IxPageHdr) + (page_hdr->num_key + 1) * sizeof(IxSlot);
+      if (GetHeapBegin() - slots_end < bytes) {
+        Compact();
+      }
+      assert(GetHeapBegin() - slots_end >= bytes);
+      int offset = GetHeapBegin() - bytes;
+      memcpy(page->GetData() + offset, cur + prefix_len, len);
+      memcpy(page->GetData() + offset + len, cur + key_size, payload_len);
+      page_hdr->heap_size += bytes;
+      page_hdr->key_bytes += bytes;
+      memmove(slots + pos + i + 1, slots + pos + i, (page_hdr->num_key - pos - i) * sizeof(IxSlot));
+      slots[pos + i] = IxSlot{rid[i], static_cast<uint16_t>(offset), static_cast<uint16_t>(len)};
+      page_hdr->num_key++;
+    }
+    return;
+  }
+
+  // 2. Shift existing keys and RIDs to make space for new pairs
   int num_keys_to_move = page_hdr->num_key - pos;
   if (num_keys_to_move > 0) {
     memmove(keys + (pos + n) * key_size, keys + pos * key_size, num_keys_to_move * key_size);
@@ -191,7 +261,7 @@ int IxNodeHandle::Insert(const char *key, const RID &value) {
   int pos = LowerBound(key);
 
   // 2. Check for duplicate keys
-  if (pos < page_hdr->num_key && IxCompare(GetKey(pos), key, file_hdr->col_types_, file_hdr->col_lens_) == 0) {
+  if (pos < page_hdr->num_key && CompareKey(pos, key) == 0) {
     // Key already Exists, do not Insert
     return page_hdr->num_key;
   }
@@ -223,6 +293,16 @@ void IxNodeHandle::ErasePair(int pos) {
   int key_size = file_hdr->col_tot_len_;
   int num_keys_to_move = page_hdr->num_key - pos - 1;
 
+  if (file_hdr->slotted_) {
+    // slotted: only the slot is removed, the hole it leaves in the heap is reclaimed by Compact
+    page_hdr->key_bytes -= slots[pos].len + GetPayloadLen();
+    memmove(slots + pos, slots + pos + 1, num_keys_to_move * sizeof(IxSlot));
+    if (--page_hdr->num_key == 0) {
+      page_hdr->heap_size = 0;
+    }
+    return;
+  }
+
   // Shift keys and rids to Remove the key-value pair at position pos
   if (num_keys_to_move > 0) {
     memmove(keys + pos * key_size, keys + (pos + 1) * key_size, num_keys_to_move * key_size);
@@ -251,7 +331,7 @@ int IxNodeHandle::Remove(const char *key) {
   int pos = LowerBound(key);
 
   // 2. Check if the key Exists at the found position
-  if (pos < page_hdr->num_key && IxCompare(GetKey(pos), key, file_hdr->col_types_, file_hdr->col_lens_) == 0) {
+  if (pos < page_hdr->num_key && CompareKey(pos, key) == 0) {
     // Key Exists, Remove the key-value pair
     ErasePair(pos);
   }
@@ -260,6 +340,259 @@ int IxNodeHandle::Remove(const char *key) {
   return page_hdr->num_key;
 }
 
+/**
+ * @brief 把第key_idx个key解码为完整的key（col_tot_len字节），写入dest
+ * slotted格式中key = 结点的前缀 + 后缀，之后补0
+ */
+void IxNodeHandle::CopyKey(int key_idx, char *dest) const {
+  int key_len = file_hdr->col_tot_len_;
+  if (!file_hdr->slotted_) {
+    memcpy(dest, GetKey(key_idx), key_len);
+    return;
+  }
+  int prefix_len = page_hdr->prefix_len;
+  int len = slots[key_idx].len;
+  memcpy(dest, GetPrefix(), prefix_len);
+  memcpy(dest + prefix_len, GetSuffix(key_idx), len);
+  memset(dest + prefix_len + len, 0, key_len - prefix_len - len);
+}
+
+/**
+ * @brief 把第key_idx个键值对的key和之后的payload写入dest，即InsertPairs中一个key的格式
+ */
+void IxNodeHandle::CopyEntry(int key_idx, char *dest) const {
+  CopyKey(key_idx, dest);
+  if (file_hdr->slotted_) {
+    memcpy(dest + file_hdr->col_tot_len_, GetPayload(key_idx), GetPayloadLen());
+  }
+}
+
+/**
+ * @brief 比较第key_idx个key与完整的key target
+ * @return <0, 0, >0 分别表示第key_idx个key小于、等于、大于target
+ */
+int IxNodeHandle::CompareKey(int key_idx, const char *target) const {
+  if (!file_hdr->slotted_) {
+    return memcmp(GetKey(key_idx), target, file_hdr->col_tot_len_);
+  }
+  int prefix_len = page_hdr->prefix_len;
+  int cmp = memcmp(GetPrefix(), target, prefix_len);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return CompareSuffix(key_idx, target + prefix_len, GetStoredLen(target, prefix_len));
+}
+
+/**
+ * @brief slotted格式中比较第key_idx个key与前缀之后的suffix，两者末尾的0都已去掉
+ * 末尾的0不存放：前len个字节相同时，较短的key较小
+ */
+int IxNodeHandle::CompareSuffix(int key_idx, const char *suffix, int len) const {
+  int key_len = slots[key_idx].len;
+  int cmp = memcmp(GetSuffix(key_idx), suffix, std::min(key_len, len));
+  if (cmp != 0) {
+    return cmp;
+  }
+  return key_len < len ? -1 : (key_len > len ? 1 : 0);
+}
+
+/**
+ * @brief slotted格式的LowerBound/UpperBound：结点中所有的key都有相同的前缀，target只与前缀比较一次，
+ * 二分查找时只比较前缀之后的部分
+ * @param upper false: 第一个>=target的位置；true: 第一个>target的位置
+ * @param begin 从这个位置开始查找
+ */
+int IxNodeHandle::SlottedBound(const char *target, bool upper, int begin) const {
+  int prefix_len = page_hdr->prefix_len;
+  int cmp = memcmp(target, GetPrefix(), prefix_len);
+  if (cmp != 0) {
+    // target is smaller (larger) than every key of the node
+    return cmp < 0 ? begin : std::max(page_hdr->num_key, begin);
+  }
+  const char *suffix = target + prefix_len;
+  int len = GetStoredLen(target, prefix_len);
+  int left = begin;
+  int right = page_hdr->num_key;
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    int c = CompareSuffix(mid, suffix, len);
+    if (upper ? c <= 0 : c < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+/**
+ * @brief 把第key_idx个key改为key，rid和payload不变
+ * @note slotted格式中新的key可能更长，调用者需先用CanReplaceKey确认放得下
+ */
+void IxNodeHandle::SetKey(int key_idx, const char *key) {
+  int key_len = file_hdr->col_tot_len_;
+  if (!file_hdr->slotted_) {
+    memcpy(keys + key_idx * key_len, key, key_len);
+    return;
+  }
+  std::string entry(key_len + GetPayloadLen(), '\0');
+  memcpy(entry.data(), key, key_len);
+  memcpy(entry.data() + key_len, GetPayload(key_idx), GetPayloadLen());
+  RID rid = slots[key_idx].rid;
+  ErasePair(key_idx);
+  InsertPair(key_idx, entry.data(), rid);
+}
+
+/**
+ * @brief 设置空结点的公共前缀为key的前prefix_len个字节，之后插入的key都必须有这个前缀
+ * 前缀由结点的key范围决定（下界与high key的公共前缀），插入时不会改变；定长格式没有前缀
+ */
+void IxNodeHandle::SetPrefix(const char *key, int prefix_len) {
+  assert(page_hdr->num_key == 0);
+  if (!file_hdr->slotted_) {
+    return;
+  }
+  page_hdr->prefix_len = prefix_len;
+  page_hdr->heap_size = 0;
+  page_hdr->key_bytes = 0;
+  memcpy(GetHighKey() - prefix_len, key, prefix_len);
+}
+
+/**
+ * @brief 把结点的公共前缀缩短为prefix_len，结点的key范围变大时调用（合并、重分配），所有key按新的前缀重新存放
+ */
+void IxNodeHandle::ShrinkPrefix(int prefix_len) {
+  if (!file_hdr->slotted_ || prefix_len >= page_hdr->prefix_len) {
+    return;
+  }
+  int n = page_hdr->num_key;
+  int entry_len = file_hdr->col_tot_len_ + GetPayloadLen();
+  std::vector<char> key_buf(n * entry_len);
+  std::vector<RID> rid_buf(n);
+  for (int i = 0; i < n; ++i) {
+    CopyEntry(i, key_buf.data() + i * entry_len);
+    rid_buf[i] = slots[i].rid;
+  }
+  std::string prefix(GetPrefix(), prefix_len);
+  page_hdr->num_key = 0;
+  SetPrefix(prefix.data(), prefix_len);
+  InsertPairs(0, key_buf.data(), rid_buf.data(), n);
+}
+
+/**
+ * @brief 分裂时左结点保留的键值对数量：定长格式为一半；slotted格式为占用空间的一半，两边都至少有一个键值对
+ */
+int IxNodeHandle::GetSplitPoint() const {
+  int n = page_hdr->num_key;
+  if (!file_hdr->slotted_) {
+    return n / 2;
+  }
+  int half = (n * static_cast<int>(sizeof(IxSlot)) + page_hdr->key_bytes) / 2;
+  int bytes = 0;
+  int split = 0;
+  while (split < n - 1 && bytes < half) {
+    bytes += sizeof(IxSlot) + slots[split].len + GetPayloadLen();
+    split++;
+  }
+  return std::max(split, 1);
+}
+
+/**
+ * @brief 与相邻结点other合并后是否仍未满：定长格式为两者的键值对数量之和小于2*min_size；
+ * slotted格式中合并后的前缀为两者前缀的公共前缀，按它计算占用的空间
+ */
+bool IxNodeHandle::CanMerge(IxNodeHandle *other) {
+  if (!file_hdr->slotted_) {
+    return GetSize() + other->GetSize() < 2 * GetMinSize();
+  }
+  int prefix_len = ix_common_prefix(GetPrefix(), other->GetPrefix(), std::min(GetPrefixLen(), other->GetPrefixLen()));
+  int used = prefix_len + (GetSize() + other->GetSize()) * static_cast<int>(sizeof(IxSlot)) +
+             GetKeyBytes(prefix_len) + other->GetKeyBytes(prefix_len);
+  return used + static_cast<int>(sizeof(IxSlot)) + file_hdr->col_tot_len_ - prefix_len + GetPayloadLen() <=
+         GetUsableSize();
+}
+
+/**
+ * @brief 前缀缩短为prefix_len并插入key之后是否仍未满，用于重分配
+ * @note 定长格式重分配时，收到键值对的结点少于min_size个键值对，总能放下
+ */
+bool IxNodeHandle::CanTake(const char *key, int prefix_len) {
+  if (!file_hdr->slotted_) {
+    return true;
+  }
+  int used = prefix_len + (GetSize() + 1) * static_cast<int>(sizeof(IxSlot)) + GetKeyBytes(prefix_len) +
+             GetStoredLen(key, prefix_len) + GetPayloadLen();
+  return used + static_cast<int>(sizeof(IxSlot)) + file_hdr->col_tot_len_ - prefix_len + GetPayloadLen() <=
+         GetUsableSize();
+}
+
+/**
+ * @brief 第key_idx个key改为key之后是否仍未满，用于重分配时修改父结点中的分隔key
+ */
+bool IxNodeHandle::CanReplaceKey(int key_idx, const char *key) {
+  if (!file_hdr->slotted_) {
+    return true;
+  }
+  int used = GetUsedSize() - slots[key_idx].len + GetStoredLen(key, page_hdr->prefix_len);
+  return used + GetMaxEntrySize() <= GetUsableSize();
+}
+
+/**
+ * @brief 把src的第[begin,end)个键值对按顺序追加到结点末尾，slotted格式中按本结点的前缀重新存放
+ */
+void IxNodeHandle::AppendPairs(const IxNodeHandle *src, int begin, int end) {
+  if (!file_hdr->slotted_) {
+    InsertPairs(page_hdr->num_key, src->GetKey(begin), src->GetRid(begin), end - begin);
+    return;
+  }
+  std::string entry(file_hdr->col_tot_len_ + GetPayloadLen(), '\0');
+  for (int i = begin; i < end; ++i) {
+    src->CopyEntry(i, entry.data());
+    InsertPair(page_hdr->num_key, entry.data(), *src->GetRid(i));
+  }
+}
+
+/**
+ * @brief slotted格式中key去掉前prefix_len个字节和末尾的0之后存放的长度
+ */
+int IxNodeHandle::GetStoredLen(const char *key, int prefix_len) const {
+  return std::max(ix_trimmed_len(key, file_hdr->col_tot_len_) - prefix_len, 0);
+}
+
+/**
+ * @brief 结点的前缀缩短为prefix_len（不超过当前的前缀）之后，所有key（连同payload）存放的字节数
+ */
+int IxNodeHandle::GetKeyBytes(int prefix_len) const {
+  assert(prefix_len <= page_hdr->prefix_len);
+  // a key stored with no bytes may still have non-zero bytes in the prefix
+  int prefix_trimmed = ix_trimmed_len(GetPrefix(), page_hdr->prefix_len);
+  int bytes = 0;
+  for (int i = 0; i < page_hdr->num_key; ++i) {
+    int len = slots[i].len > 0 ? page_hdr->prefix_len + slots[i].len : prefix_trimmed;
+    bytes += std::max(len - prefix_len, 0) + GetPayloadLen();
+  }
+  return bytes;
+}
+
+/**
+ * @brief 整理slotted格式中存放key的区域，去掉删除key后留下的空隙
+ */
+void IxNodeHandle::Compact() {
+  char buf[PAGE_SIZE];
+  int size = 0;
+  for (int i = 0; i < page_hdr->num_key; ++i) {
+    memcpy(buf + size, GetSuffix(i), slots[i].len + GetPayloadLen());
+    size += slots[i].len + GetPayloadLen();
+  }
+  int offset = GetHeapEnd() - size;
+  memcpy(page->GetData() + offset, buf, size);
+  for (int i = 0; i < page_hdr->num_key; ++i) {
+    slots[i].offset = offset;
+    offset += slots[i].len + GetPayloadLen();
+  }
+  page_hdr->heap_size = size;
+}
+
 IxIndexHandle::IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, int fd)
     : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), fd_(fd) {
   // init file_hdr_
@@ -272,54 +605,139 @@ IxIndexHandle::IxIndexHandle(DiskManager *disk_manager, BufferPoolManager *buffe
   file_hdr_ = std::make_unique<IxFileHdr>();
   file_hdr_->Deserialize(buf);
 
-  // disk_manager管理的fd对应的文件中，设置从file_hdr_->num_pages开始分配page_no
-  int now_page_no = disk_manager_->GetFd2Pageno(fd);
-  disk_manager_->SetFd2Pageno(fd, now_page_no + 1);
+  // disk_manager管理的fd对应的文件中，从文件末尾开始分配page_no（释放的结点不会缩小文件，num_pages_不是文件的大小）
+  disk_manager_->SetFd2Pageno(fd, disk_manager_->GetFileSize(disk_manager_->GetFileName(fd)) / PAGE_SIZE);
 
   delete[] buf;
 }
 
 /**
- * @brief 用于查找指定键所在的叶子结点
+ * @brief 用于查找指定键所在的叶子结点，沿途按latch crabbing加锁
+ * FIND：从根结点开始逐层加读锁，孩子结点加锁后即释放父结点，最多同时持有两个读锁
+ * INSERT/DELETE先乐观地查找：同FIND，但在仍持有父结点读锁时把叶结点的读锁换成写锁，其间叶结点不会被分裂或合并；
+ * 若叶结点在操作后不会分裂/合并（IsSafe），则只锁住叶结点，否则释放所有锁，悲观地重新查找：
+ * 持有root_latch_的写锁，从根结点开始逐层加写锁，遇到安全结点时释放其所有祖先结点和root_latch_，
+ * 剩下的即为分裂/合并可能修改的路径
+ * 开启B-link时FIND由FindLeafPageBLink完成，同一时刻只持有一个读锁
  * @param key 要查找的目标key值
  * @param operation 查找到目标键值对后要进行的操作类型
- * @param transaction 事务参数，如果不需要则默认传入nullptr
- * @return [leaf node] and [root_is_latched] 返回目标叶子结点以及根结点是否加锁
- * @note need to Unlatch and unpin the leaf node outside!
- *       remember to delete the leaf node outside!
- * 注意：用了FindLeafPage之后一定要unlatch叶结点，否则下次latch该结点会堵塞！
- * @note TOCHECK: find_first, then root_is_latched
+ * @param latched_pages INSERT/DELETE加写锁的页面，按从上到下的顺序，每个页面被pin一次，由ReleaseLatchedPages释放
+ * @return [leaf node] and [root_is_latched] 返回目标叶子结点以及是否仍持有root_latch_的写锁
+ * @note 沿途的结点句柄都在栈上，FIND不分配内存；INSERT/DELETE还会向latched_pages中加入页面
+ * @note FIND返回的叶结点持有读锁，需要在外面RUnlatch；INSERT/DELETE返回的叶结点在latched_pages中
+ *       need to unpin the leaf node outside!
+ * 注意：若latched_pages中只有叶结点且root_is_latched为false，则叶结点是安全的，不能修改其祖先结点
  */
-std::pair<IxNodeHandle *, bool> IxIndexHandle::FindLeafPage(const char *key, Operation operation,
-                                                            Transaction *transaction, bool find_first) {
-  // Todo:
-  // 1. 获取根节点
-  // 2. 从根节点开始不断向下查找目标key
-  // 3. 找到包含该key值的叶子结点停止查找，并返回叶子节点
-  // return std::make_pair(nullptr, false);
-
-  // 1. Fetch the root node
-  IxNodeHandle *current_node = FetchNode(file_hdr_->root_page_);
-  // bool root_is_latched = true;
-
-  // 2. Traverse the tree from root to leaf
-  while (!current_node->IsLeafPage()) {
-    // Get the Next child page id
-    page_id_t child_page_no = current_node->InternalLookup(key);
-
-    // Unpin the current node before moving to the child
-    buffer_pool_manager_->UnpinPage(current_node->GetPageId(), false);
-
-    // free the last node
-    if (current_node != nullptr) delete current_node;
+std::pair<IxNodeHandle, bool> IxIndexHandle::FindLeafPage(const char *key, Operation operation,
+                                                          std::deque<Page *> *latched_pages) {
+  if (operation == Operation::FIND && blink_) {
+    return std::make_pair(FindLeafPageBLink(key), false);
+  }
 
-    // Fetch the child node
-    current_node = FetchNode(child_page_no);
+  // 1. Read latch the root, root_latch_ keeps the root page from changing meanwhile
+  root_latch_.lock_shared();
+  IxNodeHandle node = PinNode(file_hdr_->root_page_);
+  node.page->RLatch();
+  IxNodeHandle parent;
+  bool has_parent = false;  // 是否仍持有父结点的读锁，否则持有root_latch_
+  bool is_safe = true;
+  while (true) {
+    if (node.IsLeafPage() && operation != Operation::FIND) {
+      node.page->RUnlatch();
+      node.page->WLatch();
+      is_safe = node.IsSafe(operation);
+      if (!is_safe) {
+        node.page->WUnlatch();
+      }
+    }
+    // 2. Release the parent once the child is latched
+    if (!has_parent) {
+      root_latch_.unlock_shared();
+    } else {
+      parent.page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(parent.GetPageId(), false);
+    }
+    if (node.IsLeafPage()) {
+      break;
+    }
+    parent = node;
+    has_parent = true;
+    node = PinNode(parent.InternalLookup(key));
+    node.page->RLatch();
+  }
+  if (operation == Operation::FIND) {
+    return std::make_pair(node, false);
+  }
+  if (is_safe) {
+    // the pin is kept by latched_pages, the leaf returned is pinned once more
+    latched_pages->push_back(node.page);
+    return std::make_pair(PinNode(node.GetPageNo()), false);
+  }
+  buffer_pool_manager_->UnpinPage(node.GetPageId(), false);
+
+  // 3. The leaf splits or underflows: write latch from the root down, releasing the ancestors of every safe node
+  root_latch_.lock();
+  bool root_is_latched = true;
+  page_id_t page_no = file_hdr_->root_page_;
+  while (true) {
+    node = PinNode(page_no);
+    node.page->WLatch();
+    if (node.IsSafe(operation)) {
+      ReleaseLatchedPages(latched_pages, false);
+      if (root_is_latched) {
+        root_latch_.unlock();
+        root_is_latched = false;
+      }
+    }
+    // the pin of PinNode is kept by latched_pages
+    latched_pages->push_back(node.page);
+    if (node.IsLeafPage()) {
+      break;
+    }
+    page_no = node.InternalLookup(key);
   }
+  return std::make_pair(PinNode(node.GetPageNo()), root_is_latched);
+}
 
-  // 3. Found the leaf node, return it
-  // return std::make_pair(current_node, root_is_latched);
-  return std::make_pair(current_node, find_first);
+/**
+ * @brief 按B-link树的方式查找指定键所在的叶子结点：读出孩子结点的page_no后即释放父结点，同一时刻只持有一个读锁
+ * 父结点释放后孩子结点可能被分裂，此时key不小于其high key，沿right link向右移动即可找到key所在的结点；
+ * 键值对左移（合并、从右兄弟结点重分配）或结点被删除时smo_epoch_加一，查找期间epoch变化则重新查找。
+ * 写操作在持有父结点和两个兄弟结点的写锁之后才修改epoch，因此epoch不变时，读到的每个结点在读的时候都是正确的
+ * @return 持有读锁的叶子结点，需要在外面RUnlatch并unpin
+ * @note 被删除结点的page_no不会被再次分配，迟到的查找读到的是其删除前的内容，不会访问到其他结点
+ */
+IxNodeHandle IxIndexHandle::FindLeafPageBLink(const char *key) {
+  while (true) {
+    uint64_t epoch = smo_epoch_.load();
+    // An old root still leads to the leaves: it is split with a right link, or removed with its only child
+    page_id_t page_no;
+    {
+      std::shared_lock lock{root_latch_};
+      page_no = file_hdr_->root_page_;
+    }
+    IxNodeHandle node = PinNode(page_no);
+    node.page->RLatch();
+    while (true) {
+      if (node.NeedMoveRight(key)) {
+        page_no = node.GetRightLink();
+      } else if (!node.IsLeafPage()) {
+        page_no = node.InternalLookup(key);
+      } else {
+        break;
+      }
+      node.page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(node.GetPageId(), false);
+      node = PinNode(page_no);
+      node.page->RLatch();
+    }
+    if (smo_epoch_.load() == epoch) {
+      return node;
+    }
+    // Keys may have moved left of the path meanwhile
+    node.page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(node.GetPageId(), false);
+  }
 }
 
 /**
@@ -331,6 +749,23 @@ std::pair<IxNodeHandle *, bool> IxIndexHandle::FindLeafPage(const char *key, Ope
  * @return bool 返回目标键值对是否存在
  */
 bool IxIndexHandle::GetValue(const char *key, std::vector<RID> *result, Transaction *transaction) {
+  RID rid;
+  if (!GetValue(key, &rid, transaction)) {
+    return false;
+  }
+  result->push_back(rid);
+  return true;
+}
+
+/**
+ * @brief 查找指定键对应的rid：索引中的key是唯一的，结果直接写入rid，整个查找不分配内存
+ *
+ * @param key 查找的目标key值
+ * @param[out] rid 目标key对应的rid
+ * @param transaction 事务指针
+ * @return bool 返回目标键值对是否存在
+ */
+bool IxIndexHandle::GetValue(const char *key, RID *rid, [[maybe_unused]] Transaction *transaction) {
   // Todo:
   // 1. 获取目标key值所在的叶子结点
   // 2. 在叶子节点中查找目标key值的位置，并读取key对应的rid
@@ -338,28 +773,21 @@ bool IxIndexHandle::GetValue(const char *key, std::vector<RID> *result, Transact
   // 提示：使用完buffer_pool提供的page之后，记得unpin page；记得处理并发的上锁
   // return false;
 
-  // Lock the root to prevent concurrent modifications
-  std::scoped_lock lock{root_latch_};
-
-  // 1. Find the leaf node containing the target key
-  auto [leaf_node, root_is_latched] = FindLeafPage(key, Operation::FIND, transaction);
-
-  if (leaf_node == nullptr) {
-    return false;
-  }
+  // 1. Find the leaf node containing the target key, read latched
+  auto [leaf_node, root_is_latched] = FindLeafPage(key, Operation::FIND);
 
   // 2. Look up the key in the leaf node
   RID *Rid = nullptr;
-  bool found = leaf_node->LeafLookup(key, &Rid);
+  bool found = leaf_node.LeafLookup(key, &Rid);
 
   if (found) {
-    // 3. Store the found Rid in the result vector
-    result->push_back(*Rid);
+    // 3. Store the found Rid in the result
+    *rid = *Rid;
   }
 
-  // Unpin the leaf node pinned in find_leaf_page
-  buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
-  delete leaf_node;
+  // Unlatch and unpin the leaf node pinned in find_leaf_page
+  leaf_node.page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf_node.GetPageId(), false);
 
   return found;
 }
@@ -367,7 +795,8 @@ bool IxIndexHandle::GetValue(const char *key, std::vector<RID> *result, Transact
 /**
  * @brief  将传入的一个node拆分(Split)成两个结点，在node的右边生成一个新结点new node
  * @param node 需要拆分的结点
- * @return 拆分得到的new_node
+ * @return 拆分得到的new_node，两者之间的分隔key为node的high key，由调用者插入父结点
+ * @note slotted格式按占用的空间平分；叶结点之间的分隔key做后缀截断，取能区分两边的最短的key
  * @note need to unpin the new node outside
  * 注意：本函数执行完毕后，原node和new node都需要在函数外面进行unpin
  * @note TOCHECK: 中文注意和note冲突！！！note才正确(unpin the new node outside)
@@ -383,9 +812,9 @@ IxNodeHandle *IxIndexHandle::Split(IxNodeHandle *node) {
 
   // 1. Create a new node(right sibling)
   IxNodeHandle *new_node = CreateNode();
-  // Determine the Split point (half the number of keys)
+  // Determine the Split point (half the number of keys, or half the bytes of the slotted format)
   int total_keys = node->page_hdr->num_key;
-  int split_point = total_keys / 2;
+  int split_point = node->GetSplitPoint();
   int new_num = total_keys - split_point;
   // Initialize the new node's header
   new_node->page_hdr->next_free_page_no = node->page_hdr->next_free_page_no;  // unused
@@ -393,10 +822,26 @@ IxNodeHandle *IxIndexHandle::Split(IxNodeHandle *node) {
   new_node->SetSize(0);
   new_node->page_hdr->is_leaf = node->page_hdr->is_leaf;
 
+  // The separator of the two halves
+  int key_len = file_hdr_->col_tot_len_;
+  std::string left_key(key_len, '\0');
+  std::string right_key(key_len, '\0');
+  std::string separator(key_len, '\0');
+  node->CopyKey(split_point - 1, left_key.data());
+  node->CopyKey(split_point, right_key.data());
+  MakeSeparator(node->IsLeafPage(), left_key.data(), right_key.data(), separator.data());
+  // The keys of the new node are in [separator, high key of node), they all have the common prefix of the two
+  int prefix_len = node->HasHighKey() ? ix_common_prefix(separator.data(), node->GetHighKey(), key_len) : 0;
+  new_node->SetPrefix(separator.data(), prefix_len);
+
   // Insert the right half of the keys and RIDs into the new node
-  new_node->InsertPairs(0, node->GetKey(split_point), node->GetRid(split_point), new_num);
+  new_node->AppendPairs(node, split_point, total_keys);
   // Update the original node's header
   node->SetSize(split_point);
+  // B-link: the new node takes over the bound of node, node is bounded by the separator
+  new_node->CopyRightBound(node);
+  node->SetRightLink(new_node->GetPageNo());
+  node->SetHighKey(separator.data());
 
   // 2. If the node is a leaf, update the leaf pointers
   if (node->IsLeafPage()) {
@@ -406,8 +851,11 @@ IxNodeHandle *IxIndexHandle::Split(IxNodeHandle *node) {
     // Update the Next leaf node of the new node
     auto next_leaf = new_node->GetNextLeaf();
     if (next_leaf != IX_NO_PAGE) {
+      // the next leaf is not on the latched path, latched from left to right like the scans
       IxNodeHandle *next_leaf_node = FetchNode(next_leaf);
+      next_leaf_node->page->WLatch();
       next_leaf_node->SetPrevLeaf(new_node->GetPageNo());
+      next_leaf_node->page->WUnlatch();
       buffer_pool_manager_->UnpinPage(next_leaf_node->GetPageId(), true);
       delete next_leaf_node;
     }
@@ -424,8 +872,8 @@ IxNodeHandle *IxIndexHandle::Split(IxNodeHandle *node) {
 /**
  * @brief Insert key & value pair into internal page after Split
  * 拆分(Split)后，向上找到old_node的父结点
- * 将new_node的第一个key插入到父结点，其位置在 父结点指向old_node的孩子指针 之后
- * 如果插入后>=maxsize，则必须继续拆分父结点，然后在其父结点的父结点再插入，即需要递归
+ * 将两者的分隔key插入到父结点，其位置在 父结点指向old_node的孩子指针 之后
+ * 如果插入后已满，则必须继续拆分父结点，然后在其父结点的父结点再插入，即需要递归
  * 直到找到的old_node为根结点时，结束递归（此时将会新建一个根R，关键字为key，old_node和new_node为其孩子）
  *
  * @param (old_node, new_node) 原结点为old_node，old_node被分裂之后产生了新的右兄弟结点new_node
@@ -453,11 +901,15 @@ void IxIndexHandle::InsertIntoParent(IxNodeHandle *old_node, const char *key, Ix
     new_root->SetParentPageNo(IX_NO_PAGE);               // New root has no parent
     new_root->SetSize(0);
     new_root->page_hdr->is_leaf = false;
+    new_root->SetRightLink(IX_NO_PAGE);
+    new_root->ClearHighKey();
 
     // Insert (old_node, new_node) into new root
     // Note: InsertPair will update num_key
-    new_root->InsertPair(0, old_node->GetKey(0), {old_node->GetPageNo(), 0});
-    new_root->InsertPair(1, new_node->GetKey(0), {new_node->GetPageNo(), 0});
+    std::string first_key(file_hdr_->col_tot_len_, '\0');
+    old_node->CopyKey(0, first_key.data());
+    new_root->InsertPair(0, first_key.data(), {old_node->GetPageNo(), 0});
+    new_root->InsertPair(1, key, {new_node->GetPageNo(), 0});
 
     // Update old and new nodes to point to new root
     int new_root_page_no = new_root->GetPageNo();
@@ -483,9 +935,9 @@ void IxIndexHandle::InsertIntoParent(IxNodeHandle *old_node, const char *key, Ix
   parent_node->InsertPair(insert_pos, key, new_node_rid);
 
   // 4. Check if the parent node needs to be Split
-  if (parent_node->GetSize() >= parent_node->GetMaxSize()) {
+  if (parent_node->IsFull()) {
     IxNodeHandle *new_sibling = Split(parent_node);
-    char *middle_key = new_sibling->GetKey(0);
+    char *middle_key = parent_node->GetHighKey();
     InsertIntoParent(parent_node, middle_key, new_sibling, transaction);
     // unpin for Split: TOCHECK
     buffer_pool_manager_->UnpinPage(new_sibling->GetPageId(), true);
@@ -499,7 +951,7 @@ void IxIndexHandle::InsertIntoParent(IxNodeHandle *old_node, const char *key, Ix
 
 /**
  * @brief 将指定键值对插入到B+树中
- * @param (key, value) 要插入的键值对
+ * @param (key, value) 要插入的键值对，有INCLUDE列时key之后紧跟payload，payload存放在叶结点中
  * @param transaction 事务指针
  * @return page_id_t 插入到的叶结点的page_no
  * @note 若插入成功，则返回插入到的叶结点的page_no；若插入失败(重复的key)，则返回-1
@@ -512,14 +964,12 @@ page_id_t IxIndexHandle::InsertEntry(const char *key, const RID &value, Transact
   // 提示：记得unpin page；若当前叶子节点是最右叶子节点，则需要更新file_hdr_.last_leaf；记得处理并发的上锁
   // return -1;
 
-  std::scoped_lock lock{root_latch_};
-
-  // 1. Find the leaf node where the key should be inserted
-  auto [leaf_node, root_is_latched] = FindLeafPage(key, Operation::INSERT, transaction);
+  std::deque<Page *> local_pages;
+  auto latched_pages = GetLatchedPages(transaction, &local_pages);
 
-  if (leaf_node == nullptr) {
-    throw InternalError("IxIndexHandle::insert_entry Error: Leaf node not found");
-  }
+  // 1. Find the leaf node where the key should be inserted, only the leaf is write latched if it does not split
+  auto [leaf, root_is_latched] = FindLeafPage(key, Operation::INSERT, latched_pages);
+  IxNodeHandle *leaf_node = &leaf;
 
   // 2. Insert the key-value pair into the leaf node
   int old_size = leaf_node->GetSize();
@@ -527,12 +977,15 @@ page_id_t IxIndexHandle::InsertEntry(const char *key, const RID &value, Transact
   if (new_size == old_size) {
     // Key already Exists, return -1
     buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
-    delete leaf_node;
+    ReleaseLatchedPages(latched_pages, false);
+    if (root_is_latched) {
+      root_latch_.unlock();
+    }
     return -1;
   }
 
   // 3. Check if the leaf node needs to be Split
-  if (new_size >= leaf_node->GetMaxSize()) {
+  if (leaf_node->IsFull()) {
     // Split the leaf node
     IxNodeHandle *new_sibling = Split(leaf_node);
 
@@ -541,8 +994,8 @@ page_id_t IxIndexHandle::InsertEntry(const char *key, const RID &value, Transact
       file_hdr_->last_leaf_ = new_sibling->GetPageNo();
     }
 
-    // Get the first key of the new sibling
-    char *middle_key = new_sibling->GetKey(0);
+    // Get the separator of the two leaves
+    char *middle_key = leaf_node->GetHighKey();
 
     // Insert the middle key into the parent node
     InsertIntoParent(leaf_node, middle_key, new_sibling, transaction);
@@ -554,14 +1007,274 @@ page_id_t IxIndexHandle::InsertEntry(const char *key, const RID &value, Transact
 
   auto page_no = leaf_node->GetPageNo();
 
-  // Unpin leaf node that was pinned in 'find_leaf_page'
+  // Unpin leaf node that was pinned in 'find_leaf_page', then release the latched path
   buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), true);
 
-  delete leaf_node;
+  ReleaseLatchedPages(latched_pages, true);
+  if (root_is_latched) {
+    root_latch_.unlock();
+  }
 
   return page_no;
 }
 
+/**
+ * @brief 将一批键值对插入到B+树中
+ * 先按key排序；若B+树为空，则自底向上构建：叶结点按顺序写满fill_factor后链接起来，再逐层构建内部结点，
+ * 否则按key的顺序逐个InsertEntry
+ * @param entries 要插入的键值对，会被排序
+ * @param transaction 事务指针
+ * @param fill_factor 每个结点的填充率
+ * @return bool 是否插入成功
+ * @note 若entries中有重复的key，或B+树非空且与已有key重复，则不插入任何键值对并返回false：
+ *       重复之前已插入的键值对会被删除
+ */
+bool IxIndexHandle::BulkLoad(std::vector<IxEntry> *entries, Transaction *transaction, double fill_factor) {
+  auto less = [this](const IxEntry &lhs, const IxEntry &rhs) {
+    return memcmp(lhs.first.data(), rhs.first.data(), file_hdr_->col_tot_len_) < 0;
+  };
+  std::sort(entries->begin(), entries->end(), less);
+  if (std::adjacent_find(entries->begin(), entries->end(), [&less](const IxEntry &lhs, const IxEntry &rhs) {
+        return !less(lhs, rhs);
+      }) != entries->end()) {
+    return false;
+  }
+  if (entries->empty()) {
+    return true;
+  }
+
+  {
+    std::unique_lock lock{root_latch_};
+    IxNodeHandle *root = GetRoot();
+    bool is_empty = root->IsLeafPage() && root->GetSize() == 0;
+    buffer_pool_manager_->UnpinPage(root->GetPageId(), false);
+    delete root;
+    if (is_empty) {
+      BuildBottomUp(*entries, fill_factor);
+      return true;
+    }
+  }
+
+  // Sorted inserts always go to the rightmost leaves that were just visited, which stay in the buffer pool
+  for (size_t i = 0; i < entries->size(); ++i) {
+    if (InsertEntry((*entries)[i].first.data(), (*entries)[i].second, transaction) == IX_NO_PAGE) {
+      for (size_t j = 0; j < i; ++j) {
+        DeleteEntry((*entries)[j].first.data(), transaction);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 由有序且不重复的键值对自底向上构建空的B+树
+ * 每一层的键值对按SplitLevel划分到结点中；原来的根结点（空的叶结点）作为第一个叶结点，
+ * 其余结点按顺序新建，因此叶结点在文件中是连续的；
+ * 每一层的结点以right link相连，high key为右边结点的下界：叶结点之间为截断后的分隔key，内部结点为其第一个key
+ * @note 调用者需持有root_latch_的写锁；原来的根结点和leaf header在修改时加写锁，新建的结点在构建完之前不可见
+ */
+void IxIndexHandle::BuildBottomUp(const std::vector<IxEntry> &entries, double fill_factor) {
+  int key_len = file_hdr_->col_tot_len_;
+  // 这一层的key，以及从每个键值对开始的结点的下界
+  int num_entries = static_cast<int>(entries.size());
+  std::vector<const char *> keys(num_entries);
+  std::vector<std::string> lows(num_entries, std::string(key_len, '\0'));
+  for (int j = 0; j < num_entries; ++j) {
+    keys[j] = entries[j].first.data();
+    if (j == 0) {
+      memcpy(lows[j].data(), keys[j], key_len);
+    } else {
+      MakeSeparator(true, keys[j - 1], keys[j], lows[j].data());
+    }
+  }
+  // 每个结点的下界和page_no，即上一层结点的键值对
+  std::vector<std::string> parent_lows;
+  std::vector<page_id_t> children;
+
+  // 1. Write the leaves in key order and link them, the leaf header is before the first and after the last leaf
+  std::vector<int> bounds = SplitLevel(keys, lows, fill_factor, file_hdr_->include_len_);
+  int num_nodes = static_cast<int>(bounds.size()) - 1;
+  IxNodeHandle *prev = nullptr;
+  for (int i = 0; i < num_nodes; ++i) {
+    IxNodeHandle *leaf = i == 0 ? GetRoot() : CreateNode();
+    if (i == 0) {
+      leaf->page->WLatch();
+    }
+    int begin = bounds[i];
+    int end = bounds[i + 1];
+    leaf->page_hdr->next_free_page_no = IX_NO_PAGE;
+    leaf->page_hdr->is_leaf = true;
+    leaf->SetParentPageNo(IX_NO_PAGE);
+    leaf->SetSize(0);
+    leaf->SetPrefix(lows[begin].data(), NodePrefixLen(lows, begin, end));
+    for (int j = begin; j < end; ++j) {
+      leaf->InsertPair(j - begin, keys[j], entries[j].second);
+    }
+    leaf->SetPrevLeaf(prev == nullptr ? IX_LEAF_HEADER_PAGE : prev->GetPageNo());
+    leaf->SetRightLink(IX_NO_PAGE);
+    leaf->ClearHighKey();
+    if (prev != nullptr) {
+      prev->SetNextLeaf(leaf->GetPageNo());
+      prev->SetRightLink(leaf->GetPageNo());
+      prev->SetHighKey(lows[begin].data());
+      if (i == 1) {
+        prev->page->WUnlatch();
+      }
+      buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+      delete prev;
+    }
+    parent_lows.push_back(lows[begin]);
+    children.push_back(leaf->GetPageNo());
+    prev = leaf;
+  }
+  prev->SetNextLeaf(IX_LEAF_HEADER_PAGE);
+  if (num_nodes == 1) {
+    prev->page->WUnlatch();
+  }
+  buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+  delete prev;
+
+  IxNodeHandle *leaf_header = FetchNode(IX_LEAF_HEADER_PAGE);
+  leaf_header->page->WLatch();
+  leaf_header->SetNextLeaf(children.front());
+  leaf_header->SetPrevLeaf(children.back());
+  leaf_header->page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf_header->GetPageId(), true);
+  delete leaf_header;
+  file_hdr_->first_leaf_ = children.front();
+  file_hdr_->last_leaf_ = children.back();
+
+  // 2. Build the internal levels from the lower bounds of the level below, until a single root is left
+  while (children.size() > 1) {
+    lows = std::move(parent_lows);
+    std::vector<page_id_t> level = std::move(children);
+    parent_lows.clear();
+    children.clear();
+    keys.resize(lows.size());
+    for (size_t j = 0; j < lows.size(); ++j) {
+      keys[j] = lows[j].data();
+    }
+    bounds = SplitLevel(keys, lows, fill_factor, 0);
+    num_nodes = static_cast<int>(bounds.size()) - 1;
+    prev = nullptr;
+    for (int i = 0; i < num_nodes; ++i) {
+      IxNodeHandle *node = CreateNode();
+      int begin = bounds[i];
+      int end = bounds[i + 1];
+      node->page_hdr->next_free_page_no = IX_NO_PAGE;
+      node->page_hdr->is_leaf = false;
+      node->page_hdr->prev_leaf = IX_NO_PAGE;
+      node->page_hdr->next_leaf = IX_NO_PAGE;
+      node->SetParentPageNo(IX_NO_PAGE);
+      node->SetPrefix(lows[begin].data(), NodePrefixLen(lows, begin, end));
+      for (int j = begin; j < end; ++j) {
+        node->InsertPair(j - begin, keys[j], {level[j], 0});
+      }
+      node->SetRightLink(IX_NO_PAGE);
+      node->ClearHighKey();
+      for (int j = 0; j < end - begin; ++j) {
+        MaintainChild(node, j);
+      }
+      if (prev != nullptr) {
+        prev->SetRightLink(node->GetPageNo());
+        prev->SetHighKey(lows[begin].data());
+        buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+        delete prev;
+      }
+      parent_lows.push_back(lows[begin]);
+      children.push_back(node->GetPageNo());
+      prev = node;
+    }
+    buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+    delete prev;
+  }
+  UpdateRootPageNo(children.front());
+}
+
+/**
+ * @brief 自底向上构建时把一层的键值对划分到结点中
+ * 定长格式：每个结点最多btree_order * fill_factor个，结点个数为ceil(n / 容量)，平均分配；
+ * slotted格式：按顺序放入结点，直到按结点的前缀压缩后占用的空间超过可用空间的fill_factor，且结点保持未满
+ * @param keys 这一层的key，按顺序
+ * @param lows lows[i]为从第i个键值对开始的结点的下界
+ * @param payload_len 每个key之后的payload的长度，只有叶结点有
+ * @return 每个结点的第一个键值对的下标，最后为键值对的数量
+ */
+std::vector<int> IxIndexHandle::SplitLevel(const std::vector<const char *> &keys, const std::vector<std::string> &lows,
+                                           double fill_factor, int payload_len) const {
+  int n = static_cast<int>(keys.size());
+  std::vector<int> bounds{0};
+  if (!file_hdr_->slotted_) {
+    int capacity = std::clamp(static_cast<int>(file_hdr_->btree_order_ * fill_factor), 2, file_hdr_->btree_order_);
+    int num_nodes = (n + capacity - 1) / capacity;
+    for (int i = 1; i <= num_nodes; ++i) {
+      bounds.push_back(static_cast<int>(static_cast<int64_t>(n) * i / num_nodes));
+    }
+    return bounds;
+  }
+  int key_len = file_hdr_->col_tot_len_;
+  int slot_size = static_cast<int>(sizeof(IxSlot));
+  int usable = PAGE_SIZE - static_cast<int>(sizeof(IxPageHdr)) - key_len;
+  int budget = static_cast<int>(usable * fill_factor);
+  std::vector<int> trimmed(n);
+  for (int j = 0; j < n; ++j) {
+    trimmed[j] = ix_trimmed_len(keys[j], key_len);
+  }
+  for (int begin = 0; begin < n;) {
+    // the bytes of the keys in [begin, end) stored after the prefix of the node
+    int end = begin + 1;
+    int prefix_len = NodePrefixLen(lows, begin, end);
+    int key_bytes = std::max(trimmed[begin] - prefix_len, 0) + payload_len;
+    while (end < n) {
+      // the prefix gets shorter as the range of the node grows
+      int next_prefix = NodePrefixLen(lows, begin, end + 1);
+      int next_bytes = key_bytes;
+      if (next_prefix != prefix_len) {
+        next_bytes = 0;
+        for (int j = begin; j < end; ++j) {
+          next_bytes += std::max(trimmed[j] - next_prefix, 0) + payload_len;
+        }
+      }
+      next_bytes += std::max(trimmed[end] - next_prefix, 0) + payload_len;
+      int used = next_prefix + (end + 1 - begin) * slot_size + next_bytes;
+      if (used > budget || used + slot_size + key_len - next_prefix + payload_len > usable) {
+        break;
+      }
+      prefix_len = next_prefix;
+      key_bytes = next_bytes;
+      end++;
+    }
+    bounds.push_back(end);
+    begin = end;
+  }
+  return bounds;
+}
+
+/**
+ * @brief 自底向上构建时由第[begin,end)个键值对组成的结点的前缀长度：下界与high key（下一个结点的下界）的公共前缀，
+ * 每一层最左和最右的结点没有前缀
+ */
+int IxIndexHandle::NodePrefixLen(const std::vector<std::string> &lows, int begin, int end) const {
+  if (!file_hdr_->slotted_ || begin == 0 || end == static_cast<int>(lows.size())) {
+    return 0;
+  }
+  return ix_common_prefix(lows[begin].data(), lows[end].data(), file_hdr_->col_tot_len_);
+}
+
+/**
+ * @brief 求相邻的left_key与right_key之间的分隔key，写入sep
+ * slotted格式的叶结点之间做后缀截断：取>left_key且<=right_key的最短的key；
+ * 内部结点的key是孩子结点的下界，不截断，为right_key
+ */
+void IxIndexHandle::MakeSeparator(bool is_leaf, const char *left_key, const char *right_key, char *sep) const {
+  if (file_hdr_->slotted_ && is_leaf) {
+    ix_separator(left_key, right_key, file_hdr_->col_tot_len_, sep);
+  } else {
+    memcpy(sep, right_key, file_hdr_->col_tot_len_);
+  }
+}
+
 /**
  * @brief 用于删除B+树中含有指定key的键值对
  * @param key 要删除的key值
@@ -578,37 +1291,41 @@ bool IxIndexHandle::DeleteEntry(const char *key, Transaction *transaction) {
   // 4. 如果需要并发，并且需要删除叶子结点，则需要在事务的delete_page_set中添加删除结点的对应页面；记得处理并发的上锁
   // return false;
 
-  std::scoped_lock lock{root_latch_};
+  std::deque<Page *> local_pages;
+  auto latched_pages = GetLatchedPages(transaction, &local_pages);
 
-  // 1. Find the leaf node where the key should be deleted
-  auto [leaf_node, root_is_latched] = FindLeafPage(key, Operation::DELETE, transaction);
-  auto leaf_pageId = leaf_node->GetPageId();
-
-  if (leaf_node == nullptr) {
-    // return false;
-    throw InternalError("IxIndexHandle::delete_entry Error: Leaf node not found");
-  }
+  // 1. Find the leaf node where the key should be deleted, only the leaf is write latched if it does not underflow
+  auto [leaf, root_is_latched] = FindLeafPage(key, Operation::DELETE, latched_pages);
+  auto leaf_pageId = leaf.GetPageId();
 
   // 2. Delete the key-value pair from the leaf node
-  int old_size = leaf_node->GetSize();
-  int new_size = leaf_node->Remove(key);
+  int old_size = leaf.GetSize();
+  int new_size = leaf.Remove(key);
   if (new_size == old_size) {
     // Key does not exist, return false
     buffer_pool_manager_->UnpinPage(leaf_pageId, false);
-    delete leaf_node;
+    ReleaseLatchedPages(latched_pages, false);
+    if (root_is_latched) {
+      root_latch_.unlock();
+    }
     return false;
   }
 
-  // 3. Coalesce or Redistribute the nodes if necessary
+  // 3. Coalesce or Redistribute the nodes if necessary, a safe leaf is the only node latched and keeps enough keys
   // Memory leak prevention: We rely on CoalesceOrRedistribute to unpin and delete the node if return false
-  bool should_delete_node = CoalesceOrRedistribute(leaf_node, transaction, &root_is_latched);
+  bool should_delete_node = false;
+  IxNodeHandle *leaf_node = nullptr;
+  if (latched_pages->size() == 1 && !root_is_latched) {
+    buffer_pool_manager_->UnpinPage(leaf_pageId, true);
+  } else {
+    // only a delete that may merge or redistribute allocates the handle that CoalesceOrRedistribute takes over
+    leaf_node = new IxNodeHandle(leaf);
+    should_delete_node = CoalesceOrRedistribute(leaf_node, transaction, &root_is_latched);
+  }
 
   // TODO: 4. Handle concurrent deletion and node removal if necessary
   if (should_delete_node) {
-    // Update the first_leaf pointer in the file header if necessary
-    if (leaf_pageId.page_no == file_hdr_->first_leaf_) {
-      file_hdr_->first_leaf_ = leaf_node->GetNextLeaf();
-    }
+    // Coalesce() always removes the right node, so the first leaf stays
     ReleaseNodeHandle(*leaf_node);
 
     // Unpin the leaf node handle
@@ -616,6 +1333,10 @@ bool IxIndexHandle::DeleteEntry(const char *key, Transaction *transaction) {
     delete leaf_node;
   }
 
+  ReleaseLatchedPages(latched_pages, true);
+  if (root_is_latched) {
+    root_latch_.unlock();
+  }
   return true;
 }
 
@@ -627,8 +1348,8 @@ bool IxIndexHandle::DeleteEntry(const char *key, Transaction *transaction) {
  * @param root_is_latched 传出参数：根节点是否上锁，用于并发操作
  * @return 是否需要删除结点
  * @note User needs to first find the sibling of input page.
- * If sibling's size + input page's size >= 2 * page's minsize, then Redistribute.
- * Otherwise, merge(Coalesce).
+ * If the two pages fit in one page (CanMerge), merge(Coalesce). Otherwise, Redistribute.
+ * slotted格式中重分配的键值对可能放不下（key变长，或前缀变短），此时node保持过空
  * @note Memory leak prevention: This function will unpin and delete the node if return false
  * @note TOOPT: 1.2 如果传入del的位置(0 or size-1)，可以避免不必要的matain_parent操作
  */
@@ -650,8 +1371,9 @@ bool IxIndexHandle::CoalesceOrRedistribute(IxNodeHandle *node, Transaction *tran
     return AdjustRoot(node);
   }
   // 1.2 If the node is not the root and does not need coalescing or redistribution, return false
-  if (node->GetSize() >= node->GetMinSize()) {
-    MaintainParent(node);
+  // Such a node was safe in FindLeafPage, so its parent is not latched and the key of the node in the parent is
+  // left as it is: it was the smallest key of the node when set, still a lower bound after deletes, lookups stay right
+  if (!node->IsUnderflow()) {
     // Memory leak prevention: unpin and delete the node
     buffer_pool_manager_->UnpinPage(node->GetPageId(), true);
     delete node;
@@ -666,18 +1388,22 @@ bool IxIndexHandle::CoalesceOrRedistribute(IxNodeHandle *node, Transaction *tran
   // 3. Find the sibling node (prefer the predecessor node)
   int node_index = parent_node->FindChild(node);
   int sibling_index = (node_index == 0) ? 1 : node_index - 1;
+  // The sibling is not on the latched path, the latch of the parent keeps other writers from reaching it
   IxNodeHandle *sibling_node = FetchNode(parent_node->ValueAt(sibling_index));
+  sibling_node->page->WLatch();
   auto sibling_pageId = sibling_node->GetPageId();
 
   bool delete_node;
   // 4. Check if redistribution is possible
-  if (node->GetSize() + sibling_node->GetSize() >= 2 * node->GetMinSize()) {
+  if (!node->CanMerge(sibling_node)) {
     delete_node = false;
+    // the node is left underfull if the pair does not fit
     Redistribute(sibling_node, node, parent_node, node_index);
 
     // Unpin the parent and sibling nodes that were pinned in 'FetchNode'
     buffer_pool_manager_->UnpinPage(parent_pageId, true);
     delete parent_node;
+    sibling_node->page->WUnlatch();
     buffer_pool_manager_->UnpinPage(sibling_pageId, true);
     delete sibling_node;
 
@@ -703,7 +1429,7 @@ bool IxIndexHandle::CoalesceOrRedistribute(IxNodeHandle *node, Transaction *tran
     }
 
     // Memory leak prevention:
-    // Note that Coalesce() will unpin and delete the sibling node no matter what return value is.
+    // Note that Coalesce() will unlatch, unpin and delete the sibling node no matter what return value is.
     // If it return false, it will also unpin and delete the parent_node
   }
 
@@ -728,6 +1454,7 @@ bool IxIndexHandle::AdjustRoot(IxNodeHandle *old_root_node) {
   if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
     page_id_t new_root_page_no = old_root_node->ValueAt(0);
     IxNodeHandle *new_root_node = FetchNode(new_root_page_no);
+    smo_epoch_++;
     new_root_node->SetParentPageNo(IX_NO_PAGE);
 
     // Update the file header to point to the new root
@@ -740,15 +1467,10 @@ bool IxIndexHandle::AdjustRoot(IxNodeHandle *old_root_node) {
     return true;
   }
 
-  // 2. If the old root node is a leaf node and its size is 0,
-  //    update the root page to reflect the removal
-  if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
-    file_hdr_->root_page_ = IX_NO_PAGE;
-
-    return true;
-  }
-
+  // 2. If the old root node is a leaf node and its size is 0, it is kept as the empty root, as a new index has,
+  //    so that the later operations still find a root
   // 3. For other cases, no adjustments are needed
+  buffer_pool_manager_->UnpinPage(old_root_node->GetPageId(), true);
   delete old_root_node;
   return false;
 }
@@ -766,57 +1488,84 @@ bool IxIndexHandle::AdjustRoot(IxNodeHandle *old_root_node) {
  * index=0，则neighbor是node后继结点，表示：node(left)      neighbor(right)
  * index>0，则neighbor是node前驱结点，表示：neighbor(left)  node(right)
  * 注意更新parent结点的相关kv对
+ * @return 是否移动了键值对：slotted格式中node缩短前缀后放不下移动的键值对，或parent放不下新的分隔key时不移动
+ * @note 叶结点之间新的分隔key同Split做后缀截断，node的前缀缩短为原前缀与新的分隔key的公共前缀
  */
-void IxIndexHandle::Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index) {
+bool IxIndexHandle::Redistribute(IxNodeHandle *neighbor_node, IxNodeHandle *node, IxNodeHandle *parent, int index) {
   // Todo:
   // 1. 通过index判断neighbor_node是否为node的前驱结点
   // 2. 从neighbor_node中移动一个键值对到node结点中
   // 3. 更新父节点中的相关信息，并且修改移动键值对对应孩字结点的父结点信息（maintain_child函数）
   // 注意：neighbor_node的位置不同，需要移动的键值对不同，需要分类讨论
 
+  // the neighbor keeps at least one pair
+  if (neighbor_node->GetSize() < 2) {
+    return false;
+  }
+  // the pair that moves keeps its payload
+  int key_len = file_hdr_->col_tot_len_;
+  std::string left_key(key_len + node->GetPayloadLen(), '\0');
+  std::string right_key(key_len + node->GetPayloadLen(), '\0');
+  std::string separator(key_len, '\0');
+
   // neighbor_node -> node
   if (index > 0) {
     // neighbor_node is the predecessor
     // Move the last key-value pair from neighbor_node to the front of node
     int neighbor_last_index = neighbor_node->GetSize() - 1;
+    neighbor_node->CopyKey(neighbor_last_index - 1, left_key.data());
+    neighbor_node->CopyEntry(neighbor_last_index, right_key.data());
+    MakeSeparator(node->IsLeafPage(), left_key.data(), right_key.data(), separator.data());
+    // node is bounded below by the separator now
+    int prefix_len = ix_common_prefix(node->GetPrefix(), separator.data(), node->GetPrefixLen());
+    if (!node->CanTake(right_key.data(), prefix_len) || !parent->CanReplaceKey(index, separator.data())) {
+      return false;
+    }
 
     // Insert the last key-value pair from neighbor_node to the front of node
-    node->InsertPairs(0, neighbor_node->GetKey(neighbor_last_index), neighbor_node->GetRid(neighbor_last_index), 1);
+    node->ShrinkPrefix(prefix_len);
+    node->InsertPair(0, right_key.data(), *neighbor_node->GetRid(neighbor_last_index));
 
     // Remove the last key-value pair from neighbor_node
     neighbor_node->ErasePair(neighbor_last_index);
 
-    // Update the key in the parent node
-    MaintainParent(node);
-    // // This below line is not enough because of cascading updates
-    // char *parent_key = node->GetKey(0);
-    // parent->SetKey(index, parent_key);
+    // Update the key in the parent node, the only latched ancestor that holds the key of node
+    parent->SetKey(index, separator.data());
+    // The moved key is right of the neighbor now, searches that read the parent before move right to node
+    neighbor_node->SetHighKey(separator.data());
 
     // Update the parent pointer of the affected child node
     MaintainChild(node, 0);
   } else {
     // neighbor_node is the successor(node -> neighbor_node)
     // Move the first key-value pair from neighbor_node to the end of node
-    char *neighbor_first_key = neighbor_node->GetKey(0);
+    neighbor_node->CopyEntry(0, left_key.data());
+    neighbor_node->CopyKey(1, right_key.data());
+    MakeSeparator(node->IsLeafPage(), left_key.data(), right_key.data(), separator.data());
+    // node is bounded above by the separator now
+    int prefix_len = ix_common_prefix(node->GetPrefix(), separator.data(), node->GetPrefixLen());
+    if (!node->CanTake(left_key.data(), prefix_len) || !parent->CanReplaceKey(1, separator.data())) {
+      return false;
+    }
+    // The key moves left, B-link searches that read the parent before cannot move left to find it
+    smo_epoch_++;
     RID neighbor_first_rid = *neighbor_node->GetRid(0);
 
     // Insert the first key-value pair from neighbor_node to the end of node
-    node->InsertPairs(node->GetSize(), neighbor_first_key, &neighbor_first_rid, 1);
+    node->ShrinkPrefix(prefix_len);
+    node->InsertPair(node->GetSize(), left_key.data(), neighbor_first_rid);
 
     // Remove the first key-value pair from neighbor_node
     neighbor_node->ErasePair(0);
 
-    // Update the key in the parent node
-    MaintainParent(neighbor_node);
-    // // This below line is not enough because of cascading updates
-    // char *parent_key = neighbor_node->GetKey(0);
-    // auto neighbor_parent = FetchNode(neighbor_node->GetParentPageNo());
-    // neighbor_parent->SetKey(neighbor_parent->FindChild(neighbor_node), parent_key);
-    // buffer_pool_manager_->UnpinPage(neighbor_parent->GetPageId(), true);
+    // Update the key in the parent node, neighbor_node is the second child of the parent
+    parent->SetKey(1, separator.data());
+    node->SetHighKey(separator.data());
 
     // Update the parent pointer of the affected child node
     MaintainChild(node, node->GetSize() - 1);
   }
+  return true;
 }
 
 /**
@@ -852,9 +1601,16 @@ bool IxIndexHandle::Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
   }
 
   // 2. Move key-value pairs from node to neighbor_node
+  // The keys move left and node is removed, B-link searches that read the parent before search again
+  smo_epoch_++;
+  // The merged node holds the keys of both, they have the common prefix of the two prefixes
+  int prefix_len = ix_common_prefix((*neighbor_node)->GetPrefix(), (*node)->GetPrefix(),
+                                    std::min((*neighbor_node)->GetPrefixLen(), (*node)->GetPrefixLen()));
+  (*neighbor_node)->ShrinkPrefix(prefix_len);
   int start_pos = (*neighbor_node)->GetSize();
   int num_to_move = (*node)->GetSize();
-  (*neighbor_node)->InsertPairs(start_pos, (*node)->GetKey(0), (*node)->GetRid(0), num_to_move);
+  (*neighbor_node)->AppendPairs(*node, 0, num_to_move);
+  (*neighbor_node)->CopyRightBound(*node);
 
   // If internal node, update children's parent pointers
   if (!(*node)->IsLeafPage()) {
@@ -874,14 +1630,11 @@ bool IxIndexHandle::Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
   // 3. Remove node and update parent
   // ReleaseNodeHandle(**node); // No need because this function let caller to update the file header!
   (*parent)->ErasePair(index);
-  // Memory leak prevention: delete neigbor_node
-  if (!swap) {
-    buffer_pool_manager_->UnpinPage((*neighbor_node)->GetPageId(), true);
-    delete *neighbor_node;
-  } else {
-    buffer_pool_manager_->UnpinPage((*node)->GetPageId(), true);
-    delete *node;
-  }
+  // Memory leak prevention: unlatch and delete the sibling, which is neigbor_node unless they were swapped
+  IxNodeHandle *sibling = swap ? *node : *neighbor_node;
+  sibling->page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling->GetPageId(), true);
+  delete sibling;
 
   // Check if the parent node needs to be deleted
   // Memory leak prevention: belowing function will unpin and delete the parent if return false
@@ -898,14 +1651,39 @@ bool IxIndexHandle::Coalesce(IxNodeHandle **neighbor_node, IxNodeHandle **node,
  * @note iid和rid存的不是一个东西，rid是上层传过来的记录位置，iid是索引内部生成的索引槽位置
  */
 RID IxIndexHandle::GetRid(const Iid &iid) const {
-  IxNodeHandle *node = FetchNode(iid.page_id_);
-  if (iid.slot_num_ >= static_cast<slot_id_t>(node->GetSize())) {
+  IxNodeHandle node = PinNode(iid.page_id_);
+  node.page->RLatch();
+  if (iid.slot_num_ >= static_cast<slot_id_t>(node.GetSize())) {
+    node.page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(node.GetPageId(), false);
     throw IndexEntryNotFoundError();
   }
-  auto rid = *node->GetRid(iid.slot_num_);
+  auto rid = *node.GetRid(iid.slot_num_);
+  node.page->RUnlatch();
+
+  buffer_pool_manager_->UnpinPage(node.GetPageId(), false);  // unpin it!
+  return rid;
+}
 
-  buffer_pool_manager_->UnpinPage(node->GetPageId(), false);  // unpin it!
-  delete node;
+/**
+ * @brief 把iid处的key（完整的col_tot_len字节）和之后的INCLUDE列写入entry，用于只读索引的扫描
+ *
+ * @param iid
+ * @param[out] entry 长度为col_tot_len + include_len
+ * @return Rid
+ */
+RID IxIndexHandle::GetEntry(const Iid &iid, char *entry) const {
+  IxNodeHandle node = PinNode(iid.page_id_);
+  node.page->RLatch();
+  if (iid.slot_num_ >= static_cast<slot_id_t>(node.GetSize())) {
+    node.page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(node.GetPageId(), false);
+    throw IndexEntryNotFoundError();
+  }
+  node.CopyEntry(iid.slot_num_, entry);
+  auto rid = *node.GetRid(iid.slot_num_);
+  node.page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(node.GetPageId(), false);
   return rid;
 }
 
@@ -920,15 +1698,9 @@ RID IxIndexHandle::GetRid(const Iid &iid) const {
 Iid IxIndexHandle::LowerBound(const char *key) {
   // return Iid{-1, -1};
 
-  // std::scoped_lock latch{root_latch_};
-
-  // 1. Find the leaf page containing the target key
-  auto [leaf_node, root_is_latched] = FindLeafPage(key, Operation::FIND, nullptr);
-
-  if (leaf_node == nullptr) {
-    throw InternalError("IxIndexHandle::LowerBound Error: Leaf node not found");
-    // return Iid{-1, -1};
-  }
+  // 1. Find the leaf page containing the target key, read latched
+  auto [leaf, root_is_latched] = FindLeafPage(key, Operation::FIND);
+  IxNodeHandle *leaf_node = &leaf;
 
   // 2. Use the LowerBound method in IxNodeHandle to find the appropriate key index within the leaf node
   int key_index = leaf_node->LowerBound(key);
@@ -936,7 +1708,7 @@ Iid IxIndexHandle::LowerBound(const char *key) {
   Iid result;
   // target key > all keys in leaf node
   if (key_index == leaf_node->GetSize()) {
-    if (leaf_node->GetPageNo() == file_hdr_->last_leaf_) {
+    if (leaf_node->GetRightLink() == IX_NO_PAGE) {
       // the last leaf node
       result = Iid{leaf_node->GetPageNo(), static_cast<slot_id_t>(leaf_node->GetSize())};
     } else {
@@ -947,10 +1719,9 @@ Iid IxIndexHandle::LowerBound(const char *key) {
     result = Iid{leaf_node->GetPageNo(), static_cast<slot_id_t>(key_index)};
   }
 
-  // 3. Unpin the leaf node that pinned in find_leaf_page()
+  // 3. Unlatch and unpin the leaf node that pinned in find_leaf_page()
+  leaf_node->page->RUnlatch();
   buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
-
-  delete leaf_node;
   return result;
 }
 
@@ -963,15 +1734,9 @@ Iid IxIndexHandle::LowerBound(const char *key) {
 Iid IxIndexHandle::UpperBound(const char *key) {
   // return Iid{-1, -1};
 
-  // std::scoped_lock latch{root_latch_};
-
-  // 1. Find the leaf page containing the target key
-  auto [leaf_node, root_is_latched] = FindLeafPage(key, Operation::FIND, nullptr);
-
-  if (leaf_node == nullptr) {
-    throw InternalError("IxIndexHandle::UpperBound Error: Leaf node not found");
-    // return Iid{-1, -1};
-  }
+  // 1. Find the leaf page containing the target key, read latched
+  auto [leaf, root_is_latched] = FindLeafPage(key, Operation::FIND);
+  IxNodeHandle *leaf_node = &leaf;
 
   // 2. Use the UpperBound method in IxNodeHandle to find the appropriate key index within the leaf node
   int key_index = leaf_node->UpperBound(key);
@@ -979,7 +1744,7 @@ Iid IxIndexHandle::UpperBound(const char *key) {
   Iid result;
   // target key >= all keys in leaf node
   if (key_index == leaf_node->GetSize()) {
-    if (leaf_node->GetPageNo() == file_hdr_->last_leaf_) {
+    if (leaf_node->GetRightLink() == IX_NO_PAGE) {
       // the last leaf node
       result = Iid{leaf_node->GetPageNo(), static_cast<slot_id_t>(leaf_node->GetSize())};
     } else {
@@ -990,13 +1755,40 @@ Iid IxIndexHandle::UpperBound(const char *key) {
     result = Iid{leaf_node->GetPageNo(), static_cast<slot_id_t>(key_index)};
   }
 
-  // 3. Unpin the leaf node that pinned in find_leaf_page()
+  // 3. Unlatch and unpin the leaf node that pinned in find_leaf_page()
+  leaf_node->page->RUnlatch();
   buffer_pool_manager_->UnpinPage(leaf_node->GetPageId(), false);
-
-  delete leaf_node;
   return result;
 }
 
+/**
+ * @brief 在iid所在的叶结点中定位key，结果的形式与LowerBound/UpperBound相同
+ *
+ * @param iid 查找的起点，key不小于iid之前的所有key
+ * @param key
+ * @param upper 为true时找第一个大于key的位置，否则找第一个不小于key的位置
+ * @param[out] result
+ * @return bool key是否在该叶结点的范围内
+ */
+bool IxIndexHandle::BoundInLeaf(const Iid &iid, const char *key, bool upper, Iid *result) const {
+  IxNodeHandle node = PinNode(iid.page_id_);
+  node.page->RLatch();
+  assert(node.IsLeafPage());
+  bool in_leaf = !node.NeedMoveRight(key);
+  if (in_leaf) {
+    int begin = static_cast<int>(iid.slot_num_);
+    int key_index = upper ? node.UpperBound(key, begin) : std::max(node.LowerBound(key), begin);
+    if (key_index == node.GetSize() && node.GetRightLink() != IX_NO_PAGE) {
+      *result = Iid{node.GetRightLink(), 0};
+    } else {
+      *result = Iid{node.GetPageNo(), static_cast<slot_id_t>(key_index)};
+    }
+  }
+  node.page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(node.GetPageId(), false);
+  return in_leaf;
+}
+
 /**
  * @brief 指向最后一个叶子的最后一个结点的后一个
  * 用处在于可以作为IxScan的最后一个
@@ -1004,10 +1796,11 @@ Iid IxIndexHandle::UpperBound(const char *key) {
  * @return Iid
  */
 Iid IxIndexHandle::LeafEnd() const {
-  IxNodeHandle *node = FetchNode(file_hdr_->last_leaf_);
-  Iid iid = {.page_id_ = file_hdr_->last_leaf_, .slot_num_ = static_cast<slot_id_t>(node->GetSize())};
-  buffer_pool_manager_->UnpinPage(node->GetPageId(), false);  // unpin it!
-  delete node;
+  IxNodeHandle node = PinNode(file_hdr_->last_leaf_);
+  node.page->RLatch();
+  Iid iid = {.page_id_ = file_hdr_->last_leaf_, .slot_num_ = static_cast<slot_id_t>(node.GetSize())};
+  node.page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(node.GetPageId(), false);  // unpin it!
   return iid;
 }
 
@@ -1037,12 +1830,19 @@ IxNodeHandle *IxIndexHandle::GetRoot() const { return FetchNode(file_hdr_->root_
  * @note pin the page, remember to unpin it outside!
  * @note remember to delete the node outside!
  */
-IxNodeHandle *IxIndexHandle::FetchNode(int page_no) const {
-  Page *page = buffer_pool_manager_->FetchPage(PageId{fd_, page_no});
-  IxNodeHandle *node = new IxNodeHandle(file_hdr_.get(), page);
-  // auto node = std::make_unique<IxNodeHandle>(file_hdr_, page);
+IxNodeHandle *IxIndexHandle::FetchNode(int page_no) const { return new IxNodeHandle(PinNode(page_no)); }
 
-  return node;
+/**
+ * @brief 获取一个指定结点，结点句柄按值返回，放在调用者的栈上
+ *
+ * @param page_no
+ * @return IxNodeHandle
+ * @note pin the page, remember to unpin it outside!
+ * @note 查找路径上用PinNode代替FetchNode，不分配内存；分裂和合并仍使用FetchNode/CreateNode返回的堆上句柄
+ */
+IxNodeHandle IxIndexHandle::PinNode(int page_no) const {
+  Page *page = buffer_pool_manager_->FetchPage(PageId{fd_, page_no});
+  return IxNodeHandle(file_hdr_.get(), page);
 }
 
 /**
@@ -1057,7 +1857,10 @@ IxNodeHandle *IxIndexHandle::FetchNode(int page_no) const {
  */
 IxNodeHandle *IxIndexHandle::CreateNode() {
   IxNodeHandle *node;
-  file_hdr_->num_pages_++;
+  {
+    std::scoped_lock lock{file_hdr_latch_};
+    file_hdr_->num_pages_++;
+  }
 
   PageId new_page_id = {.fd = fd_, .page_no = INVALID_PAGE_ID};
   // 从3开始分配page_no，第一次分配之后，new_page_id.page_no=3，file_hdr_.num_pages=4
@@ -1066,58 +1869,24 @@ IxNodeHandle *IxIndexHandle::CreateNode() {
   return node;
 }
 
-/**
- * @brief 从node开始更新其父节点的第一个key，一直向上更新直到根节点
- *
- * @param node
- */
-void IxIndexHandle::MaintainParent(IxNodeHandle *node) {
-  IxNodeHandle *curr = node;
-  while (curr->GetParentPageNo() != IX_NO_PAGE) {
-    // Load its parent
-    IxNodeHandle *parent = FetchNode(curr->GetParentPageNo());
-    int rank = parent->FindChild(curr);
-    char *parent_key = parent->GetKey(rank);
-    char *child_first_key = curr->GetKey(0);
-    if (memcmp(parent_key, child_first_key, file_hdr_->col_tot_len_) == 0) {
-      assert(buffer_pool_manager_->UnpinPage(parent->GetPageId(), true));
-      delete parent;
-      break;
-    }
-    memcpy(parent_key, child_first_key, file_hdr_->col_tot_len_);  // 修改了parent node
-
-    // Memory leak prevention: We cannot delete input node
-    if (curr != node) {
-      assert(buffer_pool_manager_->UnpinPage(curr->GetPageId(), true));
-      delete curr;
-    }
-    curr = parent;
-  }
-  // Memory leak prevention: We cannot delete input node
-  if (curr != node) {
-    assert(buffer_pool_manager_->UnpinPage(curr->GetPageId(), true));
-    delete curr;
-  }
-}
-
 /**
  * @brief 要删除leaf之前调用此函数，更新leaf前驱结点的next指针和后继结点的prev指针
  *
  * @param leaf 要删除的leaf
+ * @note leaf的前驱结点是与其合并的左结点，已由调用者加写锁；后继结点在此加写锁
  */
 void IxIndexHandle::EraseLeaf(IxNodeHandle *leaf) {
   assert(leaf->IsLeafPage());
 
-  IxNodeHandle *prev = FetchNode(leaf->GetPrevLeaf());
-  prev->SetNextLeaf(leaf->GetNextLeaf());
-  buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+  IxNodeHandle prev = PinNode(leaf->GetPrevLeaf());
+  prev.SetNextLeaf(leaf->GetNextLeaf());
+  buffer_pool_manager_->UnpinPage(prev.GetPageId(), true);
 
-  IxNodeHandle *Next = FetchNode(leaf->GetNextLeaf());
-  Next->SetPrevLeaf(leaf->GetPrevLeaf());  // 注意此处是SetPrevLeaf()
-  buffer_pool_manager_->UnpinPage(Next->GetPageId(), true);
-
-  delete prev;
-  delete Next;
+  IxNodeHandle next = PinNode(leaf->GetNextLeaf());
+  next.page->WLatch();
+  next.SetPrevLeaf(leaf->GetPrevLeaf());  // 注意此处是SetPrevLeaf()
+  next.page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(next.GetPageId(), true);
 }
 
 /**
@@ -1125,20 +1894,41 @@ void IxIndexHandle::EraseLeaf(IxNodeHandle *leaf) {
  *
  * @param node
  */
-void IxIndexHandle::ReleaseNodeHandle(IxNodeHandle &node) { file_hdr_->num_pages_--; }
+void IxIndexHandle::ReleaseNodeHandle([[maybe_unused]] IxNodeHandle &node) {
+  std::scoped_lock lock{file_hdr_latch_};
+  file_hdr_->num_pages_--;
+}
 
 /**
  * @brief 将node的第child_idx个孩子结点的父节点置为node
+ * @note 不对孩子结点加锁：父结点指针只在持有父结点写锁时读写，而调用者持有node的写锁
  */
 void IxIndexHandle::MaintainChild(IxNodeHandle *node, int child_idx) {
   if (!node->IsLeafPage()) {
     //  Current node is inner node, load its child and set its parent to current node
     int child_page_no = node->ValueAt(child_idx);
-    IxNodeHandle *child = FetchNode(child_page_no);
-    child->SetParentPageNo(node->GetPageNo());
-    buffer_pool_manager_->UnpinPage(child->GetPageId(), true);
-    delete child;
+    IxNodeHandle child = PinNode(child_page_no);
+    child.SetParentPageNo(node->GetPageNo());
+    buffer_pool_manager_->UnpinPage(child.GetPageId(), true);
+  }
+}
+
+/**
+ * @brief 获取一次INSERT/DELETE加写锁的页面集合，有事务时使用事务的index latch page set
+ */
+std::deque<Page *> *IxIndexHandle::GetLatchedPages(Transaction *transaction, std::deque<Page *> *local_pages) {
+  return transaction != nullptr ? transaction->GetIndexLatchPageSet().get() : local_pages;
+}
+
+/**
+ * @brief 按从上到下的顺序释放latched_pages中页面的写锁并unpin
+ */
+void IxIndexHandle::ReleaseLatchedPages(std::deque<Page *> *latched_pages, bool is_dirty) {
+  for (Page *page : *latched_pages) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
   }
+  latched_pages->clear();
 }
 
 /**
@@ -15,23 +15,25 @@ namespace easydb {
 
 /**
  * @brief
- * @todo 加上读锁（需要使用缓冲池得到page）
+ * @note 只在读取当前叶结点时加读锁，移动到下一个叶结点前释放，不会与从右向左加锁的合并操作形成死锁
+ * @note 是否为最后一个叶结点由结点自己的right link判断，不读取可能被并发修改的file_hdr_->last_leaf_
  */
 void IxScan::Next() {
   assert(!IsEnd());
-  IxNodeHandle *node = ih_->FetchNode(iid_.page_id_);
-  assert(node->IsLeafPage());
-  assert(iid_.slot_num_ < static_cast<slot_id_t>(node->GetSize()));
+  IxNodeHandle node = ih_->PinNode(iid_.page_id_);
+  node.page->RLatch();
+  assert(node.IsLeafPage());
+  assert(iid_.slot_num_ < static_cast<slot_id_t>(node.GetSize()));
   // increment slot no
   iid_.slot_num_++;
-  if (iid_.page_id_ != ih_->file_hdr_->last_leaf_ && iid_.slot_num_ == node->GetSize()) {
+  if (node.GetRightLink() != IX_NO_PAGE && iid_.slot_num_ == static_cast<slot_id_t>(node.GetSize())) {
     // go to Next leaf
     iid_.slot_num_ = 0;
-    iid_.page_id_ = node->GetNextLeaf();
+    iid_.page_id_ = node.GetRightLink();
   }
-  // Unpin the page that pinned in FetchNode()
-  bpm_->UnpinPage(node->GetPageId(), false);
-  delete node;
+  // Unlatch and unpin the page that pinned in PinNode()
+  node.page->RUnlatch();
+  bpm_->UnpinPage(node.GetPageId(), false);
 }
 
 RID IxScan::GetRid() const { return ih_->GetRid(iid_); }
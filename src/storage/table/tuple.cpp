@@ -24,7 +24,6 @@
 
 namespace easydb {
 
-// TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
 Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
   assert(values.size() == schema->GetColumnCount());
 
@@ -42,12 +41,16 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
   data_.resize(tuple_size);
   std::fill(data_.begin(), data_.end(), 0);
 
-  // 3. Serialize each attribute based on the input value.
+  // 3. Serialize each attribute based on the input value, a null value sets its bit in the null bitmap.
   uint32_t column_count = schema->GetColumnCount();
   uint32_t offset = schema->GetInlinedStorageSize();
+  char *null_bitmap = data_.data() + schema->GetNullBitmapOffset();
 
   for (uint32_t i = 0; i < column_count; i++) {
     const auto &col = schema->GetColumn(i);
+    if (values[i].IsNull()) {
+      null_bitmap[i / 8] = static_cast<char>(static_cast<uint8_t>(null_bitmap[i / 8]) | (1U << (i % 8)));
+    }
     if (!col.IsInlined()) {
       // Serialize relative offset, where the actual varchar data is stored.
       *reinterpret_cast<uint32_t *>(data_.data() + col.GetOffset()) = offset;
@@ -58,7 +61,7 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
         len = 0;
       }
       offset += sizeof(uint32_t) + len;
-    } else {
+    } else if (!values[i].IsNull()) {
       values[i].SerializeTo(data_.data() + col.GetOffset());
     }
   }
@@ -116,6 +119,9 @@ Tuple::Tuple(int size,const char *data) {
 auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
   assert(schema);
   const TypeId column_type = schema->GetColumn(column_idx).GetType();
+  if (IsNull(schema, column_idx)) {
+    return Value(column_type);
+  }
   const char *data_ptr = GetDataPtr(schema, column_idx);
   // the third parameter "is_inlined" is unused
   return Value::DeserializeFrom(data_ptr, column_type);
@@ -123,17 +129,7 @@ auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> V
 
 auto Tuple::GetValue(const Schema *schema, std::string column_name) const -> Value {
   assert(schema);
-  const TypeId column_type = schema->GetColumn(column_name).GetType();
-  const char *data_ptr = GetDataPtr(schema, column_name);
-  // the third parameter "is_inlined" is unused
-  return Value::DeserializeFrom(data_ptr, column_type);
-}
-
-auto Tuple::GetValue(const Column col) const -> Value {
-  const TypeId column_type = col.GetType();
-  const char *data_ptr = GetDataPtr(col);
-  // the third parameter "is_inlined" is unused
-  return Value::DeserializeFrom(data_ptr, column_type);
+  return GetValue(schema, schema->GetColIdx(column_name));
 }
 
 auto Tuple::GetValueVec(const Schema *schema) const -> std::vector<Value> {
@@ -145,6 +141,11 @@ auto Tuple::GetValueVec(const Schema *schema) const -> std::vector<Value> {
   return values;
 }
 
+auto Tuple::IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
+  assert(schema);
+  return TupleView::IsNull(data_.data(), schema, column_idx);
+}
+
 auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema,
                          const std::vector<uint32_t> &key_attrs) const -> Tuple {
   std::vector<Value> values;
@@ -157,43 +158,15 @@ auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema,
 
 auto Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
   assert(schema);
-  const auto &col = schema->GetColumn(column_idx);
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_.data() + col.GetOffset());
-  }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_.data() + offset);
+  return TupleView::GetDataPtr(data_.data(), schema->GetColumn(column_idx));
 }
 
 auto Tuple::GetDataPtr(const Schema *schema, const std::string column_name) const -> const char * {
   assert(schema);
-  const auto &col = schema->GetColumn(column_name);
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_.data() + col.GetOffset());
-  }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_.data() + offset);
+  return TupleView::GetDataPtr(data_.data(), schema->GetColumn(column_name));
 }
 
-auto Tuple::GetDataPtr(const Column col) const -> const char * {
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_.data() + col.GetOffset());
-  }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_.data() + offset);
-}
+auto Tuple::GetDataPtr(const Column col) const -> const char * { return TupleView::GetDataPtr(data_.data(), col); }
 
 auto Tuple::ToString(const Schema *schema) const -> std::string {
   std::stringstream os;
@@ -231,4 +204,35 @@ void Tuple::DeserializeFrom(const char *storage) {
   memcpy(this->data_.data(), storage + sizeof(int32_t), size);
 }
 
+auto TupleView::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+  assert(schema);
+  const auto &col = schema->GetColumn(column_idx);
+  if (IsNull(schema, column_idx)) {
+    return Value(col.GetType());
+  }
+  return Value::DeserializeFrom(GetDataPtr(data_, col), col.GetType());
+}
+
+auto TupleView::GetValue(const Schema *schema, const std::string &column_name) const -> Value {
+  assert(schema);
+  return GetValue(schema, schema->GetColIdx(column_name));
+}
+
+auto TupleView::ToTuple() const -> Tuple {
+  Tuple tuple(size_, data_);
+  tuple.SetRid(rid_);
+  return tuple;
+}
+
+auto TupleView::GetDataPtr(const char *data, const Column &col) -> const char * {
+  // For inline type, data is stored where it is.
+  if (col.IsInlined()) {
+    return data + col.GetOffset();
+  }
+  // We read the relative offset from the tuple data.
+  int32_t offset = *reinterpret_cast<const int32_t *>(data + col.GetOffset());
+  // And return the beginning address of the real data for the VARCHAR type.
+  return data + offset;
+}
+
 }  // namespace easydb
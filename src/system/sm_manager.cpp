@@ -14,14 +14,19 @@ See the Mulan PSL v2 for more details. */
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <exception>
 #include <fstream>
-#include <set>
+#include <future>
 #include <string>
+#include <thread>
 #include "catalog/schema.h"
 #include "common/context.h"
 #include "common/errors.h"
 #include "common/exception.h"
 #include "record/record_printer.h"
+#include "record/rm_bulk_appender.h"
 #include "record/rm_scan.h"
 #include "storage/index/ix_defs.h"
 #include "storage/table/tuple.h"
@@ -103,19 +108,40 @@ void SmManager::OpenDB(const std::string &db_name) {
   if (chdir(db_name.c_str()) < 0) {
     throw UnixError();
   }
+  // the disk manager makes the directory of a new database when it starts, so CreateDB is skipped above and the
+  // catalog is written here
+  if (!disk_manager_->IsFile(DB_META_NAME)) {
+    DbMeta new_db;
+    new_db.name_ = db_name;
+    std::ofstream ofs(DB_META_NAME);
+    ofs << new_db;
+  }
+  if (!disk_manager_->IsFile(LOG_FILE_NAME)) {
+    disk_manager_->CreateFile(LOG_FILE_NAME);
+  }
   // load info into db_, fhs_, ihs_
   // db_ stored in file DB_META_NAME("db.meta")
   std::ifstream ifs(DB_META_NAME);
   ifs >> db_;
 
   // fhs_ : contains of several <filename of per table, record file ptr> items
-  for (auto table : db_.tabs_) {
+  // Note: iterate by reference, the copy constructor of TabMeta copies neither the indexes nor the schema
+  for (auto &table : db_.tabs_) {
     // debug
     std::cout << "open table name: " << table.first << std::endl;
     // the name of record file is table name, index file is table_name.index
     fhs_.emplace(table.first, rm_manager_->OpenFile(table.first));
-    if (ix_manager_->Exists(table.first, db_.tabs_[table.first].cols)) {
-      ihs_.emplace(table.first, ix_manager_->OpenIndex(table.first, table.second.cols));
+    // Note: the schema is not persisted in the meta file yet, zone maps need the column types
+    if (table.second.schema.GetColumnCount() == table.second.cols.size()) {
+      fhs_.at(table.first)->EnableZoneMap(table.second.schema);
+    }
+    for (auto &index : table.second.indexes) {
+      auto index_name = ix_manager_->GetIndexName(table.first, index.cols);
+      if (index.is_hash) {
+        hash_ihs_.emplace(index_name, ix_manager_->OpenExtendibleHashIndex(table.first, index.cols));
+      } else {
+        ihs_.emplace(index_name, ix_manager_->OpenIndex(table.first, index.cols));
+      }
     }
   }
 
@@ -137,10 +163,16 @@ void SmManager::FlushMeta() {
 void SmManager::CloseDB() {
   for (auto table : db_.tabs_) {
     rm_manager_->CloseFile(fhs_[table.first].get());
-    if (ix_manager_->Exists(table.first, db_.tabs_[table.first].cols)) {
-      ix_manager_->CloseIndex(ihs_[table.first].get());
-    }
   }
+  fhs_.clear();
+  for (auto &[index_name, ih] : ihs_) {
+    ix_manager_->CloseIndex(ih.get());
+  }
+  ihs_.clear();
+  for (auto &[index_name, ih] : hash_ihs_) {
+    ix_manager_->CloseExtendibleHashIndex(ih.get());
+  }
+  hash_ihs_.clear();
 
   // return to father directory
   if (chdir("..") < 0) {
@@ -202,7 +234,8 @@ void SmManager::DescTable(const std::string &tab_name, Context *context) {
  * @param {vector<ColDef>&} col_defs 表的字段
  * @param {Context*} context
  */
-void SmManager::CreateTable(const std::string &tab_name, const std::vector<ColDef> &col_defs, Context *context) {
+void SmManager::CreateTable(const std::string &tab_name, const std::vector<ColDef> &col_defs, Context *context,
+                            RmFileFormat format) {
   if (db_.is_table(tab_name)) {
     throw TableExistsError(tab_name);
   }
@@ -239,12 +272,14 @@ void SmManager::CreateTable(const std::string &tab_name, const std::vector<ColDe
   tab.schema = schema;
 
   // Create & open record file
-  int record_size = curr_offset;  // record_size就是col meta所占的大小（表的元数据也是以记录的形式进行存储的）
-  rm_manager_->CreateFile(tab_name, record_size);
+  // 记录的大小只计定长部分，过长的变长列的值存放在TOAST页面中（列存格式按各列的最大长度在CreateFile中检查）
+  int record_size = schema.GetInlinedStorageSize();
+  rm_manager_->CreateFile(tab_name, record_size, format, &schema);
 
   db_.tabs_[tab_name] = tab;
   // fhs_[tab_name] = rm_manager_->open_file(tab_name);
   fhs_.emplace(tab_name, rm_manager_->OpenFile(tab_name));
+  fhs_.at(tab_name)->EnableZoneMap(schema);
 
   // lock manager
   if (context != nullptr) {
@@ -312,13 +347,187 @@ void SmManager::ShowIndex(const std::string &tab_name, Context *context) {
   outfile.close();
 }
 
+/**
+ * @description: 整理表中已删除记录占用的空间并封存（压缩）已满的列存页面，显示每张表回收的记录数、空间大小、
+ *               空页面数、封存的页面数和回收的TOAST页面数
+ * @param {string&} tab_name 表的名称，为空时整理所有表
+ * @param {Context*} context
+ * @note 只移动页面内的记录数据，记录的RID不变，因此不需要修改索引；已删除记录的索引项在删除时已经删除
+ */
+void SmManager::Vacuum(const std::string &tab_name, Context *context) {
+  std::vector<std::string> tab_names;
+  if (tab_name.empty()) {
+    for (auto &entry : db_.tabs_) {
+      tab_names.push_back(entry.first);
+    }
+  } else {
+    if (!db_.is_table(tab_name)) {
+      throw TableNotFoundError(tab_name);
+    }
+    tab_names.push_back(tab_name);
+  }
+
+  std::fstream outfile;
+  if (enable_output_) {
+    outfile.open("output.txt", std::ios::out | std::ios::app);
+    outfile << "| Table | Pages | Tuples | Bytes | Empty pages | Sealed pages | Toast pages |\n";
+  }
+  RecordPrinter printer(7);
+  printer.print_separator(context);
+  printer.print_record({"Table", "Pages", "Tuples", "Bytes", "Empty pages", "Sealed pages", "Toast pages"}, context);
+  printer.print_separator(context);
+  for (auto &name : tab_names) {
+    auto stats = fhs_.at(name)->Vacuum(context->lock_mgr_, context->log_mgr_);
+    std::vector<std::string> row = {name, std::to_string(stats.num_pages_), std::to_string(stats.num_tuples_),
+                                    std::to_string(stats.num_bytes_), std::to_string(stats.num_empty_pages_),
+                                    std::to_string(stats.num_sealed_pages_), std::to_string(stats.num_toast_pages_)};
+    printer.print_record(row, context);
+    if (enable_output_) {
+      outfile << "| " << row[0] << " | " << row[1] << " | " << row[2] << " | " << row[3] << " | " << row[4] << " | "
+              << row[5] << " | " << row[6] << " |\n";
+    }
+  }
+  printer.print_separator(context);
+  outfile.close();
+}
+
+/**
+ * @description: 显示锁表中所有已授予的锁
+ * @param {Context*} context
+ */
+void SmManager::ShowLocks(Context *context) {
+  std::fstream outfile;
+  if (enable_output_) {
+    outfile.open("output.txt", std::ios::out | std::ios::app);
+    outfile << "| Object | Txn | Mode |\n";
+  }
+  RecordPrinter printer(3);
+  printer.print_separator(context);
+  printer.print_record({"Object", "Txn", "Mode"}, context);
+  printer.print_separator(context);
+  for (auto &lock : context->lock_mgr_->GetLocks()) {
+    std::string object = GetLockObjectName(lock.lock_data_id_);
+    printer.print_record({object, std::to_string(lock.txn_id_), lock.lock_mode_}, context);
+    if (enable_output_) {
+      outfile << "| " << object << " | " << lock.txn_id_ << " | " << lock.lock_mode_ << " |\n";
+    }
+  }
+  printer.print_separator(context);
+  outfile.close();
+}
+
+/**
+ * @description: 显示锁的统计信息，包括每种加锁类型的申请、等待、回滚次数和等待时间直方图，
+ *               每种原因导致的事务回滚次数，以及等待时间最长的LOCK_STATS_TOP_N个热点数据项
+ * @param {Context*} context
+ */
+void SmManager::ShowLockStats(Context *context) {
+  std::fstream outfile;
+  if (enable_output_) {
+    outfile.open("output.txt", std::ios::out | std::ios::app);
+  }
+  // print a table to both the client and output.txt
+  auto print_table = [&](const std::vector<std::string> &captions,
+                         const std::vector<std::vector<std::string>> &rows) {
+    RecordPrinter printer(captions.size());
+    printer.print_separator(context);
+    printer.print_record(captions, context);
+    printer.print_separator(context);
+    for (auto &row : rows) {
+      printer.print_record(row, context);
+    }
+    printer.print_separator(context);
+    if (enable_output_) {
+      auto write_row = [&](const std::vector<std::string> &row) {
+        outfile << "|";
+        for (auto &col : row) {
+          outfile << " " << col << " |";
+        }
+        outfile << "\n";
+      };
+      write_row(captions);
+      for (auto &row : rows) {
+        write_row(row);
+      }
+    }
+  };
+
+  // 1. per lock mode
+  auto mode_stats = context->lock_mgr_->GetModeStats();
+  std::vector<std::vector<std::string>> rows;
+  for (auto &[mode, stats] : mode_stats) {
+    uint64_t avg_wait_time_us = stats.waits_ == 0 ? 0 : stats.wait_time_us_ / stats.waits_;
+    rows.push_back({mode, std::to_string(stats.requests_), std::to_string(stats.waits_), std::to_string(stats.dies_),
+                    std::to_string(avg_wait_time_us), std::to_string(stats.max_wait_time_us_)});
+  }
+  print_table({"Mode", "Requests", "Waits", "Dies", "AvgWait(us)", "MaxWait(us)"}, rows);
+
+  // 2. wait time histogram, only the non-empty buckets
+  rows.clear();
+  for (auto &[mode, stats] : mode_stats) {
+    for (int i = 0; i < LOCK_WAIT_HISTOGRAM_BUCKETS; ++i) {
+      if (stats.wait_histogram_[i] == 0) {
+        continue;
+      }
+      std::string range = i == LOCK_WAIT_HISTOGRAM_BUCKETS - 1 ? ">=" + std::to_string(1ULL << (i - 1))
+                                                               : "<" + std::to_string(1ULL << i);
+      rows.push_back({mode, range, std::to_string(stats.wait_histogram_[i])});
+    }
+  }
+  print_table({"Mode", "WaitTime(us)", "Waits"}, rows);
+
+  // 3. abort reasons
+  rows.clear();
+  for (auto &[reason, count] : context->lock_mgr_->GetAbortStats()) {
+    rows.push_back({reason, std::to_string(count)});
+  }
+  print_table({"AbortReason", "Count"}, rows);
+
+  // 4. hot objects
+  rows.clear();
+  for (auto &hot_lock : context->lock_mgr_->GetHotLocks(LOCK_STATS_TOP_N)) {
+    rows.push_back({GetLockObjectName(hot_lock.lock_data_id_), std::to_string(hot_lock.waits_),
+                    std::to_string(hot_lock.dies_), std::to_string(hot_lock.wait_time_us_)});
+  }
+  print_table({"Object", "Waits", "Dies", "WaitTime(us)"}, rows);
+  outfile.close();
+}
+
+/**
+ * @description: 加锁对象的可读名称，表锁为表名，行锁为表名(page,slot)，间隙锁为表名gap(page,slot)
+ * @return {string} 加锁对象的名称
+ * @param {LockDataId&} lock_data_id 加锁对象
+ */
+std::string SmManager::GetLockObjectName(const LockDataId &lock_data_id) {
+  std::string tab_name = "fd" + std::to_string(lock_data_id.fd_);
+  for (auto &[name, fh] : fhs_) {
+    if (fh->GetFd() == lock_data_id.fd_) {
+      tab_name = name;
+      break;
+    }
+  }
+  std::string pos = "(" + std::to_string(lock_data_id.rid_.GetPageId()) + "," +
+                    std::to_string(lock_data_id.rid_.GetSlotNum()) + ")";
+  switch (lock_data_id.type_) {
+    case LockDataType::TABLE:
+      return tab_name;
+    case LockDataType::RECORD:
+      return tab_name + pos;
+    default:
+      return tab_name + "gap" + pos;
+  }
+}
+
 /**
  * @description: 创建索引
  * @param {string&} tab_name 表的名称
  * @param {vector<string>&} col_names 索引包含的字段名称
  * @param {Context*} context
+ * @param {vector<string>&} include_names INCLUDE的字段名称，其值存放在叶结点中，只读索引的扫描不需要回表
+ * @param {bool} is_hash 创建可扩展hash索引，只用于等值查找，不支持INCLUDE
  */
-void SmManager::CreateIndex(const std::string &tab_name, const std::vector<std::string> &col_names, Context *context) {
+void SmManager::CreateIndex(const std::string &tab_name, const std::vector<std::string> &col_names, Context *context,
+                            const std::vector<std::string> &include_names, bool is_hash) {
   // check if tab exists
   if (!db_.is_table(tab_name)) {
     throw TableNotFoundError(tab_name);
@@ -343,65 +552,73 @@ void SmManager::CreateIndex(const std::string &tab_name, const std::vector<std::
     key_ids.emplace_back(tab_meta.GetColId(col_name));
     col_tot_len += colMetaTp.len;
   }
+  if (is_hash && !include_names.empty()) {
+    throw InternalError("SmManager::CreateIndex: a hash index can not have INCLUDE columns");
+  }
+  std::vector<ColMeta> include_cols;
+  std::vector<uint32_t> include_ids;
+  for (auto &col_name : include_names) {
+    if (std::find(col_names.begin(), col_names.end(), col_name) != col_names.end()) {
+      throw InternalError("SmManager::CreateIndex: column " + col_name + " is both a key and an INCLUDE column");
+    }
+    include_cols.emplace_back(*tab_meta.get_col(col_name));
+    include_ids.emplace_back(tab_meta.GetColId(col_name));
+  }
 
   // construct index_meta
   IndexMeta index_meta = {.tab_name = tab_name,
                           .col_tot_len = col_tot_len,
                           .col_num = static_cast<int>(col_names.size()),
                           .cols = index_cols,
-                          .col_ids = key_ids};
-  auto key_schema = Schema::CopySchema(&tab_meta.schema, key_ids);
+                          .col_ids = key_ids,
+                          .include_cols = include_cols,
+                          .include_ids = include_ids,
+                          .is_hash = is_hash};
+  auto index_name = ix_manager_->GetIndexName(tab_name, col_names);
+
+  if (is_hash) {
+    // the entries are inserted one by one, a hash index has no order to be built bottom-up
+    ix_manager_->CreateExtendibleHashIndex(tab_name, index_cols);
+    auto ih = ix_manager_->OpenExtendibleHashIndex(tab_name, index_cols);
+    for (RmScan rmScan(fhs_.at(tab_name).get(), context); !rmScan.IsEnd(); rmScan.Next()) {
+      auto tuple = rmScan.GetTupleView();
+      auto key = index_meta.MakeEntry([&](uint32_t col_id) { return tuple.GetValue(&tab_meta.schema, col_id); });
+      if (ih->InsertEntry(key.data(), rmScan.GetRid()) == IX_NO_PAGE) {
+        ix_manager_->CloseExtendibleHashIndex(ih.get());
+        buffer_pool_manager_->RemoveAllPages(ih->GetFd());
+        ix_manager_->DestroyIndex(tab_name, index_cols);
+        throw IndexExistsError(tab_name, col_names);
+      }
+    }
+    tab_meta.indexes.emplace_back(index_meta);
+    hash_ihs_.emplace(index_name, std::move(ih));
+    FlushMeta();
+    return;
+  }
 
   // create index
-  ix_manager_->CreateIndex(tab_name, index_cols);
+  ix_manager_->CreateIndex(tab_name, index_cols, index_meta.GetIncludeLen());
 
   // insert the records that already in table into newly constructed index
   auto Iih = ix_manager_->OpenIndex(tab_name, index_cols);
   auto Rfh = fhs_.at(tab_name).get();
-  RmScan rmScan(Rfh);
+  RmScan rmScan(Rfh, context);
 
+  // collect the keys of the table, the index is then built bottom-up from the sorted keys
+  std::vector<IxEntry> entries;
   while (!rmScan.IsEnd()) {
     auto rid = rmScan.GetRid();
-    auto tuple = Rfh->GetTupleValue(rid, context);
-    auto key_tuple = Rfh->GetKeyTuple(tab_meta.schema, key_schema, key_ids, rid, context);
-    // construct key
-    char *key = new char[index_meta.col_tot_len];
-    int offset = 0;
-    for (int i = 0; i < index_meta.col_num; ++i) {
-      // memcpy(key + offset, rec->data + index_meta.cols[i].offset, index_meta.cols[i].len);
-      auto len = index_meta.cols[i].len;
-      auto val = key_tuple.GetValue(&key_schema, i);
-      // memcpy(key + offset, val.GetData(), val.GetStorageSize());
-      if (val.GetTypeId() == TYPE_CHAR || val.GetTypeId() == TYPE_VARCHAR) {
-        memcpy(key + offset, val.GetData(), index_meta.cols[i].len);
-      } else {
-        assert(uint32_t(len) == Type(val.GetTypeId()).GetTypeSize(val.GetTypeId()));
-        val.SerializeTo(key + offset);
-      }
-      offset += index_meta.cols[i].len;
-    }
-    // // print key
-    // std::cout << "key: " << std::string(key, index_meta.col_tot_len) << std::endl;
-    // for (int i = 0; i < 4; ++i) {
-    //   std::cout << "0x" << std::hex << std::setw(2) << std::setfill('0') << (int)(unsigned char)key[i] << " ";
-    // }
-    // std::cout << std::endl;
-    // std::cout << "key(int): " << std::to_string(*(int *)key) << std::endl;
-    int pos = -1;
-    if (context != nullptr) {
-      pos = Iih->InsertEntry(key, rid, context->txn_);
-    } else {
-      pos = Iih->InsertEntry(key, rid, nullptr);
-    }
-    if (pos == -1) {
-      throw Exception("Insert index entry failed(duplicate key). Is the index unique?");
-    }
-    delete[] key;
+    auto tuple = rmScan.GetTupleView();
+    // construct key, followed by the INCLUDE columns
+    auto get_value = [&](uint32_t col_id) { return tuple.GetValue(&tab_meta.schema, col_id); };
+    entries.emplace_back(index_meta.MakeEntry(get_value), rid);
     rmScan.Next();
   }
+  if (!Iih->BulkLoad(&entries, context != nullptr ? context->txn_ : nullptr)) {
+    throw Exception("Insert index entry failed(duplicate key). Is the index unique?");
+  }
 
   // update ihs and corresponding table index meta data
-  auto index_name = ix_manager_->GetIndexName(tab_name, col_names);
   tab_meta.indexes.emplace_back(index_meta);
   ihs_.emplace(index_name, std::move(Iih));
   FlushMeta();
@@ -433,6 +650,12 @@ void SmManager::DropIndex(const std::string &tab_name, const std::vector<std::st
     // DbMeta
     ihs_.erase(index_name);
   }
+  if (hash_ihs_.find(index_name) != hash_ihs_.end()) {
+    auto ih = hash_ihs_.at(index_name).get();
+    ix_manager_->CloseExtendibleHashIndex(ih);
+    buffer_pool_manager_->RemoveAllPages(ih->GetFd());
+    hash_ihs_.erase(index_name);
+  }
 
   // delete coresponding metadata
   // table meta
@@ -500,8 +723,6 @@ void SmManager::RollbackInsert(const std::string &table_name, RID &rid, Context
   // Delete from index
   auto tab = db_.get_table(table_name);
   for (auto &index : tab.indexes) {
-    auto index_name = ix_manager_->GetIndexName(table_name, index.cols);
-    auto ih = ihs_.at(index_name).get();
     auto key_schema = Schema::CopySchema(&tab.schema, index.col_ids);
     auto key_tuple = fh->GetKeyTuple(tab.schema, key_schema, index.col_ids, rid, context);
     char *key = new char[index.col_tot_len];
@@ -511,7 +732,7 @@ void SmManager::RollbackInsert(const std::string &table_name, RID &rid, Context
       ix_memcpy(key + offset, val, index.cols[i].len);
       offset += index.cols[i].len;
     }
-    ih->DeleteEntry(key, context->txn_);
+    DeleteIndexEntry(table_name, index, key, context->txn_);
     delete[] key;
   }
   // Delete from table
@@ -542,7 +763,7 @@ void SmManager::RollbackInsert(const std::string &table_name, RID &rid, Context
 void SmManager::RollbackDelete(const std::string &table_name, RID &rid, Tuple &tuple, Context *context) {
   // insert the record back into the record file
   auto fh = fhs_.at(table_name).get();
-  fh->InsertTuple(rid, TupleMeta{0, false}, tuple, context);
+  fh->InsertTuple(rid, TupleMeta{context->txn_->GetRollbackVersion(), false}, tuple, context);
 
   // // TODO: InsertLogRecord(CLR)
   // InsertLogRecord insert_log_rec(context->txn_->GetTransactionId(), record, rid, table_name);
@@ -558,24 +779,12 @@ void SmManager::RollbackDelete(const std::string &table_name, RID &rid, Tuple &t
   // insert the index entry back into the index file
   auto tab = db_.get_table(table_name);
   for (auto index : tab.indexes) {
-    auto ih = ihs_.at(ix_manager_->GetIndexName(table_name, index.cols)).get();
-    auto key_schema = Schema::CopySchema(&tab.schema, index.col_ids);
-    auto key_tuple = fh->GetKeyTuple(tab.schema, key_schema, index.col_ids, rid, context);
-    char *key = new char[index.col_tot_len];
-    int offset = 0;
-    for (int i = 0; i < index.col_num; ++i) {
-      auto val = key_tuple.GetValue(&key_schema, i);
-      ix_memcpy(key + offset, val, index.cols[i].len);
-      offset += index.cols[i].len;
-    }
-    auto is_insert = ih->InsertEntry(key, rid, context->txn_);
-    delete[] key;
-
-    if (is_insert == -1) {
+    // the key and the INCLUDE columns of the record written back
+    auto entry = index.MakeEntry([&](uint32_t col_id) { return tuple.GetValue(&tab.schema, col_id); });
+    if (!InsertIndexEntry(table_name, index, entry.data(), rid, context->txn_)) {
       // should not happen because this is logged
       throw InternalError("SmManager::rollback_delete: index entry not found");
     }
-    delete[] key;
   }
 }
 
@@ -603,7 +812,7 @@ void SmManager::RollbackUpdate(const std::string &table_name, RID &rid, Tuple &t
 
   // update the record to the old record
   // fh->UpdateTupleInPlace(TupleMeta{0, false}, tuple, rid, context);
-  fh->UpdateTupleInPlace(TupleMeta{0, false}, tuple, rid, context);
+  fh->UpdateTupleInPlace(TupleMeta{context->txn_->GetRollbackVersion(), false}, tuple, rid, context);
 
   // // Log: after update
   // update_log_rec.prev_lsn_ = context->txn_->GetPrevLsn();
@@ -617,35 +826,67 @@ void SmManager::RollbackUpdate(const std::string &table_name, RID &rid, Tuple &t
 
   // update the index entry in the index file
   for (auto index : tab.indexes) {
-    auto ih = ihs_.at(ix_manager_->GetIndexName(table_name, index.cols)).get();
-    auto ids = index.col_ids;
-    char *key_d = new char[index.col_tot_len];
-    char *key_i = new char[index.col_tot_len];
-    int offset = 0;
-    for (int i = 0; i < index.col_num; ++i) {
-      auto id = ids[i];
-      auto val_d = new_values[id];
-      auto val_i = values[id];
-      ix_memcpy(key_d + offset, val_d, index.cols[i].len);
-      ix_memcpy(key_i + offset, val_i, index.cols[i].len);
-      offset += index.cols[i].len;
+    auto entry_d = index.MakeEntry([&](uint32_t col_id) { return new_values[col_id]; });
+    auto entry_i = index.MakeEntry([&](uint32_t col_id) { return values[col_id]; });
+    // check if the key and the INCLUDE columns are the same as before
+    if (entry_d == entry_i) {
+      continue;
     }
-    // check if the key is the same as before
-    if (memcmp(key_d, key_i, index.col_tot_len) == 0) {
+    if (memcmp(entry_d.data(), entry_i.data(), index.col_tot_len) == 0) {
+      // only the INCLUDE columns changed, the entry is written again under the same key
+      DeleteIndexEntry(table_name, index, entry_d.data(), context->txn_);
+      InsertIndexEntry(table_name, index, entry_i.data(), rid, context->txn_);
       continue;
     }
     // check if the new key duplicated
-    auto is_insert = ih->InsertEntry(key_i, rid, context->txn_);
-    if (is_insert == -1) {
+    if (!InsertIndexEntry(table_name, index, entry_i.data(), rid, context->txn_)) {
       // should not happen because this is logged
       throw InternalError("SmManager::rollback_update: index entry not found");
     }
-    ih->DeleteEntry(key_d, context->txn_);
-    delete[] key_d;
-    delete[] key_i;
+    DeleteIndexEntry(table_name, index, entry_d.data(), context->txn_);
   }
 }
 
+/**
+ * @description: 向表的一个索引插入索引项，B+树索引和hash索引都由此维护
+ * @param {IndexMeta&} index 索引元数据
+ * @param {char*} entry 索引项，key之后紧跟INCLUDE字段（hash索引没有INCLUDE字段）
+ * @return {bool} key已存在时返回false
+ */
+bool SmManager::InsertIndexEntry(const std::string &tab_name, const IndexMeta &index, const char *entry,
+                                 const RID &rid, Transaction *txn) {
+  auto index_name = ix_manager_->GetIndexName(tab_name, index.cols);
+  if (index.is_hash) {
+    return hash_ihs_.at(index_name)->InsertEntry(entry, rid) != IX_NO_PAGE;
+  }
+  return ihs_.at(index_name)->InsertEntry(entry, rid, txn) != IX_NO_PAGE;
+}
+
+/**
+ * @description: 删除表的一个索引中key对应的索引项
+ * @return {bool} key是否存在
+ */
+bool SmManager::DeleteIndexEntry(const std::string &tab_name, const IndexMeta &index, const char *key,
+                                 Transaction *txn) {
+  auto index_name = ix_manager_->GetIndexName(tab_name, index.cols);
+  if (index.is_hash) {
+    return hash_ihs_.at(index_name)->DeleteEntry(key);
+  }
+  return ihs_.at(index_name)->DeleteEntry(key, txn);
+}
+
+/**
+ * @description: 插入或删除key之前需要等待的GAP锁：B+树索引为第一个不小于key的位置前的间隙，hash索引没有顺序，
+ *               为key本身
+ */
+Iid SmManager::GetIndexGap(const std::string &tab_name, const IndexMeta &index, const char *key) {
+  auto index_name = ix_manager_->GetIndexName(tab_name, index.cols);
+  if (index.is_hash) {
+    return hash_ihs_.at(index_name)->GetKeyLock(key);
+  }
+  return ihs_.at(index_name)->LowerBound(key);
+}
+
 /**
  * @description: split string by delimiter
  * @param s: input string
@@ -686,38 +927,112 @@ void SmManager::Split(const char *start, size_t length, char delimiter, std::vec
 inline int ix_compare(const char *a, const char *b, const std::vector<ColMeta> cols) {
   int offset = 0;
   for (size_t i = 0; i < cols.size(); ++i) {
-    int res = ix_compare(a + offset, b + offset, cols[i].type, cols[i].len);
+    int res = ix_compare(a + offset, b + offset, cols[i].len);
     if (res != 0) return res;
     offset += cols[i].len;
   }
   return 0;
 }
 
+namespace {
+
 /**
- * @description: insert record into table
- * @param file_name
- * @param table_name
- * @param context
- * @note: this function will insert one record into table
+ * @description: parse a number in place, without building a string for it
+ * @note: the characters after the number are ignored, as std::stoi does
  */
-RID fh_insert(RmFileHandle *fh, std::vector<Value> &values, Schema *schema, Context *context) {
-  Tuple tuple{values, schema};
-  auto rid = fh->InsertTuple(TupleMeta{0, false}, tuple, context);
-  auto page_id = rid->GetPageId();
-  auto slot_num = rid->GetSlotNum();
-  // std::cout << "[TEST] insert rid: page id: " << page_id << " slot num: " << slot_num << std::endl;
-  return {page_id, slot_num};
+template <typename T>
+T ParseNumber(const char *begin, const char *end) {
+  T val{};
+  auto [ptr, ec] = std::from_chars(begin, end, val);
+  if (ec != std::errc() || ptr == begin) {
+    throw InternalError("SmManager::load_data: invalid number " + std::string(begin, end));
+  }
+  return val;
 }
 
+/**
+ * @description: parse the lines in [begin, end) and append them to the table through a private bulk appender
+ * @param index_entries the keys of the rows with their rids are collected here, one vector per index of the table
+ * @param pages the pages installed with the number of rows on each, also when the parsing fails, to undo the load
+ * @return {int} the number of rows loaded
+ */
+int LoadRows(const char *begin, const char *end, const TabMeta &tab, RmFileHandle *fh,
+             std::vector<ColumnStatsBuilder> *stats, std::vector<std::vector<IxEntry>> *index_entries,
+             std::vector<std::pair<page_id_t, size_t>> *pages) {
+  // The rids are only known when a page is installed
+  auto on_install = [&](page_id_t page_no, const std::vector<Tuple> &tuples) {
+    pages->emplace_back(page_no, tuples.size());
+    for (size_t i = 0; i < tab.indexes.size(); ++i) {
+      const IndexMeta &index = tab.indexes[i];
+      for (size_t slot_no = 0; slot_no < tuples.size(); ++slot_no) {
+        auto get_value = [&](uint32_t col_id) { return tuples[slot_no].GetValue(&tab.schema, col_id); };
+        (*index_entries)[i].emplace_back(index.MakeEntry(get_value), RID{page_no, static_cast<slot_id_t>(slot_no)});
+      }
+    }
+  };
+  RmBulkAppender appender(fh, on_install);
+  size_t col_size = tab.cols.size();
+  std::vector<Value> values;
+  values.reserve(col_size);
+  int num_rows = 0;
+  for (const char *line_start = begin; line_start < end; ++num_rows) {
+    const char *line_end = static_cast<const char *>(memchr(line_start, '\n', end - line_start));
+    // Last line without \n
+    if (line_end == nullptr) {
+      line_end = end;
+    }
+    values.clear();
+    const char *token_start = line_start;
+    for (size_t i = 0; i < col_size; ++i) {
+      const char *token_end = std::find(token_start, line_end, '|');
+      auto type = tab.cols[i].type;
+      // An empty number is NULL, it only sets its bit in the null bitmap and is left out of the statistics
+      if (token_start == token_end && type != TYPE_CHAR && type != TYPE_VARCHAR) {
+        values.emplace_back(type);
+        token_start = token_end + 1;
+        continue;
+      }
+      switch (type) {
+        case TYPE_INT:
+          values.emplace_back(type, ParseNumber<int>(token_start, token_end));
+          break;
+        case TYPE_DOUBLE:
+        case TYPE_FLOAT:
+          values.emplace_back(type, ParseNumber<float>(token_start, token_end));
+          break;
+        case TYPE_CHAR:
+        case TYPE_VARCHAR:
+          values.emplace_back(type, std::string(token_start, token_end));
+          break;
+        default:
+          throw InternalError("Unsupported data type.");
+      }
+      (*stats)[i].Add(values.back());
+      // Move to the next token
+      token_start = token_end + 1;
+    }
+    appender.Append(TupleMeta{0, false}, Tuple{values, &tab.schema});
+    line_start = line_end + 1;
+  }
+  // Insert the rows that did not fill a full page
+  appender.Finish();
+  return num_rows;
+}
+
+}  // namespace
+
 /**
  * @description: load data from csv file to table
  * @param file_name
  * @param table_name
  * @param context
- * @note: this function does not create table, just load data to existing table
+ * @note: this function does not create table, just load data to existing table. The file is split at line
+ *        boundaries into chunks of at least LOAD_MIN_CHUNK_SIZE bytes, each parsed by its own thread which packs its
+ *        rows into pages of its own. The indexes of the table are then bulk loaded from the sorted keys of all the
+ *        threads, and the statistics of the threads are merged at the end. A load that fails on a malformed row or a
+ *        duplicate key deletes the rows and index entries it has made, the table is left as it was.
  */
 void SmManager::LoadData(const std::string &file_name, const std::string &table_name, Context *context) {
-  // std::cout << "SmManager::load_data: load data from " << file_name << " to table " << table_name << std::endl;
   // 1. Get the table object
   // check if table exists
   if (!db_.is_table(table_name)) {
@@ -727,208 +1042,144 @@ void SmManager::LoadData(const std::string &file_name, const std::string &table_
   auto fh = fhs_.at(table_name).get();
   size_t col_size = tab.cols.size();
 
-  std::vector<std::string> col_name;
-  for (auto &col : tab.schema.GetColumns()) {
-    col_name.push_back(col.GetName());
-  }
-
   // 2. Open file and create memory mapping
   int fd = open(file_name.c_str(), O_RDONLY);
   if (fd == -1) {
-    close(fd);
     auto current = std::filesystem::current_path();
     auto err_msg =
         "SmManager::load_data: open file failed, please check file relative to current directory: " + current.string();
     throw Exception(err_msg);
   }
   size_t file_size = lseek(fd, 0, SEEK_END);
+  if (file_size == 0) {
+    close(fd);
+    throw InternalError("SmManager::load_data: invalid CSV file");
+  }
   char *data = (char *)mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
   if (data == MAP_FAILED) {
     close(fd);
     throw InternalError("SmManager::load_data: mmap failed");
   }
-
-  // 3. Parse CSV header and validate
-  char *line_start = data;
-  char *line_end = strchr(line_start, '\n');
-  if (line_end == nullptr) {
-    munmap(data, file_size);
-    close(fd);
-    throw InternalError("SmManager::load_data: invalid CSV file");
+  // The file is read front to back by each thread
+  madvise(data, file_size, MADV_SEQUENTIAL);
+  const char *file_end = data + file_size;
+
+  // 3. Split the file at line boundaries, one chunk per thread
+  size_t num_workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+  num_workers = std::max<size_t>(1, std::min(num_workers, file_size / LOAD_MIN_CHUNK_SIZE));
+  std::vector<const char *> bounds{data};
+  for (size_t i = 1; i < num_workers; ++i) {
+    const char *pos = std::max<const char *>(data + file_size * i / num_workers, bounds.back());
+    const char *line_end = static_cast<const char *>(memchr(pos, '\n', file_end - pos));
+    bounds.push_back(line_end == nullptr ? file_end : line_end + 1);
+  }
+  bounds.push_back(file_end);
+
+  // 4. Parse data and append it to the table, in parallel
+  // no context for load data because context may be destroyed before load data finish
+  // when using async load data
+  std::vector<std::vector<ColumnStatsBuilder>> worker_stats(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    for (auto &col : tab.cols) {
+      worker_stats[i].emplace_back(col.type, i);
+    }
   }
-  // std::vector<std::string> header;
-  // Split(line_start, line_end - line_start, '|', header);
-  // // for (int i = 0; i < col_size; ++i) {
-  // //   if (header[i] != tab.cols[i].name) {
-  // //     munmap(data, file_size);
-  // //     close(fd);
-  // //     throw InternalError("SmManager::load_data: header not match table schema");
-  // //   }
-  // // }
-  // line_start = line_end + 1;
-
-  // 4. Parse data and batch insert into table
+  std::vector<std::vector<std::vector<IxEntry>>> worker_entries(
+      num_workers, std::vector<std::vector<IxEntry>>(tab.indexes.size()));
+  std::vector<std::vector<std::pair<page_id_t, size_t>>> worker_pages(num_workers);
+  std::vector<std::future<int>> workers;
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back(std::async(std::launch::async, LoadRows, bounds[i], bounds[i + 1], std::cref(tab), fh,
+                                    &worker_stats[i], &worker_entries[i], &worker_pages[i]));
+  }
+  // Wait for every thread before the file is unmapped, then report the first error
   int total_records = 0;
-  int page_record_count = 0;
-
-  std::unordered_map<std::string, float> attr_max;
-  std::unordered_map<std::string, float> attr_min;
-  std::unordered_map<std::string, float> attr_sum;
-  std::unordered_map<std::string, std::set<float>>
-      attr_distinct;  // 仅统计数值型数据的distinct值，统一转换为double类型，以向低精度兼容。
-
-  // 初始化统计数据结构
-  for (auto &name : col_name) {
-    attr_max.emplace(name, 0);
-    attr_min.emplace(name, ((1 << 31) - 1));
-    attr_sum.emplace(name, 0);
-    std::set<float> set_tp;
-    attr_distinct.emplace(name, set_tp);
-  }
-
-  // int record_size = fh->GetFileHdr().record_size;
-  // int num_records_per_page = fh->get_file_hdr().num_records_per_page;
-  // int page_size = record_size * num_records_per_page;
-  // fh->GetFileHdr()
-  // char *page_data = new char[page_size];
-  // memset(page_data, 0, page_size);
-
-  // Batch data for indexes(just primary key for now)
-  std::vector<std::pair<std::string, RID>> index_entries;
-
-  while (line_start < data + file_size) {
-    line_end = strchr(line_start, '\n');
-    // Last line without \n
-    if (line_end == nullptr) {
-      line_end = data + file_size;
+  std::exception_ptr error;
+  for (auto &worker : workers) {
+    try {
+      total_records += worker.get();
+    } catch (...) {
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
     }
-
-    // Directly parse the line and fill the corresponding slot in page_data
-    std::vector<Value> values;
-    char *token_start = line_start;
-    for (int i = 0; i < col_size; ++i) {
-      char *token_end = std::find(token_start, line_end, '|');
-      // Calculate the destination address in the page buffer
-      // char *dest = page_data + (page_record_count * record_size) + tab.cols[i].offset;
-      // int len = tab.cols[i].len;
-      auto type = tab.cols[i].type;
-      Value _tmp_val;
-      switch (type) {
-        case TYPE_INT: {
-          _tmp_val = Value(type, std::stoi(std::string(token_start, token_end)));
-          float val_tp = std::stoi(std::string(token_start, token_end));
-          if (val_tp > attr_max[col_name[i]]) {
-            attr_max[col_name[i]] = val_tp;
-          }
-          if (val_tp < attr_min[col_name[i]]) {
-            attr_min[col_name[i]] = val_tp;
-          }
-          attr_sum[col_name[i]] += val_tp;
-          attr_distinct[col_name[i]].emplace(val_tp);
-          break;
-        }
-        case TYPE_DOUBLE:
-        case TYPE_FLOAT: {
-          _tmp_val = Value(type, std::stof(std::string(token_start, token_end)));
-          float val_tp = std::stof(std::string(token_start, token_end));
-          if (val_tp > attr_max[col_name[i]]) {
-            attr_max[col_name[i]] = val_tp;
-          }
-          if (val_tp < attr_min[col_name[i]]) {
-            attr_min[col_name[i]] = val_tp;
-          }
-          attr_sum[col_name[i]] += val_tp;
-          attr_distinct[col_name[i]].emplace(val_tp);
-          // *reinterpret_cast<float *>(dest) = std::stof(std::string(token_start, token_end));
-          break;
-        }
-        case TYPE_CHAR:
-        case TYPE_VARCHAR: {
-          // int token_len = token_end - token_start;
-          // if (token_len > len) {
-          //   throw StringOverflowError();
-          // }
-          // memset(dest, 0, len);
-          // memcpy(dest, token_start, token_len);
-          std::string _tmp_str = std::string(token_start, token_end);
-          _tmp_val = Value(type, _tmp_str);
-          break;
+  }
+  munmap(data, file_size);
+  close(fd);
+  auto delete_rows = [&]() {
+    for (auto &pages : worker_pages) {
+      for (auto &[page_no, num_rows] : pages) {
+        for (size_t slot_no = 0; slot_no < num_rows; ++slot_no) {
+          fh->DeleteTuple(RID{page_no, static_cast<slot_id_t>(slot_no)}, nullptr);
         }
-        default:
-          throw InternalError("Unsupported data type.");
       }
-      values.push_back(_tmp_val);
-      // Move to the next token
-      token_start = token_end + 1;
     }
-    // auto _tmp_rid = fh_insert(fh, values, &tab.schema, context);
-
-    // no context for load data because context may be destroyed before load data finish
-    // when using async load data
-    fh_insert(fh, values, &tab.schema, nullptr);
-
-    // // Extract the key for index
-    // for (auto &index : tab.indexes) {
-    //   char *key = new char[index.col_tot_len];
-    //   int offset = 0;
-    //   for (int i = 0; i < index.col_num; ++i) {
-    //     auto val = index.
-    //     // memcpy(key + offset, page_data + (page_record_count * record_size) + index.cols[i].offset,
-    //     // index.cols[i].len); offset += index.cols[i].len;
-    //     memcpy(key + offset, )
-    //   }
-    //   index_entries.emplace_back(std::string(key, index.col_tot_len),
-    //                              RID{fh->get_file_hdr().num_pages, page_record_count});
-    //   delete[] key;
-    // }
-    page_record_count++;
-    line_start = line_end + 1;
-    total_records++;
-
-    // // If the page is full, insert the page and reset the counter
-    // if (page_record_count == num_records_per_page) {
-    //   fh->insert_page(page_data, page_record_count);
-    //   page_record_count = 0;
-    //   memset(page_data, 0, page_size);  // Reset the page buffer
-    // }
+  };
+  if (error != nullptr) {
+    delete_rows();
+    std::rethrow_exception(error);
   }
 
-  // Insert any remaining records that did not fill a full page
-  // if (page_record_count > 0) {
-  //   fh->insert_page(page_data, page_record_count);
-  // }
+  // 5. Build the indexes from the keys of all the threads, bottom-up if the index was empty. On a duplicate key the
+  //    entries of the indexes built before are deleted with the rows, BulkLoad leaves the failed index unchanged
+  std::vector<std::vector<IxEntry>> index_entries(tab.indexes.size());
+  for (size_t i = 0; i < tab.indexes.size(); ++i) {
+    auto &index = tab.indexes[i];
+    std::vector<IxEntry> &entries = index_entries[i];
+    entries = std::move(worker_entries[0][i]);
+    for (size_t w = 1; w < num_workers; ++w) {
+      entries.insert(entries.end(), std::make_move_iterator(worker_entries[w][i].begin()),
+                     std::make_move_iterator(worker_entries[w][i].end()));
+      worker_entries[w][i] = {};
+    }
+    bool loaded;
+    if (index.is_hash) {
+      auto failed = std::find_if_not(entries.begin(), entries.end(), [&](const IxEntry &entry) {
+        return InsertIndexEntry(table_name, index, entry.first.data(), entry.second, nullptr);
+      });
+      loaded = failed == entries.end();
+      for (auto it = entries.begin(); !loaded && it != failed; ++it) {
+        DeleteIndexEntry(table_name, index, it->first.data(), nullptr);
+      }
+    } else {
+      loaded = ihs_.at(ix_manager_->GetIndexName(table_name, index.cols))->BulkLoad(&entries, nullptr);
+    }
+    if (!loaded) {
+      for (size_t j = 0; j < i; ++j) {
+        for (auto &entry : index_entries[j]) {
+          DeleteIndexEntry(table_name, tab.indexes[j], entry.first.data(), nullptr);
+        }
+      }
+      delete_rows();
+      std::vector<std::string> col_names;
+      for (auto &col : index.cols) {
+        col_names.emplace_back(col.name);
+      }
+      throw IndexExistsError(table_name, col_names);
+    }
+  }
 
+  // 6. Merge the statistics of the threads
   SetTableCount(table_name, total_records);
-  for (auto &name : col_name) {
-    if (attr_distinct[name].size() == 0) continue;
-    std::cout << table_name << " " << name << " max = " << attr_max[name] << " " << std::endl;
-    std::cout << table_name << " " << name << " min = " << attr_min[name] << " " << std::endl;
-    std::cout << table_name << " " << name << " sum = " << attr_sum[name] << " " << std::endl;
-    std::cout << table_name << " " << name << " distinct = " << attr_distinct[name].size() << " " << std::endl;
-    SetTableAttrMax(table_name, name, attr_max[name]);
-    SetTableAttrMin(table_name, name, attr_min[name]);
-    SetTableAttrSum(table_name, name, attr_sum[name]);
-    SetTableAttrDistinct(table_name, name, attr_distinct[name].size());
-  }
-
-  // // Sort the index entries and insert them into the index file
-  // for (auto &index : tab.indexes) {
-  //   // std::sort(index_entries.begin(), index_entries.end(), [&](const std::pair<std::string, Rid>& a, const
-  //   // std::pair<std::string, Rid>& b) {
-  //   //     return ix_compare(a.first.c_str(), b.first.c_str(), index.cols) < 0;
-  //   // });
-  //   // Insert the sorted entries into the B+ tree
-  //   auto index_name = ix_manager_->GetIndexName(table_name, index.cols);
-  //   auto ih = ihs_.at(index_name).get();
-  //   ih->build_index_bottom_up(index_entries);
-  // }
+  for (size_t i = 0; i < col_size; ++i) {
+    ColumnStatsBuilder &stats = worker_stats[0][i];
+    for (size_t w = 1; w < num_workers; ++w) {
+      stats.Merge(std::move(worker_stats[w][i]));
+    }
+    const std::string &name = tab.cols[i].name;
+    // COUNT(col) leaves out the NULLs of the column
+    SetTableAttrNullCount(table_name, name, total_records - static_cast<int>(stats.GetCount()));
+    if (stats.GetCount() == 0) continue;
+    // min, max and sum are only kept for numbers, the aggregations read them
+    if (stats.IsNumeric()) {
+      SetTableAttrMax(table_name, name, stats.GetMax());
+      SetTableAttrMin(table_name, name, stats.GetMin());
+      SetTableAttrSum(table_name, name, stats.GetSum());
+    }
+    SetTableAttrDistinct(table_name, name, stats.EstimateDistinct());
+    SetTableAttrHistogram(table_name, name, stats.BuildHistogram());
+  }
   buffer_pool_manager_->FlushAllDirtyPages();
-  // buffer_pool_manager_->FlushAllPages(fd);
-  // 5. Cleanup resources
-  index_entries.clear();
-  // delete[] page_data;
-  munmap(data, file_size);
-  close(fd);
 }
 
 void SmManager::AsyncLoadData(const std::string &file_name, const std::string &tab_name, Context *context) {
@@ -0,0 +1,161 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * sm_stats.cpp
+ *
+ * Identification: src/system/sm_stats.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "system/sm_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "murmur3/MurmurHash3.h"
+
+namespace easydb {
+
+void HyperLogLog::Add(const void *data, int len) {
+  uint64_t hash[2];
+  murmur3::MurmurHash3_x64_128(data, len, 0, hash);
+  // The first bits pick the register, the register keeps the position of the first 1 in the other bits
+  uint64_t index = hash[0] >> (64 - PRECISION);
+  uint64_t rest = hash[0] << PRECISION;
+  uint8_t rank = rest == 0 ? 64 - PRECISION + 1 : __builtin_clzll(rest) + 1;
+  registers_[index] = std::max(registers_[index], rank);
+}
+
+void HyperLogLog::Merge(const HyperLogLog &other) {
+  for (int i = 0; i < NUM_REGISTERS; ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+}
+
+auto HyperLogLog::Estimate() const -> int64_t {
+  constexpr double m = NUM_REGISTERS;
+  constexpr double alpha = 0.7213 / (1 + 1.079 / m);
+  double sum = 0;
+  int num_zeros = 0;
+  for (uint8_t rank : registers_) {
+    sum += std::ldexp(1.0, -rank);
+    num_zeros += rank == 0;
+  }
+  double estimate = alpha * m * m / sum;
+  // Small cardinalities leave many registers empty, linear counting is more accurate there
+  if (estimate <= 2.5 * m && num_zeros > 0) {
+    estimate = m * std::log(m / num_zeros);
+  }
+  return std::llround(estimate);
+}
+
+EquiDepthHistogram::EquiDepthHistogram(std::vector<Value> sample, int num_buckets) {
+  if (sample.empty()) {
+    return;
+  }
+  std::sort(sample.begin(), sample.end(), [](const Value &lhs, const Value &rhs) { return lhs < rhs; });
+  size_t n = sample.size();
+  num_buckets = std::min<int>(num_buckets, n);
+  bounds_.push_back(sample.front());
+  for (int i = 1; i <= num_buckets; ++i) {
+    bounds_.push_back(sample[(n * i + num_buckets - 1) / num_buckets - 1]);
+  }
+}
+
+auto EquiDepthHistogram::EstimateLessThan(const Value &val) const -> double {
+  if (bounds_.empty()) {
+    return 0.5;
+  }
+  if (val <= bounds_.front()) {
+    return 0;
+  }
+  if (val > bounds_.back()) {
+    return 1;
+  }
+  // The first bucket whose upper bound is not less than val
+  auto it = std::lower_bound(bounds_.begin() + 1, bounds_.end(), val,
+                             [](const Value &bound, const Value &target) { return bound < target; });
+  int bucket = static_cast<int>(it - bounds_.begin()) - 1;
+  const Value &lo = bounds_[bucket];
+  const Value &hi = bounds_[bucket + 1];
+  double fraction = 0.5;
+  if (ColumnStatsBuilder::IsNumeric(val.GetTypeId()) && ColumnStatsBuilder::IsNumeric(lo.GetTypeId())) {
+    double lo_val = ColumnStatsBuilder::ToDouble(lo);
+    double hi_val = ColumnStatsBuilder::ToDouble(hi);
+    if (hi_val > lo_val) {
+      fraction = (ColumnStatsBuilder::ToDouble(val) - lo_val) / (hi_val - lo_val);
+    }
+  }
+  return (bucket + fraction) / GetNumBuckets();
+}
+
+void ColumnStatsBuilder::Add(const Value &val) {
+  if (val.IsNull()) {
+    return;
+  }
+  if (IsNumeric()) {
+    double number = ToDouble(val);
+    min_ = count_ == 0 ? number : std::min(min_, number);
+    max_ = count_ == 0 ? number : std::max(max_, number);
+    sum_ += number;
+    distinct_.Add(&number, sizeof(number));
+  } else {
+    distinct_.Add(val.GetData(), val.GetStorageSize());
+  }
+  count_++;
+
+  // Reservoir sampling: the i-th value replaces a random sampled value with probability SAMPLE_SIZE / i
+  if (sample_.size() < SAMPLE_SIZE) {
+    sample_.push_back(val);
+  } else if (uint64_t slot = rng_() % count_; slot < SAMPLE_SIZE) {
+    sample_[slot] = val;
+  }
+}
+
+void ColumnStatsBuilder::Merge(ColumnStatsBuilder &&other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  if (count_ == 0) {
+    min_ = other.min_;
+    max_ = other.max_;
+  } else {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+  sum_ += other.sum_;
+  distinct_.Merge(other.distinct_);
+
+  // Draw the merged sample from both samples, each in proportion to the values it stands for
+  std::shuffle(sample_.begin(), sample_.end(), rng_);
+  std::shuffle(other.sample_.begin(), other.sample_.end(), rng_);
+  size_t size = std::min<size_t>(SAMPLE_SIZE, sample_.size() + other.sample_.size());
+  std::vector<Value> merged;
+  merged.reserve(size);
+  uint64_t left = count_;
+  uint64_t right = other.count_;
+  while (merged.size() < size) {
+    bool take_left = other.sample_.empty() || (!sample_.empty() && rng_() % (left + right) < left);
+    auto &from = take_left ? sample_ : other.sample_;
+    merged.push_back(std::move(from.back()));
+    from.pop_back();
+    (take_left ? left : right)--;
+  }
+  sample_ = std::move(merged);
+  count_ += other.count_;
+}
+
+auto ColumnStatsBuilder::ToDouble(const Value &val) -> double {
+  switch (val.GetTypeId()) {
+    case TYPE_INT:
+      return val.GetAs<int32_t>();
+    case TYPE_LONG:
+      return static_cast<double>(val.GetAs<int64_t>());
+    default:
+      return val.GetAs<double>();
+  }
+}
+
+}  // namespace easydb
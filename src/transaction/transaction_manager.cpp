@@ -14,17 +14,102 @@
  * Copyright (c) 2023 Renmin University of China
  */
 
-
 #include "transaction/transaction_manager.h"
 
+#include <algorithm>
+
 #include "common/context.h"
+#include "common/exception.h"
+#include "record/rm_file_handle.h"
 #include "recovery/log_recovery.h"
 #include "system/sm_manager.h"
 #include "transaction/txn_defs.h"
 
 namespace easydb {
 
-std::unordered_map<txn_id_t, Transaction *> TransactionManager::txn_map = {};
+thread_local std::unordered_map<uint64_t, std::vector<Transaction *>> TransactionManager::session_txns_ = {};
+std::atomic<uint64_t> TransactionManager::next_manager_id_{0};
+
+TransactionManager::~TransactionManager() {
+  for (auto &shard : txn_shards_) {
+    std::scoped_lock lock(shard.latch_);
+    for (auto &[txn_id, txn] : shard.txn_map_) {
+      delete txn;
+    }
+    shard.txn_map_.clear();
+  }
+  // the txns cached by other sessions are never looked up again, manager_id_ is not reused
+  session_txns_.erase(manager_id_);
+}
+
+/**
+ * @description: 把事务加入全局事务表，并记录到当前会话中
+ * @param {Transaction*} txn 事务指针
+ */
+void TransactionManager::RegisterTxn(Transaction *txn) {
+  auto &shard = GetShard(txn->GetTransactionId());
+  {
+    std::scoped_lock lock(shard.latch_);
+    shard.txn_map_[txn->GetTransactionId()] = txn;
+  }
+  auto &session_txns = SessionTxns();
+  if (txn->GetThreadId() == std::this_thread::get_id() &&
+      std::find(session_txns.begin(), session_txns.end(), txn) == session_txns.end()) {
+    session_txns.push_back(txn);
+  }
+}
+
+/**
+ * @description: 把事务从全局事务表中移除并释放事务对象
+ * @param {Transaction*} txn 事务指针，必须由当前会话开启
+ */
+void TransactionManager::ReclaimTxn(Transaction *txn) {
+  auto &shard = GetShard(txn->GetTransactionId());
+  {
+    std::scoped_lock lock(shard.latch_);
+    shard.txn_map_.erase(txn->GetTransactionId());
+  }
+  delete txn;
+}
+
+/**
+ * @description: 获取事务ID为txn_id的事务对象
+ * @return {Transaction*} 事务对象的指针
+ * @param {txn_id_t} txn_id 事务ID
+ */
+Transaction *TransactionManager::GetTransaction(txn_id_t txn_id) {
+  if (txn_id == INVALID_TXN_ID) return nullptr;
+
+  // Fast path: the txn is almost always owned by the calling session
+  for (auto *txn : SessionTxns()) {
+    if (txn->GetTransactionId() == txn_id) {
+      return txn;
+    }
+  }
+
+  auto &shard = GetShard(txn_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto iter = shard.txn_map_.find(txn_id);
+  assert(iter != shard.txn_map_.end());
+  auto *res = iter->second;
+  lock.unlock();
+  assert(res != nullptr);
+  assert(res->GetThreadId() == std::this_thread::get_id());
+
+  return res;
+}
+
+/**
+ * @description: 释放当前会话开启的所有事务，连接断开时调用
+ * @param {std::thread::id} thread_id 会话所在线程，只能是当前线程
+ */
+void TransactionManager::ReleaseTxnOfThread([[maybe_unused]] std::thread::id thread_id) {
+  assert(thread_id == std::this_thread::get_id());
+  for (auto *txn : SessionTxns()) {
+    ReclaimTxn(txn);
+  }
+  session_txns_.erase(manager_id_);
+}
 
 /**
  * @description: 事务的开始方法
@@ -39,8 +124,6 @@ Transaction *TransactionManager::Begin(Transaction *txn, LogManager *log_manager
   // 3. 把开始事务加入到全局事务表中
   // 4. 返回当前事务指针
 
-  std::scoped_lock lock(latch_);
-
   // 1. Check if txn is null
   if (txn == nullptr) {
     // 2. Create new transaction if txn is null
@@ -49,10 +132,23 @@ Transaction *TransactionManager::Begin(Transaction *txn, LogManager *log_manager
     // Assign a start timestamp
     txn->SetStartTs(next_timestamp_.fetch_add(1));
     txn->SetState(TransactionState::DEFAULT);
+    txn->SetConcurrencyMode(concurrency_mode_.load());
+  }
+
+  // Finished txns of this session are no longer referenced, reclaim them before starting a new one
+  auto &session_txns = SessionTxns();
+  for (auto iter = session_txns.begin(); iter != session_txns.end();) {
+    auto state = (*iter)->GetState();
+    if (*iter != txn && (state == TransactionState::COMMITTED || state == TransactionState::ABORTED)) {
+      ReclaimTxn(*iter);
+      iter = session_txns.erase(iter);
+    } else {
+      ++iter;
+    }
   }
 
   // 3. Add transaction to global transaction map
-  txn_map[txn->GetTransactionId()] = txn;
+  RegisterTxn(txn);
 
   // 4. Log the transaction begin
   BeginLogRecord begin_log_record(txn->GetTransactionId());
@@ -62,10 +158,36 @@ Transaction *TransactionManager::Begin(Transaction *txn, LogManager *log_manager
   return txn;
 }
 
+/**
+ * @description: OCC事务提交前的验证：事务读到的每条记录都没有被其他事务修改，且没有被其他事务写锁定
+ * @return {bool} 验证是否通过
+ * @param {Transaction*} txn 需要验证的事务，此时事务已持有其写集合中所有记录的排他锁
+ * @note 事务自己写过的记录在加排他锁时已经验证过（见RmFileHandle::CheckReadBeforeWrite），不在读集合中；
+ *       读过的表的IS锁此时还未释放，表不会被删除
+ */
+bool TransactionManager::ValidateReadSet(Transaction *txn) {
+  for (auto &[lock_data_id, read_record] : *txn->GetReadSet()) {
+    // Check the lock first: a writer that commits between the two checks bumps the version
+    if (lock_manager_->IsExclusiveLockedByOthers(txn, read_record.rid_, lock_data_id.fd_)) {
+      return false;
+    }
+    try {
+      if (read_record.fh_->GetTupleMeta(read_record.rid_, nullptr) != read_record.meta_) {
+        return false;
+      }
+    } catch (Exception &e) {
+      // the record has been deleted and its slot truncated by VACUUM
+      return false;
+    }
+  }
+  return true;
+}
+
 /**
  * @description: 事务的提交方法
  * @param {Transaction*} txn 需要提交的事务
  * @param {LogManager*} log_manager 日志管理器指针
+ * @throws TransactionAbortException OCC事务验证失败，调用者需要回滚该事务
  * @todo 提交写操作
  */
 void TransactionManager::Commit(Transaction *txn, LogManager *log_manager) {
@@ -78,15 +200,28 @@ void TransactionManager::Commit(Transaction *txn, LogManager *log_manager) {
 
   // std::scoped_lock lock(latch_);
 
+  // 0. OCC: validate the read set while still holding the write locks
+  if (txn->IsOptimistic()) {
+    if (!ValidateReadSet(txn)) {
+      lock_manager_->RecordAbort(AbortReason::VALIDATION_FAILED);
+      throw TransactionAbortException(txn->GetTransactionId(), AbortReason::VALIDATION_FAILED);
+    }
+    txn->GetReadSet()->clear();
+  }
+
   // Log the commit
   CommitLogRecord commit_log_record(txn->GetTransactionId(), txn->GetPrevLsn());
   lsn_t lsn = log_manager->add_log_to_buffer(&commit_log_record);
   txn->SetPrevLsn(lsn);
 
   // 1. Commit all uncommitted write operations
+  std::vector<std::pair<std::string, page_id_t>> freed_pages;
   for (auto write_record : *txn->GetWriteSet()) {
     // // TODO: Commit the write operation
     // std::cout << "Committing write operation: " << write_record->GetWriteType() << std::endl;
+    if (write_record->GetWriteType() == WType::DELETE_TUPLE) {
+      freed_pages.emplace_back(write_record->GetTableName(), write_record->GetRid().GetPageId());
+    }
     delete write_record;
   }
   txn->GetWriteSet()->clear();
@@ -106,6 +241,9 @@ void TransactionManager::Commit(Transaction *txn, LogManager *log_manager) {
   // 4. Flush the log to disk
   log_manager->flush_log_to_disk();
 
+  // The deleted slots can be reused or vacuumed once their locks are released and the commit is durable
+  UpdateFreeSpace(freed_pages, log_manager);
+
   // 5. Update transaction state
   txn->SetState(TransactionState::COMMITTED);
 }
@@ -133,10 +271,14 @@ void TransactionManager::Abort(Transaction *txn, LogManager *log_manager) {
   // 1. Rollback all write operations
   Context *context = new Context(lock_manager_, log_manager, txn, nullptr, 0);
   // Backward scanning
+  std::vector<std::pair<std::string, page_id_t>> freed_pages;
   auto write_set = txn->GetWriteSet();
   while (!write_set->empty()) {
     auto write_record = write_set->back();
     sm_manager_->Rollback(write_record, context);
+    if (write_record->GetWriteType() == WType::INSERT_TUPLE) {
+      freed_pages.emplace_back(write_record->GetTableName(), write_record->GetRid().GetPageId());
+    }
     write_set->pop_back();
     delete write_record;
   }
@@ -153,14 +295,39 @@ void TransactionManager::Abort(Transaction *txn, LogManager *log_manager) {
   // txn->GetLockSet()->clear();
   txn->GetIndexLatchPageSet()->clear();
   txn->GetIndexDeletedPageSet()->clear();
+  txn->GetReadSet()->clear();
 
   // 4. Flush the log to disk
   log_manager->flush_log_to_disk();
 
+  // The slots of the rolled back inserts can be reused or vacuumed once their locks are released
+  UpdateFreeSpace(freed_pages, log_manager);
+
   // 5. Update transaction state
   txn->SetState(TransactionState::ABORTED);
 }
 
+/**
+ * @description: 事务结束后更新其删除的记录所在页面在空闲空间映射中的空闲空间，
+ *               开启自动VACUUM时，已删除记录的比例超过AUTO_VACUUM_THRESHOLD的页面会被整理
+ * @param {vector<pair<string, page_id_t>>&} freed_pages 有记录被删除的页面（表名，页面号），可以重复
+ * @param {LogManager*} log_manager 日志管理器指针
+ */
+void TransactionManager::UpdateFreeSpace(std::vector<std::pair<std::string, page_id_t>> &freed_pages,
+                                         LogManager *log_manager) {
+  std::sort(freed_pages.begin(), freed_pages.end());
+  freed_pages.erase(std::unique(freed_pages.begin(), freed_pages.end()), freed_pages.end());
+  bool auto_vacuum = enable_auto_vacuum_.load();
+  for (auto &[tab_name, page_no] : freed_pages) {
+    auto *fh = sm_manager_->fhs_.at(tab_name).get();
+    if (auto_vacuum) {
+      fh->VacuumPage(page_no, lock_manager_, log_manager, AUTO_VACUUM_THRESHOLD);
+    } else {
+      fh->UpdateFreeSpace(page_no);
+    }
+  }
+}
+
 void TransactionManager::CreateStaticCheckpoint(Transaction *txn, LogManager *log_manager) {
   // std::cout << "Creating static checkpoint" << std::endl;
 
@@ -415,13 +415,13 @@ TEST(EasyDBTest, SimpleTest) {
       for (int i = 0; i < index_meta.col_num; ++i) {
         // memcpy(key + offset, rec->data + index_meta.cols[i].offset, index_meta.cols[i].len);
         auto val = key_tuple.GetValue(&key_schema, i);
-        memcpy(key + offset, val.GetData(), val.GetStorageSize());
+        ix_memcpy(key + offset, val, index_meta.cols[i].len);
         if (!flag) {
           flag = true;
           delete_key = new char[index_meta.col_tot_len];
           delete_rid = rid;
           // memcpy(delete_key + offset, rec->data + index_meta.cols[i].offset, index_meta.cols[i].len);
-          memcpy(delete_key + offset, val.GetData(), val.GetStorageSize());
+          ix_memcpy(delete_key + offset, val, index_meta.cols[i].len);
         }
         offset += index_meta.cols[i].len;
       }
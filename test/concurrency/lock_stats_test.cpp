@@ -0,0 +1,88 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * lock_stats_test.cpp
+ *
+ * Identification: test/concurrency/lock_stats_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "concurrency/lock_manager.h"
+#include "gtest/gtest.h"
+
+namespace easydb {
+
+const int TEST_TAB_FD = 3;
+
+LockManager::LockModeStats GetStats(LockManager &lock_manager, const std::string &mode) {
+  for (auto &[name, stats] : lock_manager.GetModeStats()) {
+    if (name == mode) {
+      return stats;
+    }
+  }
+  return {};
+}
+
+// NOLINTNEXTLINE
+TEST(LockStatsTest, WaitAndDie) {
+  LockManager lock_manager;
+  Transaction older(0);
+  Transaction younger(1);
+  RID rid{1, 0};
+
+  // the younger txn dies when it requests a lock held by the older one
+  ASSERT_TRUE(lock_manager.LockExclusiveOnRecord(&older, rid, TEST_TAB_FD));
+  EXPECT_THROW(lock_manager.LockSharedOnRecord(&younger, rid, TEST_TAB_FD), TransactionAbortException);
+  ASSERT_TRUE(lock_manager.Unlock(&older, LockDataId(TEST_TAB_FD, rid, LockDataType::RECORD)));
+
+  // the older txn waits for the younger one
+  Transaction youngest(2);
+  ASSERT_TRUE(lock_manager.LockExclusiveOnRecord(&youngest, rid, TEST_TAB_FD));
+  std::thread holder([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    lock_manager.Unlock(&youngest, LockDataId(TEST_TAB_FD, rid, LockDataType::RECORD));
+  });
+  Transaction waiter(-1);  // older than the holder, so it waits
+  ASSERT_TRUE(lock_manager.LockExclusiveOnRecord(&waiter, rid, TEST_TAB_FD));
+  holder.join();
+
+  auto shared = GetStats(lock_manager, "S");
+  EXPECT_EQ(shared.requests_, 1);
+  EXPECT_EQ(shared.dies_, 1);
+  EXPECT_EQ(shared.waits_, 0);
+
+  auto exclusive = GetStats(lock_manager, "X");
+  EXPECT_EQ(exclusive.requests_, 3);
+  EXPECT_EQ(exclusive.dies_, 0);
+  EXPECT_EQ(exclusive.waits_, 1);
+  EXPECT_GE(exclusive.wait_time_us_, 10000);
+  EXPECT_EQ(exclusive.max_wait_time_us_, exclusive.wait_time_us_);
+  uint64_t histogram_total = 0;
+  for (auto count : exclusive.wait_histogram_) {
+    histogram_total += count;
+  }
+  EXPECT_EQ(histogram_total, 1);
+
+  for (auto &[reason, count] : lock_manager.GetAbortStats()) {
+    EXPECT_EQ(count, reason == "DEADLOCK_PREVENTION" ? 1 : 0);
+  }
+
+  auto hot_locks = lock_manager.GetHotLocks(LOCK_STATS_TOP_N);
+  ASSERT_EQ(hot_locks.size(), 1);
+  EXPECT_EQ(hot_locks[0].lock_data_id_, LockDataId(TEST_TAB_FD, rid, LockDataType::RECORD));
+  EXPECT_EQ(hot_locks[0].waits_, 1);
+  EXPECT_EQ(hot_locks[0].dies_, 1);
+
+  auto locks = lock_manager.GetLocks();
+  ASSERT_EQ(locks.size(), 1);
+  EXPECT_EQ(locks[0].txn_id_, waiter.GetTransactionId());
+  EXPECT_EQ(locks[0].lock_mode_, "X");
+}
+
+}  // namespace easydb
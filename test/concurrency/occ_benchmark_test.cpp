@@ -0,0 +1,146 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * occ_benchmark_test.cpp
+ *
+ * Identification: test/concurrency/occ_benchmark_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+// Compare 2PL (wait-die) with OCC under different contention levels.
+// Every txn reads two accounts and moves 1 from one to the other, so the total balance is an invariant
+// that only holds if both modes are serializable.
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/context.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "system/sm_manager_test.hpp"
+#include "transaction/transaction_manager.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "occ_bench.easydb";
+const std::string TEST_TB_NAME = "account";
+const int NUM_ACCOUNTS = 1024;
+const int INIT_BALANCE = 100;
+const int NUM_THREADS = 4;
+const int TXNS_PER_THREAD = 2000;
+
+class OccBenchmarkTest : public SmManagerTest {
+ protected:
+  OccBenchmarkTest() : SmManagerTest(TEST_DB_NAME, TEST_TB_NAME) {}
+
+  void SetUp() override {
+    SmManagerTest::SetUp();
+    lock_manager_ = std::make_unique<LockManager>();
+    log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
+    txn_manager_ = std::make_unique<TransactionManager>(lock_manager_.get(), sm_manager_.get());
+
+    sm_manager_->CreateTable(TEST_TB_NAME, {{"id", TYPE_INT, sizeof(int)}, {"balance", TYPE_INT, sizeof(int)}},
+                             nullptr);
+    fh_ = sm_manager_->fhs_.at(TEST_TB_NAME).get();
+    schema_ = &sm_manager_->db_.get_table(TEST_TB_NAME).schema;
+    for (int i = 0; i < NUM_ACCOUNTS; ++i) {
+      Tuple tuple{{Value(TYPE_INT, i), Value(TYPE_INT, INIT_BALANCE)}, schema_};
+      rids_.push_back(*fh_->InsertTuple(TupleMeta{0, false}, tuple, nullptr));
+    }
+  }
+
+  /* 转账事务：读两个账户，从from转1到to。返回事务是否提交 */
+  bool Transfer(int from, int to) {
+    auto *txn = txn_manager_->Begin(nullptr, log_manager_.get());
+    Context context(lock_manager_.get(), log_manager_.get(), txn);
+    try {
+      int from_balance = fh_->GetTupleValue(rids_[from], &context)->GetValue(schema_, 1).GetAs<int>();
+      int to_balance = fh_->GetTupleValue(rids_[to], &context)->GetValue(schema_, 1).GetAs<int>();
+      MoveBalance(txn, &context, from, from_balance - 1);
+      MoveBalance(txn, &context, to, to_balance + 1);
+      txn_manager_->Commit(txn, log_manager_.get());
+      return true;
+    } catch (TransactionAbortException &e) {
+      txn_manager_->Abort(txn, log_manager_.get());
+      return false;
+    }
+  }
+
+  /* 同UpdateExecutor：先加排他锁再读取回滚用的旧记录，然后原地更新 */
+  void MoveBalance(Transaction *txn, Context *context, int account, int balance) {
+    lock_manager_->LockExclusiveOnRecord(txn, rids_[account], fh_->GetFd());
+    auto old_tuple = fh_->GetTupleValue(rids_[account], context);
+    Tuple new_tuple{{Value(TYPE_INT, account), Value(TYPE_INT, balance)}, schema_};
+    fh_->UpdateTupleInPlace(TupleMeta{txn->GetWriteVersion(), false}, new_tuple, rids_[account], context);
+    txn->AppendWriteRecord(new WriteRecord(WType::UPDATE_TUPLE, TEST_TB_NAME, rids_[account], *old_tuple));
+  }
+
+  /* 在前hot_accounts个账户上并发执行转账，打印吞吐量和回滚率 */
+  void RunWorkload(ConcurrencyMode mode, int hot_accounts) {
+    txn_manager_->SetConcurrencyMode(mode);
+    std::atomic<int> committed{0};
+    std::atomic<int> aborted{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+      workers.emplace_back([&, t]() {
+        std::mt19937 rng(t);
+        std::uniform_int_distribution<int> dist(0, hot_accounts - 1);
+        for (int i = 0; i < TXNS_PER_THREAD; ++i) {
+          int from = dist(rng);
+          int to = dist(rng);
+          if (from == to) {
+            to = (to + 1) % hot_accounts;
+          }
+          Transfer(from, to) ? ++committed : ++aborted;
+        }
+        txn_manager_->ReleaseTxnOfThread(std::this_thread::get_id());
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::left << std::setw(6) << (mode == ConcurrencyMode::OPTIMISTIC ? "OCC" : "2PL")
+              << " hot=" << std::setw(6) << hot_accounts << " commit/s=" << std::setw(10)
+              << static_cast<int>(committed / seconds) << " abort rate="
+              << static_cast<double>(aborted) / (committed + aborted) << std::endl;
+
+    EXPECT_EQ(TotalBalance(), NUM_ACCOUNTS * INIT_BALANCE);
+  }
+
+  int TotalBalance() {
+    int total = 0;
+    for (auto &rid : rids_) {
+      total += fh_->GetTupleValue(rid, nullptr)->GetValue(schema_, 1).GetAs<int>();
+    }
+    return total;
+  }
+
+  std::unique_ptr<LockManager> lock_manager_;
+  std::unique_ptr<LogManager> log_manager_;
+  std::unique_ptr<TransactionManager> txn_manager_;
+  RmFileHandle *fh_;
+  Schema *schema_;
+  std::vector<RID> rids_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(OccBenchmarkTest, TransferUnderContention) {
+  for (int hot_accounts : {NUM_ACCOUNTS, 64, 8}) {
+    RunWorkload(ConcurrencyMode::TWO_PHASE_LOCKING, hot_accounts);
+    RunWorkload(ConcurrencyMode::OPTIMISTIC, hot_accounts);
+  }
+}
+
+}  // namespace easydb
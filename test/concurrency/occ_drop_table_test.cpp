@@ -0,0 +1,112 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * occ_drop_table_test.cpp
+ *
+ * Identification: test/concurrency/occ_drop_table_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "common/context.h"
+#include "execution/executor_seq_scan.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "system/sm_manager_test.hpp"
+#include "transaction/transaction_manager.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "occ_drop_table_test.easydb";
+const std::string TEST_TB_NAME = "item";
+
+class OccDropTableTest : public SmManagerTest {
+ protected:
+  OccDropTableTest() : SmManagerTest(TEST_DB_NAME, TEST_TB_NAME) {}
+
+  void SetUp() override {
+    SmManagerTest::SetUp();
+    lock_manager_ = std::make_unique<LockManager>();
+    log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
+    txn_manager_ = std::make_unique<TransactionManager>(lock_manager_.get(), sm_manager_.get());
+
+    sm_manager_->CreateTable(TEST_TB_NAME, {{"id", TYPE_INT, sizeof(int)}}, nullptr);
+    auto *fh = sm_manager_->fhs_.at(TEST_TB_NAME).get();
+    auto *schema = &sm_manager_->db_.get_table(TEST_TB_NAME).schema;
+    for (int i = 0; i < 100; ++i) {
+      fh->InsertTuple(TupleMeta{0, false}, Tuple{{Value(TYPE_INT, i)}, schema}, nullptr);
+    }
+  }
+
+  void TearDown() override {
+    txn_manager_->ReleaseTxnOfThread(std::this_thread::get_id());
+    SmManagerTest::TearDown();
+  }
+
+  /** @return the number of rows scanned; an OCC txn puts every row it scans into its read set */
+  auto ScanAll(Context *context) -> int {
+    SeqScanExecutor scan(sm_manager_.get(), TEST_TB_NAME, {}, context);
+    int count = 0;
+    for (scan.beginTuple(); !scan.IsEnd(); scan.nextTuple()) {
+      count++;
+    }
+    return count;
+  }
+
+  std::unique_ptr<LockManager> lock_manager_;
+  std::unique_ptr<LogManager> log_manager_;
+  std::unique_ptr<TransactionManager> txn_manager_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(OccDropTableTest, DropWaitsForOccCommit) {
+  // an older 2PL txn drops the table after an OCC txn has read it
+  auto *drop_txn = txn_manager_->Begin(nullptr, log_manager_.get());
+  Context drop_context(lock_manager_.get(), log_manager_.get(), drop_txn);
+  txn_manager_->SetConcurrencyMode(ConcurrencyMode::OPTIMISTIC);
+  auto *occ_txn = txn_manager_->Begin(nullptr, log_manager_.get());
+  Context occ_context(lock_manager_.get(), log_manager_.get(), occ_txn);
+  ASSERT_EQ(ScanAll(&occ_context), 100);
+  ASSERT_FALSE(occ_txn->GetReadSet()->empty());
+
+  // the IS lock of the OCC txn keeps the file handle in its read set open until it has been validated
+  std::atomic<bool> dropped{false};
+  std::thread dropper([&]() {
+    sm_manager_->DropTable(TEST_TB_NAME, &drop_context);
+    dropped = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(dropped);
+  EXPECT_NO_THROW(txn_manager_->Commit(occ_txn, log_manager_.get()));
+  dropper.join();
+  EXPECT_TRUE(dropped);
+  EXPECT_FALSE(sm_manager_->db_.is_table(TEST_TB_NAME));
+  txn_manager_->Commit(drop_txn, log_manager_.get());
+}
+
+// NOLINTNEXTLINE
+TEST_F(OccDropTableTest, YoungerDropDies) {
+  // a younger txn that drops the table read by an OCC txn dies instead of waiting
+  txn_manager_->SetConcurrencyMode(ConcurrencyMode::OPTIMISTIC);
+  auto *occ_txn = txn_manager_->Begin(nullptr, log_manager_.get());
+  Context occ_context(lock_manager_.get(), log_manager_.get(), occ_txn);
+  ASSERT_EQ(ScanAll(&occ_context), 100);
+
+  txn_manager_->SetConcurrencyMode(ConcurrencyMode::TWO_PHASE_LOCKING);
+  auto *drop_txn = txn_manager_->Begin(nullptr, log_manager_.get());
+  Context drop_context(lock_manager_.get(), log_manager_.get(), drop_txn);
+  EXPECT_THROW(sm_manager_->DropTable(TEST_TB_NAME, &drop_context), TransactionAbortException);
+  txn_manager_->Abort(drop_txn, log_manager_.get());
+  EXPECT_TRUE(sm_manager_->db_.is_table(TEST_TB_NAME));
+
+  EXPECT_NO_THROW(txn_manager_->Commit(occ_txn, log_manager_.get()));
+}
+
+}  // namespace easydb
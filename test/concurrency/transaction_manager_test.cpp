@@ -0,0 +1,53 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * transaction_manager_test.cpp
+ *
+ * Identification: test/concurrency/transaction_manager_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "concurrency/lock_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "transaction/transaction_manager.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "transaction_manager_test.easydb";
+
+// NOLINTNEXTLINE
+TEST(TransactionManagerTest, SessionCacheOfManyManagers) {
+  std::filesystem::remove_all(TEST_DB_NAME);
+  auto disk_manager = std::make_unique<DiskManager>(TEST_DB_NAME);
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LockManager lock_manager;
+
+  // two managers alive at the same time hand out the same txn ids, each one finds its own txns
+  auto first = std::make_unique<TransactionManager>(&lock_manager, nullptr);
+  auto second = std::make_unique<TransactionManager>(&lock_manager, nullptr);
+  auto *first_txn = first->Begin(nullptr, log_manager.get());
+  auto *second_txn = second->Begin(nullptr, log_manager.get());
+  ASSERT_EQ(first_txn->GetTransactionId(), second_txn->GetTransactionId());
+  EXPECT_EQ(first->GetTransaction(first_txn->GetTransactionId()), first_txn);
+  EXPECT_EQ(second->GetTransaction(second_txn->GetTransactionId()), second_txn);
+
+  // a manager created after another one is destroyed does not see the freed txns of the session
+  first.reset();
+  second.reset();
+  auto third = std::make_unique<TransactionManager>(&lock_manager, nullptr);
+  auto *third_txn = third->Begin(nullptr, log_manager.get());
+  EXPECT_EQ(third->GetTransaction(third_txn->GetTransactionId()), third_txn);
+  third->ReleaseTxnOfThread(std::this_thread::get_id());
+
+  std::filesystem::remove_all(TEST_DB_NAME);
+}
+
+}  // namespace easydb
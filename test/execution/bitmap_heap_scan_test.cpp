@@ -0,0 +1,103 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * bitmap_heap_scan_test.cpp
+ *
+ * Identification: test/execution/bitmap_heap_scan_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "execution/executor_bitmap_heap_scan.h"
+#include "gtest/gtest.h"
+#include "system/sm_manager_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "bitmap_heap_scan_test.easydb";
+const std::string TEST_TB_NAME = "item";
+const std::string TEST_CSV_NAME = "item.tbl";
+
+class BitmapHeapScanTest : public SmManagerTest {
+ protected:
+  BitmapHeapScanTest() : SmManagerTest(TEST_DB_NAME, TEST_TB_NAME) {}
+
+  void SetUp() override {
+    SmManagerTest::SetUp();
+    sm_manager_->CreateTable(
+        TEST_TB_NAME, {{"id", TYPE_INT, sizeof(int)}, {"grp", TYPE_INT, sizeof(int)}, {"name", TYPE_CHAR, 16}},
+        nullptr);
+    sm_manager_->CreateIndex(TEST_TB_NAME, {"id"}, nullptr);
+    sm_manager_->CreateIndex(TEST_TB_NAME, {"grp", "id"}, nullptr);
+    // the ids are scattered over the heap, so that the index order is not the heap order
+    std::ofstream csv(TEST_CSV_NAME);
+    for (int i = 0; i < NUM_ROWS; ++i) {
+      int id = (i * 7919) % NUM_ROWS;
+      csv << id << "|" << id % 10 << "|item" << id % 3 << "|\n";
+    }
+    csv.close();
+    sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr);
+  }
+
+  /** @return the ids of the rows scanned, checking that the rids come in the order of the heap */
+  auto Scan(const std::vector<Condition> &conds, const std::vector<std::vector<std::string>> &index_col_names)
+      -> std::vector<int> {
+    BitmapHeapScanExecutor scan(sm_manager_.get(), TEST_TB_NAME, conds, index_col_names, nullptr);
+    const auto &schema = scan.schema();
+    std::vector<int> ids;
+    RID prev;
+    for (scan.beginTuple(); !scan.IsEnd(); scan.nextTuple()) {
+      EXPECT_TRUE(ids.empty() || prev < scan.rid());
+      prev = scan.rid();
+      ids.push_back(scan.Next()->GetValue(&schema, 0).GetAs<int>());
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+  }
+
+  static constexpr int NUM_ROWS = 10000;
+};
+
+// NOLINTNEXTLINE
+TEST_F(BitmapHeapScanTest, RangeOfOneIndex) {
+  // every row of the range once, read page by page
+  auto ids = Scan({MakeCond("id", OP_GE, Value(TYPE_INT, 1000)), MakeCond("id", OP_LT, Value(TYPE_INT, 3000))},
+                  {{"id"}});
+  ASSERT_EQ(static_cast<int>(ids.size()), 2000);
+  for (int i = 0; i < 2000; ++i) {
+    ASSERT_EQ(ids[i], 1000 + i);
+  }
+
+  // the conditions on the columns out of the index are checked on the tuples
+  ids = Scan({MakeCond("id", OP_LE, Value(TYPE_INT, 99)), MakeCond("name", OP_EQ, Value(TYPE_CHAR, "item1"))},
+             {{"id"}});
+  ASSERT_EQ(static_cast<int>(ids.size()), 33);
+  EXPECT_EQ(ids.front(), 1);
+  EXPECT_EQ(ids.back(), 97);
+
+  // an empty range
+  EXPECT_TRUE(Scan({MakeCond("id", OP_GT, Value(TYPE_INT, NUM_ROWS))}, {{"id"}}).empty());
+}
+
+// NOLINTNEXTLINE
+TEST_F(BitmapHeapScanTest, AndOfTwoIndexes) {
+  // the rids of id < 5000 and of grp = 3 are intersected before the heap is read
+  std::vector<Condition> conds{MakeCond("id", OP_LT, Value(TYPE_INT, 5000)),
+                               MakeCond("grp", OP_EQ, Value(TYPE_INT, 3))};
+  auto ids = Scan(conds, {{"id"}, {"grp", "id"}});
+  ASSERT_EQ(static_cast<int>(ids.size()), 500);
+  for (int i = 0; i < 500; ++i) {
+    ASSERT_EQ(ids[i], 10 * i + 3);
+  }
+  // the same rows from either index alone
+  EXPECT_EQ(Scan(conds, {{"grp", "id"}}), ids);
+  EXPECT_EQ(Scan(conds, {{"id"}}), ids);
+}
+
+}  // namespace easydb
@@ -0,0 +1,119 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * hash_index_scan_test.cpp
+ *
+ * Identification: test/execution/hash_index_scan_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "execution/executor_hash_index_scan.h"
+#include "gtest/gtest.h"
+#include "system/sm_manager_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "hash_index_scan_test.easydb";
+const std::string TEST_TB_NAME = "item";
+const std::string TEST_CSV_NAME = "item.tbl";
+
+class HashIndexScanTest : public SmManagerTest {
+ protected:
+  HashIndexScanTest() : SmManagerTest(TEST_DB_NAME, TEST_TB_NAME) {}
+
+  void SetUp() override {
+    SmManagerTest::SetUp();
+    sm_manager_->CreateTable(
+        TEST_TB_NAME, {{"id", TYPE_INT, sizeof(int)}, {"grp", TYPE_INT, sizeof(int)}, {"name", TYPE_CHAR, 16}},
+        nullptr);
+    // one index is built from the rows of the table, the other one while the rows are loaded
+    std::ofstream csv(TEST_CSV_NAME);
+    for (int i = 0; i < NUM_ROWS; ++i) {
+      csv << i << "|" << i % 10 << "|item" << i % 3 << "|\n";
+    }
+    csv.close();
+    sm_manager_->CreateIndex(TEST_TB_NAME, {"grp", "id"}, nullptr, {}, true);
+    sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr);
+    sm_manager_->CreateIndex(TEST_TB_NAME, {"id"}, nullptr, {}, true);
+  }
+
+  static auto MakeKey(int key) -> std::string {
+    std::string buf(sizeof(int), '\0');
+    ix_memcpy(buf.data(), Value(TYPE_INT, key), sizeof(int));
+    return buf;
+  }
+
+  /** @return the ids of the rows scanned */
+  auto Scan(const std::vector<Condition> &conds, const std::vector<std::string> &index_col_names)
+      -> std::vector<int> {
+    HashIndexScanExecutor scan(sm_manager_.get(), TEST_TB_NAME, conds, index_col_names, nullptr);
+    const auto &schema = scan.schema();
+    std::vector<int> ids;
+    for (scan.beginTuple(); !scan.IsEnd(); scan.nextTuple()) {
+      ids.push_back(scan.Next()->GetValue(&schema, 0).GetAs<int>());
+    }
+    return ids;
+  }
+
+  static constexpr int NUM_ROWS = 10000;
+};
+
+// NOLINTNEXTLINE
+TEST_F(HashIndexScanTest, PointLookup) {
+  for (int id = 0; id < NUM_ROWS; id += 97) {
+    ASSERT_EQ(Scan({MakeCond("id", OP_EQ, Value(TYPE_INT, id))}, {"id"}), std::vector<int>{id});
+  }
+  // a key of two columns, given in any order
+  EXPECT_EQ(Scan({MakeCond("id", OP_EQ, Value(TYPE_INT, 1234)), MakeCond("grp", OP_EQ, Value(TYPE_INT, 4))},
+                 {"grp", "id"}),
+            std::vector<int>{1234});
+  EXPECT_TRUE(Scan({MakeCond("id", OP_EQ, Value(TYPE_INT, 1234)), MakeCond("grp", OP_EQ, Value(TYPE_INT, 5))},
+                   {"grp", "id"})
+                  .empty());
+  // the conditions on the columns out of the index are checked on the tuple
+  EXPECT_EQ(Scan({MakeCond("id", OP_EQ, Value(TYPE_INT, 4)), MakeCond("name", OP_EQ, Value(TYPE_CHAR, "item1"))},
+                 {"id"}),
+            std::vector<int>{4});
+  EXPECT_TRUE(Scan({MakeCond("id", OP_EQ, Value(TYPE_INT, 4)), MakeCond("name", OP_NE, Value(TYPE_CHAR, "item1"))},
+                   {"id"})
+                  .empty());
+  // a missing key
+  EXPECT_TRUE(Scan({MakeCond("id", OP_EQ, Value(TYPE_INT, NUM_ROWS))}, {"id"}).empty());
+}
+
+// NOLINTNEXTLINE
+TEST_F(HashIndexScanTest, UniqueAndReopen) {
+  // the keys of a hash index are unique like the keys of a B+ tree index
+  EXPECT_THROW(sm_manager_->CreateIndex(TEST_TB_NAME, {"grp"}, nullptr, {}, true), IndexExistsError);
+  EXPECT_FALSE(sm_manager_->db_.get_table(TEST_TB_NAME).is_index({"grp"}));
+  // a hash index has no room for INCLUDE columns
+  EXPECT_THROW(sm_manager_->CreateIndex(TEST_TB_NAME, {"name"}, nullptr, {"grp"}, true), InternalError);
+
+  // the indexes are written back when the database is closed and opened again with it
+  auto index_name = ix_manager_->GetIndexName(TEST_TB_NAME, std::vector<std::string>{"id"});
+  auto lookup = [&](int id) {
+    std::vector<RID> rids;
+    sm_manager_->hash_ihs_.at(index_name)->GetValue(MakeKey(id).data(), &rids);
+    return rids;
+  };
+  std::vector<std::vector<RID>> rids;
+  for (int id = 0; id < NUM_ROWS; id += 89) {
+    rids.push_back(lookup(id));
+    ASSERT_EQ(rids.back().size(), 1U);
+  }
+  sm_manager_->CloseDB();
+  sm_manager_->OpenDB(TEST_DB_NAME);
+  EXPECT_TRUE(sm_manager_->db_.get_table(TEST_TB_NAME).get_index_meta({"id"})->is_hash);
+  for (int id = 0; id < NUM_ROWS; id += 89) {
+    ASSERT_EQ(lookup(id), rids[id / 89]);
+  }
+  EXPECT_TRUE(lookup(NUM_ROWS).empty());
+}
+
+}  // namespace easydb
@@ -0,0 +1,174 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * index_scan_test.cpp
+ *
+ * Identification: test/execution/index_scan_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "execution/executor_index_scan.h"
+#include "gtest/gtest.h"
+#include "system/sm_manager_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "index_scan_test.easydb";
+const std::string TEST_TB_NAME = "item";
+const std::string TEST_CSV_NAME = "item.tbl";
+
+class IndexScanTest : public SmManagerTest {
+ protected:
+  IndexScanTest() : SmManagerTest(TEST_DB_NAME, TEST_TB_NAME) {}
+
+  void SetUp() override {
+    SmManagerTest::SetUp();
+    sm_manager_->CreateTable(
+        TEST_TB_NAME, {{"id", TYPE_INT, sizeof(int)}, {"grp", TYPE_INT, sizeof(int)}, {"name", TYPE_CHAR, 16}},
+        nullptr);
+    sm_manager_->CreateIndex(TEST_TB_NAME, {"id"}, nullptr);
+    sm_manager_->CreateIndex(TEST_TB_NAME, {"grp", "id"}, nullptr);
+    std::ofstream csv(TEST_CSV_NAME);
+    for (int i = 0; i < NUM_ROWS; ++i) {
+      int id = (i * 7919) % NUM_ROWS;
+      csv << id << "|" << id % 10 << "|item" << id % 3 << "|\n";
+    }
+    csv.close();
+    sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr);
+  }
+
+  /** col IN (values), the way the analyzer builds it for a list of constants */
+  static auto MakeInCond(const std::string &col_name, const std::vector<int> &values) -> Condition {
+    Condition cond;
+    cond.lhs_col = {.tab_name = TEST_TB_NAME, .col_name = col_name};
+    cond.op = OP_IN;
+    cond.is_rhs_val = false;
+    cond.is_rhs_stmt = true;
+    cond.is_rhs_exe_processed = true;
+    for (int value : values) {
+      cond.rhs_in_col.emplace_back(TYPE_INT, value);
+    }
+    return cond;
+  }
+
+  /** @return the (grp, id) of the rows scanned, in the order of the scan */
+  auto Scan(const std::vector<Condition> &conds, const std::vector<std::string> &index_col_names)
+      -> std::vector<std::pair<int, int>> {
+    IndexScanExecutor scan(sm_manager_.get(), TEST_TB_NAME, conds, index_col_names, nullptr);
+    const auto &schema = scan.schema();
+    std::vector<std::pair<int, int>> rows;
+    for (scan.beginTuple(); !scan.IsEnd(); scan.nextTuple()) {
+      auto tuple = scan.Next();
+      rows.emplace_back(tuple->GetValue(&schema, 1).GetAs<int>(), tuple->GetValue(&schema, 0).GetAs<int>());
+    }
+    return rows;
+  }
+
+  auto ScanIds(const std::vector<Condition> &conds) -> std::vector<int> {
+    std::vector<int> ids;
+    for (auto &[grp, id] : Scan(conds, {"id"})) {
+      ids.push_back(id);
+    }
+    return ids;
+  }
+
+  auto MakeKey(int key) -> std::string {
+    std::string buf(sizeof(int), '\0');
+    ix_memcpy(buf.data(), Value(TYPE_INT, key), sizeof(int));
+    return buf;
+  }
+
+  static constexpr int NUM_ROWS = 10000;
+};
+
+// NOLINTNEXTLINE
+TEST_F(IndexScanTest, InList) {
+  // hundreds of keys in any order, with duplicates and missing keys, come out once each in key order
+  std::vector<int> values;
+  for (int i = 0; i < 300; ++i) {
+    values.push_back(i * 31 % (NUM_ROWS + 500));
+  }
+  values.insert(values.end(), values.begin(), values.begin() + 50);
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+  std::vector<int> expected;
+  for (int value : values) {
+    if (value < NUM_ROWS) {
+      expected.push_back(value);
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+  expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+  EXPECT_EQ(ScanIds({MakeInCond("id", values)}), expected);
+
+  // adjacent keys share the leaves
+  std::vector<int> dense;
+  for (int i = 2000; i < 3000; i += 2) {
+    dense.push_back(i);
+  }
+  EXPECT_EQ(ScanIds({MakeInCond("id", dense)}), dense);
+
+  // with other conditions on the same column, the empty ranges are skipped
+  EXPECT_EQ(ScanIds({MakeInCond("id", {5, 50, 500, 5000}), MakeCond("id", OP_LT, Value(TYPE_INT, 600))}),
+            (std::vector<int>{5, 50, 500}));
+  EXPECT_EQ(ScanIds({MakeCond("id", OP_GT, Value(TYPE_INT, 50)), MakeInCond("id", {5, 50, 500, 5000})}),
+            (std::vector<int>{500, 5000}));
+  // the conditions out of the index are checked on the tuples
+  EXPECT_EQ(ScanIds({MakeInCond("id", {3, 4, 5, 6}), MakeCond("name", OP_EQ, Value(TYPE_CHAR, "item0"))}),
+            (std::vector<int>{3, 6}));
+  // an empty list selects nothing
+  EXPECT_TRUE(ScanIds({MakeInCond("id", {})}).empty());
+}
+
+// NOLINTNEXTLINE
+TEST_F(IndexScanTest, InListOnMultiColumnIndex) {
+  // grp IN (7, 3) AND id < 100: one range per group, in the order of the index
+  auto rows = Scan({MakeInCond("grp", {7, 3, 7}), MakeCond("id", OP_LT, Value(TYPE_INT, 100))}, {"grp", "id"});
+  std::vector<std::pair<int, int>> expected;
+  for (int grp : {3, 7}) {
+    for (int id = grp; id < 100; id += 10) {
+      expected.emplace_back(grp, id);
+    }
+  }
+  EXPECT_EQ(rows, expected);
+
+  // every combination of two lists
+  rows = Scan({MakeInCond("id", {42, 43, 1234}), MakeInCond("grp", {2, 3, 4})}, {"grp", "id"});
+  EXPECT_EQ(rows, (std::vector<std::pair<int, int>>{{2, 42}, {3, 43}, {4, 1234}}));
+}
+
+// NOLINTNEXTLINE
+TEST_F(IndexScanTest, KeyRanges) {
+  // the same key twice and overlapping ranges are merged, so that no entry is scanned twice
+  auto &index_meta = *sm_manager_->db_.get_table(TEST_TB_NAME).get_index_meta({"id"});
+  auto ranges = IndexScanExecutor::GetKeyRanges(index_meta, {MakeInCond("id", {9, 1, 9, 5})});
+  ASSERT_EQ(ranges.size(), 3U);
+  EXPECT_EQ(ranges[0].lower, MakeKey(1));
+  EXPECT_EQ(ranges[1].lower, MakeKey(5));
+  EXPECT_EQ(ranges[2].lower, MakeKey(9));
+  EXPECT_EQ(ranges[2].upper, MakeKey(9));
+  ranges = IndexScanExecutor::GetKeyRanges(index_meta, {MakeInCond("id", {1, 5})});
+  EXPECT_EQ(ranges.size(), 2U);
+  EXPECT_TRUE(IndexScanExecutor::GetKeyRanges(
+                  index_meta, {MakeCond("id", OP_GT, Value(TYPE_INT, 5)), MakeCond("id", OP_LE, Value(TYPE_INT, 5))})
+                  .empty());
+
+  // the next bound on the same leaf is found from the current position, a bound on another leaf is not
+  auto ih = sm_manager_->ihs_.at(ix_manager_->GetIndexName(TEST_TB_NAME, std::vector<std::string>{"id"})).get();
+  Iid from = ih->LowerBound(MakeKey(100).data());
+  Iid result;
+  ASSERT_TRUE(ih->BoundInLeaf(from, MakeKey(101).data(), false, &result));
+  EXPECT_EQ(result, ih->LowerBound(MakeKey(101).data()));
+  ASSERT_TRUE(ih->BoundInLeaf(from, MakeKey(101).data(), true, &result));
+  EXPECT_EQ(result, ih->UpperBound(MakeKey(101).data()));
+  EXPECT_FALSE(ih->BoundInLeaf(from, MakeKey(NUM_ROWS - 1).data(), false, &result));
+}
+
+}  // namespace easydb
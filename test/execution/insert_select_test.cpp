@@ -0,0 +1,62 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * insert_select_test.cpp
+ *
+ * Identification: test/execution/insert_select_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "common/portal.h"
+#include "gtest/gtest.h"
+#include "system/sm_manager_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "insert_select_test.easydb";
+const std::string TEST_TB_NAME = "item";
+
+class InsertSelectTest : public SmManagerTest {
+ protected:
+  InsertSelectTest() : SmManagerTest(TEST_DB_NAME, TEST_TB_NAME) {}
+
+  void SetUp() override {
+    SmManagerTest::SetUp();
+    sm_manager_->CreateTable(TEST_TB_NAME, {{"id", TYPE_INT, sizeof(int)}, {"name", TYPE_CHAR, 16}}, nullptr);
+  }
+
+  /** INSERT INTO item with subplan as the select */
+  void InsertSelect(std::shared_ptr<Plan> subplan) {
+    auto plan = std::make_shared<DMLPlan>(T_Insert, std::move(subplan), TEST_TB_NAME, std::vector<Value>(),
+                                          std::vector<Condition>(), std::vector<SetClause>());
+    Portal portal(sm_manager_.get());
+    auto stmt = portal.start(plan, nullptr);
+    ASSERT_EQ(stmt->tag, PORTAL_DML_WITHOUT_SELECT);
+    stmt->root->Next();
+  }
+
+  /** @return the ids of the rows in item */
+  auto Scan() -> std::vector<int> {
+    SeqScanExecutor scan(sm_manager_.get(), TEST_TB_NAME, {}, nullptr);
+    const auto &schema = scan.schema();
+    std::vector<int> ids;
+    for (scan.beginTuple(); !scan.IsEnd(); scan.nextTuple()) {
+      ids.push_back(scan.Next()->GetValue(&schema, 0).GetAs<int>());
+    }
+    return ids;
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(InsertSelectTest, EmptySelectInsertsNothing) {
+  // the planner turns a select whose conditions can never hold, e.g. WHERE id=1 AND id=2, into an EmptyPlan
+  InsertSelect(std::make_shared<EmptyPlan>());
+  EXPECT_TRUE(Scan().empty());
+}
+
+}  // namespace easydb
@@ -0,0 +1,77 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_file_handle_test.hpp
+ *
+ * Identification: test/include/record/rm_file_handle_test.hpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/lock_manager.h"
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace easydb {
+
+/**
+ * Fixture of the tests that run on one record file: the directory db_name is made and entered before each test, and
+ * removed after it. The tests create the file file_name_ with CreateFile, by default its columns are
+ * {id INT, name CHAR(100)} and MakeTuple builds its tuples.
+ */
+class RmFileHandleTest : public ::testing::Test {
+ protected:
+  RmFileHandleTest(std::string db_name, std::string file_name,
+                   const std::vector<Column> &columns = {Column("id", TYPE_INT), Column("name", TYPE_CHAR, 100)})
+      : db_name_(std::move(db_name)), file_name_(std::move(file_name)), schema_(columns) {}
+
+  void SetUp() override {
+    std::filesystem::remove_all(db_name_);
+    disk_manager_ = std::make_unique<DiskManager>(db_name_);
+    std::filesystem::current_path(db_name_);
+    bpm_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+    rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), bpm_.get());
+    log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
+  }
+
+  void TearDown() override {
+    if (fh_ != nullptr) {
+      rm_manager_->CloseFile(fh_.get());
+    }
+    std::filesystem::current_path("..");
+    std::filesystem::remove_all(db_name_);
+  }
+
+  /** create file_name_ with the columns of schema_ and open it as fh_ */
+  void CreateFile(RmFileFormat format = RmFileFormat::ROW) {
+    rm_manager_->CreateFile(file_name_, schema_.GetInlinedStorageSize(), format, &schema_);
+    fh_ = rm_manager_->OpenFile(file_name_);
+  }
+
+  /** a tuple of the default columns, every tuple has the same length */
+  Tuple MakeTuple(int id) { return Tuple{{Value(TYPE_INT, id), Value(TYPE_CHAR, std::string(100, 'a'))}, &schema_}; }
+
+  std::string db_name_;
+  std::string file_name_;
+  Schema schema_;
+  std::unique_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<RmManager> rm_manager_;
+  std::unique_ptr<LogManager> log_manager_;
+  std::unique_ptr<RmFileHandle> fh_;
+  LockManager lock_manager_;
+};
+
+}  // namespace easydb
@@ -0,0 +1,127 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * b_plus_tree_test.hpp
+ *
+ * Identification: test/include/storage/index/b_plus_tree_test.hpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/ix_manager.h"
+#include "storage/index/ix_scan.h"
+#include "system/sm_meta.h"
+
+namespace easydb {
+
+/**
+ * Fixture of the tests that run on one B+ tree index: the directory db_name is made and entered before each test, and
+ * removed after it. If index_cols is not empty, the index file_name on them is created and opened as ih_ before each
+ * test, otherwise the test calls CreateIndex itself. By default the index is on one INT column, MakeKey and MakeRid
+ * build its keys and rids; a test on other columns overrides MakeKey.
+ */
+class BPlusTreeTest : public ::testing::Test {
+ protected:
+  BPlusTreeTest(std::string db_name, std::string file_name, std::vector<ColMeta> index_cols,
+                size_t pool_size = BUFFER_POOL_SIZE, int include_len = 0)
+      : db_name_(std::move(db_name)),
+        file_name_(std::move(file_name)),
+        index_cols_(std::move(index_cols)),
+        pool_size_(pool_size),
+        include_len_(include_len) {}
+
+  /** an index on the column id INT of file_name */
+  BPlusTreeTest(std::string db_name, const std::string &file_name, size_t pool_size = BUFFER_POOL_SIZE)
+      : BPlusTreeTest(std::move(db_name), file_name, {ColMeta(file_name, "id", TYPE_INT, sizeof(int), 0, true)},
+                      pool_size) {}
+
+  void SetUp() override {
+    std::filesystem::remove_all(db_name_);
+    disk_manager_ = std::make_unique<DiskManager>(db_name_);
+    std::filesystem::current_path(db_name_);
+    bpm_ = std::make_unique<BufferPoolManager>(pool_size_, disk_manager_.get());
+    ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), bpm_.get());
+    if (!index_cols_.empty()) {
+      CreateIndex();
+    }
+  }
+
+  void TearDown() override {
+    if (ih_ != nullptr) {
+      ix_manager_->CloseIndex(ih_.get());
+    }
+    std::filesystem::current_path("..");
+    std::filesystem::remove_all(db_name_);
+  }
+
+  /** create the index file_name_ on index_cols_ and open it as ih_ */
+  void CreateIndex() {
+    ix_manager_->CreateIndex(file_name_, index_cols_, include_len_);
+    ih_ = ix_manager_->OpenIndex(file_name_, index_cols_);
+  }
+
+  /** close ih_ and open it again, so that the tree is read back from the file */
+  void ReopenIndex() {
+    ix_manager_->CloseIndex(ih_.get());
+    ih_ = ix_manager_->OpenIndex(file_name_, index_cols_);
+  }
+
+  /** @return the INT key, encoded as ix_memcpy does for the index */
+  virtual auto MakeKey(int key) const -> std::string {
+    std::string buf(sizeof(int), '\0');
+    ix_memcpy(buf.data(), Value(TYPE_INT, key), sizeof(int));
+    return buf;
+  }
+
+  static auto MakeRid(int key) -> RID { return RID{key / 100, key % 100}; }
+
+  /** @return whether the key is found; if so, it must be found with its rid */
+  auto Lookup(int key) -> bool {
+    std::vector<RID> result;
+    bool found = ih_->GetValue(MakeKey(key).data(), &result, nullptr);
+    EXPECT_TRUE(!found || result[0] == MakeRid(key));
+    return found;
+  }
+
+  /** @return the rids of the leaves from the first to the last, in order; and the number of leaves if asked */
+  auto ScanAll(int *num_leaves = nullptr) -> std::vector<RID> {
+    std::vector<RID> rids;
+    int leaves = 0;
+    page_id_t page_no = IX_NO_PAGE;
+    for (IxScan scan(ih_.get(), ih_->LeafBegin(), ih_->LeafEnd(), bpm_.get()); !scan.IsEnd(); scan.Next()) {
+      rids.push_back(scan.GetRid());
+      if (scan.GetIid().page_id_ != page_no) {
+        page_no = scan.GetIid().page_id_;
+        leaves++;
+      }
+    }
+    if (num_leaves != nullptr) {
+      *num_leaves = leaves;
+    }
+    return rids;
+  }
+
+  std::string db_name_;
+  std::string file_name_;
+  std::vector<ColMeta> index_cols_;
+  size_t pool_size_;
+  int include_len_;
+  std::unique_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<IxManager> ix_manager_;
+  std::unique_ptr<IxIndexHandle> ih_;
+};
+
+}  // namespace easydb
@@ -0,0 +1,74 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * sm_manager_test.hpp
+ *
+ * Identification: test/include/system/sm_manager_test.hpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/condition.h"
+#include "gtest/gtest.h"
+#include "record/rm_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/ix_manager.h"
+#include "system/sm_manager.h"
+
+namespace easydb {
+
+/**
+ * Fixture of the tests that run on a whole database: a new database is opened before each test and removed after
+ * it. The tests create their table tab_name_ in SetUp after calling the SetUp of the fixture.
+ */
+class SmManagerTest : public ::testing::Test {
+ protected:
+  SmManagerTest(std::string db_name, std::string tab_name)
+      : db_name_(std::move(db_name)), tab_name_(std::move(tab_name)) {}
+
+  void SetUp() override {
+    std::filesystem::remove_all(db_name_);
+    disk_manager_ = std::make_unique<DiskManager>(db_name_);
+    bpm_ = std::make_unique<BufferPoolManager>(BUFFER_POOL_SIZE, disk_manager_.get());
+    rm_manager_ = std::make_unique<RmManager>(disk_manager_.get(), bpm_.get());
+    ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), bpm_.get());
+    sm_manager_ =
+        std::make_unique<SmManager>(disk_manager_.get(), bpm_.get(), rm_manager_.get(), ix_manager_.get(), false);
+    sm_manager_->OpenDB(db_name_);
+  }
+
+  void TearDown() override {
+    sm_manager_->CloseDB();
+    std::filesystem::remove_all(db_name_);
+  }
+
+  /** col_name op val on tab_name_, the way the analyzer builds it for a constant */
+  auto MakeCond(const std::string &col_name, CompOp op, Value val) const -> Condition {
+    Condition cond;
+    cond.lhs_col = {.tab_name = tab_name_, .col_name = col_name};
+    cond.op = op;
+    cond.is_rhs_val = true;
+    cond.is_rhs_stmt = false;
+    cond.rhs_val = std::move(val);
+    return cond;
+  }
+
+  std::string db_name_;
+  std::string tab_name_;
+  std::unique_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<RmManager> rm_manager_;
+  std::unique_ptr<IxManager> ix_manager_;
+  std::unique_ptr<SmManager> sm_manager_;
+};
+
+}  // namespace easydb
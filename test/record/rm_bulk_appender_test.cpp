@@ -0,0 +1,101 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_bulk_appender_test.cpp
+ *
+ * Identification: test/record/rm_bulk_appender_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_bulk_appender.h"
+#include "record/rm_file_handle_test.hpp"
+#include "record/rm_scan.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "bulk_appender_test.easydb";
+const std::string TEST_FILE_NAME = "bulk_table";
+
+class RmBulkAppenderTest : public RmFileHandleTest {
+ protected:
+  RmBulkAppenderTest()
+      : RmFileHandleTest(TEST_DB_NAME, TEST_FILE_NAME, {Column("id", TYPE_INT), Column("name", TYPE_VARCHAR, 20)}) {}
+
+  void AppendPages();
+
+  Tuple MakeTuple(int id) {
+    return Tuple{{Value(TYPE_INT, id), Value(TYPE_VARCHAR, std::string(id % 20, 'a' + id % 26))}, &schema_};
+  }
+};
+
+void RmBulkAppenderTest::AppendPages() {
+  // one regular tuple first, the appender leaves its page alone
+  RID first = *fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(10000), nullptr);
+
+  std::vector<RID> rids;
+  std::vector<page_id_t> pages;
+  RmBulkAppender appender(fh_.get(), [&](page_id_t page_no, const std::vector<Tuple> &tuples) {
+    pages.push_back(page_no);
+    for (size_t slot_no = 0; slot_no < tuples.size(); ++slot_no) {
+      EXPECT_TRUE(IsTupleContentEqual(tuples[slot_no], MakeTuple(rids.size())));
+      rids.emplace_back(page_no, static_cast<int>(slot_no));
+    }
+  });
+  const int num_tuples = 3000;
+  for (int i = 0; i < num_tuples; ++i) {
+    appender.Append(TupleMeta{0, false}, MakeTuple(i));
+  }
+  int num_full_pages = appender.GetNumPages();
+  ASSERT_GT(num_full_pages, 1);
+  appender.Finish();
+  appender.Finish();
+  EXPECT_EQ(appender.GetNumPages(), num_full_pages + 1);
+  ASSERT_EQ(static_cast<int>(rids.size()), num_tuples);
+
+  // the pages are new pages at the end of the file, in order
+  EXPECT_EQ(static_cast<int>(pages.size()), appender.GetNumPages());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    EXPECT_EQ(pages[i], first.GetPageId() + 1 + static_cast<int>(i));
+  }
+  EXPECT_EQ(fh_->GetFileHdr().num_pages, pages.back() + 1);
+
+  for (int i = 0; i < num_tuples; ++i) {
+    EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rids[i], nullptr), MakeTuple(i)));
+  }
+  int count = 0;
+  for (RmScan scan(fh_.get()); !scan.IsEnd(); scan.Next()) {
+    count++;
+  }
+  EXPECT_EQ(count, num_tuples + 1);
+
+  // the free space of the pages is published, so regular inserts fill them before extending the file
+  int num_pages = fh_->GetFileHdr().num_pages;
+  RID rid = *fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(10001), nullptr);
+  EXPECT_EQ(fh_->GetFileHdr().num_pages, num_pages);
+  EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rid, nullptr), MakeTuple(10001)));
+
+  // the tuples survive a restart
+  rm_manager_->CloseFile(fh_.get());
+  fh_ = rm_manager_->OpenFile(TEST_FILE_NAME);
+  EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rids.back(), nullptr), MakeTuple(num_tuples - 1)));
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmBulkAppenderTest, RowPages) {
+  CreateFile(RmFileFormat::ROW);
+  AppendPages();
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmBulkAppenderTest, ColumnarPages) {
+  CreateFile(RmFileFormat::COLUMNAR);
+  AppendPages();
+}
+
+}  // namespace easydb
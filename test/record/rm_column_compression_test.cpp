@@ -0,0 +1,135 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_column_compression_test.cpp
+ *
+ * Identification: test/record/rm_column_compression_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_file_handle_test.hpp"
+#include "record/rm_scan.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "column_compression_test.easydb";
+const std::string TEST_FILE_NAME = "column_compression_table";
+const std::vector<std::string> CITIES = {"Beijing", "Paris", "Tokyo", "Nairobi"};
+
+class RmColumnCompressionTest : public RmFileHandleTest {
+ protected:
+  RmColumnCompressionTest()
+      : RmFileHandleTest(TEST_DB_NAME, TEST_FILE_NAME,
+                         {Column("id", TYPE_INT), Column("city", TYPE_VARCHAR, 20), Column("score", TYPE_FLOAT)}) {}
+
+  void SetUp() override {
+    RmFileHandleTest::SetUp();
+    CreateFile(RmFileFormat::COLUMNAR);
+
+    // pages 1 and 2 are full, page 3 is not
+    while (rids_.empty() || rids_.back().GetPageId() < RM_FIRST_RECORD_PAGE + 2) {
+      int id = rids_.size();
+      rids_.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(id, CITIES[id % CITIES.size()]), nullptr));
+    }
+  }
+
+  Tuple MakeTuple(int id, const std::string &city) {
+    return Tuple{{Value(TYPE_INT, id), Value(TYPE_VARCHAR, city), Value(TYPE_FLOAT, id * 0.5f)}, &schema_};
+  }
+
+  void ExpectTuple(const RID &rid, int id, const std::string &city) {
+    EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rid, nullptr), MakeTuple(id, city)));
+  }
+
+  std::vector<RID> rids_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(RmColumnCompressionTest, SealAndGrow) {
+  // VACUUM seals the full pages, which then hold more tuples than a plain page
+  auto stats = fh_->Vacuum(&lock_manager_, nullptr);
+  EXPECT_EQ(stats.num_sealed_pages_, 2);
+  EXPECT_GT(stats.num_bytes_, 0);
+  EXPECT_EQ(fh_->Vacuum(&lock_manager_, nullptr).num_sealed_pages_, 0);
+  for (size_t i = 0; i < rids_.size(); ++i) {
+    ExpectTuple(rids_[i], i, CITIES[i % CITIES.size()]);
+  }
+
+  // a sealed page that is not full has room to widen its dictionary and its frame of reference
+  int num_records_per_page = fh_->GetFileHdr().num_records_per_page;
+  RID victim = rids_[num_records_per_page + 3];
+  EXPECT_TRUE(fh_->UpdateTupleInPlace(TupleMeta{0, false}, MakeTuple(1 << 30, "Reykjavik"), victim, nullptr));
+  ExpectTuple(victim, 1 << 30, "Reykjavik");
+  EXPECT_TRUE(fh_->UpdateTupleInPlace(TupleMeta{0, false}, MakeTuple(-7, "Tokyo"), victim, nullptr));
+  ExpectTuple(victim, -7, "Tokyo");
+
+  // values within the encodings are written in place, until the page is full
+  RID last_rid = rids_.back();
+  while (last_rid.GetPageId() < RM_FIRST_RECORD_PAGE + 3) {
+    last_rid = *fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(rids_.size() % 64, "Paris"), nullptr);
+  }
+  RmPageHandle page_handle = fh_->FetchPageHandle(RM_FIRST_RECORD_PAGE);
+  EXPECT_TRUE(page_handle.IsSealed());
+  EXPECT_GT(page_handle.GetCapacity(), num_records_per_page);
+  EXPECT_EQ(page_handle.GetNumTuples(), page_handle.GetCapacity());
+  bpm_->UnpinPage({fh_->GetFd(), RM_FIRST_RECORD_PAGE}, false);
+
+  // a new value re-encodes the page only if it still fits, otherwise the caller moves the tuple
+  RID rid(RM_FIRST_RECORD_PAGE, 1);
+  EXPECT_FALSE(fh_->UpdateTupleInPlace(TupleMeta{0, false}, MakeTuple(1, std::string(19, 'x')), rid, nullptr));
+  ExpectTuple(rid, 1, CITIES[1]);
+  for (size_t i = 0; i < rids_.size(); ++i) {
+    if (!(rids_[i] == victim)) {
+      ExpectTuple(rids_[i], i, CITIES[i % CITIES.size()]);
+    }
+  }
+
+  // the pages stay sealed across restarts
+  rm_manager_->CloseFile(fh_.get());
+  fh_ = rm_manager_->OpenFile(TEST_FILE_NAME);
+  ExpectTuple(victim, -7, "Tokyo");
+  ExpectTuple(rids_.back(), rids_.size() - 1, CITIES[(rids_.size() - 1) % CITIES.size()]);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmColumnCompressionTest, ScanOnDictionaryCodes) {
+  fh_->Vacuum(&lock_manager_, nullptr);
+  int num_paris = 0;
+  int num_less = 0;
+  for (size_t i = 0; i < rids_.size(); ++i) {
+    num_paris += CITIES[i % CITIES.size()] == "Paris" ? 1 : 0;
+    num_less += CITIES[i % CITIES.size()] < "Paris" ? 1 : 0;
+  }
+
+  // the sealed pages only hand out the tuples whose codes match, the last page is left to the caller
+  int num_matches = 0;
+  RmScan scan(fh_.get(), nullptr, {}, {{1, OP_EQ, Value(TYPE_VARCHAR, std::string("Paris"))}});
+  for (; !scan.IsEnd(); scan.Next()) {
+    auto city = scan.GetTupleView().GetValue(&schema_, 1).ToString();
+    if (scan.GetRid().GetPageId() < RM_FIRST_RECORD_PAGE + 2) {
+      EXPECT_EQ(city, "Paris");
+    }
+    num_matches += city == "Paris" ? 1 : 0;
+  }
+  EXPECT_EQ(num_matches, num_paris);
+
+  // the other operators compare the dictionary entries as the executors do
+  num_matches = 0;
+  for (RmScan scan(fh_.get(), nullptr, {1}, {{1, OP_LT, Value(TYPE_VARCHAR, std::string("Paris"))}}); !scan.IsEnd();
+       scan.Next()) {
+    auto city = scan.GetTupleView().GetValue(&schema_, 1).ToString();
+    num_matches += city < "Paris" ? 1 : 0;
+    if (scan.GetRid().GetPageId() < RM_FIRST_RECORD_PAGE + 2) {
+      EXPECT_LT(city, "Paris");
+    }
+  }
+  EXPECT_EQ(num_matches, num_less);
+}
+
+}  // namespace easydb
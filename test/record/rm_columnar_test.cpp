@@ -0,0 +1,137 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_columnar_test.cpp
+ *
+ * Identification: test/record/rm_columnar_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "common/context.h"
+#include "common/errors.h"
+#include "gtest/gtest.h"
+#include "record/rm_file_handle_test.hpp"
+#include "record/rm_scan.h"
+#include "transaction/transaction.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "columnar_test.easydb";
+const std::string TEST_FILE_NAME = "columnar_table";
+
+class RmColumnarTest : public RmFileHandleTest {
+ protected:
+  RmColumnarTest()
+      : RmFileHandleTest(TEST_DB_NAME, TEST_FILE_NAME,
+                         {Column("id", TYPE_INT), Column("name", TYPE_VARCHAR, 20), Column("score", TYPE_FLOAT)}) {}
+
+  void SetUp() override {
+    RmFileHandleTest::SetUp();
+    CreateFile(RmFileFormat::COLUMNAR);
+  }
+
+  Tuple MakeTuple(int id, const std::string &name) {
+    return Tuple{{Value(TYPE_INT, id), Value(TYPE_VARCHAR, name), Value(TYPE_FLOAT, id * 0.5f)}, &schema_};
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(RmColumnarTest, InsertUpdateDelete) {
+  EXPECT_EQ(fh_->GetFormat(), RmFileFormat::COLUMNAR);
+
+  // three pages of tuples with strings of different lengths
+  std::vector<RID> rids;
+  while (rids.empty() || rids.back().GetPageId() < RM_FIRST_RECORD_PAGE + 2) {
+    int id = rids.size();
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(id, std::string(id % 20, 'a')), nullptr));
+  }
+  for (size_t i = 0; i < rids.size(); ++i) {
+    EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rids[i], nullptr), MakeTuple(i, std::string(i % 20, 'a'))));
+  }
+
+  // a string longer than the column is rejected, as the minipages have a fixed width
+  EXPECT_THROW(fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(-1, std::string(21, 'b')), nullptr),
+               StringOverflowError);
+
+  // updates always fit in place
+  EXPECT_TRUE(fh_->UpdateTupleInPlace(TupleMeta{0, false}, MakeTuple(1000, std::string(20, 'c')), rids[0], nullptr));
+  EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rids[0], nullptr), MakeTuple(1000, std::string(20, 'c'))));
+
+  // a deleted slot is reused by the next insert
+  RID victim = rids[5];
+  EXPECT_TRUE(fh_->DeleteTuple(victim, nullptr));
+  EXPECT_TRUE(fh_->GetTupleMeta(victim, nullptr).is_deleted_);
+  fh_->UpdateFreeSpace(victim.GetPageId());
+  LockManager lock_manager;
+  Transaction txn(0);
+  Context context(&lock_manager, nullptr, &txn);
+  bool reused = false;
+  for (size_t i = 0; i < rids.size() && !reused; ++i) {
+    reused = *fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(2000, "new"), &context) == victim;
+  }
+  ASSERT_TRUE(reused);
+  EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(victim, nullptr), MakeTuple(2000, "new")));
+
+  // the layout is kept in the file header
+  rm_manager_->CloseFile(fh_.get());
+  fh_ = rm_manager_->OpenFile(TEST_FILE_NAME);
+  EXPECT_EQ(fh_->GetFormat(), RmFileFormat::COLUMNAR);
+  EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rids[1], nullptr), MakeTuple(1, "a")));
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmColumnarTest, Nulls) {
+  // the null bitmap has its own minipage, and is read by every scan
+  Tuple tuple{{Value(TYPE_INT, 7), Value(TYPE_VARCHAR), Value(TYPE_FLOAT)}, &schema_};
+  RID rid = *fh_->InsertTuple(TupleMeta{0, false}, tuple, nullptr);
+  EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rid, nullptr), tuple));
+  RmScan scan(fh_.get(), nullptr, {0, 2});
+  ASSERT_FALSE(scan.IsEnd());
+  auto view = scan.GetTupleView();
+  EXPECT_FALSE(view.IsNull(&schema_, 0));
+  EXPECT_EQ(view.GetValue(&schema_, 0).GetAs<int>(), 7);
+  EXPECT_TRUE(view.IsNull(&schema_, 2));
+  EXPECT_TRUE(view.GetValue(&schema_, 2).IsNull());
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmColumnarTest, ScanWithProjection) {
+  std::vector<RID> rids;
+  for (int i = 0; i < 500; ++i) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(i, std::to_string(i)), nullptr));
+  }
+  for (int i = 0; i < 500; i += 7) {
+    fh_->DeleteTuple(rids[i], nullptr);
+  }
+
+  // all columns
+  int num_tuples = 0;
+  for (RmScan scan(fh_.get()); !scan.IsEnd(); scan.Next()) {
+    auto tuple = scan.GetTupleView().ToTuple();
+    int id = tuple.GetValue(&schema_, 0).GetAs<int>();
+    EXPECT_NE(id % 7, 0);
+    EXPECT_TRUE(IsTupleContentEqual(tuple, MakeTuple(id, std::to_string(id))));
+    num_tuples++;
+  }
+  EXPECT_EQ(num_tuples, 500 - 72);
+
+  // only the projected columns are read, the others are zero or empty
+  num_tuples = 0;
+  for (RmScan scan(fh_.get(), nullptr, {2}); !scan.IsEnd(); scan.Next()) {
+    auto view = scan.GetTupleView();
+    EXPECT_EQ(view.GetValue(&schema_, 0).GetAs<int>(), 0);
+    EXPECT_EQ(view.GetValue(&schema_, 1).ToString(), "");
+    auto rid = scan.GetRid();
+    EXPECT_EQ(view.GetValue(&schema_, 2).GetAs<float>(),
+              fh_->GetTupleValue(rid, nullptr)->GetValue(&schema_, 2).GetAs<float>());
+    num_tuples++;
+  }
+  EXPECT_EQ(num_tuples, 500 - 72);
+}
+
+}  // namespace easydb
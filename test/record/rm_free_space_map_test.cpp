@@ -0,0 +1,149 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_free_space_map_test.cpp
+ *
+ * Identification: test/record/rm_free_space_map_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/context.h"
+#include "gtest/gtest.h"
+#include "record/rm_file_handle_test.hpp"
+#include "transaction/transaction.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "fsm_test.easydb";
+const std::string TEST_FILE_NAME = "fsm_table";
+
+class RmFreeSpaceMapTest : public RmFileHandleTest {
+ protected:
+  RmFreeSpaceMapTest()
+      : RmFileHandleTest(TEST_DB_NAME, TEST_FILE_NAME, {Column("id", TYPE_INT), Column("name", TYPE_CHAR, 200)}) {}
+};
+
+// NOLINTNEXTLINE
+TEST_F(RmFreeSpaceMapTest, FindAndUpdate) {
+  disk_manager_->CreateFile(TEST_FILE_NAME);
+  RmFreeSpaceMap fsm(disk_manager_.get(), bpm_.get(), TEST_FILE_NAME, 0);
+  EXPECT_TRUE(fsm.IsNew());
+  EXPECT_EQ(fsm.FindPage(1, 0), RM_NO_PAGE);
+
+  // pages in the second FSM page are covered as well
+  int far_page = RmFreeSpaceMap::FSM_LEAVES_PER_PAGE + 7;
+  fsm.Update(3, 100);
+  fsm.Update(far_page, PAGE_SIZE);
+  EXPECT_EQ(fsm.FindPage(100, 0), 3);
+  EXPECT_EQ(fsm.FindPage(100 + RmFreeSpaceMap::FSM_UNIT_SIZE, 0), far_page);
+  EXPECT_EQ(fsm.FindPage(UINT8_MAX * RmFreeSpaceMap::FSM_UNIT_SIZE, 0), far_page);
+  EXPECT_EQ(fsm.FindPage(PAGE_SIZE, 0), RM_NO_PAGE);
+
+  // the search starts from the hint and wraps around
+  EXPECT_EQ(fsm.FindPage(1, 4), far_page);
+  EXPECT_EQ(fsm.FindPage(1, far_page + 1), 3);
+
+  fsm.Update(far_page, 0);
+  EXPECT_EQ(fsm.FindPage(100 + RmFreeSpaceMap::FSM_UNIT_SIZE, 0), RM_NO_PAGE);
+  fsm.Close();
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmFreeSpaceMapTest, ReuseDeletedSlot) {
+  rm_manager_->CreateFile(TEST_FILE_NAME, schema_.GetInlinedStorageSize());
+  auto fh = rm_manager_->OpenFile(TEST_FILE_NAME);
+  LockManager lock_manager;
+  Tuple tuple{{Value(TYPE_INT, 1), Value(TYPE_CHAR, std::string(10, 'a'))}, &schema_};
+
+  // fill the first page
+  std::vector<RID> rids;
+  while (rids.empty() || rids.back().GetPageId() == RM_FIRST_RECORD_PAGE) {
+    rids.push_back(*fh->InsertTuple(TupleMeta{0, false}, tuple, nullptr));
+  }
+  ASSERT_EQ(rids.back().GetPageId(), RM_FIRST_RECORD_PAGE + 1);
+
+  // a slot deleted by a running txn is not reused
+  // Note: every thread starts searching from its own page, so insert enough tuples to fill any page first
+  int tuples_per_page = rids.size() - 1;
+  Transaction deleter(0);
+  Context delete_context(&lock_manager, nullptr, &deleter);
+  RID victim = rids[3];
+  ASSERT_TRUE(fh->DeleteTuple(victim, &delete_context));
+  fh->UpdateFreeSpace(victim.GetPageId());
+  Transaction inserter(1);
+  Context insert_context(&lock_manager, nullptr, &inserter);
+  for (int i = 0; i < tuples_per_page; ++i) {
+    auto rid = fh->InsertTuple(TupleMeta{inserter.GetWriteVersion(), false}, tuple, &insert_context);
+    EXPECT_FALSE(*rid == victim);
+  }
+
+  // once the deleter releases its lock, the slot is reused
+  lock_manager.Unlock(&deleter, LockDataId(fh->GetFd(), victim, LockDataType::RECORD));
+  fh->UpdateFreeSpace(victim.GetPageId());
+  bool reused = false;
+  for (int i = 0; i <= tuples_per_page && !reused; ++i) {
+    reused = *fh->InsertTuple(TupleMeta{inserter.GetWriteVersion(), false}, tuple, &insert_context) == victim;
+  }
+  ASSERT_TRUE(reused);
+  EXPECT_FALSE(fh->GetTupleMeta(victim, nullptr).is_deleted_);
+  EXPECT_EQ(fh->GetTupleValue(victim, nullptr)->GetValue(&schema_, 0).GetAs<int>(), 1);
+  EXPECT_EQ(inserter.GetLockSet()->count(LockDataId(fh->GetFd(), victim, LockDataType::RECORD)), 1);
+  rm_manager_->CloseFile(fh.get());
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmFreeSpaceMapTest, ConcurrentInsertAndReopen) {
+  rm_manager_->CreateFile(TEST_FILE_NAME, schema_.GetInlinedStorageSize());
+  auto fh = rm_manager_->OpenFile(TEST_FILE_NAME);
+  const int num_threads = 4;
+  const int tuples_per_thread = 500;
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      for (int i = 0; i < tuples_per_thread; ++i) {
+        Tuple tuple{{Value(TYPE_INT, t * tuples_per_thread + i), Value(TYPE_CHAR, std::string("x"))}, &schema_};
+        rids[t].push_back(*fh->InsertTuple(TupleMeta{0, false}, tuple, nullptr));
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  std::set<std::pair<page_id_t, int>> all_rids;
+  for (int t = 0; t < num_threads; ++t) {
+    for (int i = 0; i < tuples_per_thread; ++i) {
+      all_rids.emplace(rids[t][i].GetPageId(), rids[t][i].GetSlotNum());
+      EXPECT_EQ(fh->GetTupleValue(rids[t][i], nullptr)->GetValue(&schema_, 0).GetAs<int>(), t * tuples_per_thread + i);
+    }
+  }
+  EXPECT_EQ(all_rids.size(), num_threads * tuples_per_thread);
+
+  // the FSM is persisted in its own file, and the deleted slot is found again after reopen
+  RID victim = rids[0][0];
+  fh->DeleteTuple(victim, nullptr);
+  rm_manager_->CloseFile(fh.get());
+  EXPECT_GT(std::filesystem::file_size(RmFreeSpaceMap::GetFileName(TEST_FILE_NAME)), 0);
+  fh = rm_manager_->OpenFile(TEST_FILE_NAME);
+  LockManager lock_manager;
+  Transaction txn(0);
+  Context context(&lock_manager, nullptr, &txn);
+  Tuple tuple{{Value(TYPE_INT, -1), Value(TYPE_CHAR, std::string("y"))}, &schema_};
+  bool reused = false;
+  for (int i = 0; i < num_threads * tuples_per_thread && !reused; ++i) {
+    reused = *fh->InsertTuple(TupleMeta{txn.GetWriteVersion(), false}, tuple, &context) == victim;
+  }
+  EXPECT_TRUE(reused);
+  rm_manager_->CloseFile(fh.get());
+}
+
+}  // namespace easydb
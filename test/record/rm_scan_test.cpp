@@ -0,0 +1,125 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_scan_test.cpp
+ *
+ * Identification: test/record/rm_scan_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "common/context.h"
+#include "gtest/gtest.h"
+#include "record/rm_file_handle_test.hpp"
+#include "record/rm_scan.h"
+#include "transaction/transaction.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "scan_test.easydb";
+const std::string TEST_FILE_NAME = "scan_table";
+
+class RmScanTest : public RmFileHandleTest {
+ protected:
+  RmScanTest() : RmFileHandleTest(TEST_DB_NAME, TEST_FILE_NAME) {}
+
+  void SetUp() override {
+    RmFileHandleTest::SetUp();
+    CreateFile();
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(RmScanTest, ViewsSkipDeletedTuples) {
+  EXPECT_TRUE(RmScan(fh_.get()).IsEnd());
+
+  // three pages, the whole first page and every third tuple deleted
+  std::vector<RID> rids;
+  while (rids.empty() || rids.back().GetPageId() < RM_FIRST_RECORD_PAGE + 2) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(rids.size()), nullptr));
+  }
+  std::vector<int> expected;
+  for (size_t i = 0; i < rids.size(); ++i) {
+    if (rids[i].GetPageId() == RM_FIRST_RECORD_PAGE || i % 3 == 0) {
+      fh_->DeleteTuple(rids[i], nullptr);
+    } else {
+      expected.push_back(i);
+    }
+  }
+
+  std::vector<int> scanned;
+  for (RmScan scan(fh_.get()); !scan.IsEnd(); scan.Next()) {
+    auto view = scan.GetTupleView();
+    EXPECT_TRUE(view.GetRid() == scan.GetRid());
+    EXPECT_EQ(view.GetLength(), MakeTuple(0).GetLength());
+    scanned.push_back(view.GetValue(&schema_, 0).GetAs<int>());
+    EXPECT_EQ(view.GetValue(&schema_, "id").GetAs<int>(), scanned.back());
+    auto tuple = view.ToTuple();
+    EXPECT_TRUE(tuple.GetRid() == scan.GetRid());
+    EXPECT_TRUE(IsTupleContentEqual(tuple, *fh_->GetTupleValue(scan.GetRid(), nullptr)));
+  }
+  EXPECT_EQ(scanned, expected);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmScanTest, PinnedPageIsNotCompacted) {
+  std::vector<RID> rids;
+  for (int i = 0; i < 10; ++i) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(i), nullptr));
+  }
+  fh_->DeleteTuple(rids[0], nullptr);
+
+  {
+    // the scan pins the page while it is positioned on it, so VACUUM must not move the data under the views
+    RmScan scan(fh_.get());
+    auto view = scan.GetTupleView();
+    EXPECT_EQ(view.GetValue(&schema_, 0).GetAs<int>(), 1);
+    auto stats = fh_->Vacuum(&lock_manager_, log_manager_.get());
+    EXPECT_EQ(stats.num_pages_, 0);
+    EXPECT_EQ(view.GetValue(&schema_, 0).GetAs<int>(), 1);
+
+    // an insert still reuses the deleted slot in place, without moving the data of the other slots
+    Transaction txn(0);
+    Context context(&lock_manager_, log_manager_.get(), &txn);
+    EXPECT_EQ(fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(100), &context)->GetSlotNum(), 0);
+    scan.Next();
+    EXPECT_EQ(scan.GetTupleView().GetValue(&schema_, 0).GetAs<int>(), 2);
+  }
+
+  // the pin is released when the scan moves past the page
+  fh_->DeleteTuple(rids[1], nullptr);
+  RmScan scan(fh_.get());
+  while (!scan.IsEnd()) {
+    scan.Next();
+  }
+  EXPECT_EQ(fh_->Vacuum(&lock_manager_, log_manager_.get()).num_pages_, 1);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmScanTest, OptimisticScanCopiesTuples) {
+  std::vector<RID> rids;
+  for (int i = 0; i < 10; ++i) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(i), nullptr));
+  }
+
+  // an OCC txn holds no table lock, a writer may update the tuple in place while the scan is positioned on it
+  Transaction reader(0);
+  reader.SetConcurrencyMode(ConcurrencyMode::OPTIMISTIC);
+  Context reader_context(&lock_manager_, log_manager_.get(), &reader);
+  RmScan scan(fh_.get(), &reader_context);
+  auto view = scan.GetTupleView();
+  Transaction writer(1);
+  Context writer_context(&lock_manager_, log_manager_.get(), &writer);
+  fh_->UpdateTupleInPlace(TupleMeta{writer.GetWriteVersion(), false}, MakeTuple(100), rids[0], &writer_context);
+  EXPECT_EQ(view.GetValue(&schema_, 0).GetAs<int>(), 0);
+  EXPECT_EQ(fh_->GetTupleValue(rids[0], nullptr)->GetValue(&schema_, 0).GetAs<int>(), 100);
+
+  // the read is still validated against the version the scan saw
+  EXPECT_EQ(reader.GetReadSet()->size(), rids.size());
+}
+
+}  // namespace easydb
@@ -0,0 +1,107 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_toast_test.cpp
+ *
+ * Identification: test/record/rm_toast_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_file_handle_test.hpp"
+#include "record/rm_scan.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "toast_test.easydb";
+const std::string TEST_FILE_NAME = "toast_table";
+
+class RmToastTest : public RmFileHandleTest {
+ protected:
+  RmToastTest()
+      : RmFileHandleTest(
+            TEST_DB_NAME, TEST_FILE_NAME,
+            {Column("id", TYPE_INT), Column("name", TYPE_VARCHAR, 20), Column("body", TYPE_VARCHAR, 8000)}) {}
+
+  void SetUp() override {
+    RmFileHandleTest::SetUp();
+    CreateFile();
+  }
+
+  /* body is longer than a toast page, so its chain has two pages */
+  Tuple MakeTuple(int id, char c) {
+    return Tuple{{Value(TYPE_INT, id), Value(TYPE_VARCHAR, std::string("name") + std::to_string(id)),
+                  Value(TYPE_VARCHAR, std::string(5000, c))},
+                 &schema_};
+  }
+
+  void ExpectTuple(const RID &rid, int id, char c) {
+    EXPECT_TRUE(IsTupleContentEqual(*fh_->GetTupleValue(rid, nullptr), MakeTuple(id, c)));
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(RmToastTest, WideRows) {
+  // rows wider than a page are stored with their bodies out of line, many of them on one data page
+  std::vector<RID> rids;
+  for (int i = 0; i < 20; ++i) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(i, 'a' + i), nullptr));
+  }
+  EXPECT_EQ(rids.back().GetPageId(), RM_FIRST_RECORD_PAGE);
+  for (int i = 0; i < 20; ++i) {
+    ExpectTuple(rids[i], i, 'a' + i);
+  }
+
+  // a scan reads the bodies only if it projects them
+  int id = 0;
+  for (RmScan scan(fh_.get(), nullptr, {0, 1}); !scan.IsEnd(); scan.Next(), ++id) {
+    auto view = scan.GetTupleView();
+    EXPECT_EQ(view.GetValue(&schema_, 0).GetAs<int>(), id);
+    EXPECT_EQ(view.GetValue(&schema_, 1).ToString(), "name" + std::to_string(id));
+    EXPECT_EQ(view.GetValue(&schema_, 2).ToString(), "");
+  }
+  EXPECT_EQ(id, 20);
+  id = 0;
+  for (RmScan scan(fh_.get()); !scan.IsEnd(); scan.Next(), ++id) {
+    EXPECT_TRUE(IsTupleContentEqual(scan.GetTupleView().ToTuple(), MakeTuple(id, 'a' + id)));
+  }
+  EXPECT_EQ(id, 20);
+
+  // the values survive a restart
+  rm_manager_->CloseFile(fh_.get());
+  fh_ = rm_manager_->OpenFile(TEST_FILE_NAME);
+  ExpectTuple(rids[7], 7, 'a' + 7);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmToastTest, VacuumReclaimsChains) {
+  std::vector<RID> rids;
+  for (int i = 0; i < 4; ++i) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(i, 'x'), nullptr));
+  }
+  EXPECT_EQ(fh_->Vacuum(&lock_manager_, log_manager_.get()).num_toast_pages_, 0);
+
+  // the chains of an overwritten body and of a deleted tuple are freed by VACUUM, and reused by the next inserts
+  EXPECT_TRUE(fh_->UpdateTupleInPlace(TupleMeta{0, false}, MakeTuple(0, 'y'), rids[0], nullptr));
+  fh_->DeleteTuple(rids[1], nullptr);
+  ExpectTuple(rids[0], 0, 'y');
+  EXPECT_EQ(fh_->Vacuum(&lock_manager_, log_manager_.get()).num_toast_pages_, 4);
+  EXPECT_EQ(fh_->Vacuum(&lock_manager_, log_manager_.get()).num_toast_pages_, 0);
+
+  int num_pages = disk_manager_->GetFileSize(RmToastStore::GetFileName(TEST_FILE_NAME)) / PAGE_SIZE;
+  RID rid = *fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(4, 'z'), nullptr);
+  RID rid2 = *fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(5, 'w'), nullptr);
+  EXPECT_EQ(disk_manager_->GetFileSize(RmToastStore::GetFileName(TEST_FILE_NAME)) / PAGE_SIZE, num_pages);
+  ExpectTuple(rid, 4, 'z');
+  ExpectTuple(rid2, 5, 'w');
+  ExpectTuple(rids[0], 0, 'y');
+  ExpectTuple(rids[2], 2, 'x');
+  ExpectTuple(rids[3], 3, 'x');
+}
+
+}  // namespace easydb
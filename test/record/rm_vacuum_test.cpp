@@ -0,0 +1,153 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_vacuum_test.cpp
+ *
+ * Identification: test/record/rm_vacuum_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "common/context.h"
+#include "gtest/gtest.h"
+#include "record/rm_file_handle_test.hpp"
+#include "record/rm_scan.h"
+#include "transaction/transaction.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "vacuum_test.easydb";
+const std::string TEST_FILE_NAME = "vacuum_table";
+
+class RmVacuumTest : public RmFileHandleTest {
+ protected:
+  RmVacuumTest() : RmFileHandleTest(TEST_DB_NAME, TEST_FILE_NAME) {}
+
+  void SetUp() override {
+    RmFileHandleTest::SetUp();
+    CreateFile();
+  }
+
+  int GetId(const RID &rid) { return fh_->GetTupleValue(rid, nullptr)->GetValue(&schema_, 0).GetAs<int>(); }
+};
+
+// NOLINTNEXTLINE
+TEST_F(RmVacuumTest, CompactAndTruncate) {
+  std::vector<RID> rids;
+  for (int i = 0; i < 20; ++i) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(i), nullptr));
+  }
+  ASSERT_EQ(rids.back().GetPageId(), RM_FIRST_RECORD_PAGE);
+
+  // delete the even tuples and the last 5 tuples, one of them by a running txn
+  Transaction txn(0);
+  Context context(&lock_manager_, log_manager_.get(), &txn);
+  for (int i = 0; i < 20; ++i) {
+    if (i == 18) {
+      fh_->DeleteTuple(rids[i], &context);
+    } else if (i % 2 == 0 || i >= 15) {
+      fh_->DeleteTuple(rids[i], nullptr);
+    }
+  }
+
+  auto stats = fh_->Vacuum(&lock_manager_, log_manager_.get());
+  EXPECT_EQ(stats.num_pages_, 1);
+  EXPECT_EQ(stats.num_tuples_, 12);
+  EXPECT_EQ(stats.num_empty_pages_, 0);
+  EXPECT_GE(stats.num_bytes_, 12 * static_cast<int>(MakeTuple(0).GetLength()));
+
+  // the live tuples keep their rids, the slots after the locked one are truncated
+  for (int i = 1; i < 15; i += 2) {
+    EXPECT_EQ(GetId(rids[i]), i);
+  }
+  EXPECT_TRUE(fh_->GetTupleMeta(rids[18], nullptr).is_deleted_);
+  EXPECT_THROW(fh_->GetTupleMeta(rids[19], nullptr), Exception);
+
+  // the deleted tuple of the running txn can still be rolled back
+  Tuple old_tuple = *fh_->GetTupleValue(rids[18], nullptr);
+  fh_->InsertTuple(rids[18], TupleMeta{0, false}, old_tuple, nullptr);
+  EXPECT_EQ(GetId(rids[18]), 18);
+
+  // a new tuple reuses a vacuumed slot, growing it into the free space
+  Transaction inserter(1);
+  Context insert_context(&lock_manager_, log_manager_.get(), &inserter);
+  auto rid = fh_->InsertTuple(TupleMeta{inserter.GetWriteVersion(), false}, MakeTuple(100), &insert_context);
+  EXPECT_EQ(rid->GetPageId(), RM_FIRST_RECORD_PAGE);
+  EXPECT_LT(rid->GetSlotNum(), 19);
+  EXPECT_EQ(GetId(*rid), 100);
+  for (int i = 1; i < 15; i += 2) {
+    EXPECT_EQ(GetId(rids[i]), i);
+  }
+  EXPECT_EQ(GetId(rids[18]), 18);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmVacuumTest, TruncatedSlotStillLocked) {
+  std::vector<RID> rids;
+  for (int i = 0; i < 10; ++i) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(i), nullptr));
+  }
+  for (int i = 5; i < 10; ++i) {
+    fh_->DeleteTuple(rids[i], nullptr);
+  }
+  fh_->Vacuum(&lock_manager_, log_manager_.get());
+  EXPECT_THROW(fh_->GetTupleMeta(rids[5], nullptr), Exception);
+
+  // a younger txn still holds a lock on the truncated rid, the older inserter must not wait for it under the latch
+  Transaction inserter(0);
+  Transaction reader(1);
+  Context insert_context(&lock_manager_, log_manager_.get(), &inserter);
+  ASSERT_TRUE(lock_manager_.LockSharedOnRecord(&reader, rids[5], fh_->GetFd()));
+  auto rid = fh_->InsertTuple(TupleMeta{inserter.GetWriteVersion(), false}, MakeTuple(100), &insert_context);
+  ASSERT_TRUE(rid.has_value());
+  EXPECT_FALSE(*rid == rids[5]);
+  EXPECT_EQ(GetId(*rid), 100);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmVacuumTest, EmptyPagesAndThreshold) {
+  std::vector<RID> rids;
+  while (rids.empty() || rids.back().GetPageId() < RM_FIRST_RECORD_PAGE + 2) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(rids.size()), nullptr));
+  }
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == RM_FIRST_RECORD_PAGE) {
+      fh_->DeleteTuple(rid, nullptr);
+    }
+  }
+  // only one tuple of the second page is deleted, below the auto-vacuum threshold
+  RID victim = rids.back();
+  int num_live_tuples = 0;
+  for (auto &rid : rids) {
+    if (rid.GetPageId() != RM_FIRST_RECORD_PAGE) {
+      num_live_tuples++;
+    }
+  }
+  for (auto &rid : rids) {
+    if (rid.GetPageId() == RM_FIRST_RECORD_PAGE + 1) {
+      victim = rid;
+      fh_->DeleteTuple(rid, nullptr);
+      num_live_tuples--;
+      break;
+    }
+  }
+  RmVacuumStats stats;
+  fh_->VacuumPage(RM_FIRST_RECORD_PAGE, &lock_manager_, log_manager_.get(), AUTO_VACUUM_THRESHOLD, &stats);
+  fh_->VacuumPage(RM_FIRST_RECORD_PAGE + 1, &lock_manager_, log_manager_.get(), AUTO_VACUUM_THRESHOLD, &stats);
+  EXPECT_EQ(stats.num_pages_, 1);
+  EXPECT_EQ(stats.num_empty_pages_, 1);
+  EXPECT_TRUE(fh_->GetTupleMeta(victim, nullptr).is_deleted_);
+
+  // the scan skips the empty page
+  int num_tuples = 0;
+  for (RmScan scan(fh_.get()); !scan.IsEnd(); scan.Next()) {
+    num_tuples++;
+  }
+  EXPECT_EQ(num_tuples, num_live_tuples);
+}
+
+}  // namespace easydb
@@ -0,0 +1,109 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * rm_zone_map_test.cpp
+ *
+ * Identification: test/record/rm_zone_map_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "record/rm_file_handle_test.hpp"
+#include "record/rm_scan.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "zone_map_test.easydb";
+const std::string TEST_FILE_NAME = "zone_map_table";
+
+class RmZoneMapTest : public RmFileHandleTest {
+ protected:
+  RmZoneMapTest() : RmFileHandleTest(TEST_DB_NAME, TEST_FILE_NAME) {}
+
+  void SetUp() override {
+    RmFileHandleTest::SetUp();
+    CreateFile();
+    fh_->EnableZoneMap(schema_);
+  }
+
+  /* 扫描满足id op val的记录，返回记录的id */
+  auto Scan(CompOp op, int val, int *num_skipped_pages) -> std::vector<int> {
+    std::vector<int> ids;
+    RmScan scan(fh_.get(), nullptr, {}, {{0, op, Value(TYPE_INT, val)}});
+    for (; !scan.IsEnd(); scan.Next()) {
+      int id = scan.GetTupleView().GetValue(&schema_, 0).GetAs<int>();
+      Condition cond{.op = op};
+      if (cond.satisfy(Value(TYPE_INT, id), Value(TYPE_INT, val))) {
+        ids.push_back(id);
+      }
+    }
+    *num_skipped_pages = scan.GetNumSkippedPages();
+    return ids;
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(RmZoneMapTest, SkipPages) {
+  // time-ordered ids over 10 pages
+  std::vector<RID> rids;
+  while (rids.empty() || rids.back().GetPageId() < RM_FIRST_RECORD_PAGE + 10) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(rids.size()), nullptr));
+  }
+  int num_tuples = rids.size();
+  int last = num_tuples - 1;
+
+  // the zones of the pages are built as they are filled, so only the pages of the range are read
+  int num_skipped_pages;
+  auto ids = Scan(OP_GE, last - 5, &num_skipped_pages);
+  EXPECT_EQ(ids, std::vector<int>({last - 5, last - 4, last - 3, last - 2, last - 1, last}));
+  EXPECT_GE(num_skipped_pages, 9);
+  EXPECT_EQ(Scan(OP_LT, 0, &num_skipped_pages).size(), 0);
+  EXPECT_EQ(num_skipped_pages, 11);
+  EXPECT_EQ(Scan(OP_NE, -1, &num_skipped_pages).size(), num_tuples);
+  EXPECT_EQ(num_skipped_pages, 0);
+
+  // a delete does not narrow the zone, as it can be rolled back
+  fh_->DeleteTuple(rids[0], nullptr);
+  EXPECT_EQ(Scan(OP_EQ, 0, &num_skipped_pages).size(), 0);
+  EXPECT_EQ(num_skipped_pages, 10);
+
+  // an update widens the zone
+  fh_->UpdateTupleInPlace(TupleMeta{0, false}, MakeTuple(num_tuples * 2), rids[1], nullptr);
+  EXPECT_EQ(Scan(OP_GT, last, &num_skipped_pages), std::vector<int>({num_tuples * 2}));
+  EXPECT_EQ(num_skipped_pages, 10);
+}
+
+// NOLINTNEXTLINE
+TEST_F(RmZoneMapTest, BuildOnScan) {
+  std::vector<RID> rids;
+  while (rids.empty() || rids.back().GetPageId() < RM_FIRST_RECORD_PAGE + 3) {
+    rids.push_back(*fh_->InsertTuple(TupleMeta{0, false}, MakeTuple(rids.size()), nullptr));
+  }
+  // reopen the table, the zone maps are not persisted
+  rm_manager_->CloseFile(fh_.get());
+  fh_ = rm_manager_->OpenFile(TEST_FILE_NAME);
+  fh_->EnableZoneMap(schema_);
+
+  // the first scan reads every page and builds their zones, the next one skips them
+  int num_skipped_pages;
+  EXPECT_EQ(Scan(OP_LT, 3, &num_skipped_pages), std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(num_skipped_pages, 0);
+  EXPECT_EQ(Scan(OP_LT, 3, &num_skipped_pages), std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(num_skipped_pages, 3);
+
+  // a scan without predicates reads every page
+  RmScan scan(fh_.get());
+  int num_tuples = 0;
+  for (; !scan.IsEnd(); scan.Next()) {
+    num_tuples++;
+  }
+  EXPECT_EQ(num_tuples, rids.size());
+  EXPECT_EQ(scan.GetNumSkippedPages(), 0);
+}
+
+}  // namespace easydb
@@ -0,0 +1,88 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * b_plus_tree_allocation_test.cpp
+ *
+ * Identification: test/storage/index/b_plus_tree_allocation_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_test.hpp"
+
+// count the heap allocations of the whole test binary
+static std::atomic<long> num_allocations{0};
+
+void *operator new(std::size_t size) {
+  num_allocations++;
+  if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "allocation_test.easydb";
+const std::string TEST_FILE_NAME = "allocation_table";
+
+class BPlusTreeAllocationTest : public BPlusTreeTest {
+ protected:
+  BPlusTreeAllocationTest() : BPlusTreeTest(TEST_DB_NAME, TEST_FILE_NAME) {}
+
+  void SetUp() override {
+    BPlusTreeTest::SetUp();
+    for (int i = 0; i < num_keys_; ++i) {
+      ih_->InsertEntry(MakeKey(i).data(), MakeRid(i), nullptr);
+    }
+  }
+
+  /** Point lookups, bound lookups and a scan of every key; @return the allocations made meanwhile */
+  auto CountLookupAllocations() -> long {
+    std::vector<std::string> keys;
+    for (int i = 0; i < num_keys_; ++i) {
+      keys.push_back(MakeKey(i));
+    }
+    Iid end = ih_->LeafEnd();
+    long before = num_allocations.load();
+    for (int i = 0; i < num_keys_; ++i) {
+      RID rid;
+      EXPECT_TRUE(ih_->GetValue(keys[i].data(), &rid, nullptr));
+      EXPECT_EQ(rid, MakeRid(i));
+    }
+    Iid lower = ih_->LowerBound(keys[num_keys_ / 2].data());
+    ih_->UpperBound(keys[num_keys_ / 2].data());
+    int count = 0;
+    for (IxScan scan(ih_.get(), lower, end, bpm_.get()); !scan.IsEnd(); scan.Next()) {
+      count++;
+    }
+    long allocations = num_allocations.load() - before;
+    EXPECT_EQ(count, num_keys_ - num_keys_ / 2);
+    return allocations;
+  }
+
+  const int num_keys_ = 10000;
+};
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeAllocationTest, LookupsDoNotAllocate) {
+  // the node handles of the traversal live on the stack, the pages are cached in the buffer pool
+  EXPECT_EQ(CountLookupAllocations(), 0);
+  ih_->SetBLink(false);
+  EXPECT_EQ(CountLookupAllocations(), 0);
+}
+
+}  // namespace easydb
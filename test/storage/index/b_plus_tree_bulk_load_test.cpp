@@ -0,0 +1,111 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * b_plus_tree_bulk_load_test.cpp
+ *
+ * Identification: test/storage/index/b_plus_tree_bulk_load_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "bulk_load_test.easydb";
+const std::string TEST_FILE_NAME = "bulk_table";
+
+class BPlusTreeBulkLoadTest : public BPlusTreeTest {
+ protected:
+  // a small pool, so that the pages built are written back and read again
+  BPlusTreeBulkLoadTest() : BPlusTreeTest(TEST_DB_NAME, TEST_FILE_NAME, 32) {}
+
+  auto MakeEntry(int key) const -> IxEntry { return {MakeKey(key), MakeRid(key)}; }
+};
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeBulkLoadTest, BuildBottomUp) {
+  // even keys in random order, enough for three levels
+  const int num_keys = 100000;
+  std::vector<IxEntry> entries;
+  for (int i = 0; i < num_keys; ++i) {
+    entries.push_back(MakeEntry(2 * i));
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  ASSERT_TRUE(ih_->BulkLoad(&entries, nullptr));
+
+  // the leaves are linked in key order, and every key is found from the root
+  auto rids = ScanAll();
+  ASSERT_EQ(static_cast<int>(rids.size()), num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    ASSERT_EQ(rids[i], MakeEntry(2 * i).second);
+  }
+  std::vector<RID> result;
+  for (int i = 0; i < 2 * num_keys; i += 7) {
+    result.clear();
+    ASSERT_EQ(ih_->GetValue(MakeEntry(i).first.data(), &result, nullptr), i % 2 == 0);
+  }
+  std::unique_ptr<IxNodeHandle> root(ih_->GetRoot());
+  EXPECT_FALSE(root->IsLeafPage());
+  bpm_->UnpinPage(root->GetPageId(), false);
+
+  // the tree stays a regular B+ tree: odd keys fill the free slots and split the nodes, deletes merge them
+  for (int i = 1; i < 2 * num_keys; i += 2) {
+    ASSERT_NE(ih_->InsertEntry(MakeEntry(i).first.data(), MakeEntry(i).second, nullptr), -1);
+  }
+  for (int i = 0; i < 2 * num_keys; i += 3) {
+    ASSERT_TRUE(ih_->DeleteEntry(MakeEntry(i).first.data(), nullptr));
+  }
+  rids = ScanAll();
+  ASSERT_EQ(static_cast<int>(rids.size()), 2 * num_keys - (2 * num_keys + 2) / 3);
+  EXPECT_TRUE(std::is_sorted(rids.begin(), rids.end(), [](const RID &lhs, const RID &rhs) {
+    return lhs.GetPageId() * 100 + lhs.GetSlotNum() < rhs.GetPageId() * 100 + rhs.GetSlotNum();
+  }));
+
+  // the tree survives a restart
+  ReopenIndex();
+  result.clear();
+  ASSERT_TRUE(ih_->GetValue(MakeEntry(2 * num_keys - 1).first.data(), &result, nullptr));
+  EXPECT_EQ(result[0], MakeEntry(2 * num_keys - 1).second);
+}
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeBulkLoadTest, DuplicatesAndNonEmptyTree) {
+  // a duplicate key fails the load before anything is written
+  std::vector<IxEntry> entries{MakeEntry(5), MakeEntry(3), MakeEntry(5)};
+  EXPECT_FALSE(ih_->BulkLoad(&entries, nullptr));
+  EXPECT_TRUE(ScanAll().empty());
+
+  // a few keys fit in the root leaf
+  entries = {MakeEntry(3), MakeEntry(1)};
+  ASSERT_TRUE(ih_->BulkLoad(&entries, nullptr));
+  std::unique_ptr<IxNodeHandle> root(ih_->GetRoot());
+  EXPECT_TRUE(root->IsLeafPage());
+  EXPECT_EQ(root->GetSize(), 2);
+  bpm_->UnpinPage(root->GetPageId(), false);
+
+  // a tree that is not empty gets the keys one by one
+  entries.clear();
+  for (int i = 1000; i > 3; --i) {
+    entries.push_back(MakeEntry(i));
+  }
+  ASSERT_TRUE(ih_->BulkLoad(&entries, nullptr));
+  auto rids = ScanAll();
+  ASSERT_EQ(static_cast<int>(rids.size()), 999);
+  EXPECT_EQ(rids.front(), MakeEntry(1).second);
+  EXPECT_EQ(rids.back(), MakeEntry(1000).second);
+  // the keys before a duplicate are deleted again
+  entries = {MakeEntry(500), MakeEntry(0)};
+  EXPECT_FALSE(ih_->BulkLoad(&entries, nullptr));
+  EXPECT_EQ(ScanAll(), rids);
+}
+
+}  // namespace easydb
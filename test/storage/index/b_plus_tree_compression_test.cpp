@@ -0,0 +1,163 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * b_plus_tree_compression_test.cpp
+ *
+ * Identification: test/storage/index/b_plus_tree_compression_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "compression_test.easydb";
+const std::string TEST_FILE_NAME = "url_table";
+const int KEY_LEN = 128;
+
+class BPlusTreeCompressionTest : public BPlusTreeTest {
+ protected:
+  BPlusTreeCompressionTest()
+      : BPlusTreeTest(TEST_DB_NAME, TEST_FILE_NAME, {ColMeta(TEST_FILE_NAME, "url", TYPE_CHAR, KEY_LEN, 0, true)}) {}
+
+  /** @return a CHAR(128) key: a long common prefix, a group of keys with a longer one, and a short distinct tail */
+  auto MakeKey(int key) const -> std::string override {
+    std::string str = "https://www.example.com/catalog/items/group" + std::to_string(100 + key / 1000) + "/item" +
+                      std::to_string(100000 + key);
+    str.resize(KEY_LEN, '\0');
+    return str;
+  }
+
+  /** The number of keys of the fixed-width layout in a node */
+  auto FixedOrder() const -> int {
+    return static_cast<int>((PAGE_SIZE - sizeof(IxPageHdr) - KEY_LEN) / (KEY_LEN + sizeof(RID)) - 1);
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeCompressionTest, InsertLookupDelete) {
+  const int num_keys = 20000;
+  std::vector<int> keys;
+  for (int i = 0; i < num_keys; ++i) {
+    keys.push_back(i);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  for (int key : keys) {
+    ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key), nullptr), -1);
+  }
+  EXPECT_EQ(ih_->InsertEntry(MakeKey(42).data(), MakeRid(42), nullptr), -1);
+
+  // the keys are found and scanned in order; the prefixes and the trailing zeros are not stored, so the leaves
+  // hold several times the keys of the fixed-width layout
+  for (int key = 0; key < num_keys; ++key) {
+    ASSERT_TRUE(Lookup(key));
+  }
+  EXPECT_FALSE(Lookup(num_keys));
+  int num_leaves;
+  auto rids = ScanAll(&num_leaves);
+  ASSERT_EQ(static_cast<int>(rids.size()), num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    ASSERT_EQ(rids[i], MakeRid(i));
+  }
+  EXPECT_LT(num_leaves * 3, num_keys / FixedOrder());
+
+  // the bounds of the keys in the tree and between them
+  auto rid_at = [this](const Iid &iid) { return IxScan(ih_.get(), iid, ih_->LeafEnd(), bpm_.get()).GetRid(); };
+  EXPECT_EQ(rid_at(ih_->LowerBound(MakeKey(1234).data())), MakeRid(1234));
+  std::string between = MakeKey(1234);
+  between[strlen(between.data())] = '0';
+  EXPECT_EQ(rid_at(ih_->LowerBound(between.data())), MakeRid(1235));
+  EXPECT_EQ(rid_at(ih_->UpperBound(MakeKey(1234).data())), MakeRid(1235));
+  EXPECT_EQ(ih_->LowerBound(MakeKey(num_keys).data()), ih_->LeafEnd());
+
+  // deletes merge and redistribute the nodes, the prefixes of the merged nodes get shorter
+  for (int key = 0; key < num_keys; ++key) {
+    if (key % 3 != 0) {
+      ASSERT_TRUE(ih_->DeleteEntry(MakeKey(key).data(), nullptr));
+    }
+  }
+  for (int key = 0; key < num_keys; ++key) {
+    ASSERT_EQ(Lookup(key), key % 3 == 0);
+  }
+  rids = ScanAll(&num_leaves);
+  ASSERT_EQ(static_cast<int>(rids.size()), (num_keys + 2) / 3);
+  for (size_t i = 0; i < rids.size(); ++i) {
+    ASSERT_EQ(rids[i], MakeRid(3 * i));
+  }
+
+  // the keys that were deleted go in again, between the ones left
+  for (int key = num_keys - 1; key >= 0; --key) {
+    if (key % 3 != 0) {
+      ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key), nullptr), -1);
+    }
+  }
+  rids = ScanAll(&num_leaves);
+  ASSERT_EQ(static_cast<int>(rids.size()), num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    ASSERT_EQ(rids[i], MakeRid(i));
+  }
+  for (int key = 0; key < num_keys; ++key) {
+    ASSERT_TRUE(ih_->DeleteEntry(MakeKey(key).data(), nullptr));
+  }
+  EXPECT_FALSE(Lookup(0));
+}
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeCompressionTest, BulkLoad) {
+  // the nodes built bottom-up are filled by bytes, with the prefixes of their bounds
+  const int num_keys = 50000;
+  std::vector<IxEntry> entries;
+  for (int i = 0; i < num_keys; ++i) {
+    entries.emplace_back(MakeKey(2 * i), MakeRid(2 * i));
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  ASSERT_TRUE(ih_->BulkLoad(&entries, nullptr));
+  int num_leaves;
+  auto rids = ScanAll(&num_leaves);
+  ASSERT_EQ(static_cast<int>(rids.size()), num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    ASSERT_EQ(rids[i], MakeRid(2 * i));
+  }
+  EXPECT_LT(num_leaves * 3, num_keys / FixedOrder());
+  for (int key = 0; key < 2 * num_keys; ++key) {
+    ASSERT_EQ(Lookup(key), key % 2 == 0);
+  }
+
+  // the odd keys split the nodes, concurrently with lookups of the even ones
+  const int num_threads = 4;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int key = 2 * t + 1; key < 2 * num_keys; key += 2 * num_threads) {
+        ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key), nullptr), -1);
+        ASSERT_TRUE(Lookup(2 * static_cast<int>(rng() % num_keys)));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  rids = ScanAll(&num_leaves);
+  ASSERT_EQ(static_cast<int>(rids.size()), 2 * num_keys);
+  for (int i = 0; i < 2 * num_keys; ++i) {
+    ASSERT_EQ(rids[i], MakeRid(i));
+  }
+
+  // the tree survives a restart
+  ReopenIndex();
+  EXPECT_TRUE(Lookup(2 * num_keys - 1));
+}
+
+}  // namespace easydb
@@ -0,0 +1,156 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * b_plus_tree_concurrent_test.cpp
+ *
+ * Identification: test/storage/index/b_plus_tree_concurrent_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "concurrent_index_test.easydb";
+const std::string TEST_FILE_NAME = "concurrent_table";
+const int NUM_THREADS = 8;
+
+class BPlusTreeConcurrentTest : public BPlusTreeTest {
+ protected:
+  BPlusTreeConcurrentTest() : BPlusTreeTest(TEST_DB_NAME, TEST_FILE_NAME) {}
+
+  /** Run func(thread_id) on NUM_THREADS threads at once. */
+  template <typename Func>
+  static void RunThreads(Func func) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; ++i) {
+      threads.emplace_back(func, i);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  static auto HighKey(IxNodeHandle *node) -> int {
+    int key;
+    memcpy(&key, node->GetHighKey(), sizeof(int));
+    ix_decode(reinterpret_cast<char *>(&key), TYPE_INT, sizeof(int));
+    return key;
+  }
+
+  /**
+   * Check the B-link bounds of every level: the nodes are linked from left to right, every node but the last has a
+   * high key that is larger than its keys and not larger than the keys of the next node.
+   */
+  void CheckRightLinks() {
+    std::unique_ptr<IxNodeHandle> first(ih_->GetRoot());
+    while (true) {
+      std::unique_ptr<IxNodeHandle> node(ih_->FetchNode(first->GetPageNo()));
+      while (true) {
+        if (node->GetSize() > 0 && node->HasHighKey()) {
+          EXPECT_LT(node->KeyAt(node->GetSize() - 1), HighKey(node.get()));
+        }
+        page_id_t right = node->GetRightLink();
+        if (right == IX_NO_PAGE) {
+          EXPECT_FALSE(node->HasHighKey());
+          bpm_->UnpinPage(node->GetPageId(), false);
+          break;
+        }
+        std::unique_ptr<IxNodeHandle> next(ih_->FetchNode(right));
+        EXPECT_TRUE(node->HasHighKey());
+        EXPECT_LE(HighKey(node.get()), next->KeyAt(0));
+        bpm_->UnpinPage(node->GetPageId(), false);
+        node = std::move(next);
+      }
+      bpm_->UnpinPage(first->GetPageId(), false);
+      if (first->IsLeafPage()) {
+        break;
+      }
+      first.reset(ih_->FetchNode(first->ValueAt(0)));
+    }
+  }
+
+  /**
+   * Every thread inserts its own keys in random order, interleaved with the other threads, so the leaves and the
+   * internal nodes are split concurrently; meanwhile its own keys inserted before are found, and the keys of the other
+   * threads are looked up. Then deletes merge and redistribute the nodes, at last the tree is emptied.
+   */
+  void RunInsertLookupDelete() {
+    const int keys_per_thread = 5000;
+    const int num_keys = keys_per_thread * NUM_THREADS;
+    std::atomic<int> num_inserted{0};
+    RunThreads([&](int thread_id) {
+      std::vector<int> keys;
+      for (int i = 0; i < keys_per_thread; ++i) {
+        keys.push_back(i * NUM_THREADS + thread_id);
+      }
+      std::shuffle(keys.begin(), keys.end(), std::mt19937(thread_id));
+      std::mt19937 rng(thread_id + NUM_THREADS);
+      for (int i = 0; i < keys_per_thread; ++i) {
+        ASSERT_NE(ih_->InsertEntry(MakeKey(keys[i]).data(), MakeRid(keys[i]), nullptr), -1);
+        num_inserted++;
+        ASSERT_TRUE(Lookup(keys[rng() % (i + 1)]));
+        Lookup(static_cast<int>(rng() % num_keys));
+      }
+    });
+    ASSERT_EQ(num_inserted.load(), num_keys);
+    for (int key = 0; key < num_keys; ++key) {
+      ASSERT_TRUE(Lookup(key));
+    }
+    CheckRightLinks();
+
+    // the threads delete the even keys, so that nodes are merged and redistributed, while the odd keys are read
+    RunThreads([&](int thread_id) {
+      for (int i = 0; i < keys_per_thread; ++i) {
+        int key = i * NUM_THREADS + thread_id;
+        if (key % 2 == 0) {
+          ASSERT_TRUE(ih_->DeleteEntry(MakeKey(key).data(), nullptr));
+        } else {
+          ASSERT_TRUE(Lookup(key));
+        }
+      }
+    });
+    auto rids = ScanAll();
+    ASSERT_EQ(static_cast<int>(rids.size()), num_keys / 2);
+    for (int i = 0; i < num_keys / 2; ++i) {
+      ASSERT_EQ(rids[i], MakeRid(2 * i + 1));
+    }
+    CheckRightLinks();
+
+    // deleting every key leaves an empty root that takes new keys again
+    RunThreads([&](int thread_id) {
+      for (int key = 2 * thread_id + 1; key < num_keys; key += 2 * NUM_THREADS) {
+        ASSERT_TRUE(ih_->DeleteEntry(MakeKey(key).data(), nullptr));
+      }
+    });
+    EXPECT_FALSE(Lookup(1));
+    int key = 42;
+    ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key), nullptr), -1);
+    EXPECT_TRUE(Lookup(key));
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeConcurrentTest, InsertLookupDelete) {
+  // lookups hold one latch at a time and move right past concurrent splits
+  RunInsertLookupDelete();
+}
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeConcurrentTest, InsertLookupDeleteCrabbing) {
+  ih_->SetBLink(false);
+  RunInsertLookupDelete();
+}
+
+}  // namespace easydb
@@ -0,0 +1,126 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * b_plus_tree_include_test.cpp
+ *
+ * Identification: test/storage/index/b_plus_tree_include_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "include_test.easydb";
+const std::string TEST_FILE_NAME = "include_table";
+const int NAME_LEN = 16;
+
+class BPlusTreeIncludeTest : public BPlusTreeTest {
+ protected:
+  // a small pool, so that the leaves are written back and read again
+  BPlusTreeIncludeTest()
+      : BPlusTreeTest(TEST_DB_NAME, TEST_FILE_NAME, {ColMeta(TEST_FILE_NAME, "id", TYPE_INT, sizeof(int), 0, true)}, 32,
+                      INCLUDE_LEN) {}
+
+  /** @return the INT key followed by the payload of INCLUDE (name CHAR(16), score INT); every 7th score is NULL */
+  static auto MakeEntry(int key, int version = 0) -> std::string {
+    std::string entry(sizeof(int) + INCLUDE_LEN, '\0');
+    ix_memcpy(entry.data(), Value(TYPE_INT, key), sizeof(int));
+    ix_include_memcpy(entry.data() + sizeof(int), Value(TYPE_CHAR, "name" + std::to_string(key + version)), NAME_LEN);
+    ix_include_memcpy(entry.data() + sizeof(int) + 1 + NAME_LEN,
+                      key % 7 == 0 ? Value(TYPE_INT) : Value(TYPE_INT, key * 10 + version), sizeof(int));
+    return entry;
+  }
+
+  /** Check that the leaves hold the keys in order, each with its rid and payload */
+  void CheckAll(const std::vector<int> &keys, int version = 0) {
+    std::string entry(sizeof(int) + INCLUDE_LEN, '\0');
+    size_t i = 0;
+    for (IxScan scan(ih_.get(), ih_->LeafBegin(), ih_->LeafEnd(), bpm_.get()); !scan.IsEnd(); scan.Next(), ++i) {
+      ASSERT_LT(i, keys.size());
+      ASSERT_EQ(scan.GetEntry(entry.data()), MakeRid(keys[i]));
+      ASSERT_EQ(entry, MakeEntry(keys[i], version));
+    }
+    EXPECT_EQ(i, keys.size());
+  }
+
+  static constexpr int INCLUDE_LEN = 1 + NAME_LEN + 1 + sizeof(int);
+};
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeIncludeTest, PayloadFollowsTheKey) {
+  // the payload decodes to the values of the INCLUDE columns, NULLs included
+  auto entry = MakeEntry(14);
+  EXPECT_EQ(ix_include_value(entry.data() + sizeof(int), TYPE_CHAR, NAME_LEN).ToString(), "name14");
+  EXPECT_TRUE(ix_include_value(entry.data() + sizeof(int) + 1 + NAME_LEN, TYPE_INT, sizeof(int)).IsNull());
+  EXPECT_EQ(ix_include_value(MakeEntry(15).data() + sizeof(int) + 1 + NAME_LEN, TYPE_INT, sizeof(int)).GetAs<int>(),
+            150);
+
+  // random inserts split the leaves, the payload moves with its key
+  const int num_keys = 20000;
+  std::vector<int> keys;
+  for (int i = 0; i < num_keys; ++i) {
+    keys.push_back(i);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  for (int key : keys) {
+    ASSERT_NE(ih_->InsertEntry(MakeEntry(key).data(), MakeRid(key), nullptr), -1);
+  }
+  // the payload does not take part in the comparison
+  EXPECT_EQ(ih_->InsertEntry(MakeEntry(42, 1).data(), MakeRid(42), nullptr), -1);
+  std::sort(keys.begin(), keys.end());
+  CheckAll(keys);
+  std::vector<RID> result;
+  ASSERT_TRUE(ih_->GetValue(MakeEntry(1234).data(), &result, nullptr));
+  EXPECT_EQ(result[0], MakeRid(1234));
+
+  // deletes merge and redistribute the leaves
+  std::vector<int> left;
+  for (int key = 0; key < num_keys; ++key) {
+    if (key % 3 != 0) {
+      ASSERT_TRUE(ih_->DeleteEntry(MakeEntry(key).data(), nullptr));
+    } else {
+      left.push_back(key);
+    }
+  }
+  CheckAll(left);
+
+  // the tree survives a restart
+  ReopenIndex();
+  CheckAll(left);
+}
+
+// NOLINTNEXTLINE
+TEST_F(BPlusTreeIncludeTest, BulkLoad) {
+  const int num_keys = 30000;
+  std::vector<IxEntry> entries;
+  std::vector<int> keys;
+  for (int i = 0; i < num_keys; ++i) {
+    entries.emplace_back(MakeEntry(2 * i, 1), MakeRid(2 * i));
+    keys.push_back(2 * i);
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+  ASSERT_TRUE(ih_->BulkLoad(&entries, nullptr));
+  CheckAll(keys, 1);
+
+  // the leaves built bottom-up are split by the inserts of the odd keys
+  for (int i = 0; i < num_keys; ++i) {
+    ASSERT_NE(ih_->InsertEntry(MakeEntry(2 * i + 1, 1).data(), MakeRid(2 * i + 1), nullptr), -1);
+  }
+  keys.clear();
+  for (int i = 0; i < 2 * num_keys; ++i) {
+    keys.push_back(i);
+  }
+  CheckAll(keys, 1);
+}
+
+}  // namespace easydb
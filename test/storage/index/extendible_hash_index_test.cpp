@@ -1,238 +1,198 @@
-// // ix_extendible_hash_index_handle_test.cpp
-
-// #include <gtest/gtest.h>
-// #include <filesystem>
-// #include <vector>
-// #include "buffer/buffer_pool_manager.h"
-// #include "defs.h"
-// #include "storage/disk/disk_manager.h"
-// #include "storage/index/ix_defs.h"
-// #include "storage/index/ix_extendible_hash_index_handle.h"
-// #include "storage/index/ix_manager.h"
-// #include "system/sm_meta.h"
-// namespace easydb {
-
-// // Helper function to convert int to char key
-// const char *IntToKey(int key_int) {
-//   char *key = new char[sizeof(int)];
-//   memcpy(key, &key_int, sizeof(int));
-//   return key;
-// }
-
-// // Helper function to clean up key
-// void DeleteKey(const char *key) { delete[] key; }
-
-// class IxExtendibleHashIndexHandleTest : public ::testing::Test {
-//  protected:
-//   void SetUp() override {
-//     // Create a unique temporary directory
-//     temp_dir = "ix_test_dir";
-//     std::filesystem::create_directory(temp_dir);
-
-//     // Initialize DiskManager
-//     disk_manager = new DiskManager(temp_dir);
-
-//     // Initialize BufferPoolManager with 10 frames
-//     buffer_pool_manager = new BufferPoolManager(10, disk_manager);
-
-//     // Initialize ColMeta
-//     ColMeta tmp;
-//     tmp.tab_name = "index_test";
-//     tmp.name = "tp1";
-//     tmp.type = {TYPE_INT};
-//     tmp.len = sizeof(int);
-//     tmp.offset = 0;
-//     tmp.index = true;
-//     index_cols.push_back(tmp);
-
-//     // Initialize index_manager
-//     index_manager = new IxManager(disk_manager, buffer_pool_manager);
-//     // Create index file
-//     index_file = "test_index_file";
-//     index_manager->CreateIndex(index_file, index_cols);
-
-//     index_handle = (IxExtendibleHashIndexHandle *)&(*index_manager->OpenIndex(index_file, index_cols));
-//   }
-
-//   void TearDown() override {
-//     delete index_handle;
-//     delete buffer_pool_manager;
-//     delete disk_manager;
-//     delete index_manager;
-//     // Remove temporary directory and its contents
-//     std::filesystem::remove_all(temp_dir);
-//   }
-
-//   std::filesystem::path temp_dir;
-//   DiskManager *disk_manager;
-//   BufferPoolManager *buffer_pool_manager;
-//   IxExtendibleHashIndexHandle *index_handle;
-//   IxManager *index_manager;
-//   std::filesystem::path index_file;
-//   std::vector<ColMeta> index_cols;
-//   // int fd;
-// };
-
-// TEST_F(IxExtendibleHashIndexHandleTest, InsertSingleEntry) {
-//   int key_int = 42;
-//   const char *key = IntToKey(key_int);
-//   RID value = {1, 1};
-
-//   page_id_t inserted_page = index_handle->InsertEntry(key, value);
-//   page_id_t res = 2 + index_handle->HashFunction(key, index_handle->getGlobalDepth());
-//   EXPECT_EQ(inserted_page, res);
-
-//   std::vector<RID> result;
-//   bool found = index_handle->GetValue(key, &result);
-//   EXPECT_TRUE(found);
-//   ASSERT_EQ(result.size(), 1);
-//   EXPECT_EQ(result[0].GetPageId(), value.GetPageId());
-//   EXPECT_EQ(result[0].GetSlotNum(), value.GetSlotNum());
-
-//   DeleteKey(key);
-//   index_manager->CloseIndex(index_handle);
-//   index_manager->DestroyIndex(index_file, index_cols);
-// }
-
-// TEST_F(IxExtendibleHashIndexHandleTest, InsertMultipleEntries) {
-//   std::vector<int> keys_int = {10, 20, 30, 40};
-//   std::vector<RID> values = {{1, 1}, {1, 2}, {1, 3}, {1, 4}};
-
-//   for (size_t i = 0; i < keys_int.size(); ++i) {
-//     const char *key = IntToKey(keys_int[i]);
-//     page_id_t inserted_page = index_handle->InsertEntry(key, values[i]);
-//     page_id_t res = 2 + index_handle->HashFunction(key, index_handle->getGlobalDepth());
-//     EXPECT_EQ(inserted_page, res);
-//     DeleteKey(key);
-//   }
-
-//   for (size_t i = 0; i < keys_int.size(); ++i) {
-//     const char *key = IntToKey(keys_int[i]);
-//     page_id_t index = index_handle->HashFunction(key, index_handle->getGlobalDepth());
-//     std::vector<RID> result;
-//     bool found = index_handle->GetValue(key, &result);
-//     EXPECT_TRUE(found);
-//     ASSERT_EQ(result.size(), 1);
-//     EXPECT_EQ(result[0].GetPageId(), values[i].GetPageId());
-//     EXPECT_EQ(result[0].GetSlotNum(), values[i].GetSlotNum());
-//     DeleteKey(key);
-//   }
-//   index_manager->CloseIndex(index_handle);
-//   index_manager->DestroyIndex(index_file, index_cols);
-// }
-
-// TEST_F(IxExtendibleHashIndexHandleTest, RemoveEntry) {
-//   int key_int = 55;
-//   const char *key = IntToKey(key_int);
-//   RID value = {2, 2};
-
-//   page_id_t inserted_page = index_handle->InsertEntry(key, value);
-//   page_id_t res = 2 + index_handle->HashFunction(key, index_handle->getGlobalDepth());
-//   EXPECT_EQ(inserted_page, res);
-
-//   // Verify insertion
-//   std::vector<RID> result;
-//   bool found = index_handle->GetValue(key, &result);
-//   EXPECT_TRUE(found);
-//   ASSERT_EQ(result.size(), 1);
-//   EXPECT_EQ(result[0].GetPageId(), value.GetPageId());
-//   EXPECT_EQ(result[0].GetSlotNum(), value.GetSlotNum());
-
-//   // Remove the entry
-//   bool removed = index_handle->DeleteEntry(key);
-//   EXPECT_TRUE(removed);
-
-//   // Verify removal
-//   result.clear();
-//   found = index_handle->GetValue(key, &result);
-//   EXPECT_FALSE(found);
-
-//   DeleteKey(key);
-//   index_manager->CloseIndex(index_handle);
-//   index_manager->DestroyIndex(index_file, index_cols);
-// }
-
-// TEST_F(IxExtendibleHashIndexHandleTest, HandleDuplicateKeys) {
-//   int key_int = 99;
-//   const char *key = IntToKey(key_int);
-//   RID value1 = {3, 1};
-//   RID value2 = {3, 2};
-
-//   // Insert first entry
-//   page_id_t inserted_page1 = index_handle->InsertEntry(key, value1);
-//   page_id_t res = 2 + index_handle->HashFunction(key, index_handle->getGlobalDepth());
-//   EXPECT_EQ(inserted_page1, res);
-
-//   // Insert duplicate key
-//   page_id_t inserted_page2 = index_handle->InsertEntry(key, value2);
-//   res = 2 + index_handle->HashFunction(key, index_handle->getGlobalDepth());
-//   EXPECT_EQ(inserted_page2, res);
-
-//   // Verify both entries exist
-//   std::vector<RID> result;
-//   bool found = index_handle->GetValue(key, &result);
-//   EXPECT_TRUE(found);
-//   ASSERT_EQ(result.size(), 2);
-//   EXPECT_EQ(result[0].GetPageId(), value1.GetPageId());
-//   EXPECT_EQ(result[0].GetSlotNum(), value1.GetSlotNum());
-//   EXPECT_EQ(result[1].GetPageId(), value2.GetPageId());
-//   EXPECT_EQ(result[1].GetSlotNum(), value2.GetSlotNum());
-
-//   // Clean up
-//   bool removed = index_handle->DeleteEntry(key);
-//   EXPECT_TRUE(removed);
-
-//   // Verify removal
-//   result.clear();
-//   found = index_handle->GetValue(key, &result);
-//   EXPECT_FALSE(found);
-
-//   DeleteKey(key);
-//   index_manager->CloseIndex(index_handle);
-//   index_manager->DestroyIndex(index_file, index_cols);
-// }
-
-// TEST_F(IxExtendibleHashIndexHandleTest, BucketSplit) {
-//   // Assuming size_per_bucket is 4, insert 5 entries to trigger a split
-//   std::vector<int> keys_int = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
-//                                16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30};
-//   std::vector<RID> values = {{1, 1},  {1, 2},  {1, 3},  {1, 4},  {2, 5},  {2, 6},  {2, 7},  {2, 8},  {3, 9},  {3, 10},
-//                              {3, 11}, {3, 12}, {4, 13}, {4, 14}, {4, 15}, {4, 16}, {5, 17}, {5, 18}, {5, 19}, {5, 20},
-//                              {6, 21}, {6, 22}, {6, 23}, {6, 24}, {7, 25}, {7, 26}, {7, 27}, {7, 28}, {8, 29}, {8, 30}};
-
-//   for (size_t i = 0; i < keys_int.size(); ++i) {
-//     const char *key = IntToKey(keys_int[i]);
-//     page_id_t inserted_page = index_handle->InsertEntry(key, values[i]);
-//     std::vector<RID> result;
-//     bool found = index_handle->GetValue(key, &result);
-//     EXPECT_EQ(result.size(), 1);
-//     EXPECT_EQ(result[0].GetPageId(), values[i].GetPageId());
-//     EXPECT_EQ(result[0].GetSlotNum(), values[i].GetSlotNum());
-//     DeleteKey(key);
-//   }
-
-//   // Verify all entries
-//   for (size_t i = 0; i < keys_int.size(); ++i) {
-//     const char *key = IntToKey(keys_int[i]);
-//     std::vector<RID> result;
-//     bool found = index_handle->GetValue(key, &result);
-//     EXPECT_TRUE(found);
-//     // EXPECT_EQ(result.size(), 1) << "Key " << keys_int[i] << " has incorrect number of Rids.";
-//     EXPECT_EQ(result[0].GetPageId(), values[i].GetPageId());
-//     EXPECT_EQ(result[0].GetSlotNum(), values[i].GetSlotNum());
-//     DeleteKey(key);
-//   }
-
-//   // Optionally, verify that global depth has increased
-//   // Since global_depth is set to 1 initially, after a split it should be 2
-//   EXPECT_EQ(index_handle->getGlobalDepth(), 2);
-//   index_manager->CloseIndex(index_handle);
-//   index_manager->DestroyIndex(index_file, index_cols);
-// }
-
-// }  // namespace easydb
-
-// int main(int argc, char **argv) {
-//   ::testing::InitGoogleTest(&argc, argv);
-//   return RUN_ALL_TESTS();
-// }
\ No newline at end of file
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * extendible_hash_index_test.cpp
+ *
+ * Identification: test/storage/index/extendible_hash_index_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/index/ix_manager.h"
+#include "system/sm_meta.h"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "extendible_hash_test.easydb";
+const std::string TEST_FILE_NAME = "hash_table";
+
+class ExtendibleHashIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::filesystem::remove_all(TEST_DB_NAME);
+    disk_manager_ = std::make_unique<DiskManager>(TEST_DB_NAME);
+    std::filesystem::current_path(TEST_DB_NAME);
+    // a small pool, so that the buckets are written back and read again
+    bpm_ = std::make_unique<BufferPoolManager>(32, disk_manager_.get());
+    ix_manager_ = std::make_unique<IxManager>(disk_manager_.get(), bpm_.get());
+    ix_manager_->CreateExtendibleHashIndex(TEST_FILE_NAME, index_cols_);
+    ih_ = ix_manager_->OpenExtendibleHashIndex(TEST_FILE_NAME, index_cols_);
+  }
+
+  void TearDown() override {
+    ix_manager_->CloseExtendibleHashIndex(ih_.get());
+    std::filesystem::current_path("..");
+    std::filesystem::remove_all(TEST_DB_NAME);
+  }
+
+  static auto MakeKey(int key) -> std::string {
+    std::string buf(sizeof(int), '\0');
+    ix_memcpy(buf.data(), Value(TYPE_INT, key), sizeof(int));
+    return buf;
+  }
+
+  static auto MakeRid(int key) -> RID { return RID{key / 100, key % 100}; }
+
+  /** Check that each key is found with its rid and that the others are not found */
+  void CheckAll(int num_keys, const std::function<bool(int)> &exists) {
+    for (int key = 0; key < num_keys; ++key) {
+      std::vector<RID> result;
+      ASSERT_EQ(ih_->GetValue(MakeKey(key).data(), &result), exists(key)) << key;
+      if (exists(key)) {
+        ASSERT_EQ(result.size(), 1U);
+        ASSERT_EQ(result[0], MakeRid(key));
+      }
+    }
+  }
+
+  /** Run func(thread_id) on NUM_THREADS threads at once. */
+  template <typename Func>
+  static void RunThreads(Func func) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; ++i) {
+      threads.emplace_back(func, i);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+
+  static constexpr int NUM_THREADS = 8;
+  std::vector<ColMeta> index_cols_{ColMeta(TEST_FILE_NAME, "id", TYPE_INT, sizeof(int), 0, true)};
+  std::unique_ptr<DiskManager> disk_manager_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  std::unique_ptr<IxManager> ix_manager_;
+  std::unique_ptr<IxExtendibleHashIndexHandle> ih_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(ExtendibleHashIndexTest, InsertSplitAndDelete) {
+  // random inserts split the buckets and double the directory
+  const int num_keys = 50000;
+  std::vector<int> keys;
+  for (int i = 0; i < num_keys; ++i) {
+    keys.push_back(i);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  for (int key : keys) {
+    ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key)), IX_NO_PAGE);
+  }
+  // every bucket holds at most GetBucketSize keys, so the directory grew past the two initial buckets
+  EXPECT_GE(1 << ih_->GetGlobalDepth(), num_keys / ih_->GetBucketSize());
+  // the keys are unique
+  EXPECT_EQ(ih_->InsertEntry(MakeKey(42).data(), MakeRid(43)), IX_NO_PAGE);
+  CheckAll(num_keys, [](int) { return true; });
+  std::vector<RID> result;
+  EXPECT_FALSE(ih_->GetValue(MakeKey(num_keys).data(), &result));
+  EXPECT_TRUE(result.empty());
+
+  // delete two thirds of the keys, then insert some of them again
+  for (int key = 0; key < num_keys; ++key) {
+    if (key % 3 != 0) {
+      ASSERT_TRUE(ih_->DeleteEntry(MakeKey(key).data()));
+    }
+  }
+  EXPECT_FALSE(ih_->DeleteEntry(MakeKey(1).data()));
+  CheckAll(num_keys, [](int key) { return key % 3 == 0; });
+  for (int key = 1; key < num_keys; key += 3) {
+    ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key)), IX_NO_PAGE);
+  }
+  CheckAll(num_keys, [](int key) { return key % 3 != 2; });
+
+  // the same key always locks the same object, other keys do not share it (with overwhelming probability)
+  EXPECT_EQ(ih_->GetKeyLock(MakeKey(7).data()), ih_->GetKeyLock(MakeKey(7).data()));
+  EXPECT_NE(ih_->GetKeyLock(MakeKey(7).data()), ih_->GetKeyLock(MakeKey(8).data()));
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExtendibleHashIndexTest, Reopen) {
+  // the directory spans several directory pages
+  const int num_keys = 200000;
+  for (int key = 0; key < num_keys; ++key) {
+    ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key)), IX_NO_PAGE);
+  }
+  int global_depth = ih_->GetGlobalDepth();
+  ASSERT_GT(1 << global_depth, IX_HASH_DIR_ENTRIES_PER_PAGE);
+
+  // the directory is written back on close and read again on open
+  ix_manager_->CloseExtendibleHashIndex(ih_.get());
+  ih_ = ix_manager_->OpenExtendibleHashIndex(TEST_FILE_NAME, index_cols_);
+  EXPECT_EQ(ih_->GetGlobalDepth(), global_depth);
+  CheckAll(num_keys, [](int) { return true; });
+
+  // new buckets are allocated after the pages of the file
+  for (int key = num_keys; key < 2 * num_keys; ++key) {
+    ASSERT_NE(ih_->InsertEntry(MakeKey(key).data(), MakeRid(key)), IX_NO_PAGE);
+  }
+  CheckAll(2 * num_keys, [](int) { return true; });
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExtendibleHashIndexTest, ConcurrentInsertLookupDelete) {
+  // every thread inserts its own keys while the other threads split the buckets and double the directory; meanwhile
+  // its own keys inserted before are found and the keys of the other threads are looked up
+  const int keys_per_thread = 10000;
+  const int num_keys = keys_per_thread * NUM_THREADS;
+  std::atomic<int> num_inserted{0};
+  RunThreads([&](int thread_id) {
+    std::vector<int> keys;
+    for (int i = 0; i < keys_per_thread; ++i) {
+      keys.push_back(i * NUM_THREADS + thread_id);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(thread_id));
+    std::mt19937 rng(thread_id + NUM_THREADS);
+    for (int i = 0; i < keys_per_thread; ++i) {
+      ASSERT_NE(ih_->InsertEntry(MakeKey(keys[i]).data(), MakeRid(keys[i])), IX_NO_PAGE);
+      num_inserted++;
+      std::vector<RID> result;
+      ASSERT_TRUE(ih_->GetValue(MakeKey(keys[rng() % (i + 1)]).data(), &result));
+      ih_->GetValue(MakeKey(static_cast<int>(rng() % num_keys)).data(), &result);
+      // two threads inserting the same key: at most one of them succeeds
+      if (ih_->InsertEntry(MakeKey(num_keys + i).data(), MakeRid(num_keys + i)) != IX_NO_PAGE) {
+        num_inserted++;
+      }
+    }
+  });
+  ASSERT_EQ(num_inserted.load(), num_keys + keys_per_thread);
+  CheckAll(num_keys + keys_per_thread, [](int) { return true; });
+
+  // the threads delete the even keys while the odd keys are read
+  RunThreads([&](int thread_id) {
+    for (int i = 0; i < keys_per_thread; ++i) {
+      int key = i * NUM_THREADS + thread_id;
+      std::vector<RID> result;
+      if (key % 2 == 0) {
+        ASSERT_TRUE(ih_->DeleteEntry(MakeKey(key).data()));
+      } else {
+        ASSERT_TRUE(ih_->GetValue(MakeKey(key).data(), &result));
+      }
+    }
+  });
+  CheckAll(num_keys, [](int key) { return key % 2 == 1; });
+}
+
+}  // namespace easydb
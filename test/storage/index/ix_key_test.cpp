@@ -0,0 +1,135 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * ix_key_test.cpp
+ *
+ * Identification: test/storage/index/ix_key_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "ix_key_test.easydb";
+const std::string TEST_FILE_NAME = "key_table";
+
+/** @return the key of the values, encoded as ix_memcpy does for the index */
+auto EncodeKey(const std::vector<Value> &values, const std::vector<int> &lens) -> std::string {
+  std::string key;
+  for (size_t i = 0; i < values.size(); ++i) {
+    std::string col(lens[i], '\0');
+    ix_memcpy(col.data(), values[i], lens[i]);
+    key += col;
+  }
+  return key;
+}
+
+// NOLINTNEXTLINE
+TEST(IxKeyTest, EncodingKeepsOrder) {
+  // the bytes of the keys compare as the values, negative numbers included
+  std::vector<Value> values{Value(TYPE_INT, -2000000000), Value(TYPE_INT, -1), Value(TYPE_INT, 0),
+                            Value(TYPE_INT, 1), Value(TYPE_INT, 256), Value(TYPE_INT, 2000000000)};
+  for (size_t i = 1; i < values.size(); ++i) {
+    EXPECT_LT(EncodeKey({values[i - 1]}, {4}), EncodeKey({values[i]}, {4}));
+  }
+  // FLOAT values are stored as 8-byte doubles
+  std::vector<double> floats{-1e300, -2.5, -1e-300, 0.0, 1e-300, 0.5, 3.0, 1e300};
+  for (size_t i = 1; i < floats.size(); ++i) {
+    EXPECT_LT(EncodeKey({Value(TYPE_FLOAT, floats[i - 1])}, {8}), EncodeKey({Value(TYPE_FLOAT, floats[i])}, {8}));
+  }
+  // -0.0 and 0.0 are the same key
+  EXPECT_EQ(EncodeKey({Value(TYPE_FLOAT, -0.0)}, {8}), EncodeKey({Value(TYPE_FLOAT, 0.0)}, {8}));
+
+  // a composite key compares column by column
+  EXPECT_LT(EncodeKey({Value(TYPE_INT, -1), Value(TYPE_FLOAT, 9.0)}, {4, 8}),
+            EncodeKey({Value(TYPE_INT, 0), Value(TYPE_FLOAT, -9.0)}, {4, 8}));
+  EXPECT_LT(EncodeKey({Value(TYPE_INT, 7), Value(TYPE_FLOAT, -9.0)}, {4, 8}),
+            EncodeKey({Value(TYPE_INT, 7), Value(TYPE_FLOAT, -8.0)}, {4, 8}));
+
+  // the values are decoded back
+  for (int val : {-7, 0, 123456}) {
+    std::string key = EncodeKey({Value(TYPE_INT, val)}, {4});
+    ix_decode(key.data(), TYPE_INT, 4);
+    EXPECT_EQ(*reinterpret_cast<const int *>(key.data()), val);
+  }
+  for (double val : {-2.5, 0.0, 1e300}) {
+    std::string key = EncodeKey({Value(TYPE_FLOAT, val)}, {8});
+    ix_decode(key.data(), TYPE_FLOAT, 8);
+    EXPECT_EQ(*reinterpret_cast<const double *>(key.data()), val);
+  }
+}
+
+class IxKeyTreeTest : public BPlusTreeTest {
+ protected:
+  // the index is created by CheckKeys on a column of the type
+  IxKeyTreeTest() : BPlusTreeTest(TEST_DB_NAME, TEST_FILE_NAME, std::vector<ColMeta>()) {}
+
+  /**
+   * Insert the even numbers in [-20000, 20000) in random order, so that the odd ones fall between the keys; check
+   * the scan order and the bounds of every number at every position of the nodes.
+   */
+  void CheckKeys(ColType type) {
+    int len = type == TYPE_INT ? 4 : 8;
+    index_cols_ = {ColMeta(TEST_FILE_NAME, "k", type, len, 0, true)};
+    CreateIndex();
+    auto make_key = [type, len](int i) {
+      return EncodeKey({type == TYPE_INT ? Value(TYPE_INT, i) : Value(TYPE_FLOAT, i / 4.0)}, {len});
+    };
+
+    std::vector<int> keys;
+    for (int i = -20000; i < 20000; i += 2) {
+      keys.push_back(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+    for (int i : keys) {
+      ASSERT_NE(ih_->InsertEntry(make_key(i).data(), RID{i + 20000, 0}, nullptr), -1);
+    }
+    auto rids = ScanAll();
+    ASSERT_EQ(rids.size(), keys.size());
+    for (size_t i = 0; i < rids.size(); ++i) {
+      ASSERT_EQ(rids[i].GetPageId(), static_cast<int>(2 * i));
+    }
+
+    // the bounds of keys in the tree and between them, at every position of the nodes
+    for (int i = -20001; i < 20000; ++i) {
+      int expect_lower = std::clamp((i + 20001) / 2, 0, 20000);
+      int expect_upper = std::clamp((i + 20002) / 2, 0, 20000);
+      auto lower = ih_->LowerBound(make_key(i).data());
+      auto upper = ih_->UpperBound(make_key(i).data());
+      if (expect_lower < 20000) {
+        ASSERT_EQ(IxScan(ih_.get(), lower, ih_->LeafEnd(), bpm_.get()).GetRid().GetPageId(), 2 * expect_lower);
+      } else {
+        ASSERT_EQ(lower, ih_->LeafEnd());
+      }
+      if (expect_upper < 20000) {
+        ASSERT_EQ(IxScan(ih_.get(), upper, ih_->LeafEnd(), bpm_.get()).GetRid().GetPageId(), 2 * expect_upper);
+      } else {
+        ASSERT_EQ(upper, ih_->LeafEnd());
+      }
+    }
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(IxKeyTreeTest, IntKeys) {
+  // an INT index searches the nodes as integers
+  CheckKeys(TYPE_INT);
+}
+
+// NOLINTNEXTLINE
+TEST_F(IxKeyTreeTest, FloatKeys) {
+  // a FLOAT index searches the nodes byte by byte
+  CheckKeys(TYPE_FLOAT);
+}
+
+}  // namespace easydb
@@ -0,0 +1,92 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * tuple_test.cpp
+ *
+ * Identification: test/storage/table/tuple_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/common.h"
+#include "gtest/gtest.h"
+#include "storage/table/tuple.h"
+
+namespace easydb {
+
+// NOLINTNEXTLINE
+TEST(TupleTest, NullBitmap) {
+  std::vector<Column> columns;
+  for (int i = 0; i < 9; ++i) {
+    if (i % 3 == 2) {
+      columns.emplace_back("c" + std::to_string(i), TYPE_VARCHAR, 8);
+    } else {
+      columns.emplace_back("c" + std::to_string(i), TYPE_INT);
+    }
+  }
+  Schema schema(columns);
+  EXPECT_EQ(schema.GetNullBitmapSize(), 2);
+  EXPECT_EQ(schema.GetInlinedStorageSize(), schema.GetNullBitmapOffset() + 2);
+
+  // the columns 1, 5 and 8 are null, which spans both bytes of the bitmap
+  std::vector<Value> values;
+  for (int i = 0; i < 9; ++i) {
+    bool is_null = i == 1 || i == 5 || i == 8;
+    if (columns[i].GetType() == TYPE_VARCHAR) {
+      values.push_back(is_null ? Value(TYPE_VARCHAR) : Value(TYPE_VARCHAR, std::string(i, 'x')));
+    } else {
+      values.push_back(is_null ? Value(TYPE_INT) : Value(TYPE_INT, i * 10));
+    }
+  }
+  Tuple tuple(values, &schema);
+  TupleView view(tuple.GetData(), tuple.GetLength(), tuple.GetRid());
+  for (uint32_t i = 0; i < 9; ++i) {
+    bool is_null = i == 1 || i == 5 || i == 8;
+    EXPECT_EQ(tuple.IsNull(&schema, i), is_null);
+    EXPECT_EQ(view.IsNull(&schema, i), is_null);
+    EXPECT_EQ(tuple.GetValue(&schema, i).IsNull(), is_null);
+    EXPECT_EQ(view.GetValue(&schema, i).IsNull(), is_null);
+  }
+  EXPECT_EQ(tuple.GetValue(&schema, 3).GetAs<int>(), 30);
+  EXPECT_EQ(view.GetValue(&schema, 2).ToString(), "xx");
+  EXPECT_EQ(tuple.ToString(&schema), "(0, <NULL>, xx, 30, 40, <NULL>, 60, 70, <NULL>)");
+
+  // nulls survive rebuilding the tuple from its values
+  EXPECT_TRUE(IsTupleContentEqual(Tuple(tuple.GetValueVec(&schema), &schema), tuple));
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, SortNullFirst) {
+  Schema schema({Column("id", TYPE_INT), Column("price", TYPE_FLOAT)});
+  std::vector<Tuple> tuples;
+  for (int id : {3, 0, 2, 1}) {
+    Value price = id % 2 == 0 ? Value(TYPE_FLOAT) : Value(TYPE_FLOAT, static_cast<float>(-id));
+    tuples.emplace_back(std::vector<Value>{Value(TYPE_INT, id), price}, &schema);
+  }
+  auto ids = [&]() {
+    std::vector<int> res;
+    for (auto &tuple : tuples) {
+      res.push_back(tuple.GetValue(&schema, 0).GetAs<int>());
+    }
+    return res;
+  };
+
+  // a null price is not 0: it goes before the negative prices, and after them in descending order
+  std::sort(tuples.begin(), tuples.end(), cmpTuple(false, &schema, 1));
+  EXPECT_TRUE(tuples[0].IsNull(&schema, 1));
+  EXPECT_TRUE(tuples[1].IsNull(&schema, 1));
+  EXPECT_EQ(ids()[2], 3);
+  EXPECT_EQ(ids()[3], 1);
+  std::sort(tuples.begin(), tuples.end(), cmpTuple(true, &schema, 1));
+  EXPECT_EQ(ids()[0], 1);
+  EXPECT_EQ(ids()[1], 3);
+  EXPECT_TRUE(tuples[3].IsNull(&schema, 1));
+}
+
+}  // namespace easydb
@@ -0,0 +1,229 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * load_data_test.cpp
+ *
+ * Identification: test/system/load_data_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "execution/executor_index_scan.h"
+#include "gtest/gtest.h"
+#include "record/rm_scan.h"
+#include "system/sm_manager_test.hpp"
+
+namespace easydb {
+
+const std::string TEST_DB_NAME = "load_data_test.easydb";
+const std::string TEST_TB_NAME = "item";
+const std::string TEST_CSV_NAME = "item.tbl";
+
+class LoadDataTest : public SmManagerTest {
+ protected:
+  LoadDataTest() : SmManagerTest(TEST_DB_NAME, TEST_TB_NAME) {}
+
+  void SetUp() override {
+    SmManagerTest::SetUp();
+    sm_manager_->CreateTable(
+        TEST_TB_NAME, {{"id", TYPE_INT, sizeof(int)}, {"name", TYPE_CHAR, 16}, {"price", TYPE_FLOAT, sizeof(float)}},
+        nullptr);
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(LoadDataTest, ParallelChunks) {
+  // a few MB of rows, so that the file is split between several threads; the last line has no '\n'
+  const int num_rows = 150000;
+  {
+    std::ofstream csv(TEST_CSV_NAME);
+    for (int i = 0; i < num_rows; ++i) {
+      csv << i << "|item" << i % 1000 << "|";
+      if (i % 100 != 7) {
+        csv << i % 50 << ".5";
+      }
+      csv << (i + 1 < num_rows ? "|\n" : "|");
+    }
+  }
+  ASSERT_GT(std::filesystem::file_size(TEST_CSV_NAME), 2 * LOAD_MIN_CHUNK_SIZE);
+  sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr);
+
+  // every row is loaded once, with its values
+  auto *fh = sm_manager_->fhs_.at(TEST_TB_NAME).get();
+  auto *schema = &sm_manager_->db_.get_table(TEST_TB_NAME).schema;
+  std::vector<bool> seen(num_rows, false);
+  int count = 0;
+  for (RmScan scan(fh); !scan.IsEnd(); scan.Next(), ++count) {
+    auto tuple = scan.GetTupleView().ToTuple();
+    int id = tuple.GetValue(schema, 0).GetAs<int>();
+    ASSERT_TRUE(id >= 0 && id < num_rows && !seen[id]);
+    seen[id] = true;
+    EXPECT_EQ(tuple.GetValue(schema, 1).ToString().substr(0, 4 + std::to_string(id % 1000).size()),
+              "item" + std::to_string(id % 1000));
+    if (id % 100 == 7) {
+      EXPECT_TRUE(tuple.IsNull(schema, 2));
+    } else {
+      EXPECT_DOUBLE_EQ(tuple.GetValue(schema, 2).GetAs<double>(), id % 50 + 0.5);
+    }
+  }
+  EXPECT_EQ(count, num_rows);
+
+  // the statistics of the threads are merged, NULLs are left out; distinct counts are estimated
+  EXPECT_EQ(sm_manager_->GetTableCount(TEST_TB_NAME), num_rows);
+  EXPECT_EQ(sm_manager_->GetTableAttrMax(TEST_TB_NAME, "id"), num_rows - 1);
+  EXPECT_EQ(sm_manager_->GetTableAttrMin(TEST_TB_NAME, "id"), 0);
+  EXPECT_NEAR(sm_manager_->GetTableAttrDistinct(TEST_TB_NAME, "id"), num_rows, num_rows * 0.05);
+  EXPECT_EQ(sm_manager_->GetTableAttrMax(TEST_TB_NAME, "price"), 49.5f);
+  EXPECT_EQ(sm_manager_->GetTableAttrMin(TEST_TB_NAME, "price"), 0.5f);
+  EXPECT_EQ(sm_manager_->GetTableAttrDistinct(TEST_TB_NAME, "price"), 50);
+  // COUNT(price) leaves out the NULLs
+  EXPECT_EQ(sm_manager_->GetTableAttrNullCount(TEST_TB_NAME, "price"), num_rows / 100);
+  EXPECT_EQ(sm_manager_->GetTableAttrNullCount(TEST_TB_NAME, "id"), 0);
+  // strings have distinct counts and histograms, but no min, max or sum
+  EXPECT_NEAR(sm_manager_->GetTableAttrDistinct(TEST_TB_NAME, "name"), 1000, 1000 * 0.05);
+  EXPECT_EQ(sm_manager_->GetTableAttrMax(TEST_TB_NAME, "name"), -1);
+  ASSERT_NE(sm_manager_->GetTableAttrHistogram(TEST_TB_NAME, "name"), nullptr);
+  const auto *histogram = sm_manager_->GetTableAttrHistogram(TEST_TB_NAME, "id");
+  ASSERT_NE(histogram, nullptr);
+  EXPECT_NEAR(histogram->EstimateLessThan(Value(TYPE_INT, num_rows / 4)), 0.25, 0.05);
+
+  // a malformed number fails the load, the rows before it are deleted again
+  {
+    std::ofstream csv(TEST_CSV_NAME);
+    csv << "1|a|1.5|\nx|b|2.5|\n";
+  }
+  EXPECT_THROW(sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr), InternalError);
+  count = 0;
+  for (RmScan scan(fh); !scan.IsEnd(); scan.Next()) {
+    count++;
+  }
+  EXPECT_EQ(count, num_rows);
+}
+
+// NOLINTNEXTLINE
+TEST_F(LoadDataTest, IndexedTable) {
+  // the index is built bottom-up from the keys of the rows, in whatever order they are in the file
+  sm_manager_->CreateIndex(TEST_TB_NAME, {"id"}, nullptr);
+  const int num_rows = 10000;
+  {
+    std::ofstream csv(TEST_CSV_NAME);
+    for (int i = 0; i < num_rows; ++i) {
+      csv << (i * 7919) % num_rows << "|item|1.5|\n";
+    }
+  }
+  sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr);
+
+  auto *fh = sm_manager_->fhs_.at(TEST_TB_NAME).get();
+  auto *schema = &sm_manager_->db_.get_table(TEST_TB_NAME).schema;
+  auto *ih = sm_manager_->ihs_.at(ix_manager_->GetIndexName(TEST_TB_NAME, std::vector<std::string>{"id"})).get();
+  char key[sizeof(int)];
+  for (int id = 0; id < num_rows; ++id) {
+    std::vector<RID> rids;
+    ix_memcpy(key, Value(TYPE_INT, id), sizeof(int));
+    ASSERT_TRUE(ih->GetValue(key, &rids, nullptr));
+    EXPECT_EQ(fh->GetTupleValue(rids[0], nullptr)->GetValue(schema, 0).GetAs<int>(), id);
+  }
+
+  // a second load goes into the index that is not empty any more, key by key in key order; a duplicate key fails
+  // it as a whole, the key inserted before the duplicate is deleted again with the rows
+  {
+    std::ofstream csv(TEST_CSV_NAME);
+    csv << "0|item|1.5|\n-1|item|1.5|\n";
+  }
+  EXPECT_THROW(sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr), IndexExistsError);
+  ix_memcpy(key, Value(TYPE_INT, -1), sizeof(int));
+  std::vector<RID> rids;
+  EXPECT_FALSE(ih->GetValue(key, &rids, nullptr));
+  int count = 0;
+  for (RmScan scan(fh); !scan.IsEnd(); scan.Next()) {
+    count++;
+  }
+  EXPECT_EQ(count, num_rows);
+}
+
+// NOLINTNEXTLINE
+TEST_F(LoadDataTest, FailedLoadIsUndone) {
+  // the index on id is built before the duplicate name is found in the hash index, both are left empty
+  sm_manager_->CreateIndex(TEST_TB_NAME, {"id"}, nullptr);
+  sm_manager_->CreateIndex(TEST_TB_NAME, {"name"}, nullptr, {}, true);
+  {
+    std::ofstream csv(TEST_CSV_NAME);
+    csv << "1|a|1.5|\n2|b|1.5|\n3|a|1.5|\n";
+  }
+  EXPECT_THROW(sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr), IndexExistsError);
+  auto *fh = sm_manager_->fhs_.at(TEST_TB_NAME).get();
+  EXPECT_TRUE(RmScan(fh).IsEnd());
+
+  // so the same keys load again
+  {
+    std::ofstream csv(TEST_CSV_NAME);
+    csv << "1|a|1.5|\n2|b|1.5|\n";
+  }
+  sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr);
+  int count = 0;
+  for (RmScan scan(fh); !scan.IsEnd(); scan.Next()) {
+    count++;
+  }
+  EXPECT_EQ(count, 2);
+}
+
+// NOLINTNEXTLINE
+TEST_F(LoadDataTest, CoveringIndex) {
+  // the leaves of the index on id also hold the price of the rows
+  EXPECT_THROW(sm_manager_->CreateIndex(TEST_TB_NAME, {"id"}, nullptr, {"id"}), InternalError);
+  sm_manager_->CreateIndex(TEST_TB_NAME, {"id"}, nullptr, {"price"});
+  const int num_rows = 10000;
+  {
+    std::ofstream csv(TEST_CSV_NAME);
+    for (int i = 0; i < num_rows; ++i) {
+      int id = (i * 7919) % num_rows;
+      csv << id << "|item|";
+      if (id % 10 != 3) {
+        csv << id % 50 << ".5";
+      }
+      csv << "|\n";
+    }
+  }
+  sm_manager_->LoadData(TEST_CSV_NAME, TEST_TB_NAME, nullptr);
+
+  // an index-only scan gets id and price from the index, the columns that are not in it are NULL
+  std::vector<Condition> conds(2);
+  conds[0].lhs_col = conds[1].lhs_col = {.tab_name = TEST_TB_NAME, .col_name = "id"};
+  conds[0].op = OP_GE;
+  conds[1].op = OP_LT;
+  conds[0].is_rhs_val = conds[1].is_rhs_val = true;
+  conds[0].rhs_val = Value(TYPE_INT, 1000);
+  conds[1].rhs_val = Value(TYPE_INT, 2000);
+  IndexScanExecutor scan(sm_manager_.get(), TEST_TB_NAME, conds, {"id"}, nullptr, true);
+  const auto &schema = scan.schema();
+  int id = 1000;
+  for (scan.beginTuple(); !scan.IsEnd(); scan.nextTuple(), ++id) {
+    auto tuple = scan.Next();
+    ASSERT_EQ(tuple->GetValue(&schema, 0).GetAs<int>(), id);
+    EXPECT_TRUE(tuple->IsNull(&schema, 1));
+    if (id % 10 == 3) {
+      EXPECT_TRUE(tuple->IsNull(&schema, 2));
+    } else {
+      EXPECT_DOUBLE_EQ(tuple->GetValue(&schema, 2).GetAs<double>(), id % 50 + 0.5);
+    }
+  }
+  EXPECT_EQ(id, 2000);
+
+  // every entry of the index is the one made from its row, key and payload
+  auto *ih = sm_manager_->ihs_.at(ix_manager_->GetIndexName(TEST_TB_NAME, std::vector<std::string>{"id"})).get();
+  auto &index = *sm_manager_->db_.get_table(TEST_TB_NAME).get_index_meta({"id"});
+  auto *fh = sm_manager_->fhs_.at(TEST_TB_NAME).get();
+  auto *tab_schema = &sm_manager_->db_.get_table(TEST_TB_NAME).schema;
+  std::string entry(index.col_tot_len + index.GetIncludeLen(), '\0');
+  for (IxScan ix_scan(ih, ih->LeafBegin(), ih->LeafEnd(), bpm_.get()); !ix_scan.IsEnd(); ix_scan.Next()) {
+    auto tuple = fh->GetTupleValue(ix_scan.GetEntry(entry.data()), nullptr);
+    ASSERT_EQ(entry, index.MakeEntry([&](uint32_t col_id) { return tuple->GetValue(tab_schema, col_id); }));
+  }
+}
+
+}  // namespace easydb
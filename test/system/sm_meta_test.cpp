@@ -0,0 +1,86 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * sm_meta_test.cpp
+ *
+ * Identification: test/system/sm_meta_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "system/sm_meta.h"
+
+namespace easydb {
+
+// NOLINTNEXTLINE
+TEST(SmMetaTest, IndexMetaWithoutIncludeAndHash) {
+  ColMeta id{"item", "id", TYPE_INT, sizeof(int), 0, false};
+  ColMeta price{"item", "price", TYPE_FLOAT, sizeof(float), sizeof(int), false};
+  IndexMeta covering;
+  covering.tab_name = "item";
+  covering.col_tot_len = sizeof(int);
+  covering.col_num = 1;
+  covering.cols = {id};
+  covering.col_ids = {0};
+  covering.include_cols = {price};
+  covering.include_ids = {1};
+  covering.is_hash = true;
+
+  // an index written before INCLUDE and USING HASH, followed by one written now and the schema of the table
+  std::stringstream ss;
+  ss << "item " << sizeof(int) << " 1\n" << id << "\n0\n" << covering << "\nSchema[NumColumns:2]\n";
+  IndexMeta old_index;
+  IndexMeta new_index;
+  ss >> old_index >> new_index;
+  ASSERT_TRUE(ss);
+  EXPECT_EQ(old_index.col_ids, std::vector<uint32_t>{0});
+  EXPECT_TRUE(old_index.include_cols.empty());
+  EXPECT_FALSE(old_index.is_hash);
+  EXPECT_EQ(new_index.cols[0].name, "id");
+  ASSERT_EQ(new_index.include_cols.size(), 1U);
+  EXPECT_EQ(new_index.include_cols[0].name, "price");
+  EXPECT_EQ(new_index.include_ids, std::vector<uint32_t>{1});
+  EXPECT_TRUE(new_index.is_hash);
+
+  // the old index at the end of the table leaves the schema to the caller
+  std::stringstream last;
+  last << "item " << sizeof(int) << " 1\n" << id << "\n0\n" << "Schema[NumColumns:2]\n";
+  IndexMeta last_index;
+  last >> last_index;
+  std::string token;
+  last >> token;
+  EXPECT_EQ(token, "Schema[NumColumns:2]");
+}
+
+// NOLINTNEXTLINE
+TEST(SmMetaTest, DbMetaReadsEveryTable) {
+  TabMeta item;
+  item.name = "item";
+  item.cols = {ColMeta{"item", "id", TYPE_INT, sizeof(int), 0, false}};
+  TabMeta stock;
+  stock.name = "stock";
+  stock.cols = {ColMeta{"stock", "qty", TYPE_INT, sizeof(int), 0, false}};
+
+  // the same layout as DbMeta::operator<<, each table ends with its schema line
+  std::stringstream ss;
+  ss << "db\n2\n" << item << '\n' << stock << '\n';
+  DbMeta db;
+  ss >> db;
+  EXPECT_TRUE(db.is_table("item"));
+  ASSERT_TRUE(db.is_table("stock"));
+  EXPECT_EQ(db.get_table("stock").cols[0].name, "qty");
+
+  // a catalog cut off after the first table is an error instead of a database without its second table
+  std::stringstream truncated;
+  truncated << "db\n2\n" << item << '\n';
+  DbMeta truncated_db;
+  EXPECT_THROW(truncated >> truncated_db, InternalError);
+}
+
+}  // namespace easydb
@@ -0,0 +1,79 @@
+/*-------------------------------------------------------------------------
+ *
+ * EasyDB
+ *
+ * sm_stats_test.cpp
+ *
+ * Identification: test/system/sm_stats_test.cpp
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "system/sm_stats.h"
+
+namespace easydb {
+
+// NOLINTNEXTLINE
+TEST(SmStatsTest, HyperLogLog) {
+  HyperLogLog hll;
+  EXPECT_EQ(hll.Estimate(), 0);
+  // duplicates do not count, small cardinalities are nearly exact
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      hll.Add(&i, sizeof(i));
+    }
+  }
+  EXPECT_NEAR(hll.Estimate(), 100, 2);
+
+  // large cardinalities are within a few standard errors, also when merged from disjoint parts
+  HyperLogLog left;
+  HyperLogLog right;
+  for (int i = 0; i < 1000000; ++i) {
+    (i % 2 == 0 ? left : right).Add(&i, sizeof(i));
+  }
+  EXPECT_NEAR(left.Estimate(), 500000, 500000 * 0.05);
+  left.Merge(right);
+  EXPECT_NEAR(left.Estimate(), 1000000, 1000000 * 0.05);
+}
+
+// NOLINTNEXTLINE
+TEST(SmStatsTest, ColumnStats) {
+  // two builders of the same column, as two loading threads, with different sizes
+  ColumnStatsBuilder stats(TYPE_INT, 0);
+  ColumnStatsBuilder other(TYPE_INT, 1);
+  for (int i = 0; i < 100000; ++i) {
+    (i < 30000 ? stats : other).Add(Value(TYPE_INT, i - 1000));
+  }
+  stats.Add(Value(TYPE_INT));
+  stats.Merge(std::move(other));
+  EXPECT_EQ(stats.GetCount(), 100000);
+  EXPECT_EQ(stats.GetMin(), -1000);
+  EXPECT_EQ(stats.GetMax(), 98999);
+  EXPECT_EQ(stats.GetSum(), 100000.0 * 97999 / 2);
+  EXPECT_NEAR(stats.EstimateDistinct(), 100000, 100000 * 0.05);
+
+  // the merged sample stands for both parts, so the buckets hold about the same number of rows
+  auto histogram = stats.BuildHistogram();
+  EXPECT_EQ(histogram.GetNumBuckets(), ColumnStatsBuilder::HISTOGRAM_BUCKETS);
+  EXPECT_EQ(histogram.EstimateLessThan(Value(TYPE_INT, -1000)), 0);
+  EXPECT_EQ(histogram.EstimateLessThan(Value(TYPE_INT, 200000)), 1);
+  EXPECT_NEAR(histogram.EstimateLessThan(Value(TYPE_INT, 9000)), 0.1, 0.03);
+  EXPECT_NEAR(histogram.EstimateLessThan(Value(TYPE_INT, 74000)), 0.75, 0.03);
+
+  // strings get distinct counts and histograms too
+  ColumnStatsBuilder names(TYPE_VARCHAR);
+  for (int i = 0; i < 20000; ++i) {
+    names.Add(Value(TYPE_VARCHAR, "name" + std::to_string(i % 500)));
+  }
+  EXPECT_FALSE(names.IsNumeric());
+  EXPECT_NEAR(names.EstimateDistinct(), 500, 500 * 0.05);
+  histogram = names.BuildHistogram();
+  EXPECT_EQ(histogram.GetBounds().front().ToString(), "name0");
+  EXPECT_EQ(histogram.GetBounds().back().ToString(), "name99");
+}
+
+}  // namespace easydb